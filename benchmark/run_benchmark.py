@@ -0,0 +1,428 @@
+#!/usr/bin/env python
+
+"""
+Run the standard G'DAY workloads and report throughput as simulated days per
+second along with the peak resident memory of each run (make benchmark in
+src does this)
+
+    $ python run_benchmark.py                  # compare with baseline.json
+    $ python run_benchmark.py --save           # store a new baseline
+    $ python run_benchmark.py --only spinup duke_daily
+    $ python run_benchmark.py --set control.temp_tables=true
+
+The workloads are
+
+    duke_daily      the Duke ambient CO2 run on the daily forcing
+    spinup          a full spin-up on the 50 year equilibrium forcing
+    synthetic_30min a multi-decade 30 min run on forcing made up from the
+                    Duke daily file
+    grass           deciduous grass phenology on the Duke daily forcing
+
+All of them start from the Duke .cfg in example/params, with the changes set
+on the command line (-set), and are run from example/ as the .cfg expects.
+The Duke met files in example/met_data are in an older column layout than
+the one read_met_file.c reads (co2 would be read from vpd_avg, and the
+ecosystem starves), so the daily workloads run on copies rearranged into
+the model's layout. These and the 30 min forcing are written to work/ the
+first time, and again whenever the way they are made changes. A workload
+whose outputs aren't all finite fails, its days/s would only time NaN
+going through the model.
+Any --set KEY=VALUE is added to every workload, so a model option can be
+timed against the baseline without a new set of workloads. Each workload is
+run --repeat times and the fastest is kept, which is the
+least noisy number on a busy machine. The peak RSS is that of the fastest
+run. Days for the spin-up are the forcing length times the number of cycles
+it took to converge, as reported by the model.
+
+The baseline stores the numbers along with the machine and the git revision
+they came from; comparing across machines is meaningless, so rerun with
+--save when the hardware changes.
+"""
+
+import os
+import sys
+import json
+import math
+import time
+import argparse
+import platform
+import subprocess
+
+__author__  = "agent"
+__version__ = "1.0 (14.10.2026)"
+__email__   = "agent@local"
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+EXAMPLE_DIR = os.path.join(HERE, "..", "example")
+WORK_DIR = os.path.join(HERE, "work")
+CFG = "params/NCEAS_DUKE_model_youngforest_amb.cfg"
+MET_DAILY = "met_data/DUKE_met_data_amb_co2.csv"
+MET_EQUIL = "met_data/DUKE_met_data_equilibrium_50_yrs.csv"
+
+SYNTHETIC_YEARS = 48
+SYNTHETIC_START = 1996
+SYNTHETIC_LATITUDE = 35.97
+
+# calm days in the Duke file (1997 doy 14 has no wind at all) would give a
+# zero boundary layer conductance, which the Penman-Monteith divides by, m/s
+MIN_WIND = 0.1
+
+# first line of the forcing written here, bump it when that changes so any
+# copy left in work/ is made again
+FORCING_VERSION = "# made by run_benchmark.py, forcing version 2"
+
+# daily columns in the order read_daily_met_data reads them
+DAILY_COLUMNS = ["year", "doy", "tair", "rain", "tsoil", "tam", "tpm", "tmin",
+                 "tmax", "tday", "vpd_am", "vpd_pm", "co2", "ndep", "wind",
+                 "press", "wind_am", "wind_pm", "par_am", "par_pm"]
+
+
+def workloads():
+    """ name, forcing file, -s or not, and the -set overrides of each run """
+    out = os.path.join(WORK_DIR, "out.csv")
+    final = os.path.join(WORK_DIR, "final.cfg")
+    common = ["files.out_fname=%s" % out,
+              "files.out_param_fname=%s" % final]
+    daily = os.path.join(WORK_DIR, "duke_daily.csv")
+    equil = os.path.join(WORK_DIR, "duke_equilibrium.csv")
+    synthetic = os.path.join(WORK_DIR, "synthetic_30min.csv")
+
+    return [
+        ("duke_daily", daily, False,
+         common + ["files.met_fname=%s" % daily,
+                   "control.print_options=daily"]),
+        ("spinup", equil, True,
+         common + ["files.met_fname=%s" % equil,
+                   "control.print_options=end"]),
+        ("synthetic_30min", synthetic, False,
+         common + ["files.met_fname=%s" % synthetic,
+                   "control.sub_daily=true",
+                   "control.print_options=daily"]),
+        ("grass", daily, False,
+         common + ["files.met_fname=%s" % daily,
+                   "control.alloc_model=grasses",
+                   "control.deciduous_model=true",
+                   "control.print_options=daily"]),
+    ]
+
+
+def forcing_writers():
+    """ {forcing file: function writing it} of the made up forcing """
+    return {
+        os.path.join(WORK_DIR, "duke_daily.csv"):
+            lambda fname: write_daily_forcing(MET_DAILY, fname),
+        os.path.join(WORK_DIR, "duke_equilibrium.csv"):
+            lambda fname: write_daily_forcing(MET_EQUIL, fname),
+        os.path.join(WORK_DIR, "synthetic_30min.csv"):
+            write_synthetic_forcing,
+    }
+
+
+def make_forcing(fname, write):
+    """ write(fname) unless fname is there and made the current way """
+    if os.path.exists(fname):
+        with open(fname) as f:
+            if f.readline().rstrip("\n") == FORCING_VERSION:
+                return
+    sys.stderr.write("writing %s\n" % fname)
+    write(fname)
+
+
+def count_met_days(fname):
+    """ days in a met file, 48 rows a day for the 30 min files """
+    nrows = 0
+    sub_daily = False
+    with open(fname) as f:
+        for line in f:
+            if line.startswith("#"):
+                sub_daily = sub_daily or line.startswith("#year,doy,hod")
+                continue
+            if line.strip():
+                nrows += 1
+
+    return nrows // 48 if sub_daily else nrows
+
+
+def read_duke_forcing(met_fname):
+    """ rows of a Duke daily met file as {column: value}, by its header """
+    names = None
+    rows = []
+    with open(os.path.join(EXAMPLE_DIR, met_fname)) as f:
+        for line in f:
+            if line.startswith("#year,"):
+                names = line[1:].strip().split(",")
+            elif line.startswith("#") or not line.strip():
+                continue
+            else:
+                rows.append(dict(zip(names, [float(x) for x in
+                                             line.split(",")])))
+
+    return rows
+
+
+def day_length(doy):
+    """ hours, from the solar declination at SYNTHETIC_LATITUDE """
+    dec = -23.4 * math.cos(2.0 * math.pi * (doy + 10) / 365.0)
+    x = (-math.tan(math.radians(SYNTHETIC_LATITUDE)) *
+         math.tan(math.radians(dec)))
+
+    return 24.0 / math.pi * math.acos(max(-1.0, min(1.0, x)))
+
+
+def write_daily_forcing(met_fname, fname):
+    """ a Duke daily met file rearranged into the model's daily layout.
+
+    PAR is given as the day's total (umol m-2 d-1), the model wants the
+    am and pm shares of the mean over the day length (umol m-2 s-1), split
+    as the am and pm shortwave are. The equilibrium file has no tmin, tmax
+    or tday, which are taken from tam, tpm and tair. The winds are held at
+    MIN_WIND or above.
+    """
+    tmp_fname = fname + ".tmp"
+    with open(tmp_fname, "w") as f:
+        f.write("%s\n" % FORCING_VERSION)
+        f.write("# daily forcing rearranged from %s\n" % met_fname)
+        f.write("#%s\n" % ",".join(DAILY_COLUMNS))
+        for v in read_duke_forcing(met_fname):
+            v.setdefault("tmin", min(v["tam"], v["tpm"]))
+            v.setdefault("tmax", max(v["tam"], v["tpm"]))
+            v.setdefault("tday", v["tair"])
+            v["press"] = v["atmos_press"]
+            for name in ("wind", "wind_am", "wind_pm"):
+                v[name] = max(v[name], MIN_WIND)
+
+            seconds = day_length(v["doy"]) * 3600.0
+            sw = v["sw_rad_am"] + v["sw_rad_pm"]
+            am = v["sw_rad_am"] / sw if sw > 0.0 else 0.5
+            v["par_am"] = v["par"] * am / seconds
+            v["par_pm"] = v["par"] * (1.0 - am) / seconds
+
+            f.write("%d,%d,%s\n" % (v["year"], v["doy"],
+                                    ",".join("%.10g" % v[name] for name in
+                                             DAILY_COLUMNS[2:])))
+    os.rename(tmp_fname, fname)
+
+
+def write_synthetic_forcing(fname, nyears=SYNTHETIC_YEARS):
+    """ 30 min forcing for nyears years made up from the daily file.
+
+    The Duke years are cycled, which keeps the leap years in step as the
+    record is 12 years long. Within a day PAR follows the sun (a sine over
+    the day length), air temperature a cosine between tmin and tmax peaking
+    at 2pm, the am/pm VPD holds either side of noon and rain and N
+    deposition are spread evenly. The wind is held at MIN_WIND or above.
+    Nothing here is meant to be realistic, only the same every time and
+    finite throughout the run.
+    """
+    days = {}
+    years = []
+    for v in read_duke_forcing(MET_DAILY):
+        year = int(v["year"])
+        if year not in days:
+            days[year] = []
+            years.append(year)
+        days[year].append(v)
+
+    tmp_fname = fname + ".tmp"
+    with open(tmp_fname, "w") as f:
+        f.write("%s\n" % FORCING_VERSION)
+        f.write("# synthetic 30 min forcing made from %s\n" % MET_DAILY)
+        f.write("#year,doy,hod,rain,par,tair,tsoil,vpd,co2,ndep,wind,"
+                "press\n")
+        for i in range(nyears):
+            year = SYNTHETIC_START + i
+            for v in days[years[i % len(years)]]:
+                doy = int(v["doy"])
+                (tmin, tmax) = (v["tmin"], v["tmax"])
+                wind = max(v["wind"], MIN_WIND)
+
+                sunrise = 12.0 - day_length(doy) / 2.0
+                shape = [max(0.0, math.sin(math.pi * (h * 0.5 + 0.25 -
+                                                     sunrise) /
+                                           day_length(doy)))
+                         for h in range(48)]
+                total = sum(shape) * 1800.0
+
+                for h in range(48):
+                    hour = h * 0.5 + 0.25
+                    tair = (0.5 * (tmax + tmin) + 0.5 * (tmax - tmin) *
+                            math.cos(2.0 * math.pi * (hour - 14.0) / 24.0))
+                    f.write("%d,%d,%d,%f,%f,%f,%f,%f,%f,%.10e,%f,%f\n" %
+                            (year, doy, h, v["rain"] / 48.0,
+                             v["par"] * shape[h] / total, tair, v["tsoil"],
+                             v["vpd_am"] if hour < 12.0 else v["vpd_pm"],
+                             v["co2"], v["ndep"] / 48.0, wind,
+                             v["atmos_press"]))
+    os.rename(tmp_fname, fname)
+
+
+def finite(x):
+    return not (math.isnan(x) or math.isinf(x))
+
+
+def non_finite(fname):
+    """ the first variable of an output file (or the [state] of a final
+    parameter file) that isn't finite, as "name at row", else None """
+    with open(fname) as f:
+        lines = f.read().splitlines()
+    if fname.endswith(".cfg"):
+        section = None
+        for line in lines:
+            line = line.strip()
+            if line.startswith("["):
+                section = line.strip("[]")
+            elif section == "state" and "=" in line:
+                (key, value) = [x.strip() for x in line.split("=", 1)]
+                if not finite(float(value)):
+                    return "%s in the final state" % key
+        return None
+
+    names = [name.strip() for name in lines[1].split(",")]
+    for (i, line) in enumerate(lines[2:]):
+        for (name, x) in zip(names, line.split(",")):
+            if not finite(float(x)):
+                return "%s on output row %d" % (name, i + 1)
+
+    return None
+
+
+def run_once(gday, name, met_fname, spin_up, overrides):
+    """ one run of a workload, returns wall seconds, peak RSS (MB), stderr """
+    cmd = [gday]
+    if spin_up:
+        cmd.append("-s")
+    cmd += ["-p", CFG]
+    for kv in overrides:
+        cmd += ["-set", kv]
+
+    err_fname = os.path.join(WORK_DIR, name + ".log")
+    with open(err_fname, "w") as err:
+        start = time.time()
+        proc = subprocess.Popen(cmd, cwd=EXAMPLE_DIR, stdout=err, stderr=err)
+        (pid, status, usage) = os.wait4(proc.pid, 0)
+        elapsed = time.time() - start
+    proc.returncode = status
+    with open(err_fname) as err:
+        log = err.read()
+    if status != 0:
+        sys.stderr.write("%s failed:\n%s" % (name, log))
+        sys.exit(1)
+
+    # ru_maxrss is kB on Linux, bytes on OS X
+    rss = usage.ru_maxrss / 1024.0
+    if sys.platform == "darwin":
+        rss /= 1024.0
+
+    return (elapsed, rss, log)
+
+
+def spinup_cycles(log):
+    """ number of passes over the forcing, from the model's final message """
+    for line in log.splitlines():
+        if line.startswith("Spinup: converged after"):
+            return int(line.split("(")[1].split()[0])
+    sys.stderr.write("spinup: no convergence message in the log\n")
+    sys.exit(1)
+
+
+def machine():
+    cpu = platform.processor()
+    if os.path.exists("/proc/cpuinfo"):
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    cpu = line.split(":", 1)[1].strip()
+                    break
+    return "%s, %s" % (platform.node(), cpu)
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short",
+                                        "HEAD"], cwd=HERE).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--gday", default=os.path.join(HERE, "..", "src",
+                                                       "gday"),
+                        help="model executable")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="runs of each workload, the fastest is kept")
+    parser.add_argument("--baseline", default=os.path.join(HERE,
+                                                           "baseline.json"))
+    parser.add_argument("--save", action="store_true",
+                        help="store these results as the baseline")
+    parser.add_argument("--only", nargs="+", metavar="NAME",
+                        help="run just these workloads")
+    parser.add_argument("--set", action="append", default=[],
+                        metavar="KEY=VALUE",
+                        help="extra -set override for every workload")
+    args = parser.parse_args()
+
+    gday = os.path.abspath(args.gday)
+    if not os.path.exists(gday):
+        sys.stderr.write("%s not found, run make in src first\n" % gday)
+        sys.exit(1)
+    if not os.path.isdir(WORK_DIR):
+        os.makedirs(WORK_DIR)
+
+    baseline = {}
+    if os.path.exists(args.baseline) and not args.save:
+        with open(args.baseline) as f:
+            baseline = json.load(f)["results"]
+
+    print("%-16s %10s %9s %12s %10s %10s" % ("workload", "days", "time (s)",
+                                             "days/s", "RSS (MB)",
+                                             "vs base"))
+    results = {}
+    for (name, met_fname, spin_up, overrides) in workloads():
+        if args.only and name not in args.only:
+            continue
+        make_forcing(met_fname, forcing_writers()[met_fname])
+
+        best = None
+        for i in range(max(1, args.repeat)):
+            run = run_once(gday, name, met_fname, spin_up,
+                           overrides + args.set)
+            if best is None or run[0] < best[0]:
+                best = run
+        (elapsed, rss, log) = best
+
+        bad = non_finite(os.path.join(WORK_DIR, "final.cfg" if spin_up else
+                                      "out.csv"))
+        if bad is not None:
+            sys.stderr.write("%s: %s isn't finite, the run isn't worth "
+                             "timing\n" % (name, bad))
+            sys.exit(1)
+
+        days = count_met_days(os.path.join(EXAMPLE_DIR, met_fname))
+        if spin_up:
+            days *= spinup_cycles(log)
+        rate = days / max(elapsed, 1E-9)
+
+        change = "-"
+        if name in baseline:
+            change = "%+.1f%%" % (100.0 * (rate / baseline[name]["days_per_s"]
+                                           - 1.0))
+        print("%-16s %10d %9.3f %12.0f %10.1f %10s" % (name, days, elapsed,
+                                                       rate, rss, change))
+        sys.stdout.flush()
+        results[name] = {"days": days, "seconds": round(elapsed, 4),
+                         "days_per_s": round(rate, 1),
+                         "peak_rss_mb": round(rss, 1)}
+
+    if args.save:
+        with open(args.baseline, "w") as f:
+            json.dump({"machine": machine(), "revision": git_revision(),
+                       "repeat": args.repeat, "set": args.set,
+                       "results": results}, f,
+                      indent=4, sort_keys=True)
+            f.write("\n")
+        print("saved to %s" % args.baseline)
+
+
+if __name__ == "__main__":
+    main()
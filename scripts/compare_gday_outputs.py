@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+
+"""
+Compare two G'DAY CSV output files variable by variable, e.g. a run built
+with -DMET_FLOAT against the same run with the default double precision
+forcing
+
+    $ python compare_gday_outputs.py double.csv float.csv --rtol 1e-3
+
+For each variable the largest absolute difference is reported, along with
+that difference scaled by the largest magnitude the variable reaches in the
+first file. The scaled difference is used for the test as most fluxes pass
+through zero, where a pointwise relative error means nothing. The exit
+status is 1 if any variable is further apart than rtol.
+"""
+
+import sys
+import csv
+import argparse
+
+__author__  = "agent"
+__version__ = "1.0 (14.10.2026)"
+__email__   = "agent@local"
+
+
+def read_gday_csv(fname):
+    """ read a CSV output into a dictionary of columns.
+
+    The first line of the file holds the git revision, the second the
+    variable names.
+    """
+    with open(fname, "r") as fp:
+        rows = list(csv.reader(fp))
+    names = [name.strip() for name in rows[1]]
+    data = dict((name, []) for name in names)
+    for row in rows[2:]:
+        for name, value in zip(names, row):
+            data[name].append(float(value))
+
+    return names, data
+
+
+def compare_outputs(fname1, fname2):
+    """ largest absolute and scaled difference of each shared variable """
+    names, a = read_gday_csv(fname1)
+    names2, b = read_gday_csv(fname2)
+    if len(a[names[0]]) != len(b[names2[0]]):
+        raise ValueError("%s and %s have a different number of rows" %
+                         (fname1, fname2))
+
+    results = []
+    for name in names:
+        if name not in b:
+            continue
+        abs_diff = max(abs(x - y) for x, y in zip(a[name], b[name]))
+        scale = max(abs(x) for x in a[name])
+        rel_diff = abs_diff / scale if scale > 0.0 else abs_diff
+        results.append((name, abs_diff, rel_diff))
+
+    return results
+
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("reference", help="output from the reference run")
+    parser.add_argument("other", help="output to test against it")
+    parser.add_argument("--rtol", type=float, default=1e-3,
+                        help="largest difference allowed, as a fraction of "
+                             "each variable's largest magnitude")
+    parser.add_argument("--all", action="store_true",
+                        help="list every variable, not just the failures")
+    args = parser.parse_args()
+
+    results = compare_outputs(args.reference, args.other)
+    worst = max(results, key=lambda r: r[2])
+    nfail = 0
+    for (name, abs_diff, rel_diff) in results:
+        failed = rel_diff > args.rtol
+        nfail += failed
+        if failed or args.all:
+            print("%-20s abs %-12.4g scaled %-12.4g %s" %
+                  (name, abs_diff, rel_diff, "FAIL" if failed else ""))
+
+    print("%d variables, %d outside rtol=%g, worst %s (%.3g)" %
+          (len(results), nfail, args.rtol, worst[0], worst[2]))
+    sys.exit(1 if nfail > 0 else 0)
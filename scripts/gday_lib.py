@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+
+"""
+Drive G'DAY in-process through the shared library (src/libgday.so, built by
+make) rather than running the gday program and parsing its CSV output.
+
+Forcing arrays are handed to the model and outputs handed back without
+copies, e.g. a sensitivity loop over g1 with a warmer climate
+
+    from gday_lib import GDAY
+
+    with GDAY("params/NCEAS_DUKE_model_youngforest_amb.cfg") as g:
+        tair = g.forcing_array(20.0)        # right length/dtype for the build
+        g.set_forcing("tair", tair)
+        for g1 in [2.0, 3.0, 4.0]:
+            g.reset()
+            g.set("params.g1", g1)
+            g.run()
+            print(g1, g.output("gpp").sum())
+
+output() returns a view of the model's memory, which is reused by the next
+run(); take a copy() of anything that needs to outlive it. The C API is
+documented in src/include/libgday.h.
+"""
+
+import os
+import ctypes
+import numpy as np
+
+__author__  = "agent"
+__version__ = "1.0 (14.10.2026)"
+__email__   = "agent@local"
+
+DEFAULT_LIB = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "..", "src", "libgday.so")
+
+
+def load_library(lib_fname=None):
+    """ load libgday and declare the C API to ctypes.
+
+    The library is found from lib_fname, then $GDAY_LIB and finally next to
+    this script in ../src.
+    """
+    if lib_fname is None:
+        lib_fname = os.environ.get("GDAY_LIB", DEFAULT_LIB)
+    lib = ctypes.CDLL(lib_fname)
+
+    model = ctypes.c_void_p
+    string = ctypes.c_char_p
+    lib.gday_open.argtypes = [string]
+    lib.gday_open.restype = model
+    lib.gday_close.argtypes = [model]
+    lib.gday_close.restype = None
+    lib.gday_reset.argtypes = [model]
+    lib.gday_reset.restype = None
+    lib.gday_set.argtypes = [model, string, string]
+    lib.gday_get.argtypes = [model, string, ctypes.POINTER(ctypes.c_double)]
+    lib.gday_forcing_size.argtypes = []
+    lib.gday_num_forcing_rows.argtypes = [model]
+    lib.gday_num_forcing_rows.restype = ctypes.c_long
+    lib.gday_set_forcing.argtypes = [model, string, ctypes.c_void_p,
+                                     ctypes.c_long]
+    lib.gday_spin_up.argtypes = [model]
+    lib.gday_run.argtypes = [model]
+    lib.gday_num_outputs.argtypes = [model]
+    lib.gday_output_name.argtypes = [model, ctypes.c_int]
+    lib.gday_output_name.restype = string
+    lib.gday_num_records.argtypes = [model]
+    lib.gday_num_records.restype = ctypes.c_long
+    lib.gday_output.argtypes = [model, string]
+    lib.gday_output.restype = ctypes.POINTER(ctypes.c_double)
+    lib.gday_version.argtypes = []
+    lib.gday_version.restype = string
+
+    return lib
+
+
+class GDAY(object):
+    """ One model, set up from a .cfg file and its met forcing.
+
+    Models for the same met file share one copy of the forcing, so an
+    ensemble can simply be a list of these.
+    """
+
+    def __init__(self, cfg_fname, lib_fname=None):
+        self.lib = load_library(lib_fname)
+        self.model = self.lib.gday_open(cfg_fname.encode())
+        if not self.model:
+            raise IOError("couldn't open %s" % cfg_fname)
+        if self.lib.gday_forcing_size() == 4:
+            self.met_dtype = np.float32
+        else:
+            self.met_dtype = np.float64
+        self.nrows = self.lib.gday_num_forcing_rows(self.model)
+
+        # the model reads these arrays in place, hold on to them
+        self.forcing = {}
+
+    def close(self):
+        if self.model:
+            self.lib.gday_close(self.model)
+            self.model = None
+        self.forcing = {}
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def set(self, key, value):
+        """ set a [control], [params] or [state] value, e.g. params.g1 """
+        if isinstance(value, bool):
+            value = "true" if value else "false"
+        if self.lib.gday_set(self.model, key.encode(),
+                             str(value).encode()) != 0:
+            raise KeyError(key)
+
+    def get(self, key):
+        """ current value of a numeric key, e.g. state.soilc """
+        value = ctypes.c_double()
+        if self.lib.gday_get(self.model, key.encode(),
+                             ctypes.byref(value)) != 0:
+            raise KeyError(key)
+        return value.value
+
+    def reset(self):
+        """ parameters and state back to how the .cfg file set them """
+        self.lib.gday_reset(self.model)
+
+    def forcing_array(self, fill=0.0):
+        """ an array the model can use in place as a forcing column """
+        return np.full(self.nrows, fill, dtype=self.met_dtype)
+
+    def set_forcing(self, name, values):
+        """ drive the model with values in place of a met file column.
+
+        Nothing is copied if values is already a contiguous array of the
+        library's met dtype and the right length (see forcing_array).
+        """
+        values = np.ascontiguousarray(values, dtype=self.met_dtype)
+        if values.shape != (self.nrows,):
+            raise ValueError("%s needs %d values, got %s" %
+                             (name, self.nrows, values.shape))
+        if self.lib.gday_set_forcing(self.model, name.encode(),
+                                     values.ctypes.data, self.nrows) != 0:
+            raise KeyError(name)
+        self.forcing[name] = values
+
+    def spin_up(self):
+        """ spin the pools up, leaving the state in the model """
+        self.lib.gday_spin_up(self.model)
+
+    def run(self):
+        self.lib.gday_run(self.model)
+
+    def output_names(self):
+        return [self.lib.gday_output_name(self.model, i).decode()
+                for i in range(self.lib.gday_num_outputs(self.model))]
+
+    def output(self, name):
+        """ the last run's values of one output variable, as a view """
+        ptr = self.lib.gday_output(self.model, name.encode())
+        if not ptr:
+            raise KeyError(name)
+        nrecords = self.lib.gday_num_records(self.model)
+        return np.ctypeslib.as_array(ptr, shape=(nrecords,))
+
+    def outputs(self):
+        """ dictionary of every output variable of the last run """
+        return dict((name, self.output(name)) for name in self.output_names())
+
+
+if __name__ == "__main__":
+
+    import sys
+
+    g = GDAY(sys.argv[1])
+    g.run()
+    print("G'DAY %s: %d records of %s" %
+          (g.lib.gday_version().decode(), g.lib.gday_num_records(g.model),
+           ", ".join(g.output_names())))
+    g.close()
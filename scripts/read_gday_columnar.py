@@ -0,0 +1,226 @@
+#!/usr/bin/env python
+
+"""
+Read G'DAY chunked columnar output files ([outputs] format = columnar) into
+numpy arrays.
+
+Only the blocks of the requested variables are read, so pulling one
+variable out of a large ensemble touches a small fraction of each file, e.g.
+
+    import glob
+    from read_gday_columnar import read_ensemble
+
+    fnames = sorted(glob.glob("outputs/member_*.bin"))
+    gpp = read_ensemble(fnames, "gpp")      # (nmembers, ndays)
+
+or, for every cell of a regional run,
+
+    ids, gpp = read_region("cells.txt.index.csv", "gpp")
+
+The file layout is documented in src/include/columnar.h.
+"""
+
+import sys
+import zlib
+import struct
+import numpy as np
+
+__author__  = "agent"
+__version__ = "1.0 (14.10.2026)"
+__email__   = "agent@local"
+
+COLUMN_MAGIC = b"GDAYCOL1"
+COLUMN_CHUNK_MAGIC = b"CHNK"
+COLUMN_INDEX_MAGIC = b"GDAYIDX1"
+COLUMN_BYTE_ORDER = 0x01020304
+COLUMN_NAME_LEN = 32
+COMPRESS_ZLIB = 1
+
+HEADER = struct.Struct("=8siiiiii")
+CHUNK = struct.Struct("=4siq")
+TRAILER = struct.Struct("=qqq8s")
+
+
+class ColumnarFile(object):
+    """ Header and index of a columnar output file.
+
+    Attributes:
+    ----------
+    names : list
+        variable names, in file order
+    units : list
+        units of each variable
+    nrows : int
+        number of records (days, or output periods) in the file
+    first_row, chunk_rows : array
+        first record and number of records in each chunk
+    offset, nbytes : array
+        (nchunks, nvars) position and size of every block
+    """
+
+    def __init__(self, fname):
+        self.fname = fname
+        with open(fname, "rb") as fp:
+            self._read_header(fp)
+            self._read_index(fp)
+
+    def _read_header(self, fp):
+        (magic, byte_order, version, nvars, chunk_len, compression,
+         pad) = HEADER.unpack(fp.read(HEADER.size))
+        if magic != COLUMN_MAGIC:
+            raise IOError("%s is not a G'DAY columnar output" % self.fname)
+        if byte_order != COLUMN_BYTE_ORDER:
+            raise IOError("%s was written on a machine with a different "
+                          "byte order" % self.fname)
+        self.version = version
+        self.nvars = nvars
+        self.chunk_len = chunk_len
+        self.compression = compression
+        self.names = [self._string(fp.read(COLUMN_NAME_LEN))
+                      for i in range(nvars)]
+        self.units = [self._string(fp.read(COLUMN_NAME_LEN))
+                      for i in range(nvars)]
+        self.data_start = fp.tell()
+
+    def _read_index(self, fp):
+        fp.seek(0, 2)
+        end = fp.tell()
+        fp.seek(end - TRAILER.size)
+        (nchunks, nrows, index_offset,
+         magic) = TRAILER.unpack(fp.read(TRAILER.size))
+        if magic != COLUMN_INDEX_MAGIC:
+            # the run didn't finish, rebuild the index from the chunks
+            self._scan_chunks(fp, end)
+            return
+
+        fp.seek(index_offset)
+        n = nchunks
+        self.nrows = nrows
+        self.first_row = np.fromfile(fp, dtype=np.int64, count=n)
+        self.chunk_rows = np.fromfile(fp, dtype=np.int64, count=n)
+        self.offset = np.fromfile(fp, dtype=np.int64,
+                                  count=n * self.nvars).reshape(n, self.nvars)
+        self.nbytes = np.fromfile(fp, dtype=np.int64,
+                                  count=n * self.nvars).reshape(n, self.nvars)
+
+    def _scan_chunks(self, fp, end):
+        first_row, chunk_rows, offset, nbytes = [], [], [], []
+        pos = self.data_start
+        while pos + CHUNK.size <= end:
+            fp.seek(pos)
+            (magic, nrows, first) = CHUNK.unpack(fp.read(CHUNK.size))
+            if magic != COLUMN_CHUNK_MAGIC:
+                break
+            sizes = np.fromfile(fp, dtype=np.int64, count=self.nvars)
+            pos += CHUNK.size + 8 * self.nvars
+            starts = pos + np.concatenate(([0], np.cumsum(sizes)[:-1]))
+            pos += sizes.sum()
+            if pos > end:
+                break
+            first_row.append(first)
+            chunk_rows.append(nrows)
+            offset.append(starts)
+            nbytes.append(sizes)
+
+        self.first_row = np.array(first_row, dtype=np.int64)
+        self.chunk_rows = np.array(chunk_rows, dtype=np.int64)
+        self.offset = np.array(offset, dtype=np.int64).reshape(-1, self.nvars)
+        self.nbytes = np.array(nbytes, dtype=np.int64).reshape(-1, self.nvars)
+        self.nrows = int(self.chunk_rows.sum())
+
+    def _string(self, raw):
+        return raw.split(b"\0", 1)[0].decode("ascii")
+
+    def read(self, name):
+        """ return one variable as a float64 array of nrows values """
+        try:
+            j = self.names.index(name)
+        except ValueError:
+            raise KeyError("%s: no variable %s" % (self.fname, name))
+
+        out = np.empty(self.nrows, dtype=np.float64)
+        with open(self.fname, "rb") as fp:
+            for k in range(len(self.first_row)):
+                fp.seek(self.offset[k, j])
+                raw = fp.read(self.nbytes[k, j])
+                n = self.chunk_rows[k]
+                if self.compression == COMPRESS_ZLIB:
+                    # undo the byte shuffle
+                    raw = np.frombuffer(zlib.decompress(raw), dtype=np.uint8)
+                    raw = raw.reshape(8, n).T.copy()
+                values = np.frombuffer(raw, dtype=np.float64, count=n)
+                start = self.first_row[k]
+                out[start:start+n] = values
+
+        return out
+
+
+def read_columnar(fname, variables=None):
+    """ read a columnar output file.
+
+    Parameters:
+    ----------
+    fname : string
+        G'DAY output file
+    variables : list, optional
+        names to read, all of them if not given
+
+    Returns:
+    -------
+    data : dictionary
+        numpy array for each variable
+    """
+    f = ColumnarFile(fname)
+    if variables is None:
+        variables = f.names
+
+    return dict((name, f.read(name)) for name in variables)
+
+
+def read_ensemble(fnames, variable):
+    """ read one variable from many runs into a (nruns, nrows) array """
+    return np.vstack([ColumnarFile(fname).read(variable) for fname in fnames])
+
+
+def read_region(index_fname, variable):
+    """ read one variable from every cell of a regional run (gday -r).
+
+    Parameters:
+    ----------
+    index_fname : string
+        the <cell list>.index.csv written at the end of the run
+    variable : string
+        name of the output variable
+
+    Returns:
+    -------
+    ids : list
+        cell ids, in the order of the cell list
+    data : array
+        (ncells, nrows), one row per cell
+    """
+    ids = []
+    fnames = []
+    with open(index_fname) as f:
+        f.readline()
+        for line in f:
+            (cell_id, rank, seconds, fname) = line.rstrip("\n").split(",", 3)
+            ids.append(cell_id)
+            fnames.append(fname)
+
+    return ids, read_ensemble(fnames, variable)
+
+
+if __name__ == "__main__":
+
+    if len(sys.argv) < 2:
+        sys.stderr.write("usage: %s file [variable ...]\n" % sys.argv[0])
+        sys.exit(1)
+
+    f = ColumnarFile(sys.argv[1])
+    names = sys.argv[2:] or f.names
+    print("%d records, %d chunks" % (f.nrows, len(f.first_row)))
+    for name in names:
+        x = f.read(name)
+        print("%-32s %-14s mean %g" % (name, f.units[f.names.index(name)],
+                                       np.nanmean(x)))
@@ -0,0 +1,193 @@
+/* ============================================================================
+* Batch driver: run many G'DAY simulations from a manifest inside a single
+* process, spread across a pool of worker threads.
+*
+* The manifest is a plain text file with one simulation per line, e.g.
+*
+*   # cfg file                                    mode
+*   params/NCEAS_DUKE_model_youngforest_amb.cfg
+*   params/NCEAS_DUKE_model_spinup_amb.cfg         spinup
+*
+* Each .cfg carries its own met_fname/out_fname etc, so a line is all that is
+* needed to describe a site. Blank lines and lines starting with '#' are
+* ignored.
+*
+* NOTES:
+*   Every job gets its own simulation context (see sim_context.c), the
+*   only shared objects are the work queue and the met forcing, which is
+*   loaded once per file and shared read-only (see met_cache.c). Errors
+*   inside a simulation still exit the process, as they would for a single
+*   run.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "batch.h"
+
+void run_batch(char **argv, char *manifest_fname, int num_threads) {
+    /*
+        Read the manifest and hand the simulations out to a pool of threads
+
+        Parameters:
+        -----------
+        manifest_fname : char
+            file listing the .cfg files to run
+        num_threads : int
+            number of worker threads, <= 0 means one per core
+    */
+    int        i;
+    batch_job *jobs = NULL;
+    pthread_t *threads = NULL;
+    batch_queue q;
+
+    read_batch_manifest(manifest_fname, &jobs, &q.num_jobs);
+
+    if (num_threads <= 0)
+        num_threads = get_num_cores();
+    num_threads = MIN(num_threads, q.num_jobs);
+
+    if ((threads = (pthread_t *)calloc(num_threads,
+                                       sizeof(pthread_t))) == NULL) {
+        fprintf(stderr,"Error allocating space for batch threads\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* ensemble members driven by the same met file share one copy */
+    enable_met_cache();
+
+    q.argv = argv;
+    q.jobs = jobs;
+    q.next_job = 0;
+    q.num_done = 0;
+    pthread_mutex_init(&q.lock, NULL);
+
+    fprintf(stderr, "Batch: %d simulations on %d threads\n", q.num_jobs,
+            num_threads);
+
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, batch_worker, &q) != 0) {
+            fprintf(stderr, "Error creating batch worker thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&q.lock);
+    flush_met_cache();
+    free(threads);
+    free(jobs);
+
+    return;
+}
+
+void *batch_worker(void *arg) {
+    /*
+        Keep pulling the next simulation off the queue until it is empty
+    */
+    batch_queue *q = (batch_queue *)arg;
+    batch_job   *job;
+    int          job_idx, num_done;
+
+    while (TRUE) {
+        pthread_mutex_lock(&q->lock);
+        job_idx = q->next_job++;
+        pthread_mutex_unlock(&q->lock);
+
+        if (job_idx >= q->num_jobs)
+            break;
+        job = &(q->jobs[job_idx]);
+
+        simulate_site(q->argv, job->cfg_fname, job->spin_up);
+
+        pthread_mutex_lock(&q->lock);
+        num_done = ++q->num_done;
+        pthread_mutex_unlock(&q->lock);
+
+        fprintf(stderr, "Batch: finished %s (%d/%d)\n", job->cfg_fname,
+                num_done, q->num_jobs);
+    }
+
+    return (NULL);
+}
+
+void read_batch_manifest(char *fname, batch_job **jobs, int *num_jobs) {
+    /*
+        Parse the manifest, one .cfg file (+ optional mode) per line
+
+        Returns:
+        --------
+        jobs : batch_job
+            array of simulations to run
+        num_jobs : int
+            number of simulations in the manifest
+    */
+    FILE  *fp;
+    char   line[STRING_LENGTH], mode[STRING_LENGTH], *start;
+    int    line_number = 0, nalloc = 16, nread;
+    batch_job *job;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "Error: couldn't open batch manifest %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((*jobs = (batch_job *)calloc(nalloc, sizeof(batch_job))) == NULL) {
+        fprintf(stderr,"Error allocating space for batch jobs\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *num_jobs = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line_number++;
+        start = lskip(rstrip(line));
+        if (*start == '\0' || *start == '#')
+            continue;
+
+        if (*num_jobs == nalloc) {
+            nalloc *= 2;
+            *jobs = (batch_job *)realloc(*jobs, nalloc * sizeof(batch_job));
+            if (*jobs == NULL) {
+                fprintf(stderr,"Error allocating space for batch jobs\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        job = &((*jobs)[*num_jobs]);
+
+        nread = sscanf(start, "%1999s %1999s", job->cfg_fname, mode);
+        if (nread == 1) {
+            job->spin_up = FALSE;
+        } else if (nread == 2 && (strcasecmp(mode, "spinup") == 0 ||
+                                  strcasecmp(mode, "spin_up") == 0)) {
+            job->spin_up = TRUE;
+        } else if (nread == 2 && strcasecmp(mode, "run") == 0) {
+            job->spin_up = FALSE;
+        } else {
+            fprintf(stderr, "%s: badly formatted batch manifest on line %d\n",
+                    fname, line_number);
+            exit(EXIT_FAILURE);
+        }
+        (*num_jobs)++;
+    }
+    fclose(fp);
+
+    if (*num_jobs == 0) {
+        fprintf(stderr, "Error: no simulations found in batch manifest %s\n",
+                fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+int get_num_cores(void) {
+    /* Number of online processors, used as the default pool size */
+    long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (ncores < 1 ? 1 : (int)ncores);
+}
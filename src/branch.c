@@ -0,0 +1,294 @@
+/* ============================================================================
+* Scenario branching: run the shared history of several experiments once,
+* then fork them at a treatment year.
+*
+*   $ gday -p trunk.cfg -branch scenarios.txt -at 2000 -j 4
+*
+* runs trunk.cfg (with any -set) up to the start of 2000 and then continues
+* every scenario in scenarios.txt from there, in parallel. The scenario
+* list has the layout of a region cell list (see region.c), one scenario
+* per line with its own overrides, e.g.
+*
+*   *       files.out_fname=outputs/%c.csv
+*   amb
+*   fire    control.disturbance=true params.burn_specific_yr=2003
+*   ele     files.met_fname=met_data/DUKE_met_data_ele_co2.csv
+*
+* A scenario names a .cfg only if it differs from the trunk's. Overrides
+* of [control] and [files] keys (a different met file, disturbance or
+* hurricane settings, outputs...) take effect from the branch year, as
+* do [params] overrides, which replace the trunk's value of that parameter
+* at the branch. [state] overrides replace the trunk's state at the branch.
+* Everything else carries on from the trunk exactly, so a scenario with no
+* overrides gives the same answer as the trunk running straight through.
+*
+* The trunk's outputs (daily file or final state) hold the years before
+* the branch, each scenario's hold the years from it on.
+*
+* NOTES:
+*   The snapshot is just the trunk's state, params and fluxes plus the
+*   running mean of growth stress and where it was in the forcing, a few
+*   KB. The forcing itself isn't copied: scenarios on the trunk's met file
+*   share its copy (see met_cache.c), only a scenario with its own met
+*   file reads one, and that file must cover the same days.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "branch.h"
+#include "param_table.h"
+#include "water_balance.h"
+#include "met_stream.h"
+
+static double next_sim_year(sim_context *sc) {
+    /* calendar year sim_step will run next */
+    control    *c = sc->c;
+    met_arrays *ma = sc->ma;
+
+    if (c->sub_daily) {
+        if (ma->stream != NULL)
+            advance_met_stream(ma, c->hour_idx);
+        return (ma->year[c->hour_idx - ma->row0]);
+    }
+
+    return (ma->year[c->day_idx]);
+}
+
+void run_branches(char **argv, char *cfg_fname, char *branch_fname,
+                  int branch_year, int num_threads) {
+    /*
+        Run the trunk to the branch year, then every scenario on from there
+
+        Parameters:
+        -----------
+        cfg_fname : char
+            the trunk's .cfg
+        branch_fname : char
+            the scenario list
+        branch_year : int
+            calendar year the scenarios start at
+        num_threads : int
+            worker threads, <= 0 means one per core
+    */
+    int          i;
+    sim_context *trunk;
+    branch_point bp;
+    branch_queue q;
+    pthread_t   *threads = NULL;
+
+    read_region_cells(branch_fname, cfg_fname, &q.scenarios,
+                      &q.num_scenarios);
+    for (i = 0; i < q.num_scenarios; i++) {
+        if (q.scenarios[i].spin_up) {
+            fprintf(stderr, "Error: scenario %s can't be a spin-up\n",
+                    q.scenarios[i].id);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* scenarios on the trunk's forcing share its copy */
+    enable_met_cache();
+
+    trunk = new_sim_context(argv, cfg_fname, FALSE);
+    strcpy(trunk->c->run_label, "trunk");
+    sim_init(trunk);
+    while (trunk->nyr < trunk->c->num_years &&
+           next_sim_year(trunk) < branch_year) {
+        while (sim_step(trunk) && trunk->doy != 0)
+            ;
+    }
+    if (trunk->nyr >= trunk->c->num_years) {
+        fprintf(stderr, "Error: the met forcing ends before the branch year "
+                "%d\n", branch_year);
+        exit(EXIT_FAILURE);
+    }
+    if (next_sim_year(trunk) != branch_year) {
+        fprintf(stderr, "Error: the met forcing has no year %d to branch "
+                "at\n", branch_year);
+        exit(EXIT_FAILURE);
+    }
+    take_branch_point(trunk, &bp);
+    /* the trunk's outputs end here, it is only kept for its forcing */
+    sim_finish(trunk);
+
+    if (num_threads <= 0)
+        num_threads = get_num_cores();
+    num_threads = MIN(num_threads, q.num_scenarios);
+    if ((threads = (pthread_t *)calloc(num_threads,
+                                       sizeof(pthread_t))) == NULL) {
+        fprintf(stderr,"Error allocating space for branch threads\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(stderr, "Branch: %d scenarios from %d (year %d of %d) on %d "
+            "threads\n", q.num_scenarios, branch_year, bp.nyr + 1,
+            bp.num_years, num_threads);
+
+    q.argv = argv;
+    q.next = 0;
+    q.bp = &bp;
+    pthread_mutex_init(&q.lock, NULL);
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, branch_worker, &q) != 0) {
+            fprintf(stderr, "Error creating branch worker thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&q.lock);
+
+    free_sim_context(trunk);
+    flush_met_cache();
+    sma_free(&(bp.hw));
+    free_region_cells(q.scenarios, q.num_scenarios);
+    free(threads);
+
+    return;
+}
+
+void *branch_worker(void *arg) {
+    /* Keep taking the next scenario until there are none left */
+    branch_queue *q = (branch_queue *)arg;
+    int           idx;
+
+    while (TRUE) {
+        pthread_mutex_lock(&q->lock);
+        idx = q->next++;
+        pthread_mutex_unlock(&q->lock);
+
+        if (idx >= q->num_scenarios)
+            break;
+        simulate_scenario(q->argv, &(q->scenarios[idx]), q->bp);
+        fprintf(stderr, "Branch: finished scenario %s\n",
+                q->scenarios[idx].id);
+    }
+
+    return (NULL);
+}
+
+void simulate_scenario(char **argv, region_cell *scenario, branch_point *bp) {
+    /* Set up a scenario as a run of its own, then carry on from bp */
+    sim_context *sc;
+
+    sc = new_sim_context_with(argv, scenario->cfg_fname, FALSE,
+                              scenario->overrides, scenario->num_overrides);
+    strncpy0(sc->c->run_label, scenario->id, sizeof(sc->c->run_label));
+    sim_init(sc);
+    graft_branch_point(sc, bp);
+    while (sim_step(sc)) {
+        ;
+    }
+    sim_finish(sc);
+    free_sim_context(sc);
+
+    return;
+}
+
+void take_branch_point(sim_context *sc, branch_point *bp) {
+    /* Snapshot a run that sits at the start of a year */
+    control *c = sc->c;
+
+    bp->s = *(sc->s);
+    bp->p = *(sc->p);
+    bp->f = *(sc->f);
+
+    bp->hw = sc->hw;
+    if ((bp->hw.values = (double *)malloc(sc->hw.capacity *
+                                          sizeof(double))) == NULL) {
+        fprintf(stderr,"Error allocating space for branch point\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(bp->hw.values, sc->hw.values, sc->hw.capacity * sizeof(double));
+
+    bp->nyr = sc->nyr;
+    bp->day_idx = c->day_idx;
+    bp->hour_idx = c->hour_idx;
+    bp->num_years = c->num_years;
+    bp->total_num_days = c->total_num_days;
+    bp->sub_daily = c->sub_daily;
+
+    return;
+}
+
+void graft_branch_point(sim_context *sc, branch_point *bp) {
+    /*
+        Carry a scenario, just through sim_init, on from the branch point.
+        Its own sim_init has opened its outputs and set up its disturbance
+        years, tables etc. from its own options; only the model state and
+        where we are in the forcing come from the trunk.
+    */
+    control           *c = sc->c;
+    params             fresh;
+    const param_field *field;
+    char               section[STRING_LENGTH], name[STRING_LENGTH];
+    char               key[STRING_LENGTH];
+    char              *ovr, *dot, *eq;
+    size_t             size;
+    int                i, num_params = 0;
+
+    if (c->sub_daily != bp->sub_daily || c->num_years != bp->num_years ||
+        c->total_num_days != bp->total_num_days) {
+        fprintf(stderr, "Error: %s doesn't cover the same days as the "
+                "trunk's met forcing\n", c->met_fname);
+        exit(EXIT_FAILURE);
+    }
+
+    /* the scenario's parameters as its sim_init left them, i.e. with its
+       overrides in daily units */
+    fresh = *(sc->p);
+    *(sc->s) = bp->s;
+    *(sc->p) = bp->p;
+    *(sc->f) = bp->f;
+
+    for (i = 0; i < c->num_run_overrides; i++) {
+        ovr = c->run_overrides[i];
+        dot = strchr(ovr, '.');
+        eq = strchr(ovr, '=');
+        if (dot == NULL || eq == NULL || dot > eq ||
+            (size_t)(dot - ovr) >= sizeof(section) ||
+            (size_t)(eq - dot) > sizeof(name))
+            continue;
+        strncpy0(section, ovr, dot - ovr + 1);
+        strncpy0(name, dot + 1, eq - dot);
+        if ((field = find_param_field(section, name)) == NULL)
+            continue;
+
+        if (field->base == PARAM_PARAMS) {
+            if (field->type == PARAM_DOUBLE)
+                size = sizeof(double);
+            else if (field->type == PARAM_INT)
+                size = sizeof(int);
+            else if (field->type == PARAM_LONG)
+                size = sizeof(long);
+            else
+                size = STRING_LENGTH;
+            memcpy((char *)sc->p + field->offset,
+                   (char *)&fresh + field->offset, size);
+            num_params++;
+        } else if (field->base == PARAM_STATE) {
+            strncpy0(key, ovr, MIN(eq - ovr + 1, (long)sizeof(key)));
+            set_param(c, sc->p, sc->s, key, eq + 1);
+        }
+    }
+    /* soil water capacities follow from the soil parameters */
+    if (num_params > 0)
+        initialise_soil_moisture_parameters(c, sc->p);
+
+    sma_reset(&(sc->hw), bp->hw.period);
+    memcpy(sc->hw.values, bp->hw.values, bp->hw.period * sizeof(double));
+    sma_restore(&(sc->hw), bp->hw.period, bp->hw.lv, bp->hw.sma,
+                bp->hw.sum);
+
+    sc->nyr = bp->nyr;
+    sc->doy = 0;
+    c->day_idx = bp->day_idx;
+    c->hour_idx = bp->hour_idx;
+
+    return;
+}
@@ -19,6 +19,7 @@
 *
 * =========================================================================== */
 #include "canopy.h"
+#include "timing.h"
 
 void canopy(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
             params *p, state *s) {
@@ -40,68 +41,64 @@ void canopy(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
         * Dai et al. (2004) Journal of Climate, 17, 2281-2299.
         * De Pury & Farquhar (1997) PCE, 20, 537-557.
     */
-    int    hod, iter = 0, itermax = 100, dummy, sunlight_hrs;
+    int    hod, dummy, sunlight_hrs, dark = FALSE;
     double doy;
 
     /* loop through the day */
     zero_carbon_day_fluxes(f);
     zero_water_day_fluxes(f);
     sunlight_hrs = 0;
-    doy = ma->doy[c->hour_idx];
+    doy = ma->doy[c->hour_idx - ma->row0];
+    cw->leaf_solves = 0;
+    cw->leaf_iter_sum = 0;
+    cw->leaf_iter_max = 0;
+    cw->leaf_unsettled = 0;
 
     for (hod = 0; hod < c->num_hlf_hrs; hod++) {
         unpack_met_data(c, ma, m, hod);
 
-        /* calculates diffuse frac from half-hourly incident radiation */
-        calculate_solar_geometry(cw, p, doy, hod);
-        get_diffuse_frac(cw, doy, m->sw_rad);
+        get_solar_geometry(cw, p, doy, hod);
 
         /* Is the sun up? */
         if (cw->elevation > 0.0 && m->par > 20.0) {
+            /* calculates diffuse frac from half-hourly incident radiation */
+            get_diffuse_frac(cw, doy, m->sw_rad);
             calculate_absorbed_radiation(cw, p, s, m->par);
             calculate_top_of_canopy_leafn(cw, p, s);
             calc_leaf_to_canopy_scalar(cw, p);
 
-            /* sunlit / shaded loop */
+            /* initialise values of Tleaf, Cs, dleaf at the leaf surface */
             for (cw->ileaf = 0; cw->ileaf < NUM_LEAVES; cw->ileaf++) {
-
-                /* initialise values of Tleaf, Cs, dleaf at the leaf surface */
                 initialise_leaf_surface(cw, m);
+            }
 
-                /* Leaf temperature loop */
-                while (TRUE) {
-
-                    if (c->ps_pathway == C3) {
-                        photosynthesis_C3(c, cw, m, p, s);
-                    } else {
-                        /* Nothing implemented */
-                        fprintf(stderr, "C4 photosynthesis not implemented\n");
-                        exit(EXIT_FAILURE);
-                    }
-
-                    if (cw->an_leaf[cw->ileaf] > 1E-04) {
-                        /* Calculate new Cs, dleaf, Tleaf */
-                        solve_leaf_energy_balance(c, cw, f, m, p, s);
-
-
-                    } else {
-                        break;
-                    }
-
-                    if (iter >= itermax) {
-                        fprintf(stderr, "No convergence in canopy loop:\n");
-                        exit(EXIT_FAILURE);
-                    } else if (fabs(cw->tleaf[cw->ileaf] - cw->tleaf_new) < 0.02) {
-                        break;
-                    }
-
-                    /* Update temperature & do another iteration */
-                    cw->tleaf[cw->ileaf] = cw->tleaf_new;
-                    iter++;
-                } /* end of leaf temperature loop */
-            } /* end of sunlit/shaded leaf loop */
+            /* Leaf temperature loop */
+            if (c->leaf_kernel == LEAF_KERNEL_BATCH && c->ps_pathway == C3) {
+                /* both leaves in lockstep through the batched kernel */
+                solve_leaf_temperatures_batch(c, cw, f, m, p, s, doy, hod);
+            } else {
+                /* sunlit / shaded loop */
+                for (cw->ileaf = 0; cw->ileaf < NUM_LEAVES; cw->ileaf++) {
+                    solve_leaf_temperature(c, cw, f, m, p, s, doy, hod);
+                }
+            }
+            scale_leaf_to_canopy(cw);
+            sum_hourly_carbon_fluxes(cw, f, p);
+            calculate_water_balance(c, f, m, p, s, dummy, cw->trans_canopy,
+                                    cw->omega_canopy, cw->rnet_canopy);
+            dark = FALSE;
         } else {
-            zero_hourly_fluxes(cw);
+            /*
+             * Night, or too dark to photosynthesise: every leaf and canopy
+             * flux is zero, and already is if the last half-hour was dark
+             * too. Adding zeros changes none of the day's carbon sums, so
+             * only the water balance is left to do.
+             */
+            if (dark == FALSE) {
+                zero_hourly_fluxes(cw);
+                scale_leaf_to_canopy(cw);
+                dark = TRUE;
+            }
 
             /* set tleaf to tair during the night */
             cw->tleaf[SUNLIT] = m->tair;
@@ -115,16 +112,22 @@ void canopy(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
                 calc_soil_water_potential(c, p, s);
                 /*printf("%lf %.10lf\n", s->wtfac_root, s->psi_s_root );*/
             }
-
+            calculate_water_balance_night(c, f, m, p, s);
         }
-        scale_leaf_to_canopy(cw);
-        sum_hourly_carbon_fluxes(cw, f, p);
-        calculate_water_balance(c, f, m, p, s, dummy, cw->trans_canopy,
-                                cw->omega_canopy, cw->rnet_canopy);
 
         c->hour_idx++;
         sunlight_hrs++;
     } /* end of hour loop */
+    COUNT_EVENTS(COUNTER_LEAF_SOLVES, cw->leaf_solves);
+    COUNT_EVENTS(COUNTER_LEAF_ITER, cw->leaf_iter_sum);
+
+    if (c->print_leaf_iter && cw->leaf_solves > 0) {
+        fprintf(stderr, "Leaf temperature iterations: year %d doy %d "
+                "mean %.2f max %d (%d leaves, %d unsettled)\n",
+                (int)ma->year[c->hour_idx - ma->row0 - 1], (int)doy,
+                (double)cw->leaf_iter_sum / cw->leaf_solves,
+                cw->leaf_iter_max, cw->leaf_solves, cw->leaf_unsettled);
+    }
 
     /* work out average omega for the day over sunlight hours */
     f->omega /= sunlight_hrs;
@@ -145,6 +148,170 @@ void canopy(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
     return;
 }
 
+void solve_leaf_temperature(control *c, canopy_wk *cw, fluxes *f, met *m,
+                            params *p, state *s, double doy, int hod) {
+    /*
+        Iterate photosynthesis and the leaf energy balance for the current
+        leaf until the leaf temperature settles (to within 0.02 deg C).
+
+        The energy balance gives a new leaf temperature, g(Tleaf), for a
+        guess Tleaf, which is fed straight back in, starting from tair.
+        Once guesses either side of the root have been seen, any step that
+        would leave that bracket bisects it instead, so an oscillating
+        iteration still converges. When the loop exits Tleaf is the last
+        guess and the leaf fluxes were calculated at it.
+
+        A leaf that hasn't settled after LEAF_ITER_MAX iterations is given
+        its best guess so far, with a warning, rather than stopping the run.
+    */
+    leaf_iteration li = {0};
+
+    do {
+        /* ps_pathway, C3 only (see resolve_model_options) */
+        c->kernels->leaf_photosynthesis(c, cw, m, p, s);
+    } while (update_leaf_temperature(c, cw, f, m, p, s, &li, doy, hod) == FALSE);
+
+    finish_leaf_temperature(cw, &li);
+
+    return;
+}
+
+void solve_leaf_temperatures_batch(control *c, canopy_wk *cw, fluxes *f,
+                                   met *m, params *p, state *s, double doy,
+                                   int hod) {
+    /*
+        solve_leaf_temperature for the sunlit and shaded leaves together.
+        Each pass evaluates photosynthesis for every leaf that is still
+        iterating with one call to photosynthesis_C3_batch and then updates
+        those leaves' temperatures one by one. The leaves don't interact, so
+        each follows exactly the sequence of guesses it would on its own.
+    */
+    int            i, idx, num_active;
+    int            active[NUM_LEAVES];
+    leaf_iteration li[NUM_LEAVES] = {{0}};
+    leaf_batch     lb;
+
+    num_active = NUM_LEAVES;
+    for (idx = 0; idx < NUM_LEAVES; idx++) {
+        active[idx] = idx;
+    }
+
+    while (num_active > 0) {
+        lb.n = num_active;
+        for (i = 0; i < num_active; i++) {
+            idx = active[i];
+            lb.tleaf[i] = cw->tleaf[idx];
+            lb.par[i] = cw->apar_leaf[idx];
+            lb.Cs[i] = cw->Cs[idx];
+            lb.dleaf[i] = cw->dleaf[idx];
+            lb.cscalar[i] = cw->cscalar[idx];
+            lb.N0[i] = cw->N0;
+            lb.wtfac_root[i] = s->wtfac_root;
+        }
+
+        photosynthesis_C3_batch(c, p, &lb);
+
+        /* unpack and move each leaf on, dropping the ones that finished */
+        num_active = 0;
+        for (i = 0; i < lb.n; i++) {
+            idx = active[i];
+            cw->an_leaf[idx] = lb.an[i];
+            cw->gsc_leaf[idx] = lb.gsc[i];
+            if (lb.limited[i] == FALSE)
+                cw->rd_leaf[idx] = lb.rd[i];
+
+            cw->ileaf = idx;
+            if (update_leaf_temperature(c, cw, f, m, p, s, &li[idx], doy,
+                                        hod)) {
+                finish_leaf_temperature(cw, &li[idx]);
+            } else {
+                active[num_active++] = idx;
+            }
+        }
+    }
+
+    return;
+}
+
+int update_leaf_temperature(control *c, canopy_wk *cw, fluxes *f, met *m,
+                            params *p, state *s, leaf_iteration *li,
+                            double doy, int hod) {
+    /*
+        One step of the leaf temperature iteration for the current leaf,
+        given the leaf fluxes at its current temperature guess.
+
+        Returns:
+        --------
+        finished : int
+            TRUE once the leaf temperature has settled (or the leaf isn't
+            photosynthesising), otherwise the leaf needs photosynthesis
+            evaluating again at the new guess in cw->tleaf
+    */
+    int    idx = cw->ileaf;
+    double t_curr, h_curr;
+
+    if (cw->an_leaf[idx] > 1E-04) {
+        /* Calculate new Cs, dleaf, Tleaf */
+        solve_leaf_energy_balance(c, cw, f, m, p, s);
+    } else {
+        return (TRUE);
+    }
+
+    t_curr = cw->tleaf[idx];
+    h_curr = cw->tleaf_new[idx] - t_curr;
+    if (li->last || fabs(h_curr) < 0.02) {
+        return (TRUE);
+    }
+
+    /* keep the best guess and the bracket on the root of g(Tleaf) - Tleaf */
+    if (li->iter == 0 || fabs(h_curr) < fabs(li->h_best)) {
+        li->t_best = t_curr;
+        li->h_best = h_curr;
+    }
+    if (h_curr < 0.0) {
+        li->t_neg = t_curr;
+        li->have_neg = TRUE;
+    } else if (h_curr > 0.0) {
+        li->t_pos = t_curr;
+        li->have_pos = TRUE;
+    }
+    if (li->have_neg && li->have_pos && fabs(li->t_pos - li->t_neg) < 0.02) {
+        /* the root (or a jump in g) is pinned to within the tolerance */
+        return (TRUE);
+    }
+    li->iter++;
+
+    if (li->iter >= LEAF_ITER_MAX || isnan(h_curr) || isinf(h_curr)) {
+        /* give up and evaluate the fluxes once more at the best guess */
+        fprintf(stderr, "No convergence in canopy loop: doy %d, hod %d, "
+                "leaf %d, Tleaf %f, new Tleaf %f, using Tleaf %f\n",
+                (int)doy, hod, idx, t_curr, cw->tleaf_new[idx], li->t_best);
+        cw->leaf_unsettled++;
+        cw->tleaf[idx] = li->t_best;
+        li->last = TRUE;
+        return (FALSE);
+    }
+
+    /* Update temperature & do another iteration */
+    cw->tleaf[idx] = cw->tleaf_new[idx];
+    if (li->have_neg && li->have_pos &&
+        (cw->tleaf[idx] - li->t_neg) * (cw->tleaf[idx] - li->t_pos) >= 0.0) {
+        /* step leaves the bracket: bisect */
+        cw->tleaf[idx] = 0.5 * (li->t_neg + li->t_pos);
+    }
+
+    return (FALSE);
+}
+
+void finish_leaf_temperature(canopy_wk *cw, leaf_iteration *li) {
+    /* Count the current leaf's iterations */
+    cw->leaf_solves++;
+    cw->leaf_iter_sum += li->iter + 1;
+    cw->leaf_iter_max = MAX(cw->leaf_iter_max, li->iter + 1);
+
+    return;
+}
+
 void solve_leaf_energy_balance(control *c, canopy_wk *cw, fluxes *f, met *m,
                               params *p, state *s) {
     /*
@@ -163,7 +330,8 @@ void solve_leaf_energy_balance(control *c, canopy_wk *cw, fluxes *f, met *m,
 
     idx = cw->ileaf;
     sw_rad = cw->apar_leaf[idx] * PAR_2_SW; /* W m-2 */
-    cw->rnet_leaf[idx] = calc_leaf_net_rad(p, s, m->tair, m->vpd, sw_rad);
+    cw->rnet_leaf[idx] = calc_leaf_net_rad(p, s, m->derived.net_lw,
+                                           sw_rad);
     penman_leaf_wrapper(m, p, s, cw->tleaf[idx], cw->rnet_leaf[idx],
                         cw->gsc_leaf[idx], &transpiration, &LE, &gbc, &gh, &gv,
                         &omega);
@@ -176,23 +344,35 @@ void solve_leaf_energy_balance(control *c, canopy_wk *cw, fluxes *f, met *m,
      * calculate new Cs, dleaf & tleaf
      */
     Tdiff = (cw->rnet_leaf[idx] - LE) / (CP * MASS_AIR * gh);
-    cw->tleaf_new = m->tair + Tdiff / 4.0;
-    cw->Cs = m->Ca - cw->an_leaf[idx] / gbc;
-    cw->dleaf = cw->trans_leaf[idx] * m->press / gv;
+    cw->tleaf_new[idx] = m->tair + Tdiff / 4.0;
+    cw->Cs[idx] = m->Ca - cw->an_leaf[idx] / gbc;
+    cw->dleaf[idx] = cw->trans_leaf[idx] * m->press / gv;
 
     return;
 }
 
-double calc_leaf_net_rad(params *p, state *s, double tair, double vpd,
+double calc_leaf_net_rad(params *p, state *s, double net_lw_rad,
                          double sw_rad) {
-
-    double rnet, Tk, ea, emissivity_atm, net_lw_rad;
+    /*
+        net_lw_rad is the isothermal net LW loss for the timestep, see
+        calc_isothermal_net_lw
+    */
+    double rnet;
     /*
         extinction coefficient for diffuse radiation and black leaves
         (m2 ground m2 leaf)
     */
     double kd = 0.8;
 
+    rnet = p->leaf_abs * sw_rad - net_lw_rad * kd * exp(-kd * s->lai);
+
+    return (rnet);
+}
+
+double calc_isothermal_net_lw(double tair, double vpd) {
+
+    double Tk, ea, emissivity_atm, net_lw_rad;
+
     /* isothermal net LW radiaiton at top of canopy, assuming emissivity of
        the canopy is 1 */
     Tk = tair + DEG_TO_KELVIN;
@@ -209,9 +389,8 @@ double calc_leaf_net_rad(params *p, state *s, double tair, double vpd,
     emissivity_atm = 0.642 * pow((ea / Tk), (1.0 / 7.0));
 
     net_lw_rad = (1.0 - emissivity_atm) * SIGMA * pow(Tk, 4.0);
-    rnet = p->leaf_abs * sw_rad - net_lw_rad * kd * exp(-kd * s->lai);
 
-    return (rnet);
+    return (net_lw_rad);
 }
 
 void zero_carbon_day_fluxes(fluxes *f) {
@@ -307,8 +486,8 @@ void sum_hourly_carbon_fluxes(canopy_wk *cw, fluxes *f, params *p) {
 void initialise_leaf_surface(canopy_wk *cw, met *m) {
     /* initialise values of Tleaf, Cs, dleaf at the leaf surface */
     cw->tleaf[cw->ileaf] = m->tair;
-    cw->dleaf = m->vpd;
-    cw->Cs = m->Ca;
+    cw->dleaf[cw->ileaf] = m->vpd;
+    cw->Cs[cw->ileaf] = m->Ca;
 }
 
 void calc_leaf_to_canopy_scalar(canopy_wk *cw, params *p) {
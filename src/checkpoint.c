@@ -0,0 +1,260 @@
+/* ============================================================================
+* Checkpoint/restart of a simulation.
+*
+* write_final_state only writes the [state] block back out as text, which
+* loses precision and everything in flight (the stress running mean, the
+* phenology arrays, where we are in the met forcing). A checkpoint is the
+* full binary state, params and fluxes plus the running mean, disturbance
+* years, random stream and simulation cursor, e.g. in the .cfg
+*
+*   [files]
+*   checkpoint_fname = outputs/site.ckp
+*   restart_fname = outputs/site.ckp
+*
+*   [control]
+*   checkpoint_interval = 10
+*   restart_mode = resume
+*
+* writes a checkpoint every 10 years (and at the end of a spin-up) and
+* picks a run back up where the checkpoint left it. With restart_mode =
+* state only the state and running mean are taken from the checkpoint,
+* so a spun up state can be reused for many experiments.
+*
+* NOTES:
+*   Checkpoints are written at the end of a year, to a temporary file that
+*   is then renamed, so a job killed mid-write leaves the previous one
+*   intact. On resuming, the daily output file is cut back to what had
+*   been written when the checkpoint was taken and appended to.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "checkpoint.h"
+#include "output_writer.h"
+#include "columnar.h"
+
+void write_checkpoint(sim_context *sc, char *fname, int daily_rates) {
+    /*
+        Dump the simulation to fname.
+
+        Parameters:
+        -----------
+        daily_rates : int
+            TRUE if the param rate constants are currently in d-1, i.e. we
+            are between sim_init and sim_finish
+    */
+    FILE              *fp;
+    control           *c = sc->c;
+    checkpoint_header  hdr;
+    char               tmp_fname[STRING_LENGTH+4];
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic));
+    hdr.byte_order = CHECKPOINT_BYTE_ORDER;
+    hdr.version = CHECKPOINT_VERSION;
+    hdr.state_size = sizeof(state);
+    hdr.params_size = sizeof(params);
+    hdr.fluxes_size = sizeof(fluxes);
+    hdr.sub_daily = c->sub_daily;
+    hdr.daily_rates = daily_rates;
+    hdr.nyr = sc->nyr;
+    hdr.day_idx = c->day_idx;
+    hdr.hour_idx = c->hour_idx;
+    hdr.rng_state = c->rng_state;
+    hdr.num_disturbance_yrs = sc->num_disturbance_yrs;
+
+    hdr.out_offset = -1;
+    if (c->print_options == DAILY && c->spin_up == FALSE && c->ofp != NULL) {
+        if (sc->writer != NULL)
+            drain_output_writer(sc->writer);
+        if (sc->columns != NULL)
+            flush_column_chunk(sc->columns);
+        fflush(c->ofp);
+        hdr.out_offset = ftell(c->ofp);
+    }
+
+    if (sc->hw.values != NULL) {
+        hdr.sma_period = sc->hw.period;
+        hdr.sma_lv = sc->hw.lv;
+        hdr.sma = sc->hw.sma;
+        hdr.sma_sum = sc->hw.sum;
+    }
+
+    sprintf(tmp_fname, "%s.tmp", fname);
+    if ((fp = fopen(tmp_fname, "wb")) == NULL) {
+        fprintf(stderr, "Error: couldn't open checkpoint %s for write\n",
+                tmp_fname);
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        fwrite(sc->s, sizeof(state), 1, fp) != 1 ||
+        fwrite(sc->p, sizeof(params), 1, fp) != 1 ||
+        fwrite(sc->f, sizeof(fluxes), 1, fp) != 1 ||
+        (hdr.sma_period > 0 &&
+         fwrite(sc->hw.values, sizeof(double), hdr.sma_period,
+                fp) != (size_t)hdr.sma_period) ||
+        (hdr.num_disturbance_yrs > 0 &&
+         fwrite(sc->disturbance_yrs, sizeof(int), hdr.num_disturbance_yrs,
+                fp) != (size_t)hdr.num_disturbance_yrs)) {
+        fprintf(stderr, "Error writing checkpoint %s\n", tmp_fname);
+        exit(EXIT_FAILURE);
+    }
+    if (fclose(fp) != 0 || rename(tmp_fname, fname) != 0) {
+        fprintf(stderr, "Error writing checkpoint %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+void read_checkpoint_header(char *fname, checkpoint_header *hdr, FILE **fp) {
+    /* Open a checkpoint and check it was written by this build */
+
+    if ((*fp = fopen(fname, "rb")) == NULL) {
+        fprintf(stderr, "Error: couldn't open checkpoint %s for read\n",
+                fname);
+        exit(EXIT_FAILURE);
+    }
+    if (fread(hdr, sizeof(checkpoint_header), 1, *fp) != 1 ||
+        memcmp(hdr->magic, CHECKPOINT_MAGIC, sizeof(hdr->magic)) != 0) {
+        fprintf(stderr, "Error: %s is not a G'DAY checkpoint\n", fname);
+        exit(EXIT_FAILURE);
+    }
+    if (hdr->byte_order != CHECKPOINT_BYTE_ORDER ||
+        hdr->version != CHECKPOINT_VERSION ||
+        hdr->state_size != sizeof(state) ||
+        hdr->params_size != sizeof(params) ||
+        hdr->fluxes_size != sizeof(fluxes)) {
+        fprintf(stderr, "Error: checkpoint %s was written by a different "
+                "build of the model\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+void restore_checkpoint(sim_context *sc, char *fname) {
+    /*
+        Load a checkpoint into a context that has just been through
+        sim_init. With RESTART_RESUME everything is restored and the run
+        carries on from the year after the checkpoint, with RESTART_STATE
+        only the state and running mean are used and the run starts from
+        the beginning.
+    */
+    FILE              *fp;
+    control           *c = sc->c;
+    checkpoint_header  hdr;
+    params             p_saved;
+    fluxes             f_saved;
+    int                resume = (c->restart_mode == RESTART_RESUME);
+
+    read_checkpoint_header(fname, &hdr, &fp);
+
+    if (fread(sc->s, sizeof(state), 1, fp) != 1 ||
+        fread(&p_saved, sizeof(params), 1, fp) != 1 ||
+        fread(&f_saved, sizeof(fluxes), 1, fp) != 1) {
+        fprintf(stderr, "Error: checkpoint %s is truncated\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    if (hdr.sma_period > 0) {
+        if (sc->hw.values == NULL)
+            sma_init(&(sc->hw), hdr.sma_period);
+        sma_reset(&(sc->hw), hdr.sma_period);
+        if (fread(sc->hw.values, sizeof(double), hdr.sma_period,
+                  fp) != (size_t)hdr.sma_period) {
+            fprintf(stderr, "Error: checkpoint %s is truncated\n", fname);
+            exit(EXIT_FAILURE);
+        }
+        sma_restore(&(sc->hw), hdr.sma_period, hdr.sma_lv, hdr.sma,
+                    hdr.sma_sum);
+    }
+
+    if (resume) {
+        if (hdr.sub_daily != c->sub_daily || hdr.nyr > c->num_years) {
+            fprintf(stderr, "Error: checkpoint %s doesn't match the met "
+                    "forcing\n", fname);
+            exit(EXIT_FAILURE);
+        }
+
+        *(sc->p) = p_saved;
+        if (hdr.daily_rates == FALSE)
+            correct_rate_constants(sc->p, FALSE);
+        *(sc->f) = f_saved;
+
+        if (hdr.num_disturbance_yrs > 0) {
+            sc->disturbance_yrs = (int *)realloc(sc->disturbance_yrs,
+                                                 hdr.num_disturbance_yrs *
+                                                 sizeof(int));
+            if (sc->disturbance_yrs == NULL ||
+                fread(sc->disturbance_yrs, sizeof(int),
+                      hdr.num_disturbance_yrs,
+                      fp) != (size_t)hdr.num_disturbance_yrs) {
+                fprintf(stderr, "Error: checkpoint %s is truncated\n", fname);
+                exit(EXIT_FAILURE);
+            }
+            sc->num_disturbance_yrs = hdr.num_disturbance_yrs;
+        }
+
+        sc->nyr = hdr.nyr;
+        sc->doy = 0;
+        c->day_idx = hdr.day_idx;
+        c->hour_idx = hdr.hour_idx;
+        c->rng_state = hdr.rng_state;
+    }
+    fclose(fp);
+
+    fprintf(stderr, "Restarted from %s (year %d)\n", fname,
+            resume ? hdr.nyr : 0);
+
+    return;
+}
+
+void read_checkpoint_structs(char *fname, state *s, params *p, fluxes *f) {
+    /* Just the state, params & fluxes, e.g. for a finished spin-up */
+    FILE              *fp;
+    checkpoint_header  hdr;
+
+    read_checkpoint_header(fname, &hdr, &fp);
+    if (fread(s, sizeof(state), 1, fp) != 1 ||
+        fread(p, sizeof(params), 1, fp) != 1 ||
+        fread(f, sizeof(fluxes), 1, fp) != 1) {
+        fprintf(stderr, "Error: checkpoint %s is truncated\n", fname);
+        exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+
+    return;
+}
+
+void resume_output_files(control *c) {
+    /*
+        Reopen the daily output file of a resumed run, dropping anything
+        written after the checkpoint was taken
+    */
+    FILE              *fp;
+    checkpoint_header  hdr;
+
+    read_checkpoint_header(c->restart_fname, &hdr, &fp);
+    fclose(fp);
+
+    if (hdr.out_offset < 0) {
+        /* nothing written yet, start the file afresh */
+        open_daily_output_files(c);
+        return;
+    }
+
+    if ((c->ofp = fopen(c->out_fname, "r+")) == NULL ||
+        ftruncate(fileno(c->ofp), hdr.out_offset) != 0 ||
+        fseek(c->ofp, 0, SEEK_END) != 0) {
+        fprintf(stderr, "Error: couldn't reopen %s to resume\n",
+                c->out_fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
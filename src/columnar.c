@@ -0,0 +1,300 @@
+/* ============================================================================
+* Chunked columnar output.
+*
+* The CSV and raw binary outputs are row major, so pulling one variable
+* out of a few thousand ensemble members means reading every file in full.
+* Here the rows are buffered and written chunk_days at a time as one
+* contiguous (optionally compressed) block per variable, with an index at
+* the end of the file giving where every block lives. A reader only has to
+* touch the blocks of the variables it wants, see
+* scripts/read_gday_columnar.py.
+*
+*   [outputs]
+*   format = columnar
+*   chunk_days = 3650
+*   compression = zlib        ; or none
+*
+* The file layout is documented in columnar.h.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "columnar.h"
+
+
+column_file *start_column_file(control *c, FILE *fp) {
+    /*
+        Set up columnar output to fp (already open). An empty file gets the
+        file header; a non-empty one is a resumed run, whose chunks are
+        scanned to rebuild the index before appending to it.
+    */
+    column_file *cf;
+    size_t       block_len;
+
+    if ((cf = (column_file *)calloc(1, sizeof(column_file))) == NULL) {
+        fprintf(stderr, "Error allocating space for columnar output\n");
+        exit(EXIT_FAILURE);
+    }
+    cf->fp = fp;
+    cf->nvars = c->num_output_vars;
+    cf->chunk_len = c->output_chunk_len;
+    cf->compression = c->output_compression;
+
+    block_len = (size_t)cf->chunk_len * sizeof(double);
+    cf->packed_len = compressBound(block_len);
+    cf->buf = (double *)malloc(block_len * cf->nvars);
+    cf->shuffled = (unsigned char *)malloc(block_len);
+    cf->packed = (unsigned char *)malloc(cf->packed_len);
+    if (cf->buf == NULL || cf->shuffled == NULL || cf->packed == NULL) {
+        fprintf(stderr, "Error allocating space for columnar output\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) == 0)
+        write_column_file_header(c, cf);
+    else
+        scan_column_chunks(c, cf);
+
+    return (cf);
+}
+
+void write_column_file_header(control *c, column_file *cf) {
+    /* File header followed by the variable names and units */
+    column_file_header hdr;
+    char               names[COLUMN_NAME_LEN], units[COLUMN_NAME_LEN];
+    const output_var  *v;
+    int                i;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COLUMN_MAGIC, sizeof(hdr.magic));
+    hdr.byte_order = COLUMN_BYTE_ORDER;
+    hdr.version = COLUMN_VERSION;
+    hdr.nvars = cf->nvars;
+    hdr.chunk_len = cf->chunk_len;
+    hdr.compression = cf->compression;
+
+    if (fwrite(&hdr, sizeof(hdr), 1, cf->fp) != 1) {
+        fprintf(stderr, "Error writing columnar output header\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < cf->nvars; i++) {
+        memset(names, 0, sizeof(names));
+        strncpy(names, get_output_var(c->output_vars[i])->name,
+                COLUMN_NAME_LEN - 1);
+        fwrite(names, 1, COLUMN_NAME_LEN, cf->fp);
+    }
+    for (i = 0; i < cf->nvars; i++) {
+        v = get_output_var(c->output_vars[i]);
+        memset(units, 0, sizeof(units));
+        strncpy(units, v->units, COLUMN_NAME_LEN - 1);
+        fwrite(units, 1, COLUMN_NAME_LEN, cf->fp);
+    }
+
+    return;
+}
+
+void scan_column_chunks(control *c, column_file *cf) {
+    /*
+        Rebuild the index of a (truncated) columnar file from its chunk
+        headers, so a resumed run can carry on appending to it
+    */
+    column_file_header  hdr;
+    column_chunk_header chunk;
+    int64_t             nbytes[MAX_OUTPUT_VARS], offset[MAX_OUTPUT_VARS];
+    long                pos, end;
+    int                 i;
+
+    fseek(cf->fp, 0, SEEK_END);
+    end = ftell(cf->fp);
+    rewind(cf->fp);
+
+    if (fread(&hdr, sizeof(hdr), 1, cf->fp) != 1 ||
+        memcmp(hdr.magic, COLUMN_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.nvars != cf->nvars || hdr.chunk_len != cf->chunk_len ||
+        hdr.compression != cf->compression) {
+        fprintf(stderr, "Error: columnar output %s doesn't match the "
+                "[outputs] options, can't resume it\n", c->out_fname);
+        exit(EXIT_FAILURE);
+    }
+    pos = sizeof(hdr) + 2L * cf->nvars * COLUMN_NAME_LEN;
+
+    while (pos < end) {
+        fseek(cf->fp, pos, SEEK_SET);
+        if (fread(&chunk, sizeof(chunk), 1, cf->fp) != 1 ||
+            memcmp(chunk.magic, COLUMN_CHUNK_MAGIC, sizeof(chunk.magic)) != 0 ||
+            fread(nbytes, sizeof(int64_t), cf->nvars,
+                  cf->fp) != (size_t)cf->nvars) {
+            fprintf(stderr, "Error: bad chunk in columnar output %s\n",
+                    c->out_fname);
+            exit(EXIT_FAILURE);
+        }
+        pos += sizeof(chunk) + cf->nvars * sizeof(int64_t);
+        for (i = 0; i < cf->nvars; i++) {
+            offset[i] = pos;
+            pos += nbytes[i];
+        }
+        add_column_chunk(cf, chunk.first_row, chunk.nrows, offset, nbytes);
+    }
+    if (pos != end) {
+        fprintf(stderr, "Error: columnar output %s is truncated\n",
+                c->out_fname);
+        exit(EXIT_FAILURE);
+    }
+    fseek(cf->fp, 0, SEEK_END);
+
+    return;
+}
+
+void append_column_record(column_file *cf, const double *vals) {
+    /* Buffer one output record, writing the chunk out once it is full */
+    int i;
+
+    for (i = 0; i < cf->nvars; i++)
+        cf->buf[(size_t)i * cf->chunk_len + cf->nbuf] = vals[i];
+    cf->nbuf++;
+
+    if (cf->nbuf == cf->chunk_len)
+        flush_column_chunk(cf);
+
+    return;
+}
+
+void flush_column_chunk(column_file *cf) {
+    /* Write the buffered rows (if any) as a chunk, one block per variable */
+    column_chunk_header chunk;
+    int64_t             nbytes[MAX_OUTPUT_VARS], offset[MAX_OUTPUT_VARS];
+    unsigned char      *raw, *block;
+    uLongf              len;
+    long                start;
+    int                 i, j, k;
+
+    if (cf->nbuf == 0)
+        return;
+
+    memset(&chunk, 0, sizeof(chunk));
+    memcpy(chunk.magic, COLUMN_CHUNK_MAGIC, sizeof(chunk.magic));
+    chunk.nrows = cf->nbuf;
+    chunk.first_row = cf->nrows;
+
+    /* block sizes aren't known yet, they are filled in afterwards */
+    start = ftell(cf->fp);
+    memset(nbytes, 0, sizeof(nbytes));
+    fwrite(&chunk, sizeof(chunk), 1, cf->fp);
+    fwrite(nbytes, sizeof(int64_t), cf->nvars, cf->fp);
+
+    for (i = 0; i < cf->nvars; i++) {
+        raw = (unsigned char *)(cf->buf + (size_t)i * cf->chunk_len);
+        len = cf->nbuf * sizeof(double);
+
+        if (cf->compression == OUTPUT_COMPRESS_ZLIB) {
+            /* byte shuffle, the exponent bytes of nearby values match */
+            for (j = 0; j < (int)sizeof(double); j++)
+                for (k = 0; k < cf->nbuf; k++)
+                    cf->shuffled[j * cf->nbuf + k] = raw[k * sizeof(double) + j];
+
+            len = cf->packed_len;
+            if (compress2(cf->packed, &len, cf->shuffled,
+                          cf->nbuf * sizeof(double), Z_BEST_SPEED) != Z_OK) {
+                fprintf(stderr, "Error compressing columnar output\n");
+                exit(EXIT_FAILURE);
+            }
+            block = cf->packed;
+        } else {
+            block = raw;
+        }
+
+        offset[i] = ftell(cf->fp);
+        nbytes[i] = len;
+        if (fwrite(block, 1, len, cf->fp) != len) {
+            fprintf(stderr, "Error writing columnar output\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    fseek(cf->fp, start + sizeof(chunk), SEEK_SET);
+    fwrite(nbytes, sizeof(int64_t), cf->nvars, cf->fp);
+    fseek(cf->fp, 0, SEEK_END);
+
+    add_column_chunk(cf, cf->nrows, cf->nbuf, offset, nbytes);
+    cf->nbuf = 0;
+
+    return;
+}
+
+void add_column_chunk(column_file *cf, long first_row, int nrows,
+                      const int64_t *offset, const int64_t *nbytes) {
+    /* Record a written chunk in the index */
+    long n;
+
+    if (cf->nchunks == cf->max_chunks) {
+        cf->max_chunks = (cf->max_chunks == 0) ? 64 : 2 * cf->max_chunks;
+        n = cf->max_chunks;
+        cf->first_row = (int64_t *)realloc(cf->first_row, n * sizeof(int64_t));
+        cf->chunk_rows = (int64_t *)realloc(cf->chunk_rows, n * sizeof(int64_t));
+        cf->offset = (int64_t *)realloc(cf->offset,
+                                        n * cf->nvars * sizeof(int64_t));
+        cf->nbytes = (int64_t *)realloc(cf->nbytes,
+                                        n * cf->nvars * sizeof(int64_t));
+        if (cf->first_row == NULL || cf->chunk_rows == NULL ||
+            cf->offset == NULL || cf->nbytes == NULL) {
+            fprintf(stderr, "Error allocating space for columnar index\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    cf->first_row[cf->nchunks] = first_row;
+    cf->chunk_rows[cf->nchunks] = nrows;
+    memcpy(cf->offset + cf->nchunks * cf->nvars, offset,
+           cf->nvars * sizeof(int64_t));
+    memcpy(cf->nbytes + cf->nchunks * cf->nvars, nbytes,
+           cf->nvars * sizeof(int64_t));
+    cf->nchunks++;
+    cf->nrows = first_row + nrows;
+
+    return;
+}
+
+void close_column_file(column_file *cf) {
+    /*
+        Write out the last (short) chunk and the index. The file itself is
+        closed with the rest of the run's files.
+    */
+    column_file_trailer trailer;
+    long                n;
+
+    flush_column_chunk(cf);
+
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.nchunks = cf->nchunks;
+    trailer.nrows = cf->nrows;
+    trailer.index_offset = ftell(cf->fp);
+    memcpy(trailer.magic, COLUMN_INDEX_MAGIC, sizeof(trailer.magic));
+
+    n = cf->nchunks;
+    if ((n > 0 &&
+         (fwrite(cf->first_row, sizeof(int64_t), n, cf->fp) != (size_t)n ||
+          fwrite(cf->chunk_rows, sizeof(int64_t), n, cf->fp) != (size_t)n ||
+          fwrite(cf->offset, sizeof(int64_t), n * cf->nvars,
+                 cf->fp) != (size_t)(n * cf->nvars) ||
+          fwrite(cf->nbytes, sizeof(int64_t), n * cf->nvars,
+                 cf->fp) != (size_t)(n * cf->nvars))) ||
+        fwrite(&trailer, sizeof(trailer), 1, cf->fp) != 1) {
+        fprintf(stderr, "Error writing columnar output index\n");
+        exit(EXIT_FAILURE);
+    }
+
+    free(cf->buf);
+    free(cf->shuffled);
+    free(cf->packed);
+    free(cf->first_row);
+    free(cf->chunk_rows);
+    free(cf->offset);
+    free(cf->nbytes);
+    free(cf);
+
+    return;
+}
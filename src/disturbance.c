@@ -1,43 +1,47 @@
 #include "disturbance.h"
+#include "met_stream.h"
 
 
 void figure_out_years_with_disturbances(control *c, met_arrays *ma, params *p,
                                         int **yrs, int *cnt) {
+    /* Build the list of years in which a fire occurs, either the single
+    year the user asked for, or a series of events drawn from this
+    simulation's random stream (c->rng_state) */
     int nyr, year_of_disturbance, yrs_till_event, prjday, year;
 
-    if (p->burn_specific_yr < -900.0) {
-        year_of_disturbance = p->burn_specific_yr;
+    *cnt = 0;
+    if (p->burn_specific_yr > -900.0) {
         (*yrs)[0] = p->burn_specific_yr;
+        *cnt = 1;
     } else {
-        yrs_till_event = time_till_next_disturbance();
-        year = (int)ma->year[prjday];
+        yrs_till_event = time_till_next_disturbance(c, p);
         /*year_of_disturbance = year + yrs_till_event; */
         year_of_disturbance = 1996;
 
         /* figure out the years of the disturbance events  */
-        *cnt = 0;
         prjday = 0;
 
         for (nyr = 0; nyr < c->num_years - 1; nyr++) {
-            year = (int)ma->year[prjday];
+            if (ma->stream != NULL)
+                year = (int)get_met_stream_year(ma, nyr);
+            else
+                year = (int)ma->year[prjday];
             if (is_leap_year(year))
                 prjday+=366;
             else
                 prjday+=365;
 
             if (year == year_of_disturbance) {
-                yrs_till_event = time_till_next_disturbance();
+                yrs_till_event = time_till_next_disturbance(c, p);
 
-                if (*cnt == 0) {
-                    (*yrs)[0] = year_of_disturbance;
-                } else {
-                    *cnt += 1;
-                    if ((yrs = (int **)realloc(yrs, (1 + *cnt) * sizeof(int))) == NULL) {
+                if (*cnt > 0) {
+                    if ((*yrs = (int *)realloc(*yrs, (1 + *cnt) * sizeof(int))) == NULL) {
                         fprintf(stderr,"Error resizing years array\n");
                 		exit(EXIT_FAILURE);
                     }
-                    (*yrs)[*cnt] = year_of_disturbance;
                 }
+                (*yrs)[*cnt] = year_of_disturbance;
+                *cnt += 1;
 
                 /* See if there is another event? */
                 year_of_disturbance = year + yrs_till_event;
@@ -48,22 +52,30 @@ void figure_out_years_with_disturbances(control *c, met_arrays *ma, params *p,
     return;
 }
 
-int time_till_next_disturbance() {
+int time_till_next_disturbance(control *c, params *p) {
     /* calculate the number of years until a disturbance event occurs
     assuming a return interval of X years
 
     - section 3.4.1 D. Knuth, The Art of Computer Programming.
 
+    The random draw comes from the simulation's own stream, seeded from the
+    "seed" control option, so runs are reproducible and independent of any
+    other simulation running in the same process.
+
     Parameters
     ----------
     return_interval : int/float
         interval disturbance return at in years
     */
-    /* rate = 1.0 / p->return_interval; */
+    double rate;
 
-    /*return int(-log(1.0 - random.random()) / rate); */
+    if (p->return_interval <= 0) {
+        /* no return interval supplied, keep the fixed 11 yr cycle */
+        return (11);
+    }
+    rate = 1.0 / p->return_interval;
 
-    return (11);
+    return ((int)(-log(1.0 - random_uniform(&(c->rng_state))) / rate));
 }
 
 int check_for_fire(control *c, fluxes *f, params *p, state *s, int year,
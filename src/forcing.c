@@ -0,0 +1,283 @@
+/* ============================================================================
+* Forcing preprocessing.
+*
+* Day length only depends on the latitude and whether it is a leap year, and
+* the phenology drivers (growing degree days, chill days, leaf drop tests)
+* only on a year of met forcing, yet both used to be recalculated at the
+* start of every simulated year, i.e. every year of every spin-up cycle.
+* They are now worked out once, when the simulation is initialised, and the
+* year loop just looks them up.
+*
+* The same goes for the parts of the Penman-Monteith and leaf energy balance
+* that only depend on a timestep's air temperature and pressure (latent
+* heat, psychrometric constant, slope of the saturation vapour pressure
+* curve, radiation conductance and the isothermal net long-wave): these are
+* derived once per row when the forcing is read, so that every year of the
+* run, every spin-up cycle and, through the met cache, every ensemble member
+* on the same file shares them.
+*
+* AUTHOR:
+*   Martin De Kauwe
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "forcing.h"
+
+
+void preprocess_forcing(control *c, met_arrays *ma, params *p) {
+    /*
+        Build the day length tables and, for deciduous daily runs, the
+        phenology drivers for each year of the forcing. Kept with the
+        (per simulation) met_arrays, so it only happens on the first
+        sim_init; spin-up cycles find it already done.
+    */
+    met_forcing *mf = ma->forcing;
+    met_year    *my;
+    int          i, leap, row = 0;
+
+    if (mf != NULL && mf->latitude == p->latitude)
+        return;
+    free_forcing(ma);
+
+    if ((mf = (met_forcing *)calloc(1, sizeof(met_forcing))) == NULL) {
+        fprintf(stderr, "Error allocating space for forcing preprocessing\n");
+        exit(EXIT_FAILURE);
+    }
+    ma->forcing = mf;
+    mf->latitude = p->latitude;
+
+    for (leap = 0; leap < 2; leap++) {
+        calculate_daylength(365 + leap, p->latitude, mf->daylen[leap]);
+    }
+
+    if (c->deciduous_model == FALSE || c->sub_daily)
+        return;
+
+    mf->num_years = c->num_years;
+    if ((mf->years = (met_year *)calloc(c->num_years,
+                                        sizeof(met_year))) == NULL) {
+        fprintf(stderr, "Error allocating space for forcing preprocessing\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < c->num_years && row < ma->nrows; i++) {
+        my = &(mf->years[i]);
+        my->start_day = row;
+        my->num_days = is_leap_year(ma->year[row]) ? 366 : 365;
+        my->accum_gdd = (double *)calloc(my->num_days, sizeof(double));
+        my->ppt_sum = (double *)calloc(my->num_days, sizeof(double));
+        my->leaf_drop = (int *)calloc(my->num_days, sizeof(int));
+        if (my->accum_gdd == NULL || my->ppt_sum == NULL ||
+            my->leaf_drop == NULL) {
+            fprintf(stderr, "Error allocating space for phenology drivers\n");
+            exit(EXIT_FAILURE);
+        }
+        calculate_phenology_drivers(c, ma, my,
+                                    mf->daylen[my->num_days == 366]);
+        row += my->num_days;
+    }
+
+    return;
+}
+
+void calculate_phenology_drivers(control *c, met_arrays *ma, met_year *my,
+                                 double *daylen) {
+    /*
+        The met-driven part of calculate_leafon_off for one year: running
+        GDD and rain totals, the tree leaf drop test for each day, the chill
+        days accumulated from 1 Nov and the annual statistics behind the
+        grass thresholds, all from a single pass over the year
+    */
+    double Tmean, Tsoil, Tsoil_next_3days;
+    double accum_gdd = 0.0, ppt_sum = 0.0, accumulated_ncd = 0.0;
+    double tmax_ann = 0.0, tmin_ann = 70.0, tmin_sum = 0.0;
+    int    d, nov_doy, project_day = my->start_day;
+
+    if (my->num_days == 366)
+        nov_doy = 306;
+    else
+        nov_doy = 305;
+
+    for (d = 1; d < my->num_days+1; d++) {
+        Tmean = ma->tair[project_day];
+        Tsoil = ma->tsoil[project_day];
+        ppt_sum += ma->rain[project_day];
+
+        if (d < 362) {
+            Tsoil_next_3days = ((ma->tsoil[project_day] +
+                                 ma->tsoil[project_day+1] +
+                                 ma->tsoil[project_day+2]) / 3.0);
+        } else {
+            /* i.e. end of year, didn't find this so have no effect */
+            Tsoil_next_3days = 999.9;
+        }
+
+        /* Sum the daily mean air temperature above 5degC starting on Jan 1 */
+        accum_gdd += calc_gdd(Tmean);
+
+        my->accum_gdd[d-1] = accum_gdd;
+        my->ppt_sum[d-1] = ppt_sum;
+        my->leaf_drop[d-1] = leaf_drop(daylen[d-1], Tsoil, Tsoil_next_3days);
+
+        /* Calculated NCD from fixed date following Murray et al 1989. */
+        if (d+1 >= nov_doy)
+            accumulated_ncd += calc_ncd(Tmean);
+
+        /* annual extremes for the grass thresholds */
+        if (ma->tmax[project_day] > tmax_ann)
+            tmax_ann = ma->tmax[project_day];
+        if (ma->tmin[project_day] < tmin_ann)
+            tmin_ann = ma->tmin[project_day];
+        tmin_sum += ma->tmin[project_day];
+        project_day++;
+    }
+    my->ncd = accumulated_ncd;
+
+    calc_ini_grass_pheno_stuff(my->num_days, tmax_ann, tmin_ann, tmin_sum,
+                               ppt_sum, &(my->grass_temp_threshold),
+                               &(my->tmax_ann), &(my->Tmin_avg),
+                               &(my->ppt_sum_crit));
+
+    return;
+}
+
+void get_daylength(met_arrays *ma, params *p, int num_days, double *dayl) {
+    /* Fill dayl with this year's day lengths (hrs) */
+    met_forcing *mf = ma->forcing;
+
+    if (mf != NULL && mf->latitude == p->latitude &&
+        (num_days == 365 || num_days == 366))
+        memcpy(dayl, mf->daylen[num_days == 366], num_days * sizeof(double));
+    else
+        calculate_daylength(num_days, p->latitude, dayl);
+
+    return;
+}
+
+met_year *get_met_year(met_arrays *ma, int nyr) {
+    /* Phenology drivers for year nyr of the forcing, NULL if there are none */
+    met_forcing *mf = ma->forcing;
+
+    if (mf == NULL || mf->years == NULL || nyr < 0 || nyr >= mf->num_years ||
+        mf->years[nyr].accum_gdd == NULL)
+        return (NULL);
+
+    return (&(mf->years[nyr]));
+}
+
+void free_forcing(met_arrays *ma) {
+    /* Release what preprocess_forcing built */
+    met_forcing *mf = ma->forcing;
+    int          i;
+
+    if (mf == NULL)
+        return;
+
+    if (mf->years != NULL) {
+        for (i = 0; i < mf->num_years; i++) {
+            free(mf->years[i].accum_gdd);
+            free(mf->years[i].ppt_sum);
+            free(mf->years[i].leaf_drop);
+        }
+        free(mf->years);
+    }
+    free(mf);
+    ma->forcing = NULL;
+
+    return;
+}
+
+void derive_met_columns(control *c, met_arrays *ma) {
+    /*
+        Work out the derived columns for every row of a forcing that is
+        held in full. A streamed forcing only has a window of a year, so
+        its terms are worked out as each timestep is unpacked instead.
+    */
+    long i;
+    int  num_cols = c->sub_daily ? 1 : 3;
+
+    ma->derived = NULL;
+    ma->derived_am = NULL;
+    ma->derived_pm = NULL;
+    if (ma->stream != NULL)
+        return;
+
+    if ((ma->derived = (met_derived *)malloc(num_cols * ma->nrows *
+                                             sizeof(met_derived))) == NULL) {
+        fprintf(stderr, "Error allocating space for derived met columns\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (c->sub_daily) {
+        for (i = 0; i < ma->nrows; i++) {
+            calc_met_derived(ma->tair[i], ma->press[i] * KPA_2_PA,
+                             &(ma->derived[i]));
+            ma->derived[i].net_lw = calc_isothermal_net_lw(ma->tair[i],
+                                                 ma->vpd[i] * KPA_2_PA);
+        }
+    } else {
+        ma->derived_am = ma->derived + ma->nrows;
+        ma->derived_pm = ma->derived + 2 * ma->nrows;
+        for (i = 0; i < ma->nrows; i++) {
+            calc_met_derived(ma->tair[i], ma->press[i] * KPA_2_PA,
+                             &(ma->derived[i]));
+            calc_met_derived(ma->tam[i], ma->press[i] * KPA_2_PA,
+                             &(ma->derived_am[i]));
+            calc_met_derived(ma->tpm[i], ma->press[i] * KPA_2_PA,
+                             &(ma->derived_pm[i]));
+        }
+    }
+
+    return;
+}
+
+void free_met_derived(met_arrays *ma) {
+    /* the am/pm columns are part of the same block */
+    free(ma->derived);
+    ma->derived = NULL;
+    ma->derived_am = NULL;
+    ma->derived_pm = NULL;
+
+    return;
+}
+
+void calc_met_derived(double tair, double press, met_derived *md) {
+    /*
+        Temperature and pressure (Pa) dependent terms of the Penman-Monteith,
+        net_lw needs the vpd too and is left to the caller
+    */
+    md->lambda = calc_latent_heat_of_vapourisation(tair);
+    md->gamma = calc_pyschrometric_constant(press, md->lambda);
+    md->slope = calc_slope_of_sat_vapour_pressure_curve(tair);
+    md->gradn = calc_radiation_conductance(tair);
+    md->net_lw = 0.0;
+
+    return;
+}
+
+void unpack_met_derived(control *c, met_arrays *ma, met *m, long row) {
+    /* The derived terms for timestep row, m holding its unpacked forcing */
+
+    if (c->sub_daily) {
+        if (ma->derived != NULL) {
+            m->derived = ma->derived[row];
+        } else {
+            calc_met_derived(m->tair, m->press, &(m->derived));
+            m->derived.net_lw = calc_isothermal_net_lw(m->tair, m->vpd);
+        }
+    } else {
+        if (ma->derived != NULL) {
+            m->derived = ma->derived[row];
+            m->derived_am = ma->derived_am[row];
+            m->derived_pm = ma->derived_pm[row];
+        } else {
+            calc_met_derived(m->tair, m->press, &(m->derived));
+            calc_met_derived(m->tair_am, m->press, &(m->derived_am));
+            calc_met_derived(m->tair_pm, m->press, &(m->derived_pm));
+        }
+    }
+
+    return;
+}
@@ -19,436 +19,100 @@
 * =========================================================================== */
 
 #include "gday.h"
+#include "param_table.h"
+#include "branch.h"
+#include "timing.h"
+#include "forcing.h"
 
+#ifndef GDAY_LIBRARY
 int main(int argc, char **argv)
 {
-    int error = 0;
-
-    /*
-    ** Setup structures, initialise stuff, e.g. zero fluxes.
-    */
-    canopy_wk *cw;
     control *c;
-    fluxes *f;
-    met_arrays *ma;
-    met *m;
-    params *p;
-    state *s;
-
-    cw = (canopy_wk *)malloc(sizeof(canopy_wk));
-    if (cw == NULL) {
-        fprintf(stderr, "canopy wk structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
 
     c = (control *)malloc(sizeof(control));
     if (c == NULL) {
         fprintf(stderr, "control structure: Not allocated enough memory!\n");
     	exit(EXIT_FAILURE);
     }
-
-    f = (fluxes *)malloc(sizeof(fluxes));
-    if (f == NULL) {
-    	fprintf(stderr, "fluxes structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
-
-    ma = (met_arrays *)malloc(sizeof(met_arrays));
-    if (ma == NULL) {
-    	fprintf(stderr, "met arrays structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
-
-    m = (met *)malloc(sizeof(met));
-    if (m == NULL) {
-    	fprintf(stderr, "met structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
-
-    p = (params *)malloc(sizeof(params));
-    if (p == NULL) {
-    	fprintf(stderr, "params structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
-
-    s = (state *)malloc(sizeof(state));
-    if (s == NULL) {
-    	fprintf(stderr, "state structure: Not allocated enough memory!\n");
-    	exit(EXIT_FAILURE);
-    }
-
     initialise_control(c);
-    initialise_params(p);
-    initialise_fluxes(f);
-    initialise_state(s);
-
     clparser(argc, argv, c);
-    /*
-    ** Read .ini parameter file and meterological data
-    */
-    error = parse_ini_file(c, p, s);
-    if (error != 0) {
-        prog_error("Error reading .INI file on line", __LINE__);
-    }
-    strcpy(c->git_code_ver, build_git_sha);
+
     if (c->PRINT_GIT) {
-        fprintf(stderr, "\n%s\n", c->git_code_ver);
+        fprintf(stderr, "\n%s\n", build_git_sha);
         exit(EXIT_FAILURE);
     }
 
-    if (c->sub_daily)
-        read_subdaily_met_data(argv, c, ma);
-    else
-        read_daily_met_data(argv, c, ma);
-
-    if (c->spin_up)
-        spin_up_pools(cw, c, f, ma, m, p, s);
-    else
-        run_sim(cw, c, f, ma, m, p, s);
-
-    /* clean up */
-    fclose(c->ofp);
-    fclose(c->ifp);
-    if (c->output_ascii == FALSE) {
-        fclose(c->ofp_hdr);
-    }
-
-
-    free(cw);
-    free(c);
-    free(f);
-    free(ma->year);
-    free(ma->tair);
-    free(ma->rain);
-    free(ma->tsoil);
-    free(ma->co2);
-    free(ma->ndep);
-    free(ma->wind);
-    free(ma->press);
-    free(ma->par);
-    if (c->sub_daily) {
-        free(ma->vpd);
-        free(ma->doy);
+    if (c->convert_met) {
+        /* just write the CSV met forcing out as a binary file */
+        convert_met_file(argv, c->cfg_fname, c->met_bin_fname);
+    } else if (c->batch) {
+        /* many simulations listed in a manifest, shared across threads */
+        run_batch(argv, c->batch_fname, c->num_threads);
+    } else if (c->branch) {
+        /* scenarios forked from one run at the branch year */
+        if (c->branch_year < 0) {
+            fprintf(stderr, "Error: -branch needs the year to branch at, "
+                    "-at year\n");
+            exit(EXIT_FAILURE);
+        }
+        run_branches(argv, c->cfg_fname, c->branch_fname, c->branch_year,
+                     c->num_threads);
+    } else if (c->region) {
+        /* grid cells with their own overrides, across MPI ranks */
+        run_region(argv, c->region_fname, c->num_threads);
     } else {
-        free(ma->prjday);
-        free(ma->tam);
-        free(ma->tpm);
-        free(ma->tmin);
-        free(ma->tmax);
-        free(ma->vpd_am);
-        free(ma->vpd_pm);
-        free(ma->wind_am);
-        free(ma->wind_pm);
-        free(ma->par_am);
-        free(ma->par_pm);
+        simulate_site(argv, c->cfg_fname, c->spin_up);
     }
-    free(ma);
-    free(m);
-    free(p);
-    free(s);
+    free(c);
+
+#ifdef GDAY_TIMING
+    report_timing();
+#endif
 
     exit(EXIT_SUCCESS);
 }
+#endif /* GDAY_LIBRARY, libgday.c has no main */
 
-
-
-void run_sim(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
-             params *p, state *s){
-
-    int    nyr, doy, window_size, i, dummy;
-    int    fire_found = FALSE;;
-    int    num_disturbance_yrs = 0;
-
-    double fdecay, rdecay, current_limitation, nitfac, year;
-    int   *disturbance_yrs = NULL;
-
-    /* potentially allocating 1 extra spot, but will be fine as we always
-       index by num_days */
-    double *day_length = NULL;
-    if ((day_length = (double *)calloc(366, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for day_length\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if (c->deciduous_model) {
-
-        /* Are we reading in last years average growing season? */
-        if (float_eq(s->avg_alleaf, 0.0) &&
-            float_eq(s->avg_alstem, 0.0) &&
-            float_eq(s->avg_albranch, 0.0) &&
-            float_eq(s->avg_alleaf, 0.0) &&
-            float_eq(s->avg_alroot, 0.0) &&
-            float_eq(s->avg_alcroot, 0.0)) {
-            nitfac = 0.0;
-            calc_carbon_allocation_fracs(c, f, p, s, nitfac);
-        } else {
-            f->alleaf = s->avg_alleaf;
-            f->alstem = s->avg_alstem;
-            f->albranch = s->avg_albranch;
-            f->alroot = s->avg_alroot;
-            f->alcroot = s->avg_alcroot;
-        }
-        allocate_stored_c_and_n(f, p, s);
-    }
-    
-    /* Setup output file */
-    if (c->print_options == DAILY && c->spin_up == FALSE) {
-        /* Daily outputs */
-        open_output_file(c, c->out_fname, &(c->ofp));
-
-        if (c->output_ascii) {
-            write_output_header(c, &(c->ofp));
-        } else {
-            open_output_file(c, c->out_fname_hdr, &(c->ofp_hdr));
-            write_output_header(c, &(c->ofp_hdr));
-        }
-    } else if (c->print_options == END && c->spin_up == FALSE) {
-        /* Final state + param file */
-        open_output_file(c, c->out_param_fname, &(c->ofp));
-    }
-
+void simulate_site(char **argv, char *cfg_fname, int spin_up) {
     /*
-        Window size = root lifespan in days...
-        For deciduous species window size is set as the length of the
-        growing season in the main part of the code
-    */
-    window_size = (int)(1.0 / p->rdecay * NDAYS_IN_YR);
-    sma_obj *hw = sma(SMA_NEW, window_size).handle;
-    if (s->prev_sma > -900) {
-        for (i = 0; i < window_size; i++) {
-            sma(SMA_ADD, hw, s->prev_sma);
-        }
-    }
-    /* Set up SMA
-    **  - If we don't have any information about the N & water limitation, i.e.
-    **    as would be the case with spin-up, assume that there is no limitation
-    **    to begin with.
-    */
-    if (s->prev_sma < -900)
-        s->prev_sma = 1.0;
+        Run a single G'DAY simulation for the .cfg file cfg_fname.
 
-    /*
-        params are defined in per year, needs to be per day. Important this is
-        done here as rate constants elsewhere in the code are assumed to be in
-        units of days not years
+        Every model structure belongs to the simulation's own context, so
+        the batch driver can call this once per worker thread without any
+        state being shared between sites.
     */
-    correct_rate_constants(p, FALSE);
-    day_end_calculations(c, p, s, -99, TRUE);
-
-    initialise_soil_moisture_parameters(c, p);
-    s->pawater_root = p->wcapac_root;
-    s->pawater_topsoil = p->wcapac_topsoil;
-
-    if (c->fixed_lai) {
-        s->lai = p->fix_lai;
-    } else {
-        s->lai = MAX(0.01, (p->sla * M2_AS_HA / KG_AS_TONNES /
-                            p->cfracts * s->shoot));
-    }
-
-    if (c->disturbance) {
-        if ((disturbance_yrs = (int *)calloc(1, sizeof(double))) == NULL) {
-            fprintf(stderr,"Error allocating space for disturbance_yrs\n");
-    		exit(EXIT_FAILURE);
-        }
-        figure_out_years_with_disturbances(c, ma, p, &disturbance_yrs,
-                                           &num_disturbance_yrs);
-    }
-
-    /* ====================== **
-    **   Y E A R    L O O P   **
-    ** ====================== */
-    c->day_idx = 0;
-    c->hour_idx = 0;
-    for (nyr = 0; nyr < c->num_years; nyr++) {
-
-        if (c->sub_daily) {
-            year = ma->year[c->hour_idx];
-        } else {
-            year = ma->year[c->day_idx];
-        }
-        if (is_leap_year(year))
-            c->num_days = 366;
-        else
-            c->num_days = 365;
-
-        calculate_daylength(c->num_days, p->latitude, *(&day_length));
-
-        if (c->deciduous_model) {
-            phenology(c, f, ma, p, s, day_length);
-
-            /* Change window size to length of growing season */
-            sma(SMA_FREE, hw);
-            hw = sma(SMA_NEW, p->growing_seas_len).handle;
-            if (s->prev_sma > -900) {
-                for (i = 0; i < p->growing_seas_len; i++) {
-                    sma(SMA_ADD, hw, s->prev_sma);
-                }
-            }
-
-            zero_stuff(c, s);
-        }
-        /* =================== **
-        **   D A Y   L O O P   **
-        ** =================== */
-        for (doy = 0; doy < c->num_days; doy++) {
-            if (! c->sub_daily) {
-                unpack_met_data(c, ma, m, dummy);
-            }
-            calculate_litterfall(c, f, p, s, doy, &fdecay, &rdecay);
-
-            if (c->disturbance && p->disturbance_doy == doy+1) {
-                /* Fire Disturbance? */
-                fire_found = FALSE;
-                fire_found = check_for_fire(c, f, p, s, year, disturbance_yrs,
-                                            num_disturbance_yrs);
-
-                if (fire_found) {
-                    fire(c, f, p, s);
-                    sma(SMA_FREE, hw);
-                    hw = sma(SMA_NEW, p->growing_seas_len).handle;
-                }
-            } else if (c->hurricane &&
-                p->hurricane_yr == year &&
-                p->hurricane_doy == doy) {
-                /* Hurricane? */
-                hurricane(f, p, s);
-            }
-            calc_day_growth(cw, c, f, ma, m, p, s, day_length[doy],
-                            doy, fdecay, rdecay);
-
-
-            calculate_csoil_flows(c, f, p, s, m->tsoil, doy);
-            calculate_nsoil_flows(c, f, p, s, m->ndep, doy);
-
-            /* update stress SMA */
-            if (c->deciduous_model && s->leaf_out_days[doy] > 0.0) {
-                 /*Allocation is annually for deciduous "tree" model, but we
-                   need to keep a check on stresses during the growing season
-                   and the LAI figure out limitations during leaf growth period.
-                   This also applies for deciduous grasses, need to do the
-                   growth stress calc for grasses here too. */
-                current_limitation = calculate_growth_stress_limitation(p, s);
-                sma(SMA_ADD, hw, current_limitation);
-                s->prev_sma = sma(SMA_MEAN, hw).sma;
-            } else if (c->deciduous_model == FALSE) {
-                current_limitation = calculate_growth_stress_limitation(p, s);
-                sma(SMA_ADD, hw, current_limitation);
-                s->prev_sma = sma(SMA_MEAN, hw).sma;
-            }
-
-            /*
-                if grazing took place need to reset "stress" running mean
-                calculation for grasses
-            */
-            if (c->grazing == 2 && p->disturbance_doy == doy+1) {
-                sma(SMA_FREE, hw);
-                hw = sma(SMA_NEW, p->growing_seas_len).handle;
-            }
-
-            /* Turn off all N calculations */
-            if (c->ncycle == FALSE)
-                reset_all_n_pools_and_fluxes(f, s);
+    sim_context *sc;
 
-            /* calculate C:N ratios and increment annual flux sum */
-            day_end_calculations(c, p, s, c->num_days, FALSE);
-
-            if (c->print_options == DAILY && c->spin_up == FALSE) {
-                if(c->output_ascii)
-                    write_daily_outputs_ascii(c, f, s, year, doy+1);
-                else
-                    write_daily_outputs_binary(c, f, s, year, doy+1);
-            }
-            c->day_idx++;
-            /* ======================= **
-            **   E N D   O F   D A Y   **
-            ** ======================= */
-        }
+    sc = new_sim_context(argv, cfg_fname, spin_up);
 
-        /* Allocate stored C&N for the following year */
-        if (c->deciduous_model) {
-            calculate_average_alloc_fractions(f, s, p->growing_seas_len);
-            allocate_stored_c_and_n(f, p, s);
-        }
-    }
-
-    /* ========================= **
-    **   E N D   O F   Y E A R   **
-    ** ========================= */
-    correct_rate_constants(p, TRUE);
-
-    if (c->print_options == END && c->spin_up == FALSE) {
-        write_final_state(c, p, s);
-    }
+    if (sc->c->spin_up)
+        spin_up_pools(sc->cw, sc->c, sc->f, sc->ma, sc->m, sc->p, sc->s);
+    else
+        run_sim(sc->cw, sc->c, sc->f, sc->ma, sc->m, sc->p, sc->s);
 
-    sma(SMA_FREE, hw);
-    free(day_length);
-    if (c->disturbance) {
-        free(disturbance_yrs);
-    }
+    /* clean up */
+    free_sim_context(sc);
 
     return;
-
-
 }
 
-void spin_up_pools(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
-                   params *p, state *s){
-    /* Spin up model plant & soil pools to equilibrium.
 
-    - Examine sequences of 50 years and check if C pools are changing
-      by more than 0.005 units per 1000 yrs. Note this check is done in
-      units of: kg m-2.
 
-    References:
-    ----------
-    Adapted from...
-    * Murty, D and McMurtrie, R. E. (2000) Ecological Modelling, 134,
-      185-205, specifically page 196.
+void run_sim(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
+             params *p, state *s){
+    /*
+        Run the model over the full met forcing, one day at a time.
+        See sim_context.c for the init/step/finish pieces.
     */
-    double tol = 5E-03;
-    double prev_plantc = 99999.9;
-    double prev_soilc = 99999.9;
-    int i, cntrl_flag;
-    /* check for convergences in units of kg/m2 */
-    double conv = TONNES_HA_2_KG_M2;
-
-
-    /* Final state + param file */
-    open_output_file(c, c->out_param_fname, &(c->ofp));
-
-    /* If we are prescribing disturbance, first allow the forest to establish */
-    if (c->disturbance) {
-        cntrl_flag = c->disturbance;
-        c->disturbance = FALSE;
-        /*  200 years (50 yrs x 4 cycles) */
-        for (i = 0; i < 4; i++) {
-            run_sim(cw, c, f, ma, m, p, s); /* run GDAY */
-        }
-        c->disturbance = cntrl_flag;
-    }
-
-    fprintf(stderr, "Spinning up the model...\n");
-    while (TRUE) {
-        if (fabs((prev_plantc*conv) - (s->plantc*conv)) < tol &&
-            fabs((prev_soilc*conv) - (s->soilc*conv)) < tol) {
-            break;
-        } else {
-            prev_plantc = s->plantc;
-            prev_soilc = s->soilc;
+    sim_context sc;
 
-            /* 1000 years (50 yrs x 20 cycles) */
-            for (i = 0; i < 20; i++) {
-                run_sim(cw, c, f, ma, m, p, s); /* run GDAY */
-            }
+    attach_sim_context(&sc, cw, c, f, ma, m, p, s);
 
-            /* Have we reached a steady state? */
-            fprintf(stderr,
-              "Spinup: Plant C - %f, Soil C - %f, Plant N - %f, Soil N - %f\n",
-               s->plantc, s->soilc, s->plantn, s->soiln);
-        }
+    sim_init(&sc);
+    while (sim_step(&sc)) {
+        ;
     }
-    write_final_state(c, p, s);
+    sim_finish(&sc);
 
     return;
 }
@@ -460,8 +124,26 @@ void clparser(int argc, char **argv, control *c) {
         if (*argv[i] == '-') {
             if (!strncasecmp(argv[i], "-p", 2)) {
 			    strcpy(c->cfg_fname, argv[++i]);
+            } else if (!strncasecmp(argv[i], "-set", 4)) {
+                add_param_override(argv[++i]);
             } else if (!strncasecmp(argv[i], "-s", 2)) {
                 c->spin_up = TRUE;
+            } else if (!strncasecmp(argv[i], "-branch", 7)) {
+                c->branch = TRUE;
+			    strcpy(c->branch_fname, argv[++i]);
+            } else if (!strncasecmp(argv[i], "-at", 3)) {
+                c->branch_year = atoi(argv[++i]);
+            } else if (!strncasecmp(argv[i], "-b", 2)) {
+                c->batch = TRUE;
+			    strcpy(c->batch_fname, argv[++i]);
+            } else if (!strncasecmp(argv[i], "-r", 2)) {
+                c->region = TRUE;
+			    strcpy(c->region_fname, argv[++i]);
+            } else if (!strncasecmp(argv[i], "-j", 2)) {
+                c->num_threads = atoi(argv[++i]);
+            } else if (!strncasecmp(argv[i], "-m", 2)) {
+                c->convert_met = TRUE;
+			    strcpy(c->met_bin_fname, argv[++i]);
             } else if (!strncasecmp(argv[i], "-ver", 4)) {
                 c->PRINT_GIT = TRUE;
             } else if (!strncasecmp(argv[i], "-u", 2) ||
@@ -491,6 +173,14 @@ void usage(char **argv) {
     fprintf(stderr, "[-ver          \t] Print the git hash tag.]\n");
     fprintf(stderr, "[-p       fname\t] Location of parameter file (.ini/.cfg).]\n");
     fprintf(stderr, "[-s            \t] Spin-up GDAY, when it the model is finished it will print the final state to the param file.]\n");
+    fprintf(stderr, "[-set  key=value\t] Override a value of the param file, e.g. -set params.g1=3.2, may be repeated.]\n");
+    fprintf(stderr, "[-m       fname\t] Convert the CSV met file named in the param file to a binary met file and exit.]\n");
+    fprintf(stderr, "\n++Batch options:\n" );
+    fprintf(stderr, "[-b       fname\t] Manifest of simulations (one .cfg per line, optionally followed by 'spinup') to run in this process.]\n");
+    fprintf(stderr, "[-r       fname\t] Cell list of a regional run (id, .cfg, overrides per line), see region.c, across MPI ranks with gday_mpi.]\n");
+    fprintf(stderr, "[-branch  fname\t] Scenarios (one per line with their overrides) to fork from the -p run, see branch.c.]\n");
+    fprintf(stderr, "[-at       year\t] Year the -branch scenarios start at, the run before it is shared.]\n");
+    fprintf(stderr, "[-j         num\t] Number of batch (or region, per rank, or branch) worker threads, default is one per core.]\n");
     fprintf(stderr, "\n++Print this message:\n" );
     fprintf(stderr, "[-u/-h         \t] usage/help]\n");
 
@@ -700,17 +390,18 @@ void day_end_calculations(control *c, params *p, state *s, int days_in_year,
 }
 
 void unpack_met_data(control *c, met_arrays *ma, met *m, int hod) {
+    long row = c->hour_idx - ma->row0;
 
     /* unpack met forcing */
     if (c->sub_daily) {
-        m->rain = ma->rain[c->hour_idx];
-        m->wind = ma->wind[c->hour_idx];
-        m->press = ma->press[c->hour_idx] * KPA_2_PA;
-        m->vpd = ma->vpd[c->hour_idx] * KPA_2_PA;
-        m->tair = ma->tair[c->hour_idx];
-        m->par = ma->par[c->hour_idx];
-        m->sw_rad = ma->par[c->hour_idx] * PAR_2_SW; /* W m-2 */
-        m->Ca = ma->co2[c->hour_idx];
+        m->rain = ma->rain[row];
+        m->wind = ma->wind[row];
+        m->press = ma->press[row] * KPA_2_PA;
+        m->vpd = ma->vpd[row] * KPA_2_PA;
+        m->tair = ma->tair[row];
+        m->par = ma->par[row];
+        m->sw_rad = ma->par[row] * PAR_2_SW; /* W m-2 */
+        m->Ca = ma->co2[row];
 
         /*
         * NDEP is per 30 min so need to sum 30 min data
@@ -719,12 +410,13 @@ void unpack_met_data(control *c, met_arrays *ma, met *m, int hod) {
         * average outside of this function call.
         */
         if (hod == 0) {
-            m->ndep = ma->ndep[c->hour_idx];
-            m->tsoil = ma->tsoil[c->hour_idx];
+            m->ndep = ma->ndep[row];
+            m->tsoil = ma->tsoil[row];
         } else {
-            m->ndep += ma->ndep[c->hour_idx];
-            m->tsoil += ma->tsoil[c->hour_idx];
+            m->ndep += ma->ndep[row];
+            m->tsoil += ma->tsoil[row];
         }
+        unpack_met_derived(c, ma, m, row);
 
     } else {
         m->Ca = ma->co2[c->day_idx];
@@ -745,6 +437,7 @@ void unpack_met_data(control *c, met_arrays *ma, met *m, int hod) {
         m->tsoil = ma->tsoil[c->day_idx];
         m->Tk_am = ma->tam[c->day_idx] + DEG_TO_KELVIN;
         m->Tk_pm = ma->tpm[c->day_idx] + DEG_TO_KELVIN;
+        unpack_met_derived(c, ma, m, c->day_idx);
     }
 
     return;
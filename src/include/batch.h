@@ -0,0 +1,30 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pthread.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/* A single entry in the batch manifest */
+typedef struct {
+    char  cfg_fname[STRING_LENGTH];
+    int   spin_up;
+} batch_job;
+
+/* Work queue shared between the worker threads */
+typedef struct {
+    char          **argv;
+    batch_job      *jobs;
+    int             num_jobs;
+    int             next_job;
+    int             num_done;
+    pthread_mutex_t lock;
+} batch_queue;
+
+void    run_batch(char **, char *, int);
+void    read_batch_manifest(char *, batch_job **, int *);
+void   *batch_worker(void *);
+int     get_num_cores(void);
+
+#endif /* BATCH_H */
@@ -0,0 +1,44 @@
+#ifndef BRANCH_H
+#define BRANCH_H
+
+#include <pthread.h>
+
+#include "gday.h"
+#include "utilities.h"
+#include "sim_context.h"
+#include "region.h"
+
+/*
+    The trunk run at the start of the branch year, everything a scenario
+    continues from. Read-only once taken, so the scenarios share it.
+*/
+typedef struct {
+    state    s;
+    params   p;                         /* rate constants in d-1 */
+    fluxes   f;
+    sma_obj  hw;                        /* values are the snapshot's own */
+    int      nyr;                       /* first year the scenarios run */
+    long     day_idx;
+    long     hour_idx;
+    int      num_years;
+    int      total_num_days;
+    int      sub_daily;
+} branch_point;
+
+/* Scenarios waiting to run, shared between the worker threads */
+typedef struct {
+    char          **argv;
+    region_cell    *scenarios;
+    int             num_scenarios;
+    int             next;
+    branch_point   *bp;
+    pthread_mutex_t lock;
+} branch_queue;
+
+void    run_branches(char **, char *, char *, int, int);
+void    take_branch_point(sim_context *, branch_point *);
+void    graft_branch_point(sim_context *, branch_point *);
+void   *branch_worker(void *);
+void    simulate_scenario(char **, region_cell *, branch_point *);
+
+#endif /* BRANCH_H */
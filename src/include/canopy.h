@@ -15,7 +15,26 @@
 #include "photosynthesis.h"
 
 /* C stuff */
+#define LEAF_ITER_MAX 100       /* max leaf temperature iterations per leaf */
+
+/* where a leaf's temperature iteration has got to */
+typedef struct {
+    int    iter;                /* iterations so far */
+    int    last;                /* TRUE if this evaluation is the final one */
+    int    have_neg, have_pos;  /* seen a guess on that side of the root? */
+    double t_neg, t_pos;        /* latest guesses with g(Tleaf) < and > Tleaf */
+    double t_best, h_best;      /* guess with the smallest g(Tleaf) - Tleaf */
+} leaf_iteration;
+
 void    initialise_leaf_surface(canopy_wk *, met *);
+void    solve_leaf_temperature(control *, canopy_wk *, fluxes *, met *,
+                               params *, state *, double, int);
+void    solve_leaf_temperatures_batch(control *, canopy_wk *, fluxes *, met *,
+                                      params *, state *, double, int);
+int     update_leaf_temperature(control *, canopy_wk *, fluxes *, met *,
+                                params *, state *, leaf_iteration *, double,
+                                int);
+void    finish_leaf_temperature(canopy_wk *, leaf_iteration *);
 void    zero_carbon_day_fluxes(fluxes *);
 void    zero_hourly_fluxes(canopy_wk *);
 void    update_daily_carbon_fluxes(fluxes *, params *, double, double);
@@ -25,7 +44,8 @@ void    solve_leaf_energy_balance(control *, canopy_wk *, fluxes *, met *,
                                   params *, state *);
 void    sum_hourly_carbon_fluxes(canopy_wk *, fluxes *, params *);
 void    scale_leaf_to_canopy(canopy_wk *);
-double  calc_leaf_net_rad(params *, state *, double, double, double);
+double  calc_leaf_net_rad(params *, state *, double, double);
+double  calc_isothermal_net_lw(double, double);
 void    calculate_top_of_canopy_leafn(canopy_wk *, params *, state *);
 void    calc_leaf_to_canopy_scalar(canopy_wk *, params *);
 
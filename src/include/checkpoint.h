@@ -0,0 +1,49 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "gday.h"
+#include "utilities.h"
+#include "sim_context.h"
+
+#define CHECKPOINT_MAGIC "GDAYCKP1"
+#define CHECKPOINT_VERSION 3           /* 2: soil pool vectors, 3: fields ordered by update rate */
+#define CHECKPOINT_BYTE_ORDER 0x01020304
+
+/*
+    Binary snapshot of a simulation. The header is followed by the state,
+    params and fluxes structures, the sma_period values of the stress
+    running mean and then the num_disturbance_yrs disturbance years. The
+    structures are dumped as is, so a checkpoint can only be read back by
+    the same build (the sizes are checked).
+*/
+typedef struct {
+    char     magic[8];
+    int32_t  byte_order;
+    int32_t  version;
+    int32_t  state_size;
+    int32_t  params_size;
+    int32_t  fluxes_size;
+    int32_t  sub_daily;
+    int32_t  daily_rates;               /* params rate constants in d-1? */
+    int32_t  nyr;                       /* next year to run */
+    int64_t  day_idx;
+    int64_t  hour_idx;
+    uint64_t rng_state;
+    int64_t  out_offset;                /* bytes of daily output so far, -1=none */
+    int32_t  num_disturbance_yrs;
+    int32_t  sma_period;                /* 0 = no running mean stored */
+    int32_t  sma_lv;
+    int32_t  pad;
+    double   sma;
+    double   sma_sum;
+} checkpoint_header;
+
+void    write_checkpoint(sim_context *, char *, int);
+void    restore_checkpoint(sim_context *, char *);
+void    read_checkpoint_header(char *, checkpoint_header *, FILE **);
+void    read_checkpoint_structs(char *, state *, params *, fluxes *);
+void    resume_output_files(control *);
+
+#endif /* CHECKPOINT_H */
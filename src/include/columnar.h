@@ -0,0 +1,87 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <stdint.h>
+#include <zlib.h>
+
+#include "gday.h"
+#include "utilities.h"
+#include "output_vars.h"
+
+#define COLUMN_MAGIC "GDAYCOL1"
+#define COLUMN_CHUNK_MAGIC "CHNK"
+#define COLUMN_INDEX_MAGIC "GDAYIDX1"
+#define COLUMN_VERSION 1
+#define COLUMN_BYTE_ORDER 0x01020304
+#define COLUMN_NAME_LEN 32
+
+/*
+    Chunked columnar output file:
+
+        column_file_header
+        names[nvars][COLUMN_NAME_LEN], units[nvars][COLUMN_NAME_LEN]
+        chunk 0: column_chunk_header, int64 nbytes[nvars], nvars blocks
+        chunk 1: ...
+        index: int64 first_row[nchunks], int64 nrows[nchunks],
+               int64 offset[nchunks][nvars], int64 nbytes[nchunks][nvars]
+        column_file_trailer
+
+    Each block holds one variable for the chunk's rows as native doubles,
+    zlib compressed after byte shuffling (all the 1st bytes of the doubles,
+    then all the 2nd bytes...) if compression is on. The index lets a
+    reader go straight to the blocks of one variable; the chunk headers
+    mean the index can be rebuilt from the chunks alone (on restart, or
+    if a run died before writing it).
+*/
+typedef struct {
+    char    magic[8];
+    int32_t byte_order;
+    int32_t version;
+    int32_t nvars;
+    int32_t chunk_len;                  /* rows per chunk (the last may be short) */
+    int32_t compression;                /* OUTPUT_COMPRESS_* */
+    int32_t pad;
+} column_file_header;
+
+typedef struct {
+    char    magic[4];
+    int32_t nrows;
+    int64_t first_row;
+} column_chunk_header;
+
+typedef struct {
+    int64_t nchunks;
+    int64_t nrows;
+    int64_t index_offset;
+    char    magic[8];
+} column_file_trailer;
+
+typedef struct column_file {
+    FILE          *fp;
+    int            nvars;
+    int            chunk_len;
+    int            compression;
+    int            nbuf;                /* rows buffered for the next chunk */
+    double        *buf;                 /* nvars x chunk_len, by column */
+    unsigned char *shuffled;
+    unsigned char *packed;
+    uLong          packed_len;
+    long           nrows;               /* rows already written in chunks */
+    long           nchunks;
+    long           max_chunks;
+    int64_t       *first_row;
+    int64_t       *chunk_rows;
+    int64_t       *offset;              /* nchunks x nvars */
+    int64_t       *nbytes;
+} column_file;
+
+column_file *start_column_file(control *, FILE *);
+void         append_column_record(column_file *, const double *);
+void         flush_column_chunk(column_file *);
+void         close_column_file(column_file *);
+void         write_column_file_header(control *, column_file *);
+void         scan_column_chunks(control *, column_file *);
+void         add_column_chunk(column_file *, long, int, const int64_t *,
+                              const int64_t *);
+
+#endif /* COLUMNAR_H */
@@ -0,0 +1,20 @@
+#ifndef FORCING_H
+#define FORCING_H
+
+#include "gday.h"
+#include "utilities.h"
+#include "water_balance.h"
+#include "canopy.h"
+
+void    preprocess_forcing(control *, met_arrays *, params *);
+void    free_forcing(met_arrays *);
+void    calculate_phenology_drivers(control *, met_arrays *, met_year *,
+                                    double *);
+void    get_daylength(met_arrays *, params *, int, double *);
+met_year *get_met_year(met_arrays *, int);
+void    derive_met_columns(control *, met_arrays *);
+void    free_met_derived(met_arrays *);
+void    calc_met_derived(double, double, met_derived *);
+void    unpack_met_derived(control *, met_arrays *, met *, long);
+
+#endif /* FORCING_H */
@@ -52,6 +52,32 @@
 #define DAILY 0
 #define END 1
 
+/* Leaf photosynthesis kernels (sub-daily) */
+#define LEAF_KERNEL_SCALAR 0
+#define LEAF_KERNEL_BATCH 1
+
+/* what to take from a checkpoint on restart */
+#define RESTART_RESUME 0
+#define RESTART_STATE 1
+
+/* output aggregation periods */
+#define OUTPUT_PERIOD_DAILY 0
+#define OUTPUT_PERIOD_MONTHLY 1
+#define OUTPUT_PERIOD_ANNUAL 2
+#define OUTPUT_PERIOD_SEASON 3
+#define OUTPUT_PERIOD_NDAYS 4
+
+/* what an aggregated output record holds for states */
+#define OUTPUT_STATE_MEAN 0
+#define OUTPUT_STATE_END 1
+
+/* columnar output block compression */
+#define OUTPUT_COMPRESS_NONE 0
+#define OUTPUT_COMPRESS_ZLIB 1
+
+/* most variables in a daily output record */
+#define MAX_OUTPUT_VARS 128
+
 /* Texture identifiers */
 #define SILT 0
 #define SAND 1
@@ -69,16 +95,19 @@
 #include "disturbance.h"
 #include "phenology.h"
 #include "soils.h"
+#include "batch.h"
+#include "region.h"
+#include "sim_context.h"
+#include "spinup.h"
 #include "version.h"
 
 
 void   clparser(int, char **, control *);
 void   usage(char **);
+void   simulate_site(char **, char *, int);
 
 void   run_sim(canopy_wk *, control *, fluxes *, met_arrays *, met *,
                params *p, state *);
-void   spin_up_pools(canopy_wk *, control *, fluxes *, met_arrays *, met *,
-                     params *p, state *);
 void   correct_rate_constants(params *, int output);
 void   reset_all_n_pools_and_fluxes(fluxes *, state *);
 void   zero_stuff(control *, state *);
@@ -0,0 +1,52 @@
+#ifndef LIBGDAY_H
+#define LIBGDAY_H
+
+/*
+    C API of libgday.so, the model built as a shared library so that a host
+    program (e.g. Python through ctypes, see scripts/gday_lib.py) can drive
+    runs without going through the gday program and text files.
+
+        gday_model *m = gday_open("params/site.cfg");
+        gday_set(m, "params.g1", "3.2");
+        gday_set_forcing(m, "tair", tair, gday_num_forcing_rows(m));
+        gday_run(m);
+        gpp = gday_output(m, "gpp");    (gday_num_records(m) values)
+        gday_close(m);
+
+    Forcing arrays are used in place, not copied, so they must stay alive
+    until the model is closed or the column is set again. They are float
+    rather than double when the library was built with -DMET_FLOAT, see
+    gday_forcing_size(). Output columns belong to the model and stay valid
+    until the next gday_run or gday_close.
+
+    The functions below return 0 (or a valid pointer) on success and -1 (or
+    NULL) for a bad argument, e.g. an unknown key. Errors inside the model
+    itself still end the process, as they do for the gday program.
+
+    Separate models can be run on separate threads; a single model must only
+    be used from one thread at a time.
+*/
+typedef struct gday_model gday_model;
+
+gday_model   *gday_open(const char *);
+void          gday_close(gday_model *);
+void          gday_reset(gday_model *);
+
+int           gday_set(gday_model *, const char *, const char *);
+int           gday_get(gday_model *, const char *, double *);
+
+int           gday_forcing_size(void);
+long          gday_num_forcing_rows(gday_model *);
+int           gday_set_forcing(gday_model *, const char *, void *, long);
+
+int           gday_spin_up(gday_model *);
+int           gday_run(gday_model *);
+
+int           gday_num_outputs(gday_model *);
+const char   *gday_output_name(gday_model *, int);
+long          gday_num_records(gday_model *);
+const double *gday_output(gday_model *, const char *);
+
+const char   *gday_version(void);
+
+#endif /* LIBGDAY_H */
@@ -0,0 +1,48 @@
+#ifndef MET_BINARY_H
+#define MET_BINARY_H
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+#define MET_BIN_MAGIC "GDAYMET1"
+#define MET_BIN_VERSION 1
+#define MET_BIN_BYTE_ORDER 0x01020304
+#define MET_BIN_MAX_VARS 32
+#define MET_BIN_NAME_LEN 16
+
+/*
+    Binary columnar met forcing. The header is followed directly by nvars
+    columns of nrows values each (native byte order), in the order given by
+    names. The header is a multiple of 8 bytes so the columns can be used
+    in place once the file is mmap'ed.
+*/
+typedef struct {
+    char    magic[8];
+    int32_t byte_order;
+    int32_t version;
+    int32_t sub_daily;                  /* timestep, FALSE=daily, TRUE=30 min */
+    int32_t nvars;
+    int32_t dtype_size;                 /* bytes per value, 8 = double, 4 = float */
+    int32_t num_years;
+    int64_t nrows;
+    char    names[MET_BIN_MAX_VARS][MET_BIN_NAME_LEN];
+} met_bin_header;
+
+/* name of a forcing variable and where it lives in met_arrays */
+typedef struct {
+    const char *name;
+    met_real  **col;
+} met_column;
+
+int     is_binary_met_file(char *);
+void    read_binary_met_data(char **, control *, met_arrays *);
+void    write_binary_met_data(control *, met_arrays *, char *);
+void    convert_met_file(char **, char *, char *);
+int     get_met_columns(control *, met_arrays *, met_column *);
+
+#endif /* MET_BINARY_H */
@@ -0,0 +1,36 @@
+#ifndef MET_CACHE_H
+#define MET_CACHE_H
+
+#include <pthread.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/*
+    One loaded met file. The columns are read-only once loaded and shared by
+    every simulation holding a reference.
+*/
+typedef struct met_cache_entry {
+    char        fname[PATH_MAX];        /* canonical path of the forcing */
+    time_t      mtime;
+    off_t       size;
+    int         sub_daily;
+    int         loaded;                 /* FALSE while the first user reads it */
+    int         stale;                  /* file changed, drop at last release */
+    int         refcount;
+    int         num_years;
+    int         total_num_days;
+    met_arrays  ma;
+    struct met_cache_entry *next;
+} met_cache_entry;
+
+void    enable_met_cache(void);
+int     met_cache_enabled(void);
+void    acquire_met_data(char **, control *, met_arrays *);
+void    release_met_data(control *, met_arrays *);
+void    flush_met_cache(void);
+void    free_met_cache_entry(met_cache_entry *);
+
+#endif /* MET_CACHE_H */
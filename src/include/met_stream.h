@@ -0,0 +1,74 @@
+#ifndef MET_STREAM_H
+#define MET_STREAM_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "gday.h"
+#include "utilities.h"
+#include "read_met_file.h"
+
+/* most timesteps the model takes from the forcing in one year */
+#define MET_STREAM_WINDOW_ROWS (366 * 48)
+
+/* one year of the file, ncols columns of max_rows values */
+typedef struct {
+    int     nyr;                        /* forcing year held, -1 = free */
+    int     ready;                      /* FALSE while it is being read */
+    met_real *data;
+} met_stream_slot;
+
+/*
+    A sliding window of met_stream_years years of the sub-daily forcing.
+    The year of the file the model is on is held in one slot and a reader
+    thread fills the rest with the years that follow; at the start of each
+    model year its timesteps are copied out of the slots into window, which
+    is what the met_arrays columns point at. A binary (mmap'ed) forcing is
+    not copied, the window is kept in memory with madvise instead.
+*/
+typedef struct met_stream {
+    char   *prog;                       /* for reporting errors in the file */
+    char   *fname;
+    FILE   *fp;                         /* CSV forcing, NULL = binary */
+    block_reader br;
+    met_column cols[MET_BIN_MAX_VARS];  /* where each column lives in met_arrays */
+    int     ncols;
+    int     field[MET_BIN_MAX_VARS];    /* column of each CSV value, -1 = skip */
+    int     nvars;                      /* values per CSV line */
+
+    /* index of the years in the file, from one pass at the start */
+    int     num_years;
+    double *year;                       /* calendar year */
+    long   *first_row;                  /* first timestep of each year */
+    long   *num_rows;                   /* timesteps in each year */
+    off_t  *offset;                     /* file position of the first line */
+    int    *first_line;                 /* line number of the first line */
+    long    max_rows;
+
+    met_real *window;                   /* ncols columns of the model's year */
+    met_stream_slot *slots;
+    int     nslots;
+    int     current;                    /* year of the file the model is on */
+    int     next_load;                  /* next year for the reader thread */
+    int     generation;                 /* bumped when the reader is moved */
+    int     stop;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  loaded;             /* a year has been read */
+    pthread_cond_t  wake;               /* a slot is free, the model moved on */
+} met_stream;
+
+void    open_met_stream(char **, control *, met_arrays *);
+void    index_met_stream(met_stream *);
+void    index_binary_met_stream(met_stream *, met_arrays *, int);
+void    close_met_stream(met_arrays *);
+void    advance_met_stream(met_arrays *, long);
+met_stream_slot *wait_met_stream_year(met_stream *, int);
+int     find_met_stream_year(met_stream *, long);
+void   *met_stream_thread(void *);
+void    read_met_stream_year(met_stream *, met_stream_slot *, int);
+void    advise_met_stream(met_stream *, int, int, int);
+double  get_met_stream_year(met_arrays *, int);
+
+#endif /* MET_STREAM_H */
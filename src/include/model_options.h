@@ -0,0 +1,11 @@
+#ifndef MODEL_OPTIONS_H
+#define MODEL_OPTIONS_H
+
+#include "gday.h"
+#include "photosynthesis.h"
+#include "water_balance.h"
+
+void    resolve_model_options(control *);
+void    free_model_options(control *);
+
+#endif /* MODEL_OPTIONS_H */
@@ -0,0 +1,28 @@
+#ifndef OUTPUT_AGGREGATE_H
+#define OUTPUT_AGGREGATE_H
+
+#include "gday.h"
+#include "utilities.h"
+#include "output_vars.h"
+
+/*
+    Running aggregate of the daily output records over the current output
+    period (see the [outputs] period option)
+*/
+typedef struct output_accum {
+    int     nvals;                      /* values per record */
+    int     ndays;                      /* days accumulated so far */
+    double *vals;                       /* the aggregate so far */
+    int    *rule;                       /* OUTPUT_AGG_* for each column */
+} output_accum;
+
+output_accum *new_output_accum(control *);
+void          free_output_accum(output_accum *);
+int           aggregate_daily_outputs(output_accum *, control *, fluxes *,
+                                      state *, int, int, double *);
+int           flush_output_accum(output_accum *, double *);
+int           output_period_ended(control *, state *, int);
+int           count_output_records(control *, met_arrays *);
+int           count_year_records(control *, double);
+
+#endif /* OUTPUT_AGGREGATE_H */
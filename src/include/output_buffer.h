@@ -0,0 +1,24 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include "gday.h"
+#include "utilities.h"
+
+/*
+    The output records of a run held in memory rather than written to a
+    file, for a program driving the model through libgday. Each variable is
+    kept as one contiguous column so the host can use it in place.
+*/
+typedef struct output_buffer {
+    int     nvals;                      /* values per record */
+    long    capacity;                   /* records each column has room for */
+    long    nrecords;                   /* records stored so far */
+    double *data;                       /* nvals columns of capacity values */
+} output_buffer;
+
+output_buffer *new_output_buffer(int, long);
+void           free_output_buffer(output_buffer *);
+void           append_output_buffer(output_buffer *, const double *);
+double        *get_output_column(output_buffer *, int);
+
+#endif /* OUTPUT_BUFFER_H */
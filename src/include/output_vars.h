@@ -0,0 +1,42 @@
+#ifndef OUTPUT_VARS_H
+#define OUTPUT_VARS_H
+
+#include <stddef.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/* where an output variable's value comes from */
+#define OUTPUT_TIME 0
+#define OUTPUT_STATE 1
+#define OUTPUT_FLUXES 2
+
+/* how a column is aggregated over an output period */
+#define OUTPUT_AGG_FIRST 0              /* value on the first day */
+#define OUTPUT_AGG_SUM 1
+#define OUTPUT_AGG_MEAN 2
+#define OUTPUT_AGG_STATE 3              /* mean or last, per the state option */
+#define OUTPUT_AGG_LAST 4
+
+/*
+    One variable that can be written to the daily outputs: a named, unit
+    tagged double in the state or fluxes structure (or the date)
+*/
+typedef struct {
+    const char *name;
+    const char *units;
+    int         source;                 /* OUTPUT_TIME/STATE/FLUXES */
+    size_t      offset;                 /* into state/fluxes, 0/1/2 = year/doy/ndays */
+    int         aggregate;              /* OUTPUT_AGG_* */
+    int         standard;               /* part of the default output set */
+} output_var;
+
+int               num_output_vars_registered(void);
+const output_var *get_output_var(int);
+int               find_output_var(const char *);
+void              add_output_vars(control *, char *);
+void              setup_output_vars(control *);
+double            get_output_value(const output_var *, fluxes *, state *,
+                                   int, int);
+
+#endif /* OUTPUT_VARS_H */
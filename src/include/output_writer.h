@@ -0,0 +1,44 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <pthread.h>
+
+#include "gday.h"
+#include "write_output_file.h"
+#include "columnar.h"
+
+#define OUTPUT_RING_RECORDS 4096        /* days buffered between the threads */
+#define OUTPUT_BLOCK_SIZE (1 << 20)     /* bytes formatted per write */
+
+/*
+    Daily output records queued by the simulation thread (head) and
+    formatted/written by the writer thread (tail). head and tail only ever
+    increase; slot = index % capacity.
+*/
+typedef struct output_writer {
+    FILE           *fp;
+    column_file    *columns;            /* columnar output, NULL = fp */
+    int             ascii;              /* CSV (TRUE) or raw doubles */
+    int             nvals;              /* values per record */
+    int             capacity;           /* records in the ring */
+    double         *ring;               /* capacity x nvals values */
+    long            head;               /* records queued */
+    long            tail;               /* records written */
+    int             stop;
+    int             error;
+    char           *block;              /* formatted text waiting for fwrite */
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  queued;
+    pthread_cond_t  written;
+} output_writer;
+
+output_writer *start_output_writer(control *, FILE *, column_file *);
+void           queue_daily_outputs(output_writer *, control *, fluxes *,
+                                   state *, int, int);
+void           queue_output_record(output_writer *, const double *);
+void           drain_output_writer(output_writer *);
+void           stop_output_writer(output_writer *);
+void          *output_writer_thread(void *);
+
+#endif /* OUTPUT_WRITER_H */
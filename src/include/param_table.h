@@ -0,0 +1,58 @@
+#ifndef PARAM_TABLE_H
+#define PARAM_TABLE_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/* structure a .cfg key is stored in */
+#define PARAM_CONTROL 0
+#define PARAM_PARAMS 1
+#define PARAM_STATE 2
+
+/* how the value is stored, OPTION = parsed by the chain in handler() */
+#define PARAM_DOUBLE 0
+#define PARAM_INT 1
+#define PARAM_LONG 2
+#define PARAM_STRING 3
+#define PARAM_OPTION 4
+
+#define PARAM_HASH_SIZE 1024            /* power of 2, > twice the keys */
+#define MAX_PARAM_OVERRIDES 256
+
+/* one key of the .cfg file and where its value goes */
+typedef struct {
+    const char *section;
+    const char *name;
+    int         base;                   /* PARAM_CONTROL/PARAMS/STATE */
+    int         type;                   /* PARAM_DOUBLE ... PARAM_OPTION */
+    size_t      offset;                 /* offsetof the field in base */
+} param_field;
+
+/* a -set section.name=value from the command line */
+typedef struct {
+    const param_field *field;
+    char              *value;
+} param_override;
+
+extern const param_field param_table[];
+
+int                num_param_fields(void);
+const param_field *find_param_field(const char *, const char *);
+void               build_param_hash(void);
+unsigned int       hash_param_key(const char *, const char *);
+void               set_param_field(const param_field *, control *, params *,
+                                   state *, char *);
+int                get_param_value(const param_field *, control *,
+                                   params *, state *, double *);
+int                set_param(control *, params *, state *, const char *,
+                             const char *);
+void               add_param_override(char *);
+void               apply_param_overrides(control *, params *, state *);
+const char        *find_param_override(const char *, const char *);
+void               apply_run_overrides(control *, params *, state *);
+const char        *find_run_override(control *, const char *, const char *);
+
+#endif /* PARAM_TABLE_H */
@@ -5,12 +5,42 @@
 #include "constants.h"
 #include "utilities.h"
 
+#define LEAF_BATCH_MAX 96     /* most leaves per kernel call, 2 x 48 half-hrs */
+
+/*
+    Structure-of-arrays input/output for photosynthesis_C3_batch, one lane
+    per leaf
+*/
+typedef struct {
+    int    n;                           /* number of leaves in use */
+    double tleaf[LEAF_BATCH_MAX];       /* leaf temperature (deg C) */
+    double par[LEAF_BATCH_MAX];         /* absorbed PAR (umol m-2 s-1) */
+    double Cs[LEAF_BATCH_MAX];          /* CO2 at the leaf surface (umol mol-1) */
+    double dleaf[LEAF_BATCH_MAX];       /* leaf VPD (Pa) */
+    double cscalar[LEAF_BATCH_MAX];     /* leaf to canopy scalar */
+    double N0[LEAF_BATCH_MAX];          /* top of canopy N (g N m-2) */
+    double wtfac_root[LEAF_BATCH_MAX];  /* root zone water stress (0-1) */
+    double an[LEAF_BATCH_MAX];          /* net photosynthesis (umol m-2 s-1) */
+    double rd[LEAF_BATCH_MAX];          /* respiration in the light */
+    double gsc[LEAF_BATCH_MAX];         /* stomatal conductance to CO2 */
+    int    limited[LEAF_BATCH_MAX];     /* Jmax/Vcmax are zero */
+} leaf_batch;
+
 /* Sub-daily funcs */
 void   photosynthesis_C3(control *, canopy_wk *, met *m, params *, state *);
-double calc_co2_compensation_point(params *, double);
-double calculate_michaelis_menten(params *, double);
+void   photosynthesis_C3_batch(control *, params *, leaf_batch *);
+double calc_co2_compensation_point(control *, params *, double);
+double calculate_michaelis_menten(control *, params *, double);
 void   calculate_jmaxt_vcmaxt(control *, canopy_wk *, params *, state *,
                               double, double *, double *);
+void   jmax_vcmax_fixed(control *, params *, double, double, double,
+                        double *, double *);
+void   jmax_vcmax_leaf_n(control *, params *, double, double, double,
+                         double *, double *);
+void   jmax_vcmax_jv_ratio(control *, params *, double, double, double,
+                           double *, double *);
+void   jmax_vcmax_temp(control *, params *, double, double, double,
+                       double *, double *);
 double arrhenius(double, double, double, double);
 double peaked_arrhenius(double, double, double, double, double, double);
 double calc_leaf_day_respiration(double, double);
@@ -22,12 +52,21 @@ void   mate_C3_photosynthesis(control *, fluxes *, met *, params *,
                               state *, double, double);
 
 double  calculate_top_of_canopy_n(params *, state *, double);
-double  calculate_co2_compensation_point(params *, double, double);
+double  calculate_co2_compensation_point(control *, params *, double, double);
 double  arrh(double, double, double, double);
 double  peaked_arrh(double, double, double, double, double, double);
-double  calculate_michaelis_menten_parameter(params *, double, double);
+double  calculate_michaelis_menten_parameter(control *, params *, double,
+                                             double);
 void    calculate_jmax_and_vcmax(control *, params *, state *, double, double,
                                  double *, double *, double);
+void    mate_jmax_vcmax_fixed(control *, params *, double, double, double,
+                              double *, double *);
+void    mate_jmax_vcmax_leaf_n(control *, params *, double, double, double,
+                               double *, double *);
+void    mate_jmax_vcmax_jv_ratio(control *, params *, double, double, double,
+                                 double *, double *);
+void    mate_jmax_vcmax_temp(control *, params *, double, double, double,
+                             double *, double *);
 void    adj_for_low_temp(double *, double);
 double  calculate_ci(control *, params *, state *, double, double);
 double  calculate_quantum_efficiency(params *, double ci, double);
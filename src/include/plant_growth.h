@@ -21,6 +21,9 @@ void    carbon_allocation(control *, fluxes *, params *, state *,
                                                      double, int);
 void    calc_carbon_allocation_fracs(control *c, fluxes *, params *, state *,
                                     double);
+void    alloc_fracs_fixed(control *, fluxes *, params *, state *, double);
+void    alloc_fracs_grasses(control *, fluxes *, params *, state *, double);
+void    alloc_fracs_allometric(control *, fluxes *, params *, state *, double);
 double  alloc_goal_seek(double, double, double, double);
 void    update_plant_state(control *, fluxes *, params *, state *,
                                                         double, double, int);
@@ -38,6 +41,9 @@ int    nitrogen_allocation(control *c, fluxes *, params *, state *, double,
                            double, double, double, double, double, int);
 double calculate_growth_stress_limitation(params *, state *);
 double calculate_nuptake(control *, params *, state *);
+double nuptake_constant(params *, state *);
+double nuptake_inorgn(params *, state *);
+double nuptake_root_saturating(params *, state *);
 
 double nitrogen_retrans(control *, fluxes *, params *, state *,
                         double, double, int);
@@ -14,6 +14,8 @@
 /* utilities */
 double day_angle(int);
 void   calculate_solar_geometry(canopy_wk *, params *, double, double);
+void   get_solar_geometry(canopy_wk *, params *, double, int);
+void   build_solar_table(canopy_wk *, params *);
 double calculate_solar_declination(int, double);
 double calculate_eqn_of_time(double);
 void   get_diffuse_frac(canopy_wk *, int, double);
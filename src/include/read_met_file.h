@@ -3,12 +3,32 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 #include "gday.h"
 #include "utilities.h"
+#include "met_binary.h"
 
+/* buffered line reader used by the CSV met readers */
+typedef struct {
+    FILE   *fp;
+    char   *buf;
+    size_t  size;
+    size_t  start;                      /* start of the next unread line */
+    size_t  end;                        /* end of the data in buf */
+    int     eof;
+} block_reader;
+
+void    read_met_data(char **, control *, met_arrays *);
 void    read_daily_met_data(char **, control *, met_arrays *);
 void    read_subdaily_met_data(char **, control *, met_arrays *);
+void    read_met_csv(char **, control *, met_arrays *, met_real ***, int);
+int     parse_met_line(char *, double *, int);
+void    init_block_reader(block_reader *);
+char   *read_next_line(block_reader *);
+int     scan_double(char **, double *);
+void    free_met_data(control *, met_arrays *);
 
 
 #endif /* READ_MET_H */
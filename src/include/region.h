@@ -0,0 +1,49 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <pthread.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/* most overrides a cell line (plus the defaults line) can give */
+#define MAX_CELL_OVERRIDES 64
+
+/* One grid cell of the cell list, the strings are the list's own */
+typedef struct {
+    char   *id;
+    char   *cfg_fname;
+    int     spin_up;
+    double  cost;                       /* relative cost, dearest first */
+    int     num_overrides;
+    char  **overrides;                  /* section.name=value, %c expanded */
+    char   *out_fname;                  /* where the run wrote its output */
+} region_cell;
+
+/* The cells handed to this rank, shared with its worker threads */
+typedef struct {
+    char          **argv;
+    region_cell    *cells;
+    int            *order;              /* cell indices, dearest first */
+    int             num_cells;
+    int            *queue;              /* cells given to this rank */
+    int             head;               /* next to run */
+    int             tail;               /* end of those received */
+    int             exhausted;          /* no more cells to come */
+    int             num_threads;
+    int             rank;
+    double         *seconds;            /* wall time of each cell, -1 = not here */
+    pthread_mutex_t lock;
+    pthread_cond_t  more;               /* cells arrived, or no more to come */
+    pthread_cond_t  low;                /* the queue needs refilling */
+} region_queue;
+
+void    run_region(char **, char *, int);
+void    read_region_cells(char *, char *, region_cell **, int *);
+void    free_region_cells(region_cell *, int);
+void   *region_worker(void *);
+void    simulate_cell(char **, region_cell *);
+void    sort_region_cells(region_cell *, int, int *);
+void    write_region_index(char *, region_cell *, int, double *, int *);
+
+#endif /* REGION_H */
@@ -0,0 +1,64 @@
+#ifndef SIM_CONTEXT_H
+#define SIM_CONTEXT_H
+
+#include "gday.h"
+#include "simple_moving_average.h"
+#include "met_cache.h"
+
+/*
+    Everything a single simulation mutates lives in (or hangs off) one of
+    these, so separate contexts can be driven from separate threads without
+    sharing anything. The run is advanced a day at a time via
+
+        sim_init(sc);
+        while (sim_step(sc)) {
+            ...
+        }
+        sim_finish(sc);
+
+    and the same sequence is what run_sim() does internally.
+*/
+struct output_writer;
+struct output_accum;
+struct column_file;
+struct output_buffer;
+
+typedef struct {
+    canopy_wk  *cw;
+    control    *c;
+    fluxes     *f;
+    met_arrays *ma;
+    met        *m;
+    params     *p;
+    state      *s;
+
+    sma_obj     hw;                     /* running mean of growth stress */
+    struct output_writer *writer;       /* daily outputs, NULL = write inline */
+    struct output_accum  *accum;        /* aggregated outputs, NULL = daily */
+    struct column_file   *columns;      /* columnar outputs, NULL = CSV/binary */
+    struct output_buffer *buffer;       /* outputs kept in memory, see libgday.c */
+    double     *day_length;             /* hrs, for the current year */
+    int        *disturbance_yrs;
+    int         num_disturbance_yrs;
+    int         nyr;                    /* index of the current year */
+    int         doy;                    /* next day of the year to run (0-based) */
+    double      year;
+} sim_context;
+
+sim_context *new_sim_context(char **, char *, int);
+sim_context *new_sim_context_with(char **, char *, int, char **, int);
+void         free_sim_context(sim_context *);
+void         attach_sim_context(sim_context *, canopy_wk *, control *,
+                                fluxes *, met_arrays *, met *, params *,
+                                state *);
+
+void         sim_init(sim_context *);
+int          sim_step(sim_context *);
+void         sim_finish(sim_context *);
+
+void         start_sim_year(sim_context *);
+void         simulate_day(sim_context *);
+void         end_sim_year(sim_context *);
+void         write_sim_outputs(sim_context *, const double *);
+
+#endif /* SIM_CONTEXT_H */
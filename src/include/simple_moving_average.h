@@ -1,23 +1,50 @@
 #ifndef SMA_H
 #define SMA_H
 
-enum Action { SMA_NEW, SMA_FREE, SMA_VALUES, SMA_ADD, SMA_MEAN };
+#define SMA_MIN_CAPACITY 366            /* room for a growing season window */
 
+/*
+    Fixed capacity ring buffer holding the last period values and their
+    mean. The storage is allocated once (sma_init) and windows are resized
+    in place (sma_reset), so the daily update is just sma_add.
+*/
 typedef struct sma_obj {
-     double  sma;
+     double  sma;                       /* mean of the values in the window */
      double  sum;
-     int     period;
+     int     period;                    /* window length */
      double *values;
-     int     lv;
+     int     lv;                        /* values added since the reset */
+     int     pos;                       /* slot the next value goes in */
+     int     capacity;                  /* longest window without a realloc */
 } sma_obj;
 
-typedef union sma_result {
-     sma_obj   *handle;
-     double     sma;
-     double    *values;
-} sma_result;
+void sma_init(sma_obj *, int);
+void sma_free(sma_obj *);
+void sma_reset(sma_obj *, int);
+void sma_fill(sma_obj *, double, int);
+void sma_restore(sma_obj *, int, int, double, double);
 
-sma_result sma(enum Action action, ...);
+static inline double sma_add(sma_obj *o, double v) {
+    /* Push v into the window, returns the new mean */
+    if (o->lv < o->period) {
+        o->values[o->lv++] = v;
+        o->sum += v;
+        o->sma = o->sum / o->lv;
+    } else {
+        o->sum -= o->values[o->pos];
+        o->sum += v;
+        o->sma = o->sum / o->period;
+        o->values[o->pos] = v;
+        o->lv++;
+    }
+    if (++o->pos == o->period)
+        o->pos = 0;
 
+    return (o->sma);
+}
+
+static inline double sma_mean(sma_obj *o) {
+    return (o->sma);
+}
 
 #endif /* SMA_H */
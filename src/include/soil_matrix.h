@@ -0,0 +1,38 @@
+#ifndef SOIL_MATRIX_H
+#define SOIL_MATRIX_H
+
+#include "gday.h"
+#include "utilities.h"
+
+/* the soil pools, in the order of p->decayrate, s->soil_cpool and
+   s->soil_npool */
+enum {
+    SP_STRUCTSURF,  /* surface structural litter */
+    SP_METABSURF,   /* surface metabolic litter */
+    SP_STRUCTSOIL,  /* soil structural litter */
+    SP_METABSOIL,   /* soil metabolic litter */
+    SP_ACTIVE,      /* active SOM */
+    SP_SLOW,        /* slow SOM */
+    SP_PASSIVE      /* passive SOM */
+};
+
+/*
+    Where the C (and N) decomposed in each soil pool goes, worked out once
+    a run from ligshoot, ligroot and finesoil (see soil_matrix.c). Column j
+    is the pool decomposing, row i the pool receiving; what's left of a C
+    column is respired, N columns sum to one as N isn't.
+*/
+struct soil_transfer {
+    double cfrac[NSOIL_POOLS][NSOIL_POOLS];
+    double nfrac[NSOIL_POOLS][NSOIL_POOLS];
+    double resp[NSOIL_POOLS];   /* fraction of the decomposed C respired */
+};
+
+void    build_soil_transfer(control *, params *);
+void    free_soil_transfer(control *);
+void    soil_transfer_flows(double [NSOIL_POOLS][NSOIL_POOLS], double *,
+                            double *);
+int     soil_steady_state(soil_transfer *, double *, double *, int *,
+                          double *);
+
+#endif /* SOIL_MATRIX_H */
@@ -5,7 +5,9 @@
 #include "utilities.h"
 #include "constants.h"
 
-void   soil_temp_factor(fluxes *, double);
+void   soil_temp_factor(control *, fluxes *, double);
+double soil_temp_response(double);
+double soil_temp_fit(double);
 void   calculate_csoil_flows(control *, fluxes *, params *, state *,
                              double, int);
 void   calculate_decay_rates(fluxes *, params *, state *);
@@ -15,11 +17,7 @@ double ratio_of_litternc_to_live_rootnc(control *, fluxes *, params *);
 double metafract(double);
 void   partition_plant_litter(fluxes *, params *);
 double ratio_of_litternc_to_live_leafnc(control *, fluxes *, params *);
-void   cfluxes_from_structural_pool(fluxes *, params *, state *);
-void   cfluxes_from_metabolic_pool(fluxes *f, params *, state *);
-void   cfluxes_from_active_pool(fluxes *, params *, state *, double);
-void   cfluxes_from_slow_pool(fluxes *, params *, state *);
-void   cfluxes_from_passive_pool(fluxes *, params *, state *);
+void   cfluxes_from_soil_pools(control *, fluxes *, params *, state *);
 void   calculate_soil_respiration(control *, fluxes *, params *, state *);
 void   calculate_cpools(fluxes *, state *);
 void   precision_control_soil_c(fluxes *, state *);
@@ -31,11 +29,7 @@ void   calculate_nsoil_flows(control *, fluxes *, params *, state *, double, int
 void   grazer_inputs(control *, fluxes *, params *);
 void   inputs_from_plant_litter(fluxes *, params *, double *, double *);
 void   partition_plant_litter_n(control *, fluxes *, params *, double, double);
-void   nfluxes_from_structural_pools(fluxes *, params *, state *);
-void   nfluxes_from_metabolic_pool(fluxes *, params *, state *);
-void   nfluxes_from_active_pool(fluxes *, params *, state *, double);
-void   nfluxes_from_slow_pool(fluxes *, params *, state *s);
-void   nfluxes_from_passive_pool(fluxes *, params *, state *);
+void   nfluxes_from_soil_pools(control *, fluxes *, params *, state *);
 void   calculate_n_mineralisation(fluxes *);
 void   calculate_n_immobilisation(fluxes *, params *, state *, double *,
                                   double *, double *, double *);
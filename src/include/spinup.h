@@ -0,0 +1,31 @@
+#ifndef SPINUP_H
+#define SPINUP_H
+
+#include "gday.h"
+#include "utilities.h"
+#include "soil_matrix.h"
+
+/* cycles of the met forcing a convergence test is judged over, i.e. 1000
+   years of 50 yr forcing */
+#define SPINUP_WINDOW 20
+
+/* most jumps of the soil pools to their steady state in one spin-up */
+#define SPINUP_MAX_JUMPS 10
+
+/* inputs and decomposition of the soil pools summed over a cycle, in the
+   order of s->soil_cpool */
+typedef struct {
+    double litter_in[NSOIL_POOLS];      /* C from litter & exudates (t/ha) */
+    double decomposed[NSOIL_POOLS];     /* C decomposed (t/ha) */
+    double pool[NSOIL_POOLS];           /* daily pool (t/ha) */
+    long   ndays;
+} spinup_fluxes;
+
+void    spin_up_pools(canopy_wk *, control *, fluxes *, met_arrays *, met *,
+                      params *p, state *);
+void    run_spinup_cycle(canopy_wk *, control *, fluxes *, met_arrays *, met *,
+                         params *, state *, spinup_fluxes *);
+double  project_spinup_drift(double, double, int, int);
+int     accelerate_soil_pools(control *, state *, spinup_fluxes *, double *);
+
+#endif /* SPINUP_H */
@@ -0,0 +1,19 @@
+#ifndef SPINUP_LIBRARY_H
+#define SPINUP_LIBRARY_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+uint64_t spinup_state_key(control *, params *, state *);
+void     spinup_library_fname(control *, uint64_t, char *);
+int      load_spinup_state(control *, params *, state *, fluxes *, uint64_t);
+uint64_t hash_bytes(uint64_t, const void *, size_t);
+uint64_t hash_file(uint64_t, char *);
+
+#endif /* SPINUP_LIBRARY_H */
@@ -3,6 +3,19 @@
 
 #include "gday.h"
 
+/* the model option kernels, defined at the end */
+typedef struct model_kernels model_kernels;
+
+/* tabulated temperature responses, see temp_response.h */
+typedef struct temp_table temp_table;
+
+/* transfer matrix of the 7 soil litter & SOM pools, see soil_matrix.h */
+#define NSOIL_POOLS 7
+typedef struct soil_transfer soil_transfer;
+
+/* see telemetry.h */
+typedef struct telemetry_stream telemetry_stream;
+
 typedef struct {
     FILE *ifp;
     FILE *ofp;
@@ -12,10 +25,14 @@ typedef struct {
     char  out_fname[STRING_LENGTH];
     char  out_fname_hdr[STRING_LENGTH];
     char  out_param_fname[STRING_LENGTH];
+    char  checkpoint_fname[STRING_LENGTH];
+    char  restart_fname[STRING_LENGTH];
+    char  spinup_library[STRING_LENGTH];
     char  git_hash[STRING_LENGTH];
     int   adjust_rtslow;
     int   alloc_model;
     int   assim_model;
+    int   async_output;
     int   calc_sw_params;
     int   deciduous_model;
     int   disturbance;
@@ -49,80 +66,122 @@ typedef struct {
     int   num_hlf_hrs;
     long  hour_idx;
     long  day_idx;
+    long  seed;
+    int   spinup_check_interval;
+    int   spinup_extrapolate;
+    int   spinup_accelerate;
+    int   checkpoint_interval;
+    int   leaf_kernel;
+    int   print_leaf_iter;
+    int   restart;
+    int   restart_mode;
+    unsigned long long rng_state;
+    int   batch;
+    int   num_threads;
+    char  batch_fname[STRING_LENGTH];
+    int   region;                       /* run the cell list region_fname */
+    char  region_fname[STRING_LENGTH];
+    int   branch;                       /* fork the runs in branch_fname */
+    char  branch_fname[STRING_LENGTH];
+    int   branch_year;                  /* ... at the start of this year */
+    char **run_overrides;               /* this run's own section.name=value */
+    int   num_run_overrides;
+    int   convert_met;
+    char  met_bin_fname[STRING_LENGTH];
+    int   output_vars[MAX_OUTPUT_VARS];  /* registry index of each output column */
+    int   num_output_vars;
+    int   output_period;                /* OUTPUT_PERIOD_* */
+    int   output_period_days;           /* for OUTPUT_PERIOD_NDAYS */
+    int   output_state_agg;             /* OUTPUT_STATE_MEAN/END */
+    int   num_output_records;           /* rows in the daily output file */
+    int   output_columnar;              /* chunked columnar output file */
+    int   output_chunk_len;             /* rows per columnar chunk */
+    int   output_compression;           /* OUTPUT_COMPRESS_* */
+    int   output_memory;                /* keep the outputs in memory (libgday) */
+    int   met_stream;                   /* stream the sub-daily forcing */
+    int   met_stream_years;             /* years of forcing held in memory */
+    model_kernels *kernels;             /* options resolved by resolve_model_options */
+    int   temp_tables;                  /* interpolate the temperature responses from tables */
+    int   temp_table_res;               /* table points per deg C */
+    temp_table *temp_resp;              /* built by build_temp_table, NULL when off */
+    soil_transfer *soil_tr;             /* built by build_soil_transfer */
+    char  telemetry_fname[STRING_LENGTH]; /* JSON lines progress stream, file or unix:socket */
+    double telemetry_interval;          /* s between progress records */
+    char  run_label[STRING_LENGTH];     /* names the run in its telemetry */
+    telemetry_stream *telemetry;        /* open stream, NULL when off */
 
 } control;
 
 
 typedef struct {
-    double activesoil;                  /* active C som pool (t/ha) */
-    double activesoiln;                 /* active N som pool (t/ha) */
-    double age;                         /* Current stand age (years) */
-    double avg_albranch;                /* Average branch growing season allocation fractions */
-    double avg_alcroot;                 /* Average coarse root growing season allocation fractions */
-    double avg_alleaf;                  /* Average leaf growing season allocation fractions */
-    double avg_alroot;                  /* Average fine root growing season allocation fractions */
-    double avg_alstem;                  /* Average stem growing season allocation fractions */
-    double branch;                      /* branch c (t/ha) */
-    double branchn;                     /* branch n (t/ha) */
-    double canht;                       /* canopy height (m) */
-    double croot;                       /* coarse root c (t/ha) */
-    double crootn;                      /* coarse root n (t/ha) */
-    double cstore;                      /* C store for deciduous model (t/ha) */
-    double inorgn;                      /* Inorganic soil N pool - dynamic (t/ha) */
-    double lai;                         /* leaf area index m2 (leaf) m-2 (ground) */
+    /* per timestep: read (and most of it written) by the canopy and water
+       balance on every sub-daily step */
+    double lai;                     /* leaf area index m2 (leaf) m-2 (ground) */
+    double sla;                     /* specific leaf area */
     double fipar;
-    double metabsoil;                   /* metabolic soil c (t/ha) */
-    double metabsoiln;                  /* metabolic soil n (t/ha) */
-    double metabsurf;                   /* metabolic surface c (t/ha) */
-    double metabsurfn;                  /* metabolic surface n (t/ha) */
-    double nstore;                      /* N store for deciduous model (t/ha) */
-    double passivesoil;                 /* passive C som pool (t/ha) */
-    double passivesoiln;                /* passive N som pool (t/ha) */
-    double pawater_root;                /* plant available water - root zone (mm) */
-    double pawater_topsoil;             /* plant available water - top soil(mm) */
-    double prev_sma;
-    double root;                        /* root c (t/ha) */
-    double root_depth;                  /* rooting depth, Dmax (m) */
-    double rootn;                       /* root n (t/ha) */
-    double sapwood;
-    double shoot;                       /* shoot c (t/ha) */
-    double shootn;                      /* shoot n (t/ha) */
-    double sla;                         /* specific leaf area */
-    double slowsoil;                    /* slow C som pool (t/ha) */
-    double slowsoiln;                   /* slow N som pool (t/ha) */
-    double stem;
-    double stemn;                       /* Stem N (t/ha) = stemnimm + stemnmob */
-    double stemnimm;
-    double stemnmob;
-    double structsoil;                  /* soil structural c (t/ha) */
-    double structsoiln;                 /* soil structural n (t/ha) */
-    double structsurf;                  /* surface structural c (t/ha) */
-    double structsurfn;                 /* surface structural n (t/ha) */
+    double canht;                   /* canopy height (m) */
     double shootnc;
-    double rootnc;
-    double remaining_days[366];
     double wtfac_root;
     double wtfac_topsoil;
+    double pawater_root;            /* plant available water - root zone (mm) */
+    double pawater_topsoil;         /* plant available water - top soil(mm) */
     double delta_sw_store;
+    double canopy_store;
+    double psi_s_root;
+    double psi_s_topsoil;
     double b_root;
-    double theta_sat_root;
-    double theta_sat_topsoil;
+    double b_topsoil;
     double psi_sat_root;
     double psi_sat_topsoil;
-    double b_topsoil;
-    double leaf_out_days[366];
-    double growing_days[366];
-    double c_to_alloc_shoot;
-    double n_to_alloc_shoot;
-    double n_to_alloc_root;
-    double c_to_alloc_root;
-    double c_to_alloc_croot;
-    double n_to_alloc_croot;
-    double c_to_alloc_branch;
-    double n_to_alloc_branch;
-    double c_to_alloc_stem;
-    double n_to_alloc_stemmob;
-    double n_to_alloc_stemimm;
+    double theta_sat_root;
+    double theta_sat_topsoil;
+
+    /* per day: the C & N pools and totals */
+    /* the soil litter & SOM pools, also as vectors in the order of
+       p->decayrate for the transfer matrix, see soil_matrix.h */
+    union {
+        struct {
+            double structsurf;         /* surface structural c (t/ha) */
+            double metabsurf;          /* metabolic surface c (t/ha) */
+            double structsoil;         /* soil structural c (t/ha) */
+            double metabsoil;          /* metabolic soil c (t/ha) */
+            double activesoil;         /* active C som pool (t/ha) */
+            double slowsoil;           /* slow C som pool (t/ha) */
+            double passivesoil;        /* passive C som pool (t/ha) */
+        };
+        double soil_cpool[NSOIL_POOLS];
+    };
+    union {
+        struct {
+            double structsurfn;        /* surface structural n (t/ha) */
+            double metabsurfn;         /* metabolic surface n (t/ha) */
+            double structsoiln;        /* soil structural n (t/ha) */
+            double metabsoiln;         /* metabolic soil n (t/ha) */
+            double activesoiln;        /* active N som pool (t/ha) */
+            double slowsoiln;          /* slow N som pool (t/ha) */
+            double passivesoiln;       /* passive N som pool (t/ha) */
+        };
+        double soil_npool[NSOIL_POOLS];
+    };
+    double branch;                  /* branch c (t/ha) */
+    double branchn;                 /* branch n (t/ha) */
+    double croot;                   /* coarse root c (t/ha) */
+    double crootn;                  /* coarse root n (t/ha) */
+    double cstore;                  /* C store for deciduous model (t/ha) */
+    double inorgn;                  /* Inorganic soil N pool - dynamic (t/ha) */
+    double nstore;                  /* N store for deciduous model (t/ha) */
+    double prev_sma;
+    double root;                    /* root c (t/ha) */
+    double root_depth;              /* rooting depth, Dmax (m) */
+    double rootn;                   /* root n (t/ha) */
+    double sapwood;
+    double shoot;                   /* shoot c (t/ha) */
+    double shootn;                  /* shoot n (t/ha) */
+    double stem;
+    double stemn;                   /* Stem N (t/ha) = stemnimm + stemnmob */
+    double stemnimm;
+    double stemnmob;
+    double rootnc;
     double anpp;
     double litterc;
     double littern;
@@ -136,9 +195,29 @@ typedef struct {
     double totalc;
     double soilc;
     double soiln;
-    double canopy_store;
-    double psi_s_topsoil;
-    double psi_s_root;
+
+    /* per year: set at the start of the growing season (deciduous
+       phenology) and by the annual allocation */
+    double age;                     /* Current stand age (years) */
+    double avg_albranch;            /* Average branch growing season allocation fractions */
+    double avg_alcroot;             /* Average coarse root growing season allocation fractions */
+    double avg_alleaf;              /* Average leaf growing season allocation fractions */
+    double avg_alroot;              /* Average fine root growing season allocation fractions */
+    double avg_alstem;              /* Average stem growing season allocation fractions */
+    double c_to_alloc_shoot;
+    double n_to_alloc_shoot;
+    double n_to_alloc_root;
+    double c_to_alloc_root;
+    double c_to_alloc_croot;
+    double n_to_alloc_croot;
+    double c_to_alloc_branch;
+    double n_to_alloc_branch;
+    double c_to_alloc_stem;
+    double n_to_alloc_stemmob;
+    double n_to_alloc_stemimm;
+    double remaining_days[366];
+    double leaf_out_days[366];
+    double growing_days[366];
 } state;
 
 typedef struct {
@@ -312,7 +391,7 @@ typedef struct {
     double z0h_z0m;                         /* Assume z0m = z0h, probably a big assumption [as z0h often < z0m.], see comment in code!! But 0.1 might be a better assumption */
     double fmleaf;
     double fmroot;
-    double decayrate[7];
+    double decayrate[NSOIL_POOLS];
     double fmfaeces;
     int    growing_seas_len;
     double prime_y;
@@ -326,37 +405,108 @@ typedef struct {
     double leaf_abs;
 } params;
 
+/* phenology drivers for one year of the (daily) met forcing */
+typedef struct {
+    int     start_day;                  /* met row of 1 Jan */
+    int     num_days;                   /* 365 or 366 */
+    double *accum_gdd;                  /* GDD summed from 1 Jan, by doy-1 */
+    double *ppt_sum;                    /* rain summed from 1 Jan, by doy-1 */
+    int    *leaf_drop;                  /* would trees drop their leaves today */
+    double  ncd;                        /* chill days from 1 Nov */
+
+    /* grass thresholds, see calc_ini_grass_pheno_stuff */
+    double  grass_temp_threshold;
+    double  tmax_ann;
+    double  Tmin_avg;
+    double  ppt_sum_crit;
+} met_year;
+
+/*
+    Everything that can be worked out from the forcing (and site) alone,
+    done once when the simulation starts and looked up by every year of
+    the run, and every spin-up cycle, after that
+*/
 typedef struct {
+    double    latitude;                 /* site the tables were built for */
+    double    daylen[2][366];           /* day length (hrs), [leap year][doy-1] */
+    int       num_years;
+    met_year *years;                    /* NULL unless deciduous, daily */
+} met_forcing;
+
+struct met_stream;
+
+/*
+    Precision the met forcing is held in. Building with -DMET_FLOAT halves
+    the memory (and bandwidth) the forcing takes, values are widened to
+    double as they are read, see README for how far the outputs move.
+*/
+#ifdef MET_FLOAT
+typedef float met_real;
+#else
+typedef double met_real;
+#endif
 
-    double *year;
-    double *rain;
-    double *par;
-    double *tair;
-    double *tsoil;
-    double *co2;
-    double *ndep;
-    double *wind;
-    double *press;
+/*
+    The terms of the Penman-Monteith and leaf energy balance that only
+    depend on a timestep's air temperature, pressure (and vpd), worked out
+    once per row of the forcing by derive_met_columns (forcing.c)
+*/
+typedef struct {
+    double lambda;                      /* latent heat of vapourisation (J mol-1) */
+    double gamma;                       /* psychrometric constant (Pa K-1) */
+    double slope;                       /* slope of sat. vapour press. curve (Pa K-1) */
+    double gradn;                       /* radiation conductance (mol m-2 s-1) */
+    double net_lw;                      /* isothermal net LW loss (W m-2), sub-daily */
+} met_derived;
+
+/*
+    The met forcing, one array per variable indexed by timestep. When the
+    forcing is streamed (met_stream.c) only a window of years is held and
+    the row for timestep i is i - row0.
+*/
+typedef struct {
+
+    met_real *year;
+    met_real *rain;
+    met_real *par;
+    met_real *tair;
+    met_real *tsoil;
+    met_real *co2;
+    met_real *ndep;
+    met_real *wind;
+    met_real *press;
 
     /* Day timestep */
-    double *prjday; /* should really be renamed to doy for consistancy */
-    double *tam;
-    double *tpm;
-    double *tmin;
-    double *tmax;
-    double *tday;
-    double *vpd_am;
-    double *vpd_pm;
-    double *wind_am;
-    double *wind_pm;
-    double *par_am;
-    double *par_pm;
+    met_real *prjday; /* should really be renamed to doy for consistancy */
+    met_real *tam;
+    met_real *tpm;
+    met_real *tmin;
+    met_real *tmax;
+    met_real *tday;
+    met_real *vpd_am;
+    met_real *vpd_pm;
+    met_real *wind_am;
+    met_real *wind_pm;
+    met_real *par_am;
+    met_real *par_pm;
 
     /* sub-daily timestep */
-    double *vpd;
-    double *doy;
-    double *diffuse_frac;
-
+    met_real *vpd;
+    met_real *doy;
+    met_real *diffuse_frac;
+
+    /* derived from tair/press, NULL for a streamed forcing (see forcing.c) */
+    met_derived *derived;               /* daily: from the day's mean tair */
+    met_derived *derived_am;            /* daily only, morning */
+    met_derived *derived_pm;            /* daily only, afternoon */
+
+    long    nrows;                      /* number of timesteps in the forcing */
+    void   *map_base;                   /* mmap'ed binary forcing, else NULL */
+    size_t  map_len;
+    void   *cache_entry;                /* shared met_cache entry, else NULL */
+    met_forcing *forcing;               /* this run's preprocessing (forcing.c) */
+    long    row0;                       /* forcing row held in element 0 */
+    struct met_stream *stream;          /* streamed forcing, else NULL */
 
 } met_arrays;
 
@@ -387,6 +537,11 @@ typedef struct {
     double Tk_am;
     double Tk_pm;
 
+    /* this timestep's row of the derived columns */
+    met_derived derived;
+    met_derived derived_am;
+    met_derived derived_pm;
+
 } met;
 
 
@@ -408,30 +563,16 @@ typedef struct {
 
 
 typedef struct {
+    /* per timestep: summed over the day by the canopy and water balance
+       on every sub-daily step */
     double gpp_gCm2;
     double npp_gCm2;
-    double gpp_am;
-    double gpp_pm;
     double gpp;
     double npp;
-    double nep;
     double auto_resp;
-    double hetero_resp;
-    double retrans;
     double apar;
 
-    /* n */
-    double nuptake;
-    double nloss;
-    double npassive;        /* n passive -> active */
-    double ngross;          /* N gross mineralisation */
-    double nimmob;          /* N immobilisation in SOM */
-    double nlittrelease;    /* N rel litter = struct + metab */
-    double activelossf;     /* frac of active C -> CO2 */
-    double nmineralisation;
-
     /* water fluxes */
-    double wue;
     double et;
     double soil_evap;
     double transpiration;
@@ -443,6 +584,24 @@ typedef struct {
     double ga_mol_m2_sec;
     double omega;
 
+    /* per day */
+    double gpp_am;
+    double gpp_pm;
+    double nep;
+    double hetero_resp;
+    double retrans;
+    double wue;
+
+    /* n */
+    double nuptake;
+    double nloss;
+    double npassive;        /* n passive -> active */
+    double ngross;          /* N gross mineralisation */
+    double nimmob;          /* N immobilisation in SOM */
+    double nlittrelease;    /* N rel litter = struct + metab */
+    double activelossf;     /* frac of active C -> CO2 */
+    double nmineralisation;
+
     /* daily C production */
     double cpleaf;
     double cproot;
@@ -534,6 +693,12 @@ typedef struct {
     /* CO2 flows to the air */
     double co2_to_air[7];
 
+    /* the same day's flows by soil pool, in the order of s->soil_cpool */
+    double soil_litter_c[NSOIL_POOLS];  /* plant & faeces C into the pool */
+    double soil_c_out[NSOIL_POOLS];     /* C decomposed */
+    double soil_c_in[NSOIL_POOLS];      /* decomposed C from the other pools */
+    double soil_n_out[NSOIL_POOLS];     /* N leaving with it */
+
     /* C allocated fracs  */
     double alleaf;
     double alroot;
@@ -554,6 +719,16 @@ typedef struct {
     double co2_rel_from_slow_pool;
     double co2_rel_from_passive_pool;
 
+    /* priming/exudation */
+    double root_exc;
+    double root_exn;
+    double co2_released_exud;
+    double factive;
+    double rtslow;
+    double rexc_cue;
+
+    /* per year: the deciduous growth and litterfall rates, set at the
+       start of the growing season */
     double lrate;
     double wrate;
     double brate;
@@ -564,16 +739,23 @@ typedef struct {
     double wnimrate;
     double wnmobrate;
     double cnrate;
-
-    /* priming/exudation */
-    double root_exc;
-    double root_exn;
-    double co2_released_exud;
-    double factive;
-    double rtslow;
-    double rexc_cue;
 } fluxes;
 
+#define SOLAR_TABLE_NDAYS 366
+#define SOLAR_TABLE_NHRS 48
+
+/*
+    Sun position for every half-hour of the year at one site, filled in
+    once by build_solar_table (see radiation.c). Indexed [doy-1][hod]
+*/
+typedef struct {
+    double latitude;        /* site the table was built for (deg) */
+    double longitude;
+    double cos_zenith[SOLAR_TABLE_NDAYS][SOLAR_TABLE_NHRS];
+    double elevation[SOLAR_TABLE_NDAYS][SOLAR_TABLE_NHRS];
+    double So[SOLAR_TABLE_NDAYS][SOLAR_TABLE_NHRS];
+} solar_table;
+
 typedef struct {
     /* 2 member arrays are for the sunlit (0) and shaded (1) components */
     int    ileaf;           /* sunlit (0) or shaded (1) leaf index */
@@ -598,12 +780,43 @@ typedef struct {
     double cos_zenith;      /* cos(zenith angle of sun) in radians */
     double diffuse_frac;    /* Fraction of incident rad which is diffuse (-) */
     double direct_frac;     /* Fraction of incident rad which is beam (-) */
-    double tleaf_new;       /* new leaf temperature (deg C) */
-    double dleaf;           /* leaf VPD (Pa) */
-    double Cs;              /* CO2 conc at the leaf surface (umol mol-1) */
+    double So;              /* extra-terrestrial radiation (J m-2 s-1) */
+    solar_table *solar;     /* precomputed sun positions, NULL if not built */
+    double tleaf_new[2];    /* new leaf temperature (deg C) */
+    double dleaf[2];        /* leaf VPD (Pa) */
+    double Cs[2];           /* CO2 conc at the leaf surface (umol mol-1) */
     double kb;              /* beam radiation ext coeff of canopy */
     double cscalar[2];      /* scale from single leaf to canopy */
+    int    leaf_solves;     /* leaf temperature solves so far today */
+    long   leaf_iter_sum;   /* total leaf temperature iterations today */
+    int    leaf_iter_max;   /* most iterations any leaf needed today */
+    int    leaf_unsettled;  /* leaves that hit LEAF_ITER_MAX today */
 } canopy_wk;
 
+/*
+    The variant of each model option chosen by the .cfg file, looked up once
+    by resolve_model_options (model_options.c) so the daily and half-hourly
+    code calls straight into it rather than re-testing the control flags
+*/
+struct model_kernels {
+    /* modeljm: Jmax and Vcmax at the leaf temperature, before water stress
+       (canopy, i.e. sub_daily) and for the daily MATE model */
+    void   (*jmax_vcmax)(control *, params *, double, double, double,
+                         double *, double *);
+    void   (*mate_jmax_vcmax)(control *, params *, double, double, double,
+                              double *, double *);
+    /* ps_pathway */
+    void   (*leaf_photosynthesis)(control *, canopy_wk *, met *, params *,
+                                  state *);
+    void   (*mate_photosynthesis)(control *, fluxes *, met *, params *,
+                                  state *, double, double);
+    /* alloc_model */
+    void   (*alloc_fracs)(control *, fluxes *, params *, state *, double);
+    /* nuptake_model */
+    double (*nuptake)(params *, state *);
+    /* sw_stress_model */
+    void   (*soil_water_fac)(params *, state *);
+};
+
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "gday.h"
+#include "utilities.h"
+#include "sim_context.h"
+
+/* most a record can hold, it is written out in one go: up to three
+   strings (json_string keeps each to STRING_LENGTH) and the numbers */
+#define TELEMETRY_RECORD_LEN (3 * STRING_LENGTH + 2048)
+
+/* a telemetry_fname naming a unix domain socket rather than a file */
+#define TELEMETRY_SOCKET_PREFIX "unix:"
+
+/*
+    A run's telemetry stream, opened on its first sim_init and closed with
+    its context. Spin-up cycles, which are each a run of their own, carry
+    on writing to the same one.
+*/
+struct telemetry_stream {
+    int     fd;                         /* -1 once a write has failed */
+    int     is_socket;
+    char    label[STRING_LENGTH];       /* run_label, else the .cfg */
+    int64_t start_ns;                   /* when it was opened */
+    int64_t last_ns;                    /* last progress record */
+    long    days;                       /* days simulated, all cycles */
+    long    years;                      /* years simulated, all cycles */
+    long    last_years;                 /* ... at the last progress record */
+    int64_t leaf_solves;                /* leaf temperature solves since then */
+    int64_t leaf_iter;
+    int     cycle;                      /* spin-up cycle, 0 = not spinning up */
+};
+
+void    open_telemetry(control *);
+void    close_telemetry(control *);
+void    telemetry_day(control *, canopy_wk *);
+void    telemetry_year(sim_context *);
+void    telemetry_spinup_cycle(control *, state *, int, double, double);
+void    telemetry_spinup_test(control *, int, double, double, double, int);
+void    write_telemetry_record(telemetry_stream *, char *, int);
+int     telemetry_header(telemetry_stream *, char *, int, const char *);
+int     json_number(char *, int, double);
+int     json_string(char *, int, const char *);
+void    get_memory_use(double *, double *);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,104 @@
+#ifndef TEMP_RESPONSE_H
+#define TEMP_RESPONSE_H
+
+#include "gday.h"
+#include "constants.h"
+#include "photosynthesis.h"
+#include "soils.h"
+
+/* range of the tables (deg C), anything outside is worked out exactly */
+#define TEMP_TABLE_TMIN -50.0
+#define TEMP_TABLE_TMAX  60.0
+
+/* columns of the table, the Arrhenius ones are for k25 = 1 */
+enum {
+    TT_GAMSTAR,     /* CO2 compensation point, eag */
+    TT_KC,          /* Michaelis-Menten, carboxylation, eac */
+    TT_KO,          /* Michaelis-Menten, oxygenation, eao */
+    TT_VCMAX,       /* Vcmax, eav */
+    TT_JMAX,        /* Jmax, peaked with eaj, delsj, edj */
+    TT_SOIL,        /* soil temperature factor for decomposition */
+    TT_NCOLS
+};
+
+/*
+    Temperature responses tabulated every 1 / temp_table_res deg C over the
+    run's parameters (see temp_response.c). Row i holds the TT_NCOLS
+    responses at tmin + i * step, so one lookup reads one or two cache lines
+*/
+struct temp_table {
+    double  tmin;
+    double  step;
+    double  inv_step;
+    int     n;                  /* rows */
+    double  max_rel_err;        /* worst interpolation error found at build */
+    double *v;                  /* [n][TT_NCOLS] */
+};
+
+void    build_temp_table(control *, params *);
+void    free_temp_table(control *);
+
+static inline int temp_lookup(temp_table *t, int col, double T,
+                              double *value) {
+    /* linear interpolation in the table, FALSE outside it (or no table) */
+    double x, w, *v;
+    int    i;
+
+    if (t == NULL)
+        return (FALSE);
+    x = (T - t->tmin) * t->inv_step;
+    if (!(x >= 0.0 && x < (double)(t->n - 1)))
+        return (FALSE);
+
+    i = (int)x;
+    w = x - (double)i;
+    v = t->v + i * TT_NCOLS + col;
+    *value = v[0] + w * (v[TT_NCOLS] - v[0]);
+
+    return (TRUE);
+}
+
+static inline double table_arrhenius(temp_table *t, int col, double k25,
+                                     double Ea, double T, double Tref) {
+    /* arrhenius(), from the table when there is one */
+    double factor;
+
+    if (temp_lookup(t, col, T, &factor))
+        return (k25 * factor);
+    return (arrhenius(k25, Ea, T, Tref));
+}
+
+static inline double table_peaked_arrhenius(temp_table *t, int col,
+                                            double k25, double Ea, double T,
+                                            double Tref, double deltaS,
+                                            double Hd) {
+    /* peaked_arrhenius(), from the table when there is one */
+    double factor;
+
+    if (temp_lookup(t, col, T, &factor))
+        return (k25 * factor);
+    return (peaked_arrhenius(k25, Ea, T, Tref, deltaS, Hd));
+}
+
+static inline double table_arrh(temp_table *t, int col, double mt,
+                                double k25, double Ea, double Tk) {
+    /* arrh(), the MATE form in Kelvin, mt = measurement_temp in K */
+    double factor;
+
+    if (temp_lookup(t, col, Tk - DEG_TO_KELVIN, &factor))
+        return (k25 * factor);
+    return (arrh(mt, k25, Ea, Tk));
+}
+
+static inline double table_peaked_arrh(temp_table *t, int col, double mt,
+                                       double k25, double Ea, double Tk,
+                                       double deltaS, double Hd) {
+    /* peaked_arrh(), the MATE form in Kelvin */
+    double factor;
+
+    if (temp_lookup(t, col, Tk - DEG_TO_KELVIN, &factor))
+        return (k25 * factor);
+    return (peaked_arrh(mt, k25, Ea, Tk, deltaS, Hd));
+}
+
+#endif /* TEMP_RESPONSE_H */
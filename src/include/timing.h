@@ -0,0 +1,51 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "gday.h"
+#include "utilities.h"
+
+/* regions timed in a -DGDAY_TIMING build, times include nested regions */
+#define TIMER_READ_MET 0
+#define TIMER_DAY 1                     /* simulate_day */
+#define TIMER_DAY_GROWTH 2              /* calc_day_growth */
+#define TIMER_CANOPY 3                  /* canopy / carbon_daily_production */
+#define TIMER_WATER_BALANCE 4
+#define TIMER_CSOIL 5
+#define TIMER_NSOIL 6
+#define TIMER_PHENOLOGY 7
+#define TIMER_OUTPUTS 8                 /* handing the day to the writers */
+#define NUM_TIMERS 9
+
+/* solver counters */
+#define COUNTER_LEAF_SOLVES 0           /* leaf temperature solutions */
+#define COUNTER_LEAF_ITER 1             /* iterations of the leaf loop */
+#define COUNTER_NEWTON_CALLS 2          /* optimal root newton() */
+#define COUNTER_NEWTON_ITER 3
+#define COUNTER_QUAD_FAIL 4             /* quadratics without a real root */
+#define NUM_COUNTERS 5
+
+/*
+    With -DGDAY_TIMING these accumulate wall time and call counts per region
+    and the solver counters, reported when the program exits (see README).
+    Otherwise they compile to nothing.
+*/
+#ifdef GDAY_TIMING
+#define TIMER_START(t) int64_t timer_start_##t = timing_clock()
+#define TIMER_STOP(t) add_timing(t, timing_clock() - timer_start_##t)
+#define COUNT_EVENTS(k, n) add_count(k, n)
+#else
+#define TIMER_START(t)
+#define TIMER_STOP(t)
+#define COUNT_EVENTS(k, n)
+#endif
+
+int64_t timing_clock(void);
+void    add_timing(int, int64_t);
+void    add_count(int, int64_t);
+void    report_timing(void);
+void    write_timing_json(char *);
+
+#endif /* TIMING_H */
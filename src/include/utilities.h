@@ -27,4 +27,7 @@ char   *find_char_or_comment(char*, char);
 char   *strncpy0(char*, char*, size_t);
 char   *strip_first_and_last_character(char);
 
+void   seed_random(unsigned long long *, unsigned long long);
+double random_uniform(unsigned long long *);
+
 #endif /* UTILITIES_H */
@@ -11,15 +11,17 @@ void    update_water_storage(control *, fluxes *, params *, state *, double,
 double  calc_canopy_evaporation(met *, params *, state *, double);
 void    calculate_water_balance(control *, fluxes *, met *, params *,
                               state *, int, double, double, double);
+void    calculate_water_balance_night(control *, fluxes *, met *, params *,
+                                      state *);
 void    zero_water_day_fluxes(fluxes *);
 void    update_water_storage_recalwb(control *, fluxes *, params *, state *,
                                      met *);
 double  calc_soil_evaporation(met *, params*, state *, double);
 void    calc_interception(control *c, met *m, params *, fluxes *, state *,
                           double *, double *, double *);
-void    penman_canopy_wrapper(params *, state *, double, double, double, double,
-                              double, double, double, double *, double *,
-                              double *, double *, double *);
+void    penman_canopy_wrapper(params *, state *, met_derived *, double, double,
+                              double, double, double, double, double, double *,
+                              double *, double *, double *, double *);
 void    penman_leaf_wrapper(met *, params *, state *, double, double,
                             double, double *, double *, double *, double *,
                             double *, double *);
@@ -36,12 +38,14 @@ double  calc_slope_of_sat_vapour_pressure_curve(double);
 void    calc_soil_water_potential(control *, params *, state *);
 double  calc_sw_modifier(double, double, double);
 void    initialise_soil_moisture_parameters(control *, params *);
-double *get_soil_fracs(char *);
+void    get_soil_fracs(char *, double *);
 double  calc_beta(double, double, double, double, double);
 void    get_soil_params(char *, double *, double *);
 void    calc_soil_params(double *, double *, double *,
                         double *, double *, double *);
 void    calculate_soil_water_fac(control *, params *, state *);
+void    soil_water_fac_jules(params *, state *);
+void    soil_water_fac_landsberg(params *, state *);
 void    sum_hourly_water_fluxes(fluxes *, double, double, double, double,
                                 double, double, double, double);
 void    update_daily_water_struct(fluxes *, double, double, double, double,
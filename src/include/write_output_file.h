@@ -4,11 +4,19 @@
 
 #include "gday.h"
 #include "utilities.h"
+#include "output_vars.h"
+
+#define OUTPUT_CHARS_PER_VAL 64     /* room for one "%.10f," */
 
 void  open_output_file(control *, char *, FILE **);
+void  open_daily_output_files(control *);
 void  write_output_header(control *, FILE **);
+void  write_output_description(control *, FILE **);
 void  write_daily_outputs_ascii(control *, fluxes *, state *, int, int);
 void  write_daily_outputs_binary(control *, fluxes *, state *, int, int);
+void  write_output_record(control *, const double *, int);
+int   pack_daily_outputs(control *, fluxes *, state *, int, int, double *);
+size_t format_output_record(const double *, int, char *, size_t);
 int   write_final_state(control *, params *p, state *);
 int   ohandler(char *, char *, char *, control *, params *p, state *, int *);
 
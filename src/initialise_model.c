@@ -17,6 +17,9 @@ void initialise_control(control *c) {
     strcpy(c->out_fname, "*NOT SET*");
     strcpy(c->out_fname_hdr, "*NOT SET*");
     strcpy(c->out_param_fname, "*NOT SET*");
+    strcpy(c->checkpoint_fname, "*NOT SET*");
+    strcpy(c->restart_fname, "*NOT SET*");
+    strcpy(c->spinup_library, "*NOT SET*");
 
     c->alloc_model = ALLOMETRIC;    /* C allocation scheme: FIXED, GRASSES, ALLOMETRIC */
     c->assim_model = MATE;          /* Photosynthesis model: BEWDY (not coded :p) or MATE */
@@ -27,13 +30,27 @@ void initialise_control(control *c) {
     c->fixleafnc = FALSE;           /* fixed leaf N C ? */
     c->grazing = 0;                 /* Is foliage grazed? 0=No, 1=daily, 2=annual and then set disturbance_doy=doy */
     c->gs_model = MEDLYN;           /* Stomatal conductance model, currently only this one is implemented */
+    c->leaf_kernel = LEAF_KERNEL_BATCH; /* Leaf photosynthesis (sub-daily): SCALAR=one leaf at a time, BATCH=both leaves together */
     c->model_optroot = FALSE;       /* Ross's optimal root model...not sure if this works yet...0=off, 1=on */
+    c->met_stream = FALSE;          /* sub-daily: hold a few years of met in memory, read ahead on a separate thread, rather than the whole file */
+    c->met_stream_years = 3;        /* years held when streaming: the current one plus those being read ahead */
     c->modeljm = 2;                 /* modeljm=0, Jmax and Vcmax parameters are read in, modeljm=1, parameters are calculated from leaf N content, modeljm=2, Vcmax is calculated from leaf N content but Jmax is related to Vcmax */
     c->ncycle = TRUE;               /* Nitrogen cycle on or off? */
     c->nuptake_model = 2;           /* 0=constant uptake, 1=func of N inorgn, 2=depends on rate of soil N availability */
+    c->async_output = TRUE;         /* format/write daily outputs on a separate thread */
+    c->num_output_vars = 0;         /* no [outputs] section = standard set */
+    c->output_period = OUTPUT_PERIOD_DAILY;
+    c->output_period_days = 0;
+    c->output_state_agg = OUTPUT_STATE_MEAN;
+    c->num_output_records = 0;
+    c->output_columnar = FALSE;
+    c->output_chunk_len = 3650;     /* rows per block in columnar outputs */
+    c->output_compression = OUTPUT_COMPRESS_ZLIB;
+    c->output_memory = FALSE;       /* only set by a host driving libgday */
     c->output_ascii = TRUE;         /* If this is false you get a binary file as an output. */
     c->passiveconst = FALSE;        /* hold passive pool at passivesoil */
     c->print_options = DAILY;       /* DAILY=every timestep, END=end of run */
+    c->print_leaf_iter = FALSE;     /* print daily mean/max leaf temperature iterations (sub-daily) to stderr? */
     c->ps_pathway = C3;             /* Photosynthetic pathway, c3/c4 */
     c->respiration_model = FIXED;   /* Plant respiration ... Fixed, TEMPERATURE or BIOMASS */
     c->strfloat = 0;                /* Structural pool input N:C varies=1, fixed=0 */
@@ -41,6 +58,13 @@ void initialise_control(control *c) {
     c->use_eff_nc = 0;              /* use constant leaf n:c for  metfrac s */
     c->water_stress = TRUE;         /* water stress modifier turned on=TRUE (default)...ability to turn off to test things without drought stress = FALSE */
     c->spin_up = FALSE;             /* Spin up to a steady state? If False it just runs the model */
+    c->seed = 1;                    /* Seed for this simulation's random number stream (disturbance return intervals) */
+    c->spinup_check_interval = 20;  /* Cycles of the met forcing between spin-up convergence tests */
+    c->spinup_extrapolate = FALSE;  /* Project the spin-up convergence test from the trend between tests? */
+    c->spinup_accelerate = FALSE;   /* Jump the slow & passive soil pools to their semi-analytic steady state during spin-up? */
+    c->checkpoint_interval = 0;     /* Write a checkpoint every N years, 0=never (a spin-up always writes one at the end if checkpoint_fname is set) */
+    c->restart = FALSE;             /* Start from the checkpoint in restart_fname? Set when restart_fname is given */
+    c->restart_mode = RESTART_RESUME; /* RESUME=carry on from the checkpoint, STATE=only take the state from it */
 
     /* Internal calculated */
     c->num_years = 0;               /* Total number of years simulated */
@@ -50,6 +74,28 @@ void initialise_control(control *c) {
 
     c->sub_daily = FALSE;           /* Run at daily or 30 minute timestep */
     c->num_hlf_hrs = 48;
+
+    c->batch = FALSE;               /* Run a manifest of simulations across threads? Set from the cmd line parsar */
+    c->num_threads = 0;             /* Number of batch worker threads, 0=one per core */
+    strcpy(c->batch_fname, "*NOT SET*");
+    c->region = FALSE;              /* Run a regional cell list? Set from the cmd line parsar */
+    strcpy(c->region_fname, "*NOT SET*");
+    c->branch = FALSE;              /* Branch scenarios off this run? Set from the cmd line parsar */
+    strcpy(c->branch_fname, "*NOT SET*");
+    c->branch_year = -1;            /* Year the scenarios branch at */
+    c->run_overrides = NULL;        /* Overrides of this run only (region cells), after any -set */
+    c->num_run_overrides = 0;
+    c->convert_met = FALSE;         /* Write the met forcing out as a binary file and exit? Set from the cmd line parsar */
+    strcpy(c->met_bin_fname, "*NOT SET*");
+    c->kernels = NULL;              /* Model option variants, filled in by resolve_model_options at sim_init */
+    c->temp_tables = FALSE;         /* Interpolate the Arrhenius & soil temperature responses from per-run tables? */
+    c->temp_table_res = 10;         /* Points per deg C in those tables */
+    c->temp_resp = NULL;            /* The tables, built at sim_init when temp_tables is on */
+    c->soil_tr = NULL;              /* Soil pool transfer matrix, built at sim_init */
+    strcpy(c->telemetry_fname, "*NOT SET*"); /* JSON lines telemetry, a file or unix:socket path */
+    c->telemetry_interval = 10.0;   /* Seconds between telemetry progress records, 0=every year */
+    strcpy(c->run_label, "*NOT SET*"); /* Run name in the telemetry, set for region cells & scenarios, else the .cfg */
+    c->telemetry = NULL;            /* The open stream, opened at the first sim_init */
     return;
 }
 
@@ -71,6 +117,7 @@ void initialise_params(params *p) {
     p->branch0 = 5.61;
     p->branch1 = 0.346;
     p->bretrans = 0.0;
+    p->burn_specific_yr = -999;
     p->c_alloc_bmax = 0.1;
     p->c_alloc_bmin = 0.1;
     p->c_alloc_cmax = 0.0;
@@ -94,6 +141,8 @@ void initialise_params(params *p) {
     p->direct_frac = 0.5;
     p->displace_ratio = 0.78;
     p->disturbance_doy = 1.0;
+    p->hurricane_doy = -999;
+    p->hurricane_yr = -999;
     p->dz0v_dh = 0.075;
     p->eac = 79430.0;   /* Temp. response of Kc (J mol-1) */
     p->eag = 37830.0;
@@ -187,6 +236,7 @@ void initialise_params(params *p) {
     p->rdecay = 0.33333;
     p->rdecaydry = 0.33333;
     p->retransmob = 0.0;
+    p->return_interval = -999;
     p->rfmult = 1.0;
     p->root_exu_CUE = -999.9;
     p->rooting_depth = 750.0;
@@ -368,6 +418,12 @@ void initialise_fluxes(fluxes *f) {
     for (i = 0; i < 7; i++) {
         f->co2_to_air[i] = 0.0;
     }
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        f->soil_litter_c[i] = 0.0;
+        f->soil_c_out[i] = 0.0;
+        f->soil_c_in[i] = 0.0;
+        f->soil_n_out[i] = 0.0;
+    }
 
     /* C allocated fracs  */
     f->alleaf = 0.0;
@@ -0,0 +1,298 @@
+/* ============================================================================
+* libgday: the model as a shared library (make lib), see include/libgday.h
+* for the API and scripts/gday_lib.py for the Python (ctypes) bindings.
+*
+* A model handle is a simulation context (sim_context.c) read from a .cfg
+* file, which is then driven with sim_init/sim_step/sim_finish exactly as
+* the gday program drives it. The daily (or aggregated) outputs go into an
+* output_buffer rather than a file, and forcing columns handed over by the
+* host replace the ones read from met_fname, both without copying.
+*
+* NOTES:
+*   Handles opened for the same met file share one copy of it (met_cache.c),
+*   so opening an ensemble of models only reads the forcing once.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "libgday.h"
+#include "gday.h"
+#include "met_binary.h"
+#include "forcing.h"
+#include "met_cache.h"
+#include "output_buffer.h"
+#include "output_vars.h"
+#include "param_table.h"
+
+/* for reporting errors in the .cfg and met files */
+static char *libgday_argv[] = { "libgday", NULL };
+
+struct gday_model {
+    sim_context *sc;
+    met_column   cols[MET_BIN_MAX_VARS]; /* the forcing columns by name */
+    met_real    *file_col[MET_BIN_MAX_VARS]; /* as read, restored on close */
+    int          ncols;
+    params       p0;                    /* as the .cfg left them, for reset */
+    state        s0;
+    fluxes       f0;
+};
+
+gday_model *gday_open(const char *cfg_fname) {
+    /*
+        Read a .cfg file and its met forcing, ready to run
+
+        Returns:
+        --------
+        m : gday_model
+            the model or NULL if the .cfg file can't be read
+    */
+    char        fname[STRING_LENGTH];
+    FILE       *fp;
+    gday_model *m;
+    int         i;
+
+    if (strlen(cfg_fname) >= sizeof(fname) ||
+        (fp = fopen(cfg_fname, "r")) == NULL)
+        return (NULL);
+    fclose(fp);
+    strcpy(fname, cfg_fname);
+
+    if ((m = (gday_model *)calloc(1, sizeof(gday_model))) == NULL) {
+        fprintf(stderr, "gday model: Not allocated enough memory!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    enable_met_cache();
+    m->sc = new_sim_context(libgday_argv, fname, FALSE);
+    m->sc->c->output_memory = TRUE;
+
+    m->ncols = get_met_columns(m->sc->c, m->sc->ma, m->cols);
+    for (i = 0; i < m->ncols; i++) {
+        m->file_col[i] = *(m->cols[i].col);
+    }
+    m->p0 = *(m->sc->p);
+    m->s0 = *(m->sc->s);
+    m->f0 = *(m->sc->f);
+
+    return (m);
+}
+
+void gday_close(gday_model *m) {
+    /* Release the model; the host's forcing arrays are left alone */
+    int i;
+
+    if (m == NULL)
+        return;
+
+    for (i = 0; i < m->ncols; i++) {
+        *(m->cols[i].col) = m->file_col[i];
+    }
+    free_sim_context(m->sc);
+    free(m);
+
+    /* drop this model's forcing unless another model is using it */
+    flush_met_cache();
+
+    return;
+}
+
+void gday_reset(gday_model *m) {
+    /*
+        Put the parameters, state and fluxes back to how the .cfg file left
+        them, undoing gday_set and any spin-up or earlier runs
+    */
+    *(m->sc->p) = m->p0;
+    *(m->sc->s) = m->s0;
+    *(m->sc->f) = m->f0;
+
+    return;
+}
+
+int gday_set(gday_model *m, const char *key, const char *value) {
+    /*
+        Set a [control], [params] or [state] value, given as it would be in
+        the .cfg file, e.g. gday_set(m, "params.g1", "3.2"). The [files] and
+        [outputs] are fixed once the model is open.
+    */
+    if (strncasecmp(key, "control.", 8) != 0 &&
+        strncasecmp(key, "params.", 7) != 0 &&
+        strncasecmp(key, "state.", 6) != 0)
+        return (-1);
+
+    return (set_param(m->sc->c, m->sc->p, m->sc->s, key, value) ? 0 : -1);
+}
+
+int gday_get(gday_model *m, const char *key, double *value) {
+    /* Current value of a numeric key, e.g. "state.soilc" after a spin-up */
+    char section[STRING_LENGTH];
+    const char *dot = strchr(key, '.');
+    const param_field *f;
+
+    if (dot == NULL || (size_t)(dot - key) >= sizeof(section))
+        return (-1);
+    strncpy0(section, (char *)key, dot - key + 1);
+
+    if ((f = find_param_field(section, dot + 1)) == NULL ||
+        get_param_value(f, m->sc->c, m->sc->p, m->sc->s, value) == FALSE)
+        return (-1);
+
+    return (0);
+}
+
+int gday_forcing_size(void) {
+    /* bytes per forcing value, 8 or 4 in a -DMET_FLOAT build */
+
+    return ((int)sizeof(met_real));
+}
+
+long gday_num_forcing_rows(gday_model *m) {
+    /* days, or 30 min timesteps for a sub_daily run, in the forcing */
+
+    return (m->sc->ma->nrows);
+}
+
+int gday_set_forcing(gday_model *m, const char *name, void *values,
+                     long nrows) {
+    /*
+        Drive the model with the host's values of one forcing variable in
+        place of those in the met file. The calendar (year, doy/prjday)
+        always comes from the met file.
+
+        Parameters:
+        -----------
+        name : char
+            column name, as listed in get_met_columns (met_binary.c)
+        values : met_real
+            nrows values, used without a copy
+        nrows : long
+            must equal gday_num_forcing_rows
+    */
+    met_arrays *ma = m->sc->ma;
+    int         i;
+
+    /* a streamed forcing only ever holds part of the file */
+    if (ma->stream != NULL || values == NULL || nrows != ma->nrows)
+        return (-1);
+
+    for (i = 0; i < m->ncols; i++) {
+        if (strcasecmp(m->cols[i].name, name) == 0)
+            break;
+    }
+    if (i == m->ncols ||
+        strcmp(m->cols[i].name, "year") == 0 ||
+        strcmp(m->cols[i].name, "doy") == 0 ||
+        strcmp(m->cols[i].name, "prjday") == 0)
+        return (-1);
+
+    *(m->cols[i].col) = (met_real *)values;
+
+    /* the day lengths and phenology drivers are rebuilt on the next run */
+    free_forcing(ma);
+
+    /*
+     * The Penman terms derived from these (derive_met_columns) no longer
+     * match, they're worked out as each timestep is unpacked instead. The
+     * block itself belongs to the met cache and the other models on it.
+     */
+    if (strcmp(m->cols[i].name, "tair") == 0 ||
+        strcmp(m->cols[i].name, "tam") == 0 ||
+        strcmp(m->cols[i].name, "tpm") == 0 ||
+        strcmp(m->cols[i].name, "press") == 0 ||
+        strcmp(m->cols[i].name, "vpd") == 0) {
+        ma->derived = NULL;
+        ma->derived_am = NULL;
+        ma->derived_pm = NULL;
+    }
+
+    return (0);
+}
+
+int gday_spin_up(gday_model *m) {
+    /*
+        Spin the pools up to equilibrium; the state is left in the model for
+        gday_get or a following gday_run. The final state is also written to
+        out_param_fname if the .cfg names one.
+    */
+    control *c = m->sc->c;
+    sim_context *sc = m->sc;
+
+    if (c->ofp != NULL) {
+        /* spun up before, the .cfg is copied out again from the top */
+        fclose(c->ofp);
+        c->ofp = NULL;
+        rewind(c->ifp);
+    }
+    c->spin_up = TRUE;
+    spin_up_pools(sc->cw, c, sc->f, sc->ma, sc->m, sc->p, sc->s);
+    c->spin_up = FALSE;
+
+    return (0);
+}
+
+int gday_run(gday_model *m) {
+    /*
+        Run over the forcing from the current state, keeping the outputs
+        selected in the .cfg (daily or aggregated) in memory
+    */
+    sim_context *sc = m->sc;
+
+    sc->c->spin_up = FALSE;
+    sc->c->print_options = DAILY;
+
+    sim_init(sc);
+    while (sim_step(sc)) {
+        ;
+    }
+    sim_finish(sc);
+
+    return (0);
+}
+
+int gday_num_outputs(gday_model *m) {
+    /* variables in each output record, including year and doy */
+
+    return (m->sc->c->num_output_vars);
+}
+
+const char *gday_output_name(gday_model *m, int idx) {
+    /* name of output column idx, NULL if there is no such column */
+
+    if (idx < 0 || idx >= m->sc->c->num_output_vars)
+        return (NULL);
+
+    return (get_output_var(m->sc->c->output_vars[idx])->name);
+}
+
+long gday_num_records(gday_model *m) {
+    /* records written by the last gday_run */
+
+    return (m->sc->buffer == NULL ? 0 : m->sc->buffer->nrecords);
+}
+
+const double *gday_output(gday_model *m, const char *name) {
+    /*
+        The last run's values of one output variable, gday_num_records of
+        them, or NULL if it isn't one of the outputs or nothing has been run
+    */
+    int i;
+
+    if (m->sc->buffer == NULL)
+        return (NULL);
+
+    for (i = 0; i < m->sc->c->num_output_vars; i++) {
+        if (strcasecmp(gday_output_name(m, i), name) == 0)
+            return (get_output_column(m->sc->buffer, i));
+    }
+
+    return (NULL);
+}
+
+const char *gday_version(void) {
+    /* git revision the library was built from */
+
+    return (build_git_sha);
+}
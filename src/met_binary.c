@@ -0,0 +1,266 @@
+/* ============================================================================
+* Binary columnar met forcing.
+*
+* Reading the CSV forcing means parsing every value with sscanf before the
+* first timestep, which for long 30 min runs takes longer than a lot of the
+* simulations. The binary file holds the same columns the CSV readers
+* produce, stored contiguously, so loading it is just an mmap and pointing
+* the met_arrays columns into the mapping; nothing is parsed or copied.
+*
+* Files are written from an existing CSV via the -m command line option,
+* e.g.
+*
+*   $ gday -p params/site.cfg -m met_data/site_met.bin
+*
+* and picked up automatically (by their magic number) when met_fname points
+* at one.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "met_binary.h"
+
+
+int get_met_columns(control *c, met_arrays *ma, met_column *cols) {
+    /*
+        List the forcing variables for the current timestep in the order
+        the CSV readers store them.
+
+        Returns:
+        --------
+        ncols : int
+            number of entries filled in cols
+    */
+    int n = 0;
+
+    if (c->sub_daily) {
+        cols[n].name = "year";    cols[n++].col = &(ma->year);
+        cols[n].name = "doy";     cols[n++].col = &(ma->doy);
+        cols[n].name = "rain";    cols[n++].col = &(ma->rain);
+        cols[n].name = "par";     cols[n++].col = &(ma->par);
+        cols[n].name = "tair";    cols[n++].col = &(ma->tair);
+        cols[n].name = "tsoil";   cols[n++].col = &(ma->tsoil);
+        cols[n].name = "vpd";     cols[n++].col = &(ma->vpd);
+        cols[n].name = "co2";     cols[n++].col = &(ma->co2);
+        cols[n].name = "ndep";    cols[n++].col = &(ma->ndep);
+        cols[n].name = "wind";    cols[n++].col = &(ma->wind);
+        cols[n].name = "press";   cols[n++].col = &(ma->press);
+    } else {
+        cols[n].name = "year";    cols[n++].col = &(ma->year);
+        cols[n].name = "prjday";  cols[n++].col = &(ma->prjday);
+        cols[n].name = "tair";    cols[n++].col = &(ma->tair);
+        cols[n].name = "rain";    cols[n++].col = &(ma->rain);
+        cols[n].name = "tsoil";   cols[n++].col = &(ma->tsoil);
+        cols[n].name = "tam";     cols[n++].col = &(ma->tam);
+        cols[n].name = "tpm";     cols[n++].col = &(ma->tpm);
+        cols[n].name = "tmin";    cols[n++].col = &(ma->tmin);
+        cols[n].name = "tmax";    cols[n++].col = &(ma->tmax);
+        cols[n].name = "tday";    cols[n++].col = &(ma->tday);
+        cols[n].name = "vpd_am";  cols[n++].col = &(ma->vpd_am);
+        cols[n].name = "vpd_pm";  cols[n++].col = &(ma->vpd_pm);
+        cols[n].name = "co2";     cols[n++].col = &(ma->co2);
+        cols[n].name = "ndep";    cols[n++].col = &(ma->ndep);
+        cols[n].name = "wind";    cols[n++].col = &(ma->wind);
+        cols[n].name = "press";   cols[n++].col = &(ma->press);
+        cols[n].name = "wind_am"; cols[n++].col = &(ma->wind_am);
+        cols[n].name = "wind_pm"; cols[n++].col = &(ma->wind_pm);
+        cols[n].name = "par_am";  cols[n++].col = &(ma->par_am);
+        cols[n].name = "par_pm";  cols[n++].col = &(ma->par_pm);
+    }
+
+    return (n);
+}
+
+int is_binary_met_file(char *fname) {
+    /* Does the file start with the binary met magic number? */
+    FILE *fp;
+    char  magic[8];
+    int   is_binary = FALSE;
+
+    if ((fp = fopen(fname, "rb")) == NULL)
+        return (FALSE);
+
+    if (fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+        memcmp(magic, MET_BIN_MAGIC, sizeof(magic)) == 0)
+        is_binary = TRUE;
+    fclose(fp);
+
+    return (is_binary);
+}
+
+void read_binary_met_data(char **argv, control *c, met_arrays *ma) {
+    /*
+        mmap a binary met file and point the met_arrays columns straight
+        into it. The mapping is released by free_met_data.
+    */
+    int             fd, i, j, ncols, found;
+    struct stat     sb;
+    char           *base;
+    met_bin_header *hdr;
+    met_column      cols[MET_BIN_MAX_VARS];
+    double          current_yr;
+    size_t          expected_len;
+
+    if ((fd = open(c->met_fname, O_RDONLY)) < 0) {
+		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
+                c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+    if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(met_bin_header)) {
+        fprintf(stderr, "%s: binary met file %s is truncated\n", *argv,
+                c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+
+    base = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Error: couldn't mmap Met file %s\n", c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+    hdr = (met_bin_header *)base;
+
+    if (memcmp(hdr->magic, MET_BIN_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->byte_order != MET_BIN_BYTE_ORDER ||
+        hdr->version != MET_BIN_VERSION) {
+        fprintf(stderr, "%s: %s is not a binary met file for this machine\n",
+                *argv, c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+    if (hdr->sub_daily != c->sub_daily) {
+        fprintf(stderr, "%s: binary met file %s timestep doesn't match the "
+                "sub_daily option\n", *argv, c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+    if (hdr->dtype_size != sizeof(met_real)) {
+        fprintf(stderr, "%s: binary met file %s holds %d byte values, this "
+                "build (see MET_FLOAT) reads %d byte values, convert it "
+                "again\n", *argv, c->met_fname, hdr->dtype_size,
+                (int)sizeof(met_real));
+		exit(EXIT_FAILURE);
+    }
+    if (hdr->nvars > MET_BIN_MAX_VARS) {
+        fprintf(stderr, "%s: unsupported column layout in binary met file %s\n",
+                *argv, c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+    expected_len = sizeof(met_bin_header) +
+                   (size_t)hdr->nvars * hdr->nrows * hdr->dtype_size;
+    if ((size_t)sb.st_size < expected_len) {
+        fprintf(stderr, "%s: binary met file %s is truncated\n", *argv,
+                c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+
+    ma->map_base = base;
+    ma->map_len = sb.st_size;
+
+    /* point each column into the mapping */
+    ncols = get_met_columns(c, ma, cols);
+    for (i = 0; i < ncols; i++) {
+        found = FALSE;
+        for (j = 0; j < hdr->nvars; j++) {
+            if (strncmp(hdr->names[j], cols[i].name, MET_BIN_NAME_LEN) == 0) {
+                *(cols[i].col) = (met_real *)(base + sizeof(met_bin_header) +
+                                            (size_t)j * hdr->nrows *
+                                            sizeof(met_real));
+                found = TRUE;
+                break;
+            }
+        }
+        if (found == FALSE) {
+            fprintf(stderr, "%s: binary met file %s has no %s column\n",
+                    *argv, c->met_fname, cols[i].name);
+    		exit(EXIT_FAILURE);
+        }
+    }
+    if (c->sub_daily == FALSE) {
+        /* never read from the daily forcing */
+        ma->par = NULL;
+    }
+
+    ma->nrows = hdr->nrows;
+    if (c->sub_daily)
+        c->total_num_days = hdr->nrows / 48;
+    else
+        c->total_num_days = hdr->nrows;
+
+    /* Build an array of the unique years */
+    c->num_years = 0;
+    current_yr = -9999.9;
+    for (i = 0; i < hdr->nrows; i++) {
+        if (current_yr != ma->year[i]) {
+            c->num_years++;
+            current_yr = ma->year[i];
+        }
+    }
+
+    return;
+}
+
+void write_binary_met_data(control *c, met_arrays *ma, char *fname) {
+    /* Dump the met_arrays columns as a binary columnar met file */
+    FILE           *fp;
+    met_bin_header  hdr;
+    met_column      cols[MET_BIN_MAX_VARS];
+    int             i, ncols;
+    long            nrows = ma->nrows;
+
+    if (ma->stream != NULL && ma->map_base == NULL) {
+        fprintf(stderr, "Error: can't convert a streamed met file, turn "
+                "met_stream off\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MET_BIN_MAGIC, sizeof(hdr.magic));
+    hdr.byte_order = MET_BIN_BYTE_ORDER;
+    hdr.version = MET_BIN_VERSION;
+    hdr.sub_daily = c->sub_daily;
+    hdr.dtype_size = sizeof(met_real);
+    hdr.num_years = c->num_years;
+    hdr.nrows = nrows;
+
+    ncols = get_met_columns(c, ma, cols);
+    hdr.nvars = ncols;
+    for (i = 0; i < ncols; i++) {
+        strncpy(hdr.names[i], cols[i].name, MET_BIN_NAME_LEN - 1);
+    }
+
+    if ((fp = fopen(fname, "wb")) == NULL) {
+        fprintf(stderr, "Error: couldn't open %s for write\n", fname);
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+        fprintf(stderr, "Error writing binary met file %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < ncols; i++) {
+        if (fwrite(*(cols[i].col), sizeof(met_real), nrows, fp) != (size_t)nrows) {
+            fprintf(stderr, "Error writing binary met file %s\n", fname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(fp);
+
+    return;
+}
+
+void convert_met_file(char **argv, char *cfg_fname, char *out_fname) {
+    /*
+        Read the met forcing named in cfg_fname (CSV, daily or 30 min as set
+        by the sub_daily option) and write it out as a binary met file
+    */
+    sim_context *sc;
+
+    sc = new_sim_context(argv, cfg_fname, FALSE);
+    write_binary_met_data(sc->c, sc->ma, out_fname);
+    fprintf(stderr, "Wrote %s (%d years)\n", out_fname, sc->c->num_years);
+    free_sim_context(sc);
+
+    return;
+}
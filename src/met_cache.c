@@ -0,0 +1,166 @@
+/* ============================================================================
+* Shared met forcing cache.
+*
+* A parameter ensemble run through the batch driver typically has every
+* member pointing at the same met file. Rather than each simulation reading
+* and holding its own copy, the forcing is loaded once into a read-only
+* entry keyed by (path, mtime, size, timestep) and each simulation's
+* met_arrays just points at the shared columns. Entries are reference
+* counted; unreferenced entries are kept until flush_met_cache() so that
+* jobs which follow one another on the pool don't reload the file.
+*
+* NOTES:
+*   Nothing in the model writes to met_arrays, which is what makes sharing
+*   the columns safe. The cache is only switched on by the batch driver, a
+*   single run still owns its forcing outright.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "met_cache.h"
+#include "read_met_file.h"
+
+static met_cache_entry *cache_head = NULL;
+static int              cache_enabled = FALSE;
+static pthread_mutex_t  cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   cache_loaded = PTHREAD_COND_INITIALIZER;
+
+void enable_met_cache(void) {
+    /* Share met forcing between the simulations run from now on */
+
+    pthread_mutex_lock(&cache_lock);
+    cache_enabled = TRUE;
+    pthread_mutex_unlock(&cache_lock);
+
+    return;
+}
+
+int met_cache_enabled(void) {
+    int enabled;
+
+    pthread_mutex_lock(&cache_lock);
+    enabled = cache_enabled;
+    pthread_mutex_unlock(&cache_lock);
+
+    return (enabled);
+}
+
+void acquire_met_data(char **argv, control *c, met_arrays *ma) {
+    /*
+        Point ma at the shared copy of c->met_fname, loading it if this is
+        the first simulation to ask for it (or the file has changed on disk
+        since it was loaded). Other threads asking for the same file while
+        it is being read wait for it rather than reading it again.
+    */
+    struct stat      sb;
+    char             fname[PATH_MAX];
+    met_cache_entry *e;
+
+    if (realpath(c->met_fname, fname) == NULL || stat(fname, &sb) != 0) {
+		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
+                c->met_fname);
+		exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    for (e = cache_head; e != NULL; e = e->next) {
+        if (e->stale || e->sub_daily != c->sub_daily ||
+            strcmp(e->fname, fname) != 0)
+            continue;
+        if (e->mtime == sb.st_mtime && e->size == sb.st_size)
+            break;
+        /* file has been rewritten, don't hand this copy out again */
+        e->stale = TRUE;
+    }
+
+    if (e == NULL) {
+        if ((e = (met_cache_entry *)calloc(1, sizeof(met_cache_entry))) == NULL) {
+            fprintf(stderr, "met cache entry: Not allocated enough memory!\n");
+        	exit(EXIT_FAILURE);
+        }
+        strcpy(e->fname, fname);
+        e->mtime = sb.st_mtime;
+        e->size = sb.st_size;
+        e->sub_daily = c->sub_daily;
+        e->refcount = 1;
+        e->next = cache_head;
+        cache_head = e;
+
+        /* read it without holding the lock, so other files can load */
+        pthread_mutex_unlock(&cache_lock);
+        read_met_data(argv, c, &(e->ma));
+        pthread_mutex_lock(&cache_lock);
+
+        e->num_years = c->num_years;
+        e->total_num_days = c->total_num_days;
+        e->loaded = TRUE;
+        pthread_cond_broadcast(&cache_loaded);
+    } else {
+        e->refcount++;
+        while (e->loaded == FALSE)
+            pthread_cond_wait(&cache_loaded, &cache_lock);
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    *ma = e->ma;
+    ma->cache_entry = e;
+    c->num_years = e->num_years;
+    c->total_num_days = e->total_num_days;
+
+    return;
+}
+
+void release_met_data(control *c, met_arrays *ma) {
+    /*
+        Drop a reference taken by acquire_met_data. The entry itself stays
+        cached until flush_met_cache, unless the file has since changed.
+    */
+    met_cache_entry *e = (met_cache_entry *)ma->cache_entry, **prev;
+
+    pthread_mutex_lock(&cache_lock);
+    e->refcount--;
+    if (e->refcount == 0 && e->stale) {
+        for (prev = &cache_head; *prev != e; prev = &((*prev)->next))
+            ;
+        *prev = e->next;
+        free_met_cache_entry(e);
+    }
+    pthread_mutex_unlock(&cache_lock);
+    ma->cache_entry = NULL;
+
+    return;
+}
+
+void flush_met_cache(void) {
+    /* Free every entry nobody is using any more */
+    met_cache_entry *e, **prev;
+
+    pthread_mutex_lock(&cache_lock);
+    prev = &cache_head;
+    while ((e = *prev) != NULL) {
+        if (e->refcount == 0) {
+            *prev = e->next;
+            free_met_cache_entry(e);
+        } else {
+            prev = &(e->next);
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    return;
+}
+
+void free_met_cache_entry(met_cache_entry *e) {
+    control c;
+
+    /* free_met_data only needs the timestep to know which columns exist */
+    c.sub_daily = e->sub_daily;
+    free_met_data(&c, &(e->ma));
+    free(e);
+
+    return;
+}
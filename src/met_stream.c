@@ -0,0 +1,503 @@
+/* ============================================================================
+* Streamed sub-daily met forcing.
+*
+* A century of 30 min forcing is ~1.75 million rows, which read_met_data
+* parses and holds in full before the first timestep. With met_stream on,
+* only met_stream_years years are in memory at once: the year the model is
+* on plus the years after it, which a reader thread parses ahead of the
+* model. Peak memory is then set by met_stream_years, not the length of the
+* run, and the parsing overlaps the simulation instead of preceding it.
+*
+* The file is scanned once at the start to find where each year begins
+* (only the year column is parsed), which gives the number of years and
+* rows the rest of the model needs before the first day.
+*
+* NOTES:
+*   The model only ever looks at the current year of the sub-daily forcing.
+*   The phenology and leaf on/off lookahead reads the daily forcing, which
+*   is never streamed, so holding the model's year, plus the years being
+*   read ahead, is all that is needed. Going back to an earlier year (the
+*   next spin-up cycle, a restart) sends the reader back to that year.
+*
+*   A binary forcing is already mmap'ed rather than read, so nothing is
+*   copied; the years either side of the window are dropped from memory,
+*   and the years ahead requested, with madvise.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "met_stream.h"
+
+
+void open_met_stream(char **argv, control *c, met_arrays *ma) {
+    /*
+        Index the forcing in c->met_fname and start streaming it. For a
+        binary file read_binary_met_data has already mapped it.
+    */
+    met_stream *ms;
+    int         i, j;
+
+    if ((ms = (met_stream *)calloc(1, sizeof(met_stream))) == NULL) {
+        fprintf(stderr,"Error allocating space for met stream\n");
+		exit(EXIT_FAILURE);
+    }
+    ms->prog = *argv;
+    ms->fname = c->met_fname;
+    ms->nslots = c->met_stream_years;
+
+    /* the CSV has an hod column after doy that isn't stored */
+    ms->ncols = get_met_columns(c, ma, ms->cols);
+    for (i = 0, j = 0; i < ms->ncols; i++) {
+        ms->field[j++] = i;
+        if (i == 1)
+            ms->field[j++] = -1;
+    }
+    ms->nvars = j;
+
+    if (ma->map_base != NULL) {
+        index_binary_met_stream(ms, ma, c->num_years);
+
+        /* the index pass touched the whole year column */
+        advise_met_stream(ms, 0, ms->num_years, MADV_DONTNEED);
+    } else {
+        if ((ms->fp = fopen(c->met_fname, "r")) == NULL) {
+    		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
+                    c->met_fname);
+    		exit(EXIT_FAILURE);
+        }
+        init_block_reader(&(ms->br));
+        ms->br.fp = ms->fp;
+        index_met_stream(ms);
+
+        if ((ms->slots = (met_stream_slot *)calloc(ms->nslots,
+                                         sizeof(met_stream_slot))) == NULL) {
+            fprintf(stderr,"Error allocating space for met stream\n");
+    		exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < ms->nslots; i++) {
+            ms->slots[i].nyr = -1;
+            ms->slots[i].data = (met_real *)malloc(ms->ncols * ms->max_rows *
+                                                 sizeof(met_real));
+            if (ms->slots[i].data == NULL) {
+                fprintf(stderr,"Error allocating space for met stream\n");
+        		exit(EXIT_FAILURE);
+            }
+        }
+        ma->nrows = ms->first_row[ms->num_years-1] +
+                    ms->num_rows[ms->num_years-1];
+
+        /* the columns the model sees, filled from the slots each year */
+        ms->window = (met_real *)calloc(ms->ncols * MET_STREAM_WINDOW_ROWS,
+                                      sizeof(met_real));
+        if (ms->window == NULL) {
+            fprintf(stderr,"Error allocating space for met stream\n");
+    		exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < ms->ncols; i++) {
+            *(ms->cols[i].col) = ms->window + i * MET_STREAM_WINDOW_ROWS;
+        }
+    }
+
+    c->num_years = ms->num_years;
+    c->total_num_days = ma->nrows / 48;
+    ma->stream = ms;
+
+    ms->current = -1;
+    ms->next_load = 0;
+    ms->generation = 0;
+    ms->stop = FALSE;
+    if (ms->fp != NULL) {
+        pthread_mutex_init(&(ms->lock), NULL);
+        pthread_cond_init(&(ms->loaded), NULL);
+        pthread_cond_init(&(ms->wake), NULL);
+        if (pthread_create(&(ms->thread), NULL, met_stream_thread, ms) != 0) {
+            fprintf(stderr, "Error creating met stream thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* so the columns always hold something */
+    advance_met_stream(ma, 0);
+
+    return;
+}
+
+void index_met_stream(met_stream *ms) {
+    /*
+        One pass over the CSV forcing, recording the file position, first
+        row and length of every year. Only the year column is parsed.
+    */
+    char   *line, *ptr;
+    int     line_number = 0, nalloc = 0, n = -1;
+    long    nrows = 0;
+    off_t   pos = 0, line_start;
+    double  yr, current_yr = -9999.9;
+
+    while ((line = read_next_line(&(ms->br))) != NULL) {
+        line_start = pos;
+        pos += strlen(line) + 1;
+        line_number++;
+
+        /* ignore comment line */
+        if (*line == '#')
+            continue;
+
+        ptr = line;
+        if (scan_double(&ptr, &yr) == FALSE) {
+            fprintf(stderr, "%s: badly formatted input in met file on line %d\n",
+                    ms->prog, line_number);
+            exit(EXIT_FAILURE);
+        }
+
+        if (yr != current_yr) {
+            n++;
+            if (n == nalloc) {
+                nalloc = (nalloc == 0) ? 64 : nalloc * 2;
+                ms->year = (double *)realloc(ms->year, nalloc * sizeof(double));
+                ms->first_row = (long *)realloc(ms->first_row,
+                                                nalloc * sizeof(long));
+                ms->num_rows = (long *)realloc(ms->num_rows,
+                                               nalloc * sizeof(long));
+                ms->offset = (off_t *)realloc(ms->offset,
+                                              nalloc * sizeof(off_t));
+                ms->first_line = (int *)realloc(ms->first_line,
+                                                nalloc * sizeof(int));
+                if (ms->year == NULL || ms->first_row == NULL ||
+                    ms->num_rows == NULL || ms->offset == NULL ||
+                    ms->first_line == NULL) {
+                    fprintf(stderr,"Error allocating space for met stream\n");
+            		exit(EXIT_FAILURE);
+                }
+            }
+            ms->year[n] = yr;
+            ms->first_row[n] = nrows;
+            ms->num_rows[n] = 0;
+            ms->offset[n] = line_start;
+            ms->first_line[n] = line_number;
+            current_yr = yr;
+        }
+        ms->num_rows[n]++;
+        ms->max_rows = MAX(ms->max_rows, ms->num_rows[n]);
+        nrows++;
+    }
+    ms->num_years = n + 1;
+
+    if (ms->num_years == 0) {
+        fprintf(stderr, "%s: no data in met file %s\n", ms->prog, ms->fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+void index_binary_met_stream(met_stream *ms, met_arrays *ma, int num_years) {
+    /* Year boundaries of a mapped binary forcing, from its year column */
+    long   i;
+    int    n = -1;
+    double current_yr = -9999.9;
+
+    ms->year = (double *)malloc(num_years * sizeof(double));
+    ms->first_row = (long *)malloc(num_years * sizeof(long));
+    ms->num_rows = (long *)malloc(num_years * sizeof(long));
+    if (ms->year == NULL || ms->first_row == NULL || ms->num_rows == NULL) {
+        fprintf(stderr,"Error allocating space for met stream\n");
+		exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < ma->nrows; i++) {
+        if (ma->year[i] != current_yr) {
+            n++;
+            current_yr = ma->year[i];
+            ms->year[n] = current_yr;
+            ms->first_row[n] = i;
+            ms->num_rows[n] = 0;
+        }
+        ms->num_rows[n]++;
+    }
+    ms->num_years = n + 1;
+
+    return;
+}
+
+void close_met_stream(met_arrays *ma) {
+    /* Stop the reader thread and release the window */
+    met_stream *ms = ma->stream;
+    int         i;
+
+    if (ms->fp != NULL) {
+        pthread_mutex_lock(&(ms->lock));
+        ms->stop = TRUE;
+        pthread_cond_broadcast(&(ms->wake));
+        pthread_mutex_unlock(&(ms->lock));
+        pthread_join(ms->thread, NULL);
+
+        pthread_mutex_destroy(&(ms->lock));
+        pthread_cond_destroy(&(ms->loaded));
+        pthread_cond_destroy(&(ms->wake));
+        fclose(ms->fp);
+        free(ms->br.buf);
+
+        for (i = 0; i < ms->nslots; i++) {
+            free(ms->slots[i].data);
+        }
+        free(ms->slots);
+        free(ms->window);
+
+        /* the columns pointed into the slots */
+        for (i = 0; i < ms->ncols; i++) {
+            *(ms->cols[i].col) = NULL;
+        }
+    }
+
+    free(ms->year);
+    free(ms->first_row);
+    free(ms->num_rows);
+    free(ms->offset);
+    free(ms->first_line);
+    free(ms);
+    ma->stream = NULL;
+
+    return;
+}
+
+void advance_met_stream(met_arrays *ma, long row) {
+    /*
+        Put the year of forcing starting at timestep row (365 or 366 days
+        from there) in the met_arrays columns, waiting for the reader thread
+        if it hasn't got that far yet. Years of the file before it are let
+        go so the reader can move on.
+    */
+    met_stream      *ms = ma->stream;
+    met_stream_slot *slot;
+    int              i, nyr;
+    long             nrows, got = 0, first, n;
+
+    if (row < 0 || row >= ma->nrows) {
+        fprintf(stderr, "%s: timestep %ld is outside the met file %s\n",
+                ms->prog, row, ms->fname);
+        exit(EXIT_FAILURE);
+    }
+    nyr = find_met_stream_year(ms, row);
+
+    if (ms->fp == NULL) {
+        /* binary: keep the window resident, drop the rest */
+        if (nyr > 0)
+            advise_met_stream(ms, 0, nyr, MADV_DONTNEED);
+        if (nyr + ms->nslots < ms->num_years)
+            advise_met_stream(ms, nyr + ms->nslots, ms->num_years,
+                              MADV_DONTNEED);
+        advise_met_stream(ms, nyr, MIN(nyr + ms->nslots, ms->num_years),
+                          MADV_WILLNEED);
+        return;
+    }
+
+    /*
+        The model takes a calendar year from the first row, which needn't
+        line up with where the year column changes in the file, so it can
+        span the end of one year of the file and the start of the next
+    */
+    nrows = (is_leap_year((int)ms->year[nyr]) ? 366 : 365) * 48;
+    while (got < nrows && nyr < ms->num_years) {
+        slot = wait_met_stream_year(ms, nyr);
+
+        first = row + got - ms->first_row[nyr];
+        n = MIN(nrows - got, ms->num_rows[nyr] - first);
+        for (i = 0; i < ms->ncols; i++) {
+            memcpy(ms->window + i * MET_STREAM_WINDOW_ROWS + got,
+                   slot->data + i * ms->max_rows + first, n * sizeof(met_real));
+        }
+        got += n;
+        nyr++;
+    }
+    ma->row0 = row;
+
+    return;
+}
+
+met_stream_slot *wait_met_stream_year(met_stream *ms, int nyr) {
+    /*
+        Wait for year nyr of the file to be read, freeing the slots of the
+        years before it. If the reader isn't heading for nyr (the model has
+        gone back to the start for the next spin-up cycle, or a restart)
+        it is sent there.
+    */
+    met_stream_slot *slot = NULL;
+    int              i, held = FALSE;
+
+    pthread_mutex_lock(&(ms->lock));
+    for (i = 0; i < ms->nslots; i++) {
+        if (ms->slots[i].nyr == nyr)
+            held = TRUE;
+    }
+
+    if (held == FALSE && ms->next_load != nyr) {
+        ms->generation++;
+        ms->next_load = nyr;
+        for (i = 0; i < ms->nslots; i++) {
+            ms->slots[i].nyr = -1;
+        }
+    } else {
+        for (i = 0; i < ms->nslots; i++) {
+            if (ms->slots[i].nyr < nyr || ms->slots[i].nyr >= nyr + ms->nslots)
+                ms->slots[i].nyr = -1;
+        }
+    }
+    ms->current = nyr;
+    pthread_cond_broadcast(&(ms->wake));
+
+    while (slot == NULL) {
+        for (i = 0; i < ms->nslots; i++) {
+            if (ms->slots[i].nyr == nyr && ms->slots[i].ready)
+                slot = &(ms->slots[i]);
+        }
+        if (slot == NULL)
+            pthread_cond_wait(&(ms->loaded), &(ms->lock));
+    }
+    pthread_mutex_unlock(&(ms->lock));
+
+    /* only the model frees slots, so it stays put while we copy from it */
+    return (slot);
+}
+
+int find_met_stream_year(met_stream *ms, long row) {
+    /* Year of the file holding timestep row (binary search of the index) */
+    int lo = 0, hi = ms->num_years - 1, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (ms->first_row[mid] <= row)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    return (lo);
+}
+
+void *met_stream_thread(void *arg) {
+    /*
+        Read the years after the model's current one into the free slots,
+        until the window is full, then wait for the model to move on
+    */
+    met_stream      *ms = (met_stream *)arg;
+    met_stream_slot *slot;
+    int              i, nyr, generation;
+
+    pthread_mutex_lock(&(ms->lock));
+    while (TRUE) {
+        slot = NULL;
+        while (ms->stop == FALSE) {
+            if (ms->next_load < ms->num_years &&
+                ms->next_load < MAX(ms->current, 0) + ms->nslots) {
+                for (i = 0; i < ms->nslots && slot == NULL; i++) {
+                    if (ms->slots[i].nyr == -1)
+                        slot = &(ms->slots[i]);
+                }
+            }
+            if (slot != NULL)
+                break;
+            pthread_cond_wait(&(ms->wake), &(ms->lock));
+        }
+        if (ms->stop)
+            break;
+
+        nyr = ms->next_load++;
+        generation = ms->generation;
+        slot->nyr = nyr;
+        slot->ready = FALSE;
+        pthread_mutex_unlock(&(ms->lock));
+
+        read_met_stream_year(ms, slot, nyr);
+
+        pthread_mutex_lock(&(ms->lock));
+        if (generation == ms->generation && slot->nyr == nyr)
+            slot->ready = TRUE;
+        else
+            /* the model went elsewhere while we were reading */
+            slot->nyr = -1;
+        pthread_cond_broadcast(&(ms->loaded));
+    }
+    pthread_mutex_unlock(&(ms->lock));
+
+    return (NULL);
+}
+
+void read_met_stream_year(met_stream *ms, met_stream_slot *slot, int nyr) {
+    /* Parse forcing year nyr from the CSV into slot */
+    char   *line;
+    int     j, line_number = ms->first_line[nyr] - 1;
+    long    row = 0;
+    double  values[MET_BIN_MAX_VARS];
+
+    if (fseeko(ms->fp, ms->offset[nyr], SEEK_SET) != 0) {
+        fprintf(stderr, "%s: couldn't seek in met file %s\n", ms->prog,
+                ms->fname);
+        exit(EXIT_FAILURE);
+    }
+    ms->br.start = 0;
+    ms->br.end = 0;
+    ms->br.eof = FALSE;
+
+    while (row < ms->num_rows[nyr]) {
+        if ((line = read_next_line(&(ms->br))) == NULL) {
+            fprintf(stderr, "%s: met file %s changed while it was being "
+                    "read\n", ms->prog, ms->fname);
+            exit(EXIT_FAILURE);
+        }
+        line_number++;
+
+        /* ignore comment line */
+        if (*line == '#')
+            continue;
+
+        if (parse_met_line(line, values, ms->nvars) == FALSE) {
+            fprintf(stderr, "%s: badly formatted input in met file on line %d\n",
+                    ms->prog, line_number);
+            exit(EXIT_FAILURE);
+        }
+        for (j = 0; j < ms->nvars; j++) {
+            if (ms->field[j] >= 0)
+                slot->data[ms->field[j] * ms->max_rows + row] = values[j];
+        }
+        row++;
+    }
+
+    return;
+}
+
+void advise_met_stream(met_stream *ms, int first_yr, int last_yr, int advice) {
+    /*
+        madvise every column of a mapped binary forcing over the years
+        [first_yr, last_yr). Pages are only dropped if they lie wholly
+        inside the range.
+    */
+    long   page = sysconf(_SC_PAGESIZE);
+    long   first_row = ms->first_row[first_yr];
+    long   last_row = ms->first_row[last_yr-1] + ms->num_rows[last_yr-1];
+    int    i;
+    size_t start, end;
+
+    for (i = 0; i < ms->ncols; i++) {
+        start = (size_t)(*(ms->cols[i].col) + first_row);
+        end = (size_t)(*(ms->cols[i].col) + last_row);
+        if (advice == MADV_DONTNEED) {
+            start = (start + page - 1) / page * page;
+            end = end / page * page;
+        } else {
+            start = start / page * page;
+        }
+        if (end > start)
+            madvise((void *)start, end - start, advice);
+    }
+
+    return;
+}
+
+double get_met_stream_year(met_arrays *ma, int nyr) {
+    /* Calendar year of forcing year nyr */
+    return (ma->stream->year[nyr]);
+}
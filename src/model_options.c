@@ -0,0 +1,128 @@
+/* ============================================================================
+* Model option resolution.
+*
+* The .cfg file picks one of several variants for the Jmax/Vcmax model
+* (modeljm), the C allocation scheme (alloc_model), N uptake
+* (nuptake_model), the soil water stress function (sw_stress_model) and
+* the photosynthetic pathway. These used to be if/else chains tested every
+* day, or for every leaf every half-hour, with the unknown/not implemented
+* cases only caught (and the run killed) when first reached. The choice is
+* now made once, at sim_init, into a table of function pointers hung off
+* control, and any combination the model can't run is rejected before the
+* first day.
+*
+* Options with a single implemented variant (gs_model = MEDLYN,
+* respiration_model = FIXED, assim_model = MATE) are just checked here and
+* the daily code calls the variant directly.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "model_options.h"
+
+
+void resolve_model_options(control *c) {
+    /*
+        Fill in c->kernels from the control flags. Called from every
+        sim_init, so a -set override (or a libgday caller changing an
+        option between runs) is always picked up.
+    */
+    model_kernels *k = c->kernels;
+
+    if (k == NULL) {
+        if ((k = (model_kernels *)calloc(1, sizeof(model_kernels))) == NULL) {
+            fprintf(stderr, "Error allocating space for model kernels\n");
+            exit(EXIT_FAILURE);
+        }
+        c->kernels = k;
+    }
+
+    if (c->modeljm == 0) {
+        k->jmax_vcmax = jmax_vcmax_fixed;
+        k->mate_jmax_vcmax = mate_jmax_vcmax_fixed;
+    } else if (c->modeljm == 1) {
+        k->jmax_vcmax = jmax_vcmax_leaf_n;
+        k->mate_jmax_vcmax = mate_jmax_vcmax_leaf_n;
+    } else if (c->modeljm == 2) {
+        k->jmax_vcmax = jmax_vcmax_jv_ratio;
+        k->mate_jmax_vcmax = mate_jmax_vcmax_jv_ratio;
+    } else if (c->modeljm == 3) {
+        k->jmax_vcmax = jmax_vcmax_temp;
+        k->mate_jmax_vcmax = mate_jmax_vcmax_temp;
+    } else {
+        fprintf(stderr, "You haven't set Jmax/Vcmax model: modeljm \n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (c->ps_pathway == C3) {
+        k->leaf_photosynthesis = photosynthesis_C3;
+        k->mate_photosynthesis = mate_C3_photosynthesis;
+    } else if (c->ps_pathway == C4 && c->sub_daily == FALSE) {
+        k->leaf_photosynthesis = NULL;
+        k->mate_photosynthesis = mate_C4_photosynthesis;
+    } else {
+        /* Nothing implemented */
+        fprintf(stderr, "C4 photosynthesis not implemented\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (c->alloc_model == FIXED) {
+        k->alloc_fracs = alloc_fracs_fixed;
+    } else if (c->alloc_model == GRASSES) {
+        k->alloc_fracs = alloc_fracs_grasses;
+    } else if (c->alloc_model == ALLOMETRIC) {
+        k->alloc_fracs = alloc_fracs_allometric;
+    } else {
+        fprintf(stderr, "Unknown C allocation model: %d\n", c->alloc_model);
+        exit(EXIT_FAILURE);
+    }
+
+    if (c->nuptake_model == 0) {
+        k->nuptake = nuptake_constant;
+    } else if (c->nuptake_model == 1) {
+        k->nuptake = nuptake_inorgn;
+    } else if (c->nuptake_model == 2) {
+        k->nuptake = nuptake_root_saturating;
+    } else {
+        fprintf(stderr, "Unknown N uptake option\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (c->sw_stress_model == 0) {
+        k->soil_water_fac = soil_water_fac_jules;
+    } else if (c->sw_stress_model == 1) {
+        k->soil_water_fac = soil_water_fac_landsberg;
+    } else {
+        fprintf(stderr, "Zhou model not implemented\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* only the daily MATE code reads these */
+    if (c->sub_daily == FALSE) {
+        if (c->assim_model != MATE) {
+            fprintf(stderr,"Unknown photosynthesis model'");
+            exit(EXIT_FAILURE);
+        }
+        if (c->gs_model != MEDLYN) {
+            prog_error("Only Belindas gs model is implemented", __LINE__);
+        }
+        if (c->respiration_model != FIXED) {
+            fprintf(stderr, "Not implemented yet");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return;
+}
+
+void free_model_options(control *c) {
+
+    free(c->kernels);
+    c->kernels = NULL;
+
+    return;
+}
@@ -21,10 +21,11 @@
 #include "photosynthesis.h"
 
 #include "optimal_root_model.h"
+#include "timing.h"
 
-void calc_opt_root_depth(double d0, double r0, double top_soil_depth,
-                         double rtoti, double nsupply, double depth_guess,
-                         double *root_depth, double *nuptake, double *rabove) {
+int calc_opt_root_depth(double d0, double r0, double top_soil_depth,
+                        double rtoti, double nsupply, double depth_guess,
+                        double *root_depth, double *nuptake, double *rabove) {
     /*
 
         Parameters:
@@ -42,7 +43,7 @@ void calc_opt_root_depth(double d0, double r0, double top_soil_depth,
             daily net N mineralisation in top soil layer from G'DAY
         depth_guess : float
             Initial guess at the rooting depth, used as the first point in the
-            root depth optimisation scheme [m].
+            root depth optimisation scheme, i.e. yesterday's depth [m].
 
         Returns:
         --------
@@ -52,30 +53,43 @@ void calc_opt_root_depth(double d0, double r0, double top_soil_depth,
             N uptake from roots [gN m-2 yr-1]
         rabove : float
 
+        TRUE if the depth was found, otherwise FALSE and root_depth is left
+        at depth_guess, which nuptake and rabove are then worked out for.
+
     */
     double depth;
+    int    found;
+
     /* Determine maximum rooting depth for model for a value root C */
-    depth = estimate_max_root_depth(rtoti, depth_guess, r0, d0);
+    found = estimate_max_root_depth(rtoti, depth_guess, r0, d0, &depth);
+    if (found == FALSE)
+        depth = depth_guess;
     *root_depth = depth;
+
     /* Optimised plant N uptake */
     *nuptake = calc_plant_nuptake(depth, nsupply, d0, top_soil_depth);
 
     /* G'DAY requires root litter input to the top 30 cm of soil, so
        return the roots above this depth */
-    printf("%f\n", depth);
     *rabove = calculate_root_mass_above_depth(rtoti, depth, r0, d0,
                                               top_soil_depth);
 
-    return;
+    return (found);
 
 }
 
 
-double estimate_max_root_depth(double rtoti, double depth_guess, double r0,
-                               double d0) {
+int estimate_max_root_depth(double rtoti, double depth_guess, double r0,
+                            double d0, double *root_depth) {
     /* Determing the maximum rooting depth through solving Eqn. B6. for
     rooting depth
 
+    rtot is zero at the surface and increases (convex) with depth, so the
+    root lies between 0 and the first depth where rtot exceeds rtoti. Only
+    the root C enters B6, so if it has barely changed since the previous
+    solve (the guess already meets B6 to within the solver's tolerance)
+    the guess is kept as it is.
+
     Parameters:
     -----------
     rtoti : float
@@ -88,14 +102,56 @@ double estimate_max_root_depth(double rtoti, double depth_guess, double r0,
     rooting_depth : float
         optimised rooting depth [m]
 
+    TRUE if the root was found
+
     */
     double (*fPtr)(double, double, double, double) = &rtot_wrapper;
     double (*fprimePtr)(double, double, double, double) = &rtot_derivative;
-    double root_depth;
+    double lo = 0.0, hi, f_guess, df_guess;
+    double tol = 1E-6;
+    int    i;
+
+    COUNT_EVENTS(COUNTER_NEWTON_CALLS, 1);
+
+    if (!(rtoti > 0.0)) {
+        /* no roots: zero depth, negative or NaN root C has no answer */
+        *root_depth = 0.0;
+        return (rtoti == 0.0);
+    }
+
+    if (depth_guess > 0.0) {
+        f_guess = fPtr(depth_guess, rtoti, r0, d0);
+        df_guess = fprimePtr(depth_guess, rtoti, r0, d0);
+        if (fabs(f_guess) < tol * df_guess) {
+            *root_depth = depth_guess;
+            return (TRUE);
+        }
+        /* yesterday's depth is one side of the root. From below, the
+           tangent of the convex rtot crosses zero beyond the root */
+        if (f_guess < 0.0) {
+            lo = depth_guess;
+            hi = (df_guess > 0.0) ? depth_guess - f_guess / df_guess :
+                                    2.0 * depth_guess;
+        } else {
+            hi = depth_guess;
+        }
+    } else {
+        hi = 1.0;
+    }
+
+    /* grow the bracket until rtot passes rtoti */
+    for (i = 0; i < 64 && fPtr(hi, rtoti, r0, d0) < 0.0; i++) {
+        lo = hi;
+        hi *= 2.0;
+    }
+    if (!(fPtr(hi, rtoti, r0, d0) >= 0.0))
+        return (FALSE);
 
-    root_depth = newton(fPtr, fprimePtr, depth_guess, rtoti, r0, d0);
+    if (!(depth_guess >= lo && depth_guess <= hi))
+        depth_guess = 0.5 * (lo + hi);
 
-    return (root_depth);
+    return (safeguarded_newton(fPtr, fprimePtr, depth_guess, lo, hi, rtoti,
+                               r0, d0, root_depth));
 }
 
 
@@ -265,44 +321,99 @@ double calc_net_n_uptake(double nuptake, double Nr, double rabove,
 }
 
 
-double newton(double (*func)(double, double, double, double),
-              double (*fprime)(double, double, double, double), double x0,
-              double arg1, double arg2, double arg3) {
-    /* Newton-Raphson: finds a zero of the func, given an inital guess
+int safeguarded_newton(double (*func)(double, double, double, double),
+                       double (*fprime)(double, double, double, double),
+                       double x0, double lo, double hi, double arg1,
+                       double arg2, double arg3, double *root) {
+    /* Newton-Raphson kept inside a bracket: finds a zero of the func, given
+    an inital guess and an interval the zero lies in. Steps that would
+    leave the bracket, or aren't closing in fast enough, are replaced by
+    bisection, so it converges wherever the guess is.
+
+    References
+    ----------
+    * Press et al. (1992) Numerical Recipes in C, 2nd ed., rtsafe, p. 366.
 
     Parameters
     ----------
     f : function
         The function whose zero is wanted.
-    x0 : float
-        An initial guess.
     fprime : function
         The derivative of the function
+    x0 : float
+        An initial guess, within [lo, hi].
+    lo, hi : float
+        The bracket, func(lo) and func(hi) of opposite sign (or zero).
     args : tuple, optional
         Extra arguments to be used in the function call.
-    tol : float, optional
-        The allowable error of the zero value.
-    maxiter : int, optional
-        Maximum number of iterations.
 
     Returns
     -------
-    val : float
+    root : float
         Estimated location where function is zero
 
+    TRUE if it converged, FALSE if not (root is then the last estimate)
+
     */
-    int    iter, maxiter = 250;
+    int    iter, maxiter = 100;
     double tol = 1E-6;
-    double x;
+    double x, dx, dx_old, fx, dfx, f_lo, f_hi, x_neg, x_pos;
+
+    f_lo = func(lo, arg1, arg2, arg3);
+    f_hi = func(hi, arg1, arg2, arg3);
+    if (f_lo == 0.0 || f_hi == 0.0) {
+        *root = (f_lo == 0.0) ? lo : hi;
+        return (TRUE);
+    }
+    if ((f_lo > 0.0) == (f_hi > 0.0) || isnan(f_lo) || isnan(f_hi)) {
+        *root = x0;
+        return (FALSE);
+    }
+
+    /* orient the bracket so func(x_neg) < 0 */
+    if (f_lo < 0.0) {
+        x_neg = lo;
+        x_pos = hi;
+    } else {
+        x_neg = hi;
+        x_pos = lo;
+    }
+
+    x = x0;
+    dx_old = fabs(hi - lo);
+    dx = dx_old;
+    fx = func(x, arg1, arg2, arg3);
+    dfx = fprime(x, arg1, arg2, arg3);
 
     for (iter = 0; iter < maxiter; iter++) {
 
-        x = (x0 - (func(x0, arg1, arg2, arg3) / fprime(x0, arg1, arg2, arg3)));
-        if (fabs(x - x0) < tol) {
-            return x;
+        if ((((x - x_pos) * dfx - fx) * ((x - x_neg) * dfx - fx) > 0.0) ||
+            (fabs(2.0 * fx) > fabs(dx_old * dfx))) {
+            /* Newton step leaves the bracket or is too slow: bisect */
+            dx_old = dx;
+            dx = 0.5 * (x_pos - x_neg);
+            x = x_neg + dx;
+        } else {
+            dx_old = dx;
+            dx = fx / dfx;
+            x -= dx;
         }
-        x0 = x;
+
+        if (fabs(dx) < tol) {
+            COUNT_EVENTS(COUNTER_NEWTON_ITER, iter + 1);
+            *root = x;
+            return (TRUE);
+        }
+
+        fx = func(x, arg1, arg2, arg3);
+        dfx = fprime(x, arg1, arg2, arg3);
+        if (fx < 0.0)
+            x_neg = x;
+        else
+            x_pos = x;
     }
-    fprintf(stderr, "Minimum not found!!\n");
-    exit(EXIT_FAILURE);
+    COUNT_EVENTS(COUNTER_NEWTON_ITER, maxiter);
+    *root = x;
+
+    return (FALSE);
 }
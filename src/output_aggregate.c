@@ -0,0 +1,206 @@
+/* ============================================================================
+* Aggregate the daily outputs over months, years, growing seasons or blocks
+* of N days inside the model, so long runs needn't write (and then re-read)
+* every day.
+*
+*   [outputs]
+*   period = monthly         ; daily, monthly, annual, growing_season or N
+*   state = mean             ; mean or end
+*
+* Fluxes are summed over the period, rates and scalars (conductances,
+* decomposition factors...) are averaged and states are either averaged or
+* taken from the last day of the period. Each record carries the year and
+* doy the period started on and the number of days it covers (ndays).
+*
+* NOTES:
+*   Every period ends at the end of a year, so N day blocks restart each
+*   January and a growing season is the run of leaf-out days within a year.
+*   Nothing is then ever carried over a year boundary, which is where
+*   checkpoints are taken.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "output_aggregate.h"
+#include "met_stream.h"
+
+
+output_accum *new_output_accum(control *c) {
+    /* Set up an (empty) aggregate for the selected output variables */
+    output_accum     *a;
+    const output_var *v;
+    int               i;
+
+    if ((a = (output_accum *)calloc(1, sizeof(output_accum))) == NULL) {
+        fprintf(stderr, "Error allocating space for output aggregate\n");
+        exit(EXIT_FAILURE);
+    }
+    a->nvals = c->num_output_vars;
+    a->vals = (double *)calloc(a->nvals, sizeof(double));
+    a->rule = (int *)calloc(a->nvals, sizeof(int));
+    if (a->vals == NULL || a->rule == NULL) {
+        fprintf(stderr, "Error allocating space for output aggregate\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < a->nvals; i++) {
+        v = get_output_var(c->output_vars[i]);
+        if (v->aggregate == OUTPUT_AGG_STATE)
+            a->rule[i] = (c->output_state_agg == OUTPUT_STATE_END) ?
+                          OUTPUT_AGG_LAST : OUTPUT_AGG_MEAN;
+        else
+            a->rule[i] = v->aggregate;
+    }
+
+    return (a);
+}
+
+void free_output_accum(output_accum *a) {
+
+    free(a->vals);
+    free(a->rule);
+    free(a);
+
+    return;
+}
+
+int aggregate_daily_outputs(output_accum *a, control *c, fluxes *f,
+                            state *s, int year, int doy, double *rec) {
+    /*
+        Add today to the current period and, if that was its last day, copy
+        the finished aggregate into rec
+
+        Parameters:
+        -----------
+        doy : int
+            day of the year, 1 = 1st Jan
+
+        Returns:
+        --------
+        done : int
+            TRUE if rec holds a finished period
+    */
+    double vals[MAX_OUTPUT_VARS];
+    int    i;
+
+    if (c->output_period == OUTPUT_PERIOD_SEASON &&
+        s->leaf_out_days[doy-1] <= 0.0)
+        return (flush_output_accum(a, rec));
+
+    pack_daily_outputs(c, f, s, year, doy, vals);
+    for (i = 0; i < a->nvals; i++) {
+        if (a->rule[i] == OUTPUT_AGG_FIRST) {
+            if (a->ndays == 0)
+                a->vals[i] = vals[i];
+        } else if (a->rule[i] == OUTPUT_AGG_LAST) {
+            a->vals[i] = vals[i];
+        } else {
+            /* sums, means are divided through when the period ends */
+            a->vals[i] = (a->ndays == 0) ? vals[i] : a->vals[i] + vals[i];
+        }
+    }
+    a->ndays++;
+
+    if (output_period_ended(c, s, doy))
+        return (flush_output_accum(a, rec));
+
+    return (FALSE);
+}
+
+int flush_output_accum(output_accum *a, double *rec) {
+    /*
+        Close the current period (also used for the partial period left at
+        the end of a run)
+
+        Returns:
+        --------
+        done : int
+            TRUE if there was anything to write and rec now holds it
+    */
+    int i;
+
+    if (a->ndays == 0)
+        return (FALSE);
+
+    for (i = 0; i < a->nvals; i++) {
+        if (a->rule[i] == OUTPUT_AGG_MEAN)
+            rec[i] = a->vals[i] / a->ndays;
+        else
+            rec[i] = a->vals[i];
+    }
+    a->ndays = 0;
+
+    return (TRUE);
+}
+
+int output_period_ended(control *c, state *s, int doy) {
+    /* Is doy (1 = 1st Jan) the last day of an output period? */
+    int month_end[12] = {31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334,
+                         365};
+    int leap = (c->num_days == 366), m;
+
+    if (doy >= c->num_days)
+        return (TRUE);
+
+    if (c->output_period == OUTPUT_PERIOD_DAILY) {
+        return (TRUE);
+    } else if (c->output_period == OUTPUT_PERIOD_MONTHLY) {
+        for (m = 0; m < 12; m++) {
+            if (doy == month_end[m] + (leap && m > 0))
+                return (TRUE);
+        }
+    } else if (c->output_period == OUTPUT_PERIOD_NDAYS) {
+        return (doy % c->output_period_days == 0);
+    } else if (c->output_period == OUTPUT_PERIOD_SEASON) {
+        /* tomorrow the leaves are off */
+        return (s->leaf_out_days[doy] <= 0.0);
+    }
+
+    return (FALSE);
+}
+
+int count_output_records(control *c, met_arrays *ma) {
+    /*
+        Number of records the run will write, for the output header. Each
+        year of forcing gives 365/366 daily records, 12 monthly, one annual
+        or growing season record, or ceil(num_days / N) N day blocks.
+    */
+    long   i, stride = c->sub_daily ? 48 : 1;
+    int    nyr, nrecords = 0;
+    double current_yr = -9999.9;
+
+    if (ma->stream != NULL) {
+        /* only a window of the forcing is in memory */
+        for (nyr = 0; nyr < c->num_years; nyr++)
+            nrecords += count_year_records(c, get_met_stream_year(ma, nyr));
+        return (nrecords);
+    }
+
+    for (i = 0; i < ma->nrows; i += stride) {
+        if (ma->year[i] == current_yr)
+            continue;
+        current_yr = ma->year[i];
+        nrecords += count_year_records(c, current_yr);
+    }
+
+    return (nrecords);
+}
+
+int count_year_records(control *c, double year) {
+    /* Number of output records written for one year of forcing */
+    int num_days = is_leap_year((int)year) ? 366 : 365;
+
+    if (c->output_period == OUTPUT_PERIOD_DAILY)
+        return (num_days);
+    else if (c->output_period == OUTPUT_PERIOD_MONTHLY)
+        return (12);
+    else if (c->output_period == OUTPUT_PERIOD_NDAYS)
+        return ((num_days + c->output_period_days - 1) /
+                c->output_period_days);
+
+    return (1);
+}
@@ -0,0 +1,79 @@
+/* ============================================================================
+* In-memory outputs.
+*
+* When the model is driven through libgday (see libgday.c) the daily or
+* aggregated records aren't written anywhere, they are stored column by
+* column so a host program (e.g. numpy via ctypes) can wrap each variable
+* without a copy. The number of records is known once the forcing has been
+* read (count_output_records), so the columns are allocated once.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "output_buffer.h"
+
+output_buffer *new_output_buffer(int nvals, long capacity) {
+    /*
+        Room for capacity records of nvals values
+
+        Parameters:
+        -----------
+        nvals : int
+            values per record (c->num_output_vars)
+        capacity : long
+            records the run will write (c->num_output_records)
+    */
+    output_buffer *ob;
+
+    if ((ob = (output_buffer *)calloc(1, sizeof(output_buffer))) == NULL) {
+        fprintf(stderr, "output buffer: Not allocated enough memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    ob->nvals = nvals;
+    ob->capacity = MAX(1, capacity);
+    ob->nrecords = 0;
+
+    if ((ob->data = (double *)calloc((size_t)nvals * ob->capacity,
+                                     sizeof(double))) == NULL) {
+        fprintf(stderr, "Error allocating space for the output buffer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return (ob);
+}
+
+void free_output_buffer(output_buffer *ob) {
+    /* Release a buffer made by new_output_buffer */
+
+    free(ob->data);
+    free(ob);
+
+    return;
+}
+
+void append_output_buffer(output_buffer *ob, const double *rec) {
+    /* Store one record, each value at the end of its variable's column */
+    int i;
+
+    if (ob->nrecords == ob->capacity) {
+        fprintf(stderr, "Error: more output records than the %ld expected\n",
+                ob->capacity);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < ob->nvals; i++) {
+        ob->data[i * ob->capacity + ob->nrecords] = rec[i];
+    }
+    ob->nrecords++;
+
+    return;
+}
+
+double *get_output_column(output_buffer *ob, int idx) {
+    /* The nrecords values of output column idx */
+
+    return (ob->data + (size_t)idx * ob->capacity);
+}
@@ -0,0 +1,314 @@
+/* ============================================================================
+* Registry of the variables that can be written to the daily outputs.
+*
+* Each entry names a double in the state or fluxes structure, with its units,
+* so the writers can emit any selection of them by looking the offset up
+* rather than hard-coding one fixed list. The selection comes from the
+* [outputs] section of the .cfg file, e.g.
+*
+*   [outputs]
+*   variables = lai, gpp, npp, nep, transpiration, soilc
+*
+* year and doy always lead each record (then ndays if the outputs are
+* aggregated, see output_aggregate.c). Without an [outputs] section the
+* standard set is written, i.e. the same columns, in the same order, as
+* before the selection existed.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "output_vars.h"
+
+#define TIME_VAR(n, u, i, agg, std) { #n, u, OUTPUT_TIME, i, agg, std }
+#define STATE_VAR(n, u, std) { #n, u, OUTPUT_STATE, offsetof(state, n), \
+                               OUTPUT_AGG_STATE, std }
+#define FLUX_VAR(n, u, std) { #n, u, OUTPUT_FLUXES, offsetof(fluxes, n), \
+                              OUTPUT_AGG_SUM, std }
+
+/* fluxes structure members that are rates/scalars, averaged not summed */
+#define RATE_VAR(n, u, std) { #n, u, OUTPUT_FLUXES, offsetof(fluxes, n), \
+                              OUTPUT_AGG_MEAN, std }
+
+/* the standard set, in file order, then everything else */
+const output_var output_registry[] = {
+
+    /* time stuff */
+    TIME_VAR(year, "year", 0, OUTPUT_AGG_FIRST, TRUE),
+    TIME_VAR(doy, "day", 1, OUTPUT_AGG_FIRST, TRUE),
+
+    /*
+    ** STATE
+    */
+
+    /* water */
+    STATE_VAR(wtfac_root, "-", TRUE),
+    STATE_VAR(pawater_root, "mm", TRUE),
+
+    /* plant */
+    STATE_VAR(shoot, "t C ha-1", TRUE),
+    STATE_VAR(lai, "m2 m-2", TRUE),
+    STATE_VAR(branch, "t C ha-1", TRUE),
+    STATE_VAR(stem, "t C ha-1", TRUE),
+    STATE_VAR(root, "t C ha-1", TRUE),
+    STATE_VAR(croot, "t C ha-1", TRUE),
+    STATE_VAR(shootn, "t N ha-1", TRUE),
+    STATE_VAR(branchn, "t N ha-1", TRUE),
+    STATE_VAR(stemn, "t N ha-1", TRUE),
+    STATE_VAR(rootn, "t N ha-1", TRUE),
+    STATE_VAR(crootn, "t N ha-1", TRUE),
+    STATE_VAR(cstore, "t C ha-1", TRUE),
+    STATE_VAR(nstore, "t N ha-1", TRUE),
+
+    /* belowground */
+    STATE_VAR(soilc, "t C ha-1", TRUE),
+    STATE_VAR(soiln, "t N ha-1", TRUE),
+    STATE_VAR(inorgn, "t N ha-1", TRUE),
+    STATE_VAR(litterc, "t C ha-1", TRUE),
+    STATE_VAR(littercag, "t C ha-1", TRUE),
+    STATE_VAR(littercbg, "t C ha-1", TRUE),
+    STATE_VAR(litternag, "t N ha-1", TRUE),
+    STATE_VAR(litternbg, "t N ha-1", TRUE),
+    STATE_VAR(activesoil, "t C ha-1", TRUE),
+    STATE_VAR(slowsoil, "t C ha-1", TRUE),
+    STATE_VAR(passivesoil, "t C ha-1", TRUE),
+    STATE_VAR(activesoiln, "t N ha-1", TRUE),
+    STATE_VAR(slowsoiln, "t N ha-1", TRUE),
+    STATE_VAR(passivesoiln, "t N ha-1", TRUE),
+
+    /*
+    ** FLUXES
+    */
+
+    /* water */
+    FLUX_VAR(et, "mm d-1", TRUE),
+    FLUX_VAR(transpiration, "mm d-1", TRUE),
+    FLUX_VAR(soil_evap, "mm d-1", TRUE),
+    FLUX_VAR(canopy_evap, "mm d-1", TRUE),
+    FLUX_VAR(runoff, "mm d-1", TRUE),
+    RATE_VAR(gs_mol_m2_sec, "mol m-2 s-1", TRUE),
+    RATE_VAR(ga_mol_m2_sec, "mol m-2 s-1", TRUE),
+
+    /* litter */
+    FLUX_VAR(deadleaves, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(deadbranch, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(deadstems, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(deadroots, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(deadcroots, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(deadleafn, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(deadbranchn, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(deadstemn, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(deadrootn, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(deadcrootn, "t N ha-1 d-1", TRUE),
+
+    /* C fluxes */
+    FLUX_VAR(nep, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(gpp, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(npp, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(hetero_resp, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(auto_resp, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(apar, "MJ m-2 d-1", TRUE),
+
+    /* C & N growth */
+    FLUX_VAR(cpleaf, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(cpbranch, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(cpstem, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(cproot, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(cpcroot, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(npleaf, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(npbranch, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(npstemimm, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(npstemmob, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(nproot, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(npcroot, "t N ha-1 d-1", TRUE),
+
+    /* N stuff */
+    FLUX_VAR(nuptake, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(ngross, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(nmineralisation, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(nloss, "t N ha-1 d-1", TRUE),
+
+    /* traceability stuff */
+    RATE_VAR(tfac_soil_decomp, "-", TRUE),
+    FLUX_VAR(c_into_active, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(c_into_slow, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(c_into_passive, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(active_to_slow, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(active_to_passive, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(slow_to_active, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(slow_to_passive, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(passive_to_active, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_surf_struct_litter, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_soil_struct_litter, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_surf_metab_litter, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_soil_metab_litter, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_active_pool, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_slow_pool, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(co2_rel_from_passive_pool, "t C ha-1 d-1", TRUE),
+
+    /* extra priming stuff */
+    FLUX_VAR(root_exc, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(root_exn, "t N ha-1 d-1", TRUE),
+    FLUX_VAR(co2_released_exud, "t C ha-1 d-1", TRUE),
+    FLUX_VAR(factive, "t C ha-1 d-1", TRUE),
+    RATE_VAR(rtslow, "-", TRUE),
+    RATE_VAR(rexc_cue, "-", TRUE),
+
+    /* Misc */
+    FLUX_VAR(leafretransn, "t N ha-1 d-1", TRUE),
+
+    /*
+    ** EXTRAS, only written when asked for
+    */
+    TIME_VAR(ndays, "days", 2, OUTPUT_AGG_SUM, FALSE),
+    STATE_VAR(wtfac_topsoil, "-", FALSE),
+    STATE_VAR(pawater_topsoil, "mm", FALSE),
+    STATE_VAR(sapwood, "t C ha-1", FALSE),
+    STATE_VAR(canht, "m", FALSE),
+    STATE_VAR(root_depth, "m", FALSE),
+    STATE_VAR(stemnimm, "t N ha-1", FALSE),
+    STATE_VAR(stemnmob, "t N ha-1", FALSE),
+    STATE_VAR(structsurf, "t C ha-1", FALSE),
+    STATE_VAR(metabsurf, "t C ha-1", FALSE),
+    STATE_VAR(structsoil, "t C ha-1", FALSE),
+    STATE_VAR(metabsoil, "t C ha-1", FALSE),
+    STATE_VAR(structsurfn, "t N ha-1", FALSE),
+    STATE_VAR(metabsurfn, "t N ha-1", FALSE),
+    STATE_VAR(structsoiln, "t N ha-1", FALSE),
+    STATE_VAR(metabsoiln, "t N ha-1", FALSE),
+    STATE_VAR(age, "years", FALSE),
+    STATE_VAR(sla, "m2 kg-1", FALSE),
+    STATE_VAR(fipar, "-", FALSE),
+    FLUX_VAR(interception, "mm d-1", FALSE),
+    FLUX_VAR(throughfall, "mm d-1", FALSE),
+    FLUX_VAR(retrans, "t N ha-1 d-1", FALSE),
+    FLUX_VAR(nlittrelease, "t N ha-1 d-1", FALSE),
+    FLUX_VAR(gpp_gCm2, "g C m-2 d-1", FALSE),
+    FLUX_VAR(npp_gCm2, "g C m-2 d-1", FALSE),
+    RATE_VAR(omega, "-", FALSE),
+};
+
+#undef TIME_VAR
+#undef STATE_VAR
+#undef FLUX_VAR
+#undef RATE_VAR
+
+
+int num_output_vars_registered(void) {
+    return ((int)(sizeof(output_registry) / sizeof(output_registry[0])));
+}
+
+const output_var *get_output_var(int idx) {
+    return (&output_registry[idx]);
+}
+
+int find_output_var(const char *name) {
+    /* Registry index of the variable called name, -1 if there isn't one */
+    int i, n = num_output_vars_registered();
+
+    for (i = 0; i < n; i++) {
+        if (strcasecmp(output_registry[i].name, name) == 0)
+            return (i);
+    }
+
+    return (-1);
+}
+
+void add_output_vars(control *c, char *value) {
+    /*
+        Append the comma/space separated variable names in value (from the
+        [outputs] section) to the output selection. Repeats are ignored.
+    */
+    char *name, *saveptr = NULL;
+    int   i, idx, found;
+
+    for (name = strtok_r(value, ", \t", &saveptr); name != NULL;
+         name = strtok_r(NULL, ", \t", &saveptr)) {
+
+        if ((idx = find_output_var(name)) < 0) {
+            fprintf(stderr, "Unknown output variable: %s\n", name);
+            exit(EXIT_FAILURE);
+        }
+
+        found = FALSE;
+        for (i = 0; i < c->num_output_vars; i++) {
+            if (c->output_vars[i] == idx) {
+                found = TRUE;
+                break;
+            }
+        }
+        if (found)
+            continue;
+
+        if (c->num_output_vars == MAX_OUTPUT_VARS) {
+            fprintf(stderr, "Too many output variables, max is %d\n",
+                    MAX_OUTPUT_VARS);
+            exit(EXIT_FAILURE);
+        }
+        c->output_vars[c->num_output_vars++] = idx;
+    }
+
+    return;
+}
+
+void setup_output_vars(control *c) {
+    /*
+        Finalise the output selection once the .cfg file has been read:
+        year and doy (plus ndays when the outputs are aggregated), followed
+        by either the standard set or the requested variables in the order
+        they were listed
+    */
+    int i, n, idx, sel[MAX_OUTPUT_VARS];
+
+    if (c->output_period == OUTPUT_PERIOD_SEASON && c->deciduous_model == FALSE) {
+        fprintf(stderr, "Growing season outputs need the deciduous model\n");
+        exit(EXIT_FAILURE);
+    }
+
+    n = 0;
+    sel[n++] = find_output_var("year");
+    sel[n++] = find_output_var("doy");
+    if (c->output_period != OUTPUT_PERIOD_DAILY)
+        sel[n++] = find_output_var("ndays");
+
+    if (c->num_output_vars == 0) {
+        for (i = 0; i < num_output_vars_registered(); i++) {
+            if (output_registry[i].standard)
+                c->output_vars[c->num_output_vars++] = i;
+        }
+    }
+    for (i = 0; i < c->num_output_vars; i++) {
+        idx = c->output_vars[i];
+        if (output_registry[idx].source == OUTPUT_TIME)
+            continue;
+        if (n == MAX_OUTPUT_VARS) {
+            fprintf(stderr, "Too many output variables, max is %d\n",
+                    MAX_OUTPUT_VARS);
+            exit(EXIT_FAILURE);
+        }
+        sel[n++] = idx;
+    }
+    memcpy(c->output_vars, sel, n * sizeof(int));
+    c->num_output_vars = n;
+
+    return;
+}
+
+double get_output_value(const output_var *v, fluxes *f, state *s, int year,
+                        int doy) {
+    /* Today's value of output variable v */
+
+    if (v->source == OUTPUT_STATE)
+        return (*(double *)((char *)s + v->offset));
+    else if (v->source == OUTPUT_FLUXES)
+        return (*(double *)((char *)f + v->offset));
+    else if (v->offset == 0)
+        return ((double)year);
+    else if (v->offset == 1)
+        return ((double)doy);
+    else
+        return (1.0);
+}
@@ -0,0 +1,215 @@
+/* ============================================================================
+* Asynchronous daily output.
+*
+* Formatting ~90 "%.10f" columns a day is a noticeable part of a long daily
+* run. With async_output on, the simulation thread just copies the day's
+* values into a ring of records (pack_daily_outputs) and carries on; a
+* writer thread formats them and writes them out in large blocks. The
+* simulation only waits on the writer when the ring is full, or when it
+* needs the file to be up to date (checkpoints, end of the run).
+*
+* The bytes written are exactly those of write_daily_outputs_ascii/binary
+* (or of the columnar writer, columnar.c).
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "output_writer.h"
+
+
+output_writer *start_output_writer(control *c, FILE *fp, column_file *cf) {
+    /*
+        Set up the ring and start the writer thread for the daily output
+        file fp (header already written), or for columnar output cf if
+        that isn't NULL
+    */
+    output_writer *w;
+    double         vals[MAX_OUTPUT_VARS];
+    fluxes         f;
+    state          s;
+
+    if ((w = (output_writer *)calloc(1, sizeof(output_writer))) == NULL) {
+        fprintf(stderr, "Error allocating space for output writer\n");
+        exit(EXIT_FAILURE);
+    }
+    w->fp = fp;
+    w->columns = cf;
+    w->ascii = c->output_ascii;
+    w->capacity = OUTPUT_RING_RECORDS;
+
+    /* record length for this output mode */
+    memset(&f, 0, sizeof(fluxes));
+    memset(&s, 0, sizeof(state));
+    w->nvals = pack_daily_outputs(c, &f, &s, 0, 0, vals);
+
+    w->ring = (double *)malloc((size_t)w->capacity * w->nvals *
+                               sizeof(double));
+    w->block = (char *)malloc(OUTPUT_BLOCK_SIZE);
+    if (w->ring == NULL || w->block == NULL) {
+        fprintf(stderr, "Error allocating space for output writer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->queued, NULL);
+    pthread_cond_init(&w->written, NULL);
+    if (pthread_create(&w->thread, NULL, output_writer_thread, w) != 0) {
+        fprintf(stderr, "Error creating output writer thread\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return (w);
+}
+
+void queue_daily_outputs(output_writer *w, control *c, fluxes *f, state *s,
+                         int year, int doy) {
+    /* Hand the day's outputs to the writer, waiting only if the ring is full */
+    double *slot;
+
+    pthread_mutex_lock(&w->lock);
+    while (w->head - w->tail >= w->capacity)
+        pthread_cond_wait(&w->written, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+
+    /* the writer never touches slots between tail and head + 1 */
+    slot = w->ring + (w->head % w->capacity) * w->nvals;
+    pack_daily_outputs(c, f, s, year, doy, slot);
+
+    pthread_mutex_lock(&w->lock);
+    w->head++;
+    pthread_cond_signal(&w->queued);
+    pthread_mutex_unlock(&w->lock);
+
+    return;
+}
+
+void queue_output_record(output_writer *w, const double *vals) {
+    /* Hand an already packed (e.g. aggregated) record to the writer */
+    double *slot;
+
+    pthread_mutex_lock(&w->lock);
+    while (w->head - w->tail >= w->capacity)
+        pthread_cond_wait(&w->written, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+
+    slot = w->ring + (w->head % w->capacity) * w->nvals;
+    memcpy(slot, vals, w->nvals * sizeof(double));
+
+    pthread_mutex_lock(&w->lock);
+    w->head++;
+    pthread_cond_signal(&w->queued);
+    pthread_mutex_unlock(&w->lock);
+
+    return;
+}
+
+void drain_output_writer(output_writer *w) {
+    /* Wait until everything queued so far has been written to the file */
+
+    pthread_mutex_lock(&w->lock);
+    while (w->tail < w->head && w->error == FALSE)
+        pthread_cond_wait(&w->written, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+
+    if (w->error) {
+        fprintf(stderr, "Error writing daily output file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+void stop_output_writer(output_writer *w) {
+    /* Write out whatever is left, stop the thread and free the writer */
+
+    pthread_mutex_lock(&w->lock);
+    w->stop = TRUE;
+    pthread_cond_signal(&w->queued);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->thread, NULL);
+
+    if (w->error) {
+        fprintf(stderr, "Error writing daily output file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->queued);
+    pthread_cond_destroy(&w->written);
+    free(w->ring);
+    free(w->block);
+    free(w);
+
+    return;
+}
+
+void *output_writer_thread(void *arg) {
+    /*
+        Take whatever records are waiting, format them into the block
+        buffer and write it whenever it fills up or the queue runs dry
+    */
+    output_writer *w = (output_writer *)arg;
+    long           tail, head;
+    size_t         len, rec_len, max_rec_len;
+    double        *rec;
+    int            written;
+
+    max_rec_len = (size_t)w->nvals * (w->ascii ? OUTPUT_CHARS_PER_VAL :
+                                                 sizeof(double));
+    while (TRUE) {
+        pthread_mutex_lock(&w->lock);
+        while (w->tail == w->head && w->stop == FALSE)
+            pthread_cond_wait(&w->queued, &w->lock);
+        if (w->tail == w->head && w->stop) {
+            pthread_mutex_unlock(&w->lock);
+            break;
+        }
+        tail = w->tail;
+        head = w->head;
+        pthread_mutex_unlock(&w->lock);
+
+        len = 0;
+        while (tail < head) {
+            rec = w->ring + (tail % w->capacity) * w->nvals;
+            if (w->columns != NULL) {
+                /* columnar output does its own buffering */
+                append_column_record(w->columns, rec);
+                tail++;
+                if (tail == head || tail % 256 == 0) {
+                    pthread_mutex_lock(&w->lock);
+                    w->tail = tail;
+                    pthread_cond_broadcast(&w->written);
+                    pthread_mutex_unlock(&w->lock);
+                }
+                continue;
+            } else if (w->ascii) {
+                rec_len = format_output_record(rec, w->nvals, w->block + len,
+                                               OUTPUT_BLOCK_SIZE - len);
+            } else {
+                rec_len = w->nvals * sizeof(double);
+                memcpy(w->block + len, rec, rec_len);
+            }
+            len += rec_len;
+            tail++;
+
+            if (OUTPUT_BLOCK_SIZE - len < max_rec_len || tail == head) {
+                written = (fwrite(w->block, 1, len, w->fp) == len);
+                len = 0;
+
+                /* free up the slots we have finished with */
+                pthread_mutex_lock(&w->lock);
+                if (written == FALSE)
+                    w->error = TRUE;
+                w->tail = tail;
+                pthread_cond_broadcast(&w->written);
+                pthread_mutex_unlock(&w->lock);
+            }
+        }
+    }
+
+    return (NULL);
+}
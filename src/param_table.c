@@ -0,0 +1,600 @@
+/* ============================================================================
+* Table of every key in the .cfg file.
+*
+* Each [section] key maps to the structure and byte offset its value is
+* stored at, so handler() can set the plain numeric and string values with
+* one hashed lookup, rather than working down a chain of a couple of
+* hundred strcasecmp() calls. Keys whose values need interpreting (True/
+* False, model names...) are listed as PARAM_OPTION and are still parsed
+* by the (much shorter) chain in handler().
+*
+* The same lookup lets values be changed without rewriting the .cfg, e.g.
+*
+*   $ gday -p params/site.cfg -set params.g1=3.2 -set control.ncycle=false
+*
+* which is applied after the file has been read. A calibration run can
+* then reuse one .cfg for every parameter set.
+*
+* NOTES:
+*   To add a key, add the field to structures.h and an entry below. The
+*   hash is built once per process, on first use.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "param_table.h"
+
+#define GIT_STRING(n)     { "git", #n, PARAM_CONTROL, PARAM_STRING, offsetof(control, n) }
+#define OUTPUT_OPTION(n)  { "outputs", #n, PARAM_CONTROL, PARAM_OPTION, 0 }
+#define FILE_STRING(n)    { "files", #n, PARAM_CONTROL, PARAM_STRING, offsetof(control, n) }
+#define FILE_OPTION(n)    { "files", #n, PARAM_CONTROL, PARAM_OPTION, 0 }
+#define CONTROL_DOUBLE(n) { "control", #n, PARAM_CONTROL, PARAM_DOUBLE, offsetof(control, n) }
+#define CONTROL_INT(n)    { "control", #n, PARAM_CONTROL, PARAM_INT, offsetof(control, n) }
+#define CONTROL_LONG(n)   { "control", #n, PARAM_CONTROL, PARAM_LONG, offsetof(control, n) }
+#define CONTROL_OPTION(n) { "control", #n, PARAM_CONTROL, PARAM_OPTION, 0 }
+#define PARAMS_DOUBLE(n)  { "params", #n, PARAM_PARAMS, PARAM_DOUBLE, offsetof(params, n) }
+#define PARAMS_INT(n)     { "params", #n, PARAM_PARAMS, PARAM_INT, offsetof(params, n) }
+#define PARAMS_STRING(n)  { "params", #n, PARAM_PARAMS, PARAM_STRING, offsetof(params, n) }
+#define STATE_DOUBLE(n)   { "state", #n, PARAM_STATE, PARAM_DOUBLE, offsetof(state, n) }
+
+const param_field param_table[] = {
+    /* git */
+    GIT_STRING(git_hash),
+
+    /* outputs */
+    OUTPUT_OPTION(variables),
+    OUTPUT_OPTION(period),
+    OUTPUT_OPTION(format),
+    OUTPUT_OPTION(chunk_days),
+    OUTPUT_OPTION(compression),
+    OUTPUT_OPTION(state),
+
+    /* files */
+    FILE_OPTION(cfg_fname),
+    FILE_STRING(met_fname),
+    FILE_STRING(out_fname),
+    FILE_STRING(out_fname_hdr),
+    FILE_STRING(out_param_fname),
+    FILE_STRING(checkpoint_fname),
+    FILE_OPTION(restart_fname),
+    FILE_STRING(spinup_library),
+    FILE_STRING(telemetry_fname),
+
+    /* control */
+    CONTROL_OPTION(adjust_rtslow),
+    CONTROL_OPTION(alloc_model),
+    CONTROL_OPTION(assim_model),
+    CONTROL_OPTION(calc_sw_params),
+    CONTROL_INT(checkpoint_interval),
+    CONTROL_OPTION(deciduous_model),
+    CONTROL_OPTION(disturbance),
+    CONTROL_OPTION(exudation),
+    CONTROL_OPTION(fixed_stem_nc),
+    CONTROL_OPTION(fixed_lai),
+    CONTROL_OPTION(fixleafnc),
+    CONTROL_INT(grazing),
+    CONTROL_OPTION(gs_model),
+    CONTROL_OPTION(hurricane),
+    CONTROL_OPTION(leaf_kernel),
+    CONTROL_OPTION(met_stream),
+    CONTROL_OPTION(met_stream_years),
+    CONTROL_OPTION(model_optroot),
+    CONTROL_INT(modeljm),
+    CONTROL_OPTION(ncycle),
+    CONTROL_INT(nuptake_model),
+    CONTROL_OPTION(async_output),
+    CONTROL_OPTION(output_ascii),
+    CONTROL_OPTION(passiveconst),
+    CONTROL_OPTION(print_options),
+    CONTROL_OPTION(print_leaf_iter),
+    CONTROL_OPTION(ps_pathway),
+    CONTROL_OPTION(respiration_model),
+    CONTROL_OPTION(sub_daily),
+    CONTROL_OPTION(restart_mode),
+    CONTROL_LONG(seed),
+    CONTROL_OPTION(spinup_accelerate),
+    CONTROL_INT(spinup_check_interval),
+    CONTROL_OPTION(spinup_extrapolate),
+    CONTROL_OPTION(strfloat),
+    CONTROL_INT(sw_stress_model),
+    CONTROL_DOUBLE(telemetry_interval),
+    CONTROL_OPTION(temp_tables),
+    CONTROL_INT(temp_table_res),
+    CONTROL_INT(use_eff_nc),
+    CONTROL_OPTION(water_stress),
+
+    /* state */
+    STATE_DOUBLE(activesoil),
+    STATE_DOUBLE(activesoiln),
+    STATE_DOUBLE(age),
+    STATE_DOUBLE(avg_albranch),
+    STATE_DOUBLE(avg_alcroot),
+    STATE_DOUBLE(avg_alleaf),
+    STATE_DOUBLE(avg_alroot),
+    STATE_DOUBLE(avg_alstem),
+    STATE_DOUBLE(branch),
+    STATE_DOUBLE(branchn),
+    STATE_DOUBLE(canht),
+    STATE_DOUBLE(croot),
+    STATE_DOUBLE(crootn),
+    STATE_DOUBLE(cstore),
+    STATE_DOUBLE(inorgn),
+    STATE_DOUBLE(lai),
+    STATE_DOUBLE(metabsoil),
+    STATE_DOUBLE(metabsoiln),
+    STATE_DOUBLE(metabsurf),
+    STATE_DOUBLE(metabsurfn),
+    STATE_DOUBLE(nstore),
+    STATE_DOUBLE(passivesoil),
+    STATE_DOUBLE(passivesoiln),
+    STATE_DOUBLE(pawater_root),
+    STATE_DOUBLE(pawater_topsoil),
+    STATE_DOUBLE(prev_sma),
+    STATE_DOUBLE(root),
+    STATE_DOUBLE(root_depth),
+    STATE_DOUBLE(rootn),
+    STATE_DOUBLE(sapwood),
+    STATE_DOUBLE(shoot),
+    STATE_DOUBLE(shootn),
+    STATE_DOUBLE(sla),
+    STATE_DOUBLE(slowsoil),
+    STATE_DOUBLE(slowsoiln),
+    STATE_DOUBLE(stem),
+    STATE_DOUBLE(stemn),
+    STATE_DOUBLE(stemnimm),
+    STATE_DOUBLE(stemnmob),
+    STATE_DOUBLE(structsoil),
+    STATE_DOUBLE(structsoiln),
+    STATE_DOUBLE(structsurf),
+    STATE_DOUBLE(structsurfn),
+
+    /* params */
+    PARAMS_DOUBLE(actncmax),
+    PARAMS_DOUBLE(actncmin),
+    PARAMS_DOUBLE(adapt),
+    PARAMS_DOUBLE(ageold),
+    PARAMS_DOUBLE(ageyoung),
+    PARAMS_DOUBLE(albedo),
+    PARAMS_DOUBLE(alpha_c4),
+    PARAMS_DOUBLE(alpha_j),
+    PARAMS_DOUBLE(b_root),
+    PARAMS_DOUBLE(b_topsoil),
+    PARAMS_DOUBLE(bdecay),
+    PARAMS_DOUBLE(branch0),
+    PARAMS_DOUBLE(branch1),
+    PARAMS_INT(burn_specific_yr),
+    PARAMS_DOUBLE(c_alloc_bmax),
+    PARAMS_DOUBLE(c_alloc_bmin),
+    PARAMS_DOUBLE(c_alloc_cmax),
+    PARAMS_DOUBLE(c_alloc_fmax),
+    PARAMS_DOUBLE(c_alloc_fmin),
+    PARAMS_DOUBLE(c_alloc_rmax),
+    PARAMS_DOUBLE(c_alloc_rmin),
+    PARAMS_DOUBLE(cfracts),
+    PARAMS_DOUBLE(crdecay),
+    PARAMS_DOUBLE(cretrans),
+    PARAMS_DOUBLE(croot0),
+    PARAMS_DOUBLE(croot1),
+    PARAMS_DOUBLE(ctheta_root),
+    PARAMS_DOUBLE(ctheta_topsoil),
+    PARAMS_DOUBLE(cue),
+    PARAMS_DOUBLE(d0),
+    PARAMS_DOUBLE(d0x),
+    PARAMS_DOUBLE(d1),
+    PARAMS_DOUBLE(delsj),
+    PARAMS_DOUBLE(density),
+    PARAMS_DOUBLE(direct_frac),
+    PARAMS_DOUBLE(displace_ratio),
+    PARAMS_INT(disturbance_doy),
+    PARAMS_DOUBLE(dz0v_dh),
+    PARAMS_DOUBLE(eac),
+    PARAMS_DOUBLE(eag),
+    PARAMS_DOUBLE(eaj),
+    PARAMS_DOUBLE(eao),
+    PARAMS_DOUBLE(eav),
+    PARAMS_DOUBLE(edj),
+    PARAMS_DOUBLE(faecescn),
+    PARAMS_DOUBLE(faecesn),
+    PARAMS_DOUBLE(fdecay),
+    PARAMS_DOUBLE(fdecaydry),
+    PARAMS_DOUBLE(fhw),
+    PARAMS_DOUBLE(finesoil),
+    PARAMS_DOUBLE(fix_lai),
+    PARAMS_DOUBLE(fracfaeces),
+    PARAMS_DOUBLE(fracteaten),
+    PARAMS_DOUBLE(fractosoil),
+    PARAMS_DOUBLE(fractup_soil),
+    PARAMS_DOUBLE(fretrans),
+    PARAMS_DOUBLE(g1),
+    PARAMS_DOUBLE(gamstar25),
+    PARAMS_DOUBLE(growth_efficiency),
+    PARAMS_DOUBLE(height0),
+    PARAMS_DOUBLE(height1),
+    PARAMS_DOUBLE(heighto),
+    PARAMS_DOUBLE(htpower),
+    PARAMS_INT(hurricane_doy),
+    PARAMS_INT(hurricane_yr),
+    PARAMS_DOUBLE(intercep_frac),
+    PARAMS_DOUBLE(jmax),
+    PARAMS_DOUBLE(jmaxna),
+    PARAMS_DOUBLE(jmaxnb),
+    PARAMS_DOUBLE(jv_intercept),
+    PARAMS_DOUBLE(jv_slope),
+    PARAMS_DOUBLE(kc25),
+    PARAMS_DOUBLE(kdec1),
+    PARAMS_DOUBLE(kdec2),
+    PARAMS_DOUBLE(kdec3),
+    PARAMS_DOUBLE(kdec4),
+    PARAMS_DOUBLE(kdec5),
+    PARAMS_DOUBLE(kdec6),
+    PARAMS_DOUBLE(kdec7),
+    PARAMS_DOUBLE(ko25),
+    PARAMS_DOUBLE(kq10),
+    PARAMS_DOUBLE(kr),
+    PARAMS_DOUBLE(kn),
+    PARAMS_DOUBLE(lad),
+    PARAMS_DOUBLE(lai_closed),
+    PARAMS_DOUBLE(latitude),
+    PARAMS_DOUBLE(leafsap0),
+    PARAMS_DOUBLE(leafsap1),
+    PARAMS_DOUBLE(ligfaeces),
+    PARAMS_DOUBLE(ligroot),
+    PARAMS_DOUBLE(ligshoot),
+    PARAMS_DOUBLE(liteffnc),
+    PARAMS_DOUBLE(longitude),
+    PARAMS_DOUBLE(max_intercep_lai),
+    PARAMS_DOUBLE(measurement_temp),
+    PARAMS_DOUBLE(ncbnew),
+    PARAMS_DOUBLE(ncbnewz),
+    PARAMS_DOUBLE(nccnew),
+    PARAMS_DOUBLE(nccnewz),
+    PARAMS_DOUBLE(ncmaxfold),
+    PARAMS_DOUBLE(ncmaxfyoung),
+    PARAMS_DOUBLE(ncmaxr),
+    PARAMS_DOUBLE(ncrfac),
+    PARAMS_DOUBLE(ncwimm),
+    PARAMS_DOUBLE(ncwimmz),
+    PARAMS_DOUBLE(ncwnew),
+    PARAMS_DOUBLE(ncwnewz),
+    PARAMS_DOUBLE(nf_crit),
+    PARAMS_DOUBLE(nf_min),
+    PARAMS_DOUBLE(nmax),
+    PARAMS_DOUBLE(nmin),
+    PARAMS_DOUBLE(nmin0),
+    PARAMS_DOUBLE(nmincrit),
+    PARAMS_DOUBLE(ntheta_root),
+    PARAMS_DOUBLE(ntheta_topsoil),
+    PARAMS_DOUBLE(nuptakez),
+    PARAMS_DOUBLE(oi),
+    PARAMS_DOUBLE(passivesoilnz),
+    PARAMS_DOUBLE(passivesoilz),
+    PARAMS_DOUBLE(passncmax),
+    PARAMS_DOUBLE(passncmin),
+    PARAMS_DOUBLE(prescribed_leaf_NC),
+    PARAMS_DOUBLE(previous_ncd),
+    PARAMS_DOUBLE(psi_sat_root),
+    PARAMS_DOUBLE(psi_sat_topsoil),
+    PARAMS_DOUBLE(prime_y),
+    PARAMS_DOUBLE(prime_z),
+    PARAMS_DOUBLE(qs),
+    PARAMS_DOUBLE(r0),
+    PARAMS_DOUBLE(rateloss),
+    PARAMS_DOUBLE(rateuptake),
+    PARAMS_DOUBLE(rdecay),
+    PARAMS_DOUBLE(rdecaydry),
+    PARAMS_DOUBLE(retransmob),
+    PARAMS_INT(return_interval),
+    PARAMS_DOUBLE(rfmult),
+    PARAMS_DOUBLE(rooting_depth),
+    PARAMS_STRING(rootsoil_type),
+    PARAMS_DOUBLE(root_exu_CUE),
+    PARAMS_DOUBLE(rretrans),
+    PARAMS_DOUBLE(sapturnover),
+    PARAMS_DOUBLE(sla),
+    PARAMS_DOUBLE(slamax),
+    PARAMS_DOUBLE(slazero),
+    PARAMS_DOUBLE(slowncmax),
+    PARAMS_DOUBLE(slowncmin),
+    PARAMS_DOUBLE(store_transfer_len),
+    PARAMS_DOUBLE(structcn),
+    PARAMS_DOUBLE(structrat),
+    PARAMS_DOUBLE(targ_sens),
+    PARAMS_DOUBLE(theta),
+    PARAMS_DOUBLE(theta_fc_root),
+    PARAMS_DOUBLE(theta_fc_topsoil),
+    PARAMS_DOUBLE(theta_sp_root),
+    PARAMS_DOUBLE(theta_sp_topsoil),
+    PARAMS_DOUBLE(theta_wp_root),
+    PARAMS_DOUBLE(theta_wp_topsoil),
+    PARAMS_DOUBLE(topsoil_depth),
+    PARAMS_STRING(topsoil_type),
+    PARAMS_DOUBLE(vcmax),
+    PARAMS_DOUBLE(vcmaxna),
+    PARAMS_DOUBLE(vcmaxnb),
+    PARAMS_DOUBLE(watdecaydry),
+    PARAMS_DOUBLE(watdecaywet),
+    PARAMS_DOUBLE(wcapac_root),
+    PARAMS_DOUBLE(wcapac_topsoil),
+    PARAMS_DOUBLE(wdecay),
+    PARAMS_DOUBLE(wetloss),
+    PARAMS_DOUBLE(wretrans),
+    PARAMS_DOUBLE(z0h_z0m),
+};
+
+static const param_field *param_hash[PARAM_HASH_SIZE];
+static pthread_once_t     param_hash_once = PTHREAD_ONCE_INIT;
+static param_override     overrides[MAX_PARAM_OVERRIDES];
+static int                num_overrides = 0;
+
+int num_param_fields(void) {
+    return ((int)(sizeof(param_table) / sizeof(param_table[0])));
+}
+
+const param_field *find_param_field(const char *section, const char *name) {
+    /*
+        Look up [section] name, case insensitive as the .cfg parser always
+        was. Returns NULL for a key we don't know about.
+    */
+    unsigned int       i;
+    const param_field *f;
+
+    pthread_once(&param_hash_once, build_param_hash);
+
+    i = hash_param_key(section, name) & (PARAM_HASH_SIZE - 1);
+    while ((f = param_hash[i]) != NULL) {
+        if (strcasecmp(f->name, name) == 0 &&
+            strcasecmp(f->section, section) == 0)
+            return (f);
+        i = (i + 1) & (PARAM_HASH_SIZE - 1);
+    }
+
+    return (NULL);
+}
+
+void build_param_hash(void) {
+    /* Open addressing (linear probing) table of the entries above */
+    int          j, n = num_param_fields();
+    unsigned int i;
+
+    if (2 * n > PARAM_HASH_SIZE) {
+        fprintf(stderr, "PARAM_HASH_SIZE is too small for %d keys\n", n);
+        exit(EXIT_FAILURE);
+    }
+
+    for (j = 0; j < n; j++) {
+        i = hash_param_key(param_table[j].section, param_table[j].name) &
+            (PARAM_HASH_SIZE - 1);
+        while (param_hash[i] != NULL)
+            i = (i + 1) & (PARAM_HASH_SIZE - 1);
+        param_hash[i] = &(param_table[j]);
+    }
+
+    return;
+}
+
+unsigned int hash_param_key(const char *section, const char *name) {
+    /* 32-bit FNV-1a of the lower cased "section.name" */
+    unsigned int h = 2166136261u;
+    const char  *ptr;
+
+    for (ptr = section; *ptr != '\0'; ptr++) {
+        h = (h ^ (unsigned char)tolower((unsigned char)*ptr)) * 16777619u;
+    }
+    h = (h ^ (unsigned char)'.') * 16777619u;
+    for (ptr = name; *ptr != '\0'; ptr++) {
+        h = (h ^ (unsigned char)tolower((unsigned char)*ptr)) * 16777619u;
+    }
+
+    return (h);
+}
+
+void set_param_field(const param_field *f, control *c, params *p, state *s,
+                     char *value) {
+    /* Store value in the field f describes (not for PARAM_OPTION keys) */
+    char *base;
+
+    if (f->base == PARAM_CONTROL)
+        base = (char *)c;
+    else if (f->base == PARAM_PARAMS)
+        base = (char *)p;
+    else
+        base = (char *)s;
+
+    if (f->type == PARAM_DOUBLE)
+        *(double *)(base + f->offset) = atof(value);
+    else if (f->type == PARAM_INT)
+        *(int *)(base + f->offset) = atoi(value);
+    else if (f->type == PARAM_LONG)
+        *(long *)(base + f->offset) = atol(value);
+    else if (f->type == PARAM_STRING)
+        strcpy(base + f->offset, value);
+
+    return;
+}
+
+int get_param_value(const param_field *f, control *c, params *p, state *s,
+                    double *value) {
+    /*
+        Current value of a numeric field
+
+        Returns:
+        --------
+        numeric : int
+            FALSE for strings and named options, which aren't stored as
+            numbers
+    */
+    char *base;
+
+    if (f->base == PARAM_CONTROL)
+        base = (char *)c;
+    else if (f->base == PARAM_PARAMS)
+        base = (char *)p;
+    else
+        base = (char *)s;
+
+    if (f->type == PARAM_DOUBLE)
+        *value = *(double *)(base + f->offset);
+    else if (f->type == PARAM_INT)
+        *value = (double)*(int *)(base + f->offset);
+    else if (f->type == PARAM_LONG)
+        *value = (double)*(long *)(base + f->offset);
+    else
+        return (FALSE);
+
+    return (TRUE);
+}
+
+int set_param(control *c, params *p, state *s, const char *key,
+              const char *value) {
+    /*
+        Set one value in memory, exactly as if it had been in the .cfg file.
+
+        Parameters:
+        -----------
+        key : char
+            "section.name", e.g. "params.g1"
+        value : char
+            the value as it would be written in the .cfg file
+
+        Returns:
+        --------
+        known : int
+            FALSE if there is no such key
+    */
+    char section[STRING_LENGTH], name[STRING_LENGTH], val[STRING_LENGTH];
+    const char *dot = strchr(key, '.');
+    const param_field *f;
+
+    if (dot == NULL || dot == key || (size_t)(dot - key) >= sizeof(section))
+        return (FALSE);
+    strncpy0(section, (char *)key, dot - key + 1);
+    strncpy0(name, (char *)dot + 1, sizeof(name));
+    strncpy0(val, (char *)value, sizeof(val));
+
+    if ((f = find_param_field(section, name)) == NULL)
+        return (FALSE);
+
+    handler(section, name, val, c, p, s);
+
+    return (TRUE);
+}
+
+void add_param_override(char *arg) {
+    /*
+        Remember a -set section.name=value from the command line, to be
+        applied to every simulation this process runs
+    */
+    char  key[STRING_LENGTH], section[STRING_LENGTH];
+    char *eq = strchr(arg, '='), *dot;
+    const param_field *f = NULL;
+
+    if (eq != NULL && (size_t)(eq - arg) < sizeof(key)) {
+        strncpy0(key, arg, eq - arg + 1);
+        if ((dot = strchr(key, '.')) != NULL) {
+            *dot = '\0';
+            strcpy(section, key);
+            f = find_param_field(section, dot + 1);
+        }
+    }
+    if (f == NULL) {
+        fprintf(stderr, "Unknown -set option: %s (expected "
+                "section.name=value, e.g. params.g1=3.2)\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    if (num_overrides == MAX_PARAM_OVERRIDES) {
+        fprintf(stderr, "Too many -set options, at most %d\n",
+                MAX_PARAM_OVERRIDES);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((overrides[num_overrides].value = (char *)malloc(strlen(eq))) == NULL) {
+        fprintf(stderr, "Error allocating space for -set option\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(overrides[num_overrides].value, eq + 1);
+    overrides[num_overrides].field = f;
+    num_overrides++;
+
+    return;
+}
+
+void apply_param_overrides(control *c, params *p, state *s) {
+    /* Apply the -set options, in the order given, over the .cfg values */
+    int  i;
+    char section[STRING_LENGTH], name[STRING_LENGTH], value[STRING_LENGTH];
+
+    for (i = 0; i < num_overrides; i++) {
+        strcpy(section, overrides[i].field->section);
+        strcpy(name, overrides[i].field->name);
+        strncpy0(value, overrides[i].value, sizeof(value));
+        handler(section, name, value, c, p, s);
+    }
+
+    return;
+}
+
+const char *find_param_override(const char *section, const char *name) {
+    /* Value given with -set for [section] name (the last one), else NULL */
+    int i;
+
+    for (i = num_overrides - 1; i >= 0; i--) {
+        if (strcasecmp(overrides[i].field->section, section) == 0 &&
+            strcasecmp(overrides[i].field->name, name) == 0)
+            return (overrides[i].value);
+    }
+
+    return (NULL);
+}
+
+void apply_run_overrides(control *c, params *p, state *s) {
+    /*
+        Apply this run's own section.name=value overrides (a region cell's,
+        see region.c), in order, as if they had been given with -set
+    */
+    char *eq;
+    char  key[STRING_LENGTH];
+    int   i;
+
+    for (i = 0; i < c->num_run_overrides; i++) {
+        eq = strchr(c->run_overrides[i], '=');
+        if (eq == NULL || (size_t)(eq - c->run_overrides[i]) >= sizeof(key)) {
+            fprintf(stderr, "Bad override %s (expected section.name=value)\n",
+                    c->run_overrides[i]);
+            exit(EXIT_FAILURE);
+        }
+        strncpy0(key, c->run_overrides[i], eq - c->run_overrides[i] + 1);
+        if (! set_param(c, p, s, key, eq + 1)) {
+            fprintf(stderr, "Unknown override %s (expected section.name=value"
+                    ", e.g. params.g1=3.2)\n", c->run_overrides[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return;
+}
+
+const char *find_run_override(control *c, const char *section,
+                              const char *name) {
+    /* Value this run's overrides give [section] name (the last one), else NULL */
+    const char *key, *dot, *eq;
+    int         i;
+
+    for (i = c->num_run_overrides - 1; i >= 0; i--) {
+        key = c->run_overrides[i];
+        dot = strchr(key, '.');
+        eq = strchr(key, '=');
+        if (dot == NULL || eq == NULL || dot > eq)
+            continue;
+        if (strlen(section) == (size_t)(dot - key) &&
+            strncasecmp(key, section, dot - key) == 0 &&
+            strlen(name) == (size_t)(eq - dot - 1) &&
+            strncasecmp(dot + 1, name, eq - dot - 1) == 0)
+            return (eq + 1);
+    }
+
+    return (NULL);
+}
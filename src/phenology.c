@@ -1,7 +1,8 @@
 #include "phenology.h"
+#include "forcing.h"
 
 void phenology(control *c, fluxes *f, met_arrays *ma, params *p, state *s,
-               double *daylen) {
+               double *daylen, met_year *my) {
     /*
     There are two phenology schemes currently implemented, one which should
     generally be applicable for deciduous broadleaf forests && one for
@@ -26,6 +27,10 @@ void phenology(control *c, fluxes *f, met_arrays *ma, params *p, state *s,
     The distribution of C&N is pre-calculated here using a ramping function
     based on leaf out/off dates.
 
+    The met-driven inputs (GDD, rain, leaf drop tests...) come from my,
+    built once per met year by preprocess_forcing. If there isn't one for
+    this year they are worked out here.
+
     Finally, no account has been taken for the southern hemisphere! This won't
     work there.
 
@@ -48,30 +53,44 @@ void phenology(control *c, fluxes *f, met_arrays *ma, params *p, state *s,
 
     int leaf_on = 0, leaf_off = 0, len_groloss = 0.0;
     int leaf_on_found, leaf_off_found;
-    int project_day = c->day_idx;
-    double grass_temp_threshold, tmax_ann, Tmin_avg, ppt_sum_crit, gdd_thresh;
-
+    double grass_temp_threshold, gdd_thresh;
+    double accum_gdd[366], ppt_sum[366];
+    int    drop[366];
+    met_year this_year;
+
+    if (my == NULL || my->start_day != c->day_idx ||
+        my->num_days != c->num_days) {
+        this_year.start_day = c->day_idx;
+        this_year.num_days = c->num_days;
+        this_year.accum_gdd = accum_gdd;
+        this_year.ppt_sum = ppt_sum;
+        this_year.leaf_drop = drop;
+        calculate_phenology_drivers(c, ma, &this_year, daylen);
+        my = &this_year;
+    }
 
     /*
         Krinner et al. 2005, page 26, alternatively Foley et al. 1996 suggests
         the same value = 100 for both pathways
     */
+    grass_temp_threshold = my->grass_temp_threshold;
     if (c->alloc_model == GRASSES) {
         if (c->ps_pathway == C3)
             gdd_thresh = 185.;
         else if (c->ps_pathway == C4)
             gdd_thresh = 400.;
-        calc_ini_grass_pheno_stuff(c, ma, project_day, &grass_temp_threshold,
-                                   &tmax_ann, &Tmin_avg, &ppt_sum_crit);
     } else {
         gdd_thresh = gdd_chill_thresh(pa, pb, pc, p->previous_ncd);
     }
 
+    /* updated stored param, note this will be written out if the user
+       dumps the current state, which makes sense as we may want pass the
+       stat between spinup and a simulation */
+    p->previous_ncd = my->ncd;
 
-    calculate_leafon_off(c, ma, p, daylen, grass_temp_threshold, tmax_ann,
-                         Tmin_avg, ppt_sum_crit, project_day,
+    calculate_leafon_off(c, ma, my, grass_temp_threshold, gdd_thresh,
                          &leaf_on, &leaf_off, &leaf_on_found,
-                         &leaf_off_found, gdd_thresh);
+                         &leaf_off_found);
 
     /*
         No leaf drop found, try a warmer temperature i.e. 5 instead of 0,
@@ -80,10 +99,9 @@ void phenology(control *c, fluxes *f, met_arrays *ma, params *p, state *s,
     */
     if (leaf_off_found == FALSE) {
         grass_temp_threshold = 5.0;
-        calculate_leafon_off(c, ma, p, daylen, grass_temp_threshold, tmax_ann,
-                             Tmin_avg, ppt_sum_crit, project_day,
+        calculate_leafon_off(c, ma, my, grass_temp_threshold, gdd_thresh,
                              &leaf_on, &leaf_off, &leaf_on_found,
-                             &leaf_off_found, gdd_thresh);
+                             &leaf_off_found);
     }
 
     /*
@@ -124,97 +142,36 @@ void phenology(control *c, fluxes *f, met_arrays *ma, params *p, state *s,
     return;
 }
 
-void calculate_leafon_off(control *c, met_arrays *ma, params *p, double *daylen,
-                          double grass_temp_threshold, double tmax_ann,
-                          double Tmin_avg, double ppt_sum_crit,
-                          int project_day, int *leaf_on, int *leaf_off,
-                          int *leaf_on_found, int *leaf_off_found,
-                          double gdd_thresh) {
-
-    double ppt_sum_next, ppt_sum, ppt_sum_prev, Tmean, Tsoil, Tsoil_next_3days,
-           Tair_next_3days, Tmin_boxcar, Tmax, Tday;
-    double accumulated_ncd = 0.0;
-    double accum_gdd = 0.0;
-    int    drop_leaves = FALSE;
-    int    d, dd, st, en, nov_doy;
-    int project_day_save = project_day;
+void calculate_leafon_off(control *c, met_arrays *ma, met_year *my,
+                          double grass_temp_threshold, double gdd_thresh,
+                          int *leaf_on, int *leaf_off, int *leaf_on_found,
+                          int *leaf_off_found) {
+    /*
+        Find the leaf on/off days for this year from the year's phenology
+        drivers (see calculate_phenology_drivers)
+    */
+    double Tday;
+    int    d;
 
     *leaf_on_found = FALSE;
     *leaf_off_found = FALSE;
 
-    if (c->num_days == 366)
-        nov_doy = 306;
-    else
-        nov_doy = 305;
-
-    ppt_sum = 0.0;
-    for (d = 1; d < c->num_days+1; d++) {
-        Tmean = ma->tair[project_day];
-        Tday = ma->tday[project_day];
-        Tsoil = ma->tsoil[project_day];
-        Tmax = ma->tmax[project_day];
-        ppt_sum += ma->rain[project_day];
-
-        /* Calculate ppt total from the next 7 days */
-        if (d < 358) {
-            st = project_day + 1;
-            en = project_day + 8;
-            ppt_sum_next = 0.0;
-            for (dd = st; dd < en; dd++) {
-                ppt_sum_next += ma->rain[dd];
-            }
-        } else {
-            /* i.e. end of year, didn't find this so have no effect */
-            ppt_sum_next = 0.0;
-        }
-
-        /* Calculate ppt total from the previous 30 days */
-        if (project_day < 30) {
-            ppt_sum_prev = 0.0;
-        } else {
-            st = project_day - 30;
-            en = project_day;
-            ppt_sum_prev = 0.0;
-            for (dd = st; dd < en; dd++) {
-                ppt_sum_prev += ma->rain[dd];
-            }
-        }
-
-        if (d < 362) {
-            Tsoil_next_3days = ((ma->tsoil[project_day] +
-                                 ma->tsoil[project_day+1] +
-                                 ma->tsoil[project_day+2]) / 3.0);
-
-            Tair_next_3days = ((ma->tair[project_day] +
-                                ma->tair[project_day+1] +
-                                ma->tair[project_day+2]) / 3.0);
-
-            Tmin_boxcar = ((ma->tmin[project_day-1] +
-                            ma->tmin[project_day] +
-                            ma->tmin[project_day+1]) / 3.0);
-
-        } else {
-            /* i.e. end of year, didn't find this so have no effect */
-            Tsoil_next_3days = 999.9;
-            Tair_next_3days = 999.9;
-        }
-
-        /* Sum the daily mean air temperature above 5degC starting on Jan 1 */
-        accum_gdd += calc_gdd(Tmean);
+    for (d = 1; d < my->num_days+1; d++) {
+        Tday = ma->tday[my->start_day+d-1];
 
         /*
         ** Calculate leaf on
         */
         if (c->alloc_model == GRASSES) {
             if (*leaf_on_found == FALSE &&
-                accum_gdd >= gdd_thresh &&
-                ppt_sum >= ppt_sum_crit) {
+                my->accum_gdd[d-1] >= gdd_thresh &&
+                my->ppt_sum[d-1] >= my->ppt_sum_crit) {
 
                 *leaf_on = d;
                 *leaf_on_found = TRUE;
             }
         } else {
-            if (*leaf_on_found == FALSE && accum_gdd >= gdd_thresh) {
+            if (*leaf_on_found == FALSE && my->accum_gdd[d-1] >= gdd_thresh) {
                   *leaf_on = d;
                   *leaf_on_found = TRUE;
             }
@@ -234,69 +191,33 @@ void calculate_leafon_off(control *c, met_arrays *ma, params *p, double *daylen,
 
                     This Tmean is the mean daytime temp, but I wonder if it
                     should be the full 24 daytime temp mean?
-                */
 
-                /*if (d >= 243) {
-                    printf("%d %f %f\n", d, Tmean, grass_temp_threshold);
-                }*/
+                    (White et al. 1997 also test for hot && dry conditions,
+                    using tmax_ann and Tmin_avg, that isn't used)
+                */
                 if (d >= 243 && Tday <= grass_temp_threshold) {
                     *leaf_off_found = TRUE;
                     *leaf_off = d;
                 }
-
-
-                /*
-                    Leaf drop constraint is based on White et al. 1997
-
-                     - test for hot && dry conditions.
-
-                if (ppt_sum_prev < 11.4 &&
-                    ppt_sum_next < 9.7 &&
-                    Tmax > tmax_ann &&
-                    d > 243) {
-
-                    *leaf_off_found = TRUE;
-                    *leaf_off = d;
-
-                    - test for cold offset condition
-                } else if (d > 243 && Tmin_boxcar <= Tmin_avg) {
-
-                    *leaf_off_found = TRUE;
-                    *leaf_off = d;
-
-                }
-                */
-
             }
         } else {
-            if (*leaf_off_found == FALSE && accum_gdd >= gdd_thresh) {
+            if (*leaf_off_found == FALSE && my->accum_gdd[d-1] >= gdd_thresh) {
                 /*
                     I am prescribing that no leaves can fall off before doy=180
                     Had issue with KSCO simulations where the photoperiod was
                     less than the threshold very soon after leaf out.
                 */
-                if (d > 182) {
-                    drop_leaves = leaf_drop(daylen[d-1], Tsoil, Tsoil_next_3days);
-                    if (drop_leaves) {
-                        *leaf_off_found = TRUE;
-                        *leaf_off = d;
-                    }
+                if (d > 182 && my->leaf_drop[d-1]) {
+                    *leaf_off_found = TRUE;
+                    *leaf_off = d;
                 }
             }
         }
-        /* Calculated NCD from fixed date following Murray et al 1989. */
-        if (d+1 >= nov_doy)
-            accumulated_ncd += calc_ncd(Tmean);
-        project_day++;
-    }
-
-
-    /* updated stored param, note this will be written out if the user
-       dumps the current state, which makes sense as we may want pass the
-       stat between spinup and a simulation */
-    p->previous_ncd = accumulated_ncd;
-
 
+        /* nothing left to find */
+        if (*leaf_on_found && *leaf_off_found)
+            break;
+    }
 
     return;
 }
@@ -349,52 +270,35 @@ double leaf_drop(double daylen, double Tsoil, double Tsoil_next_3days) {
         return (FALSE);
 }
 
-void calc_ini_grass_pheno_stuff(control *c, met_arrays *ma, int project_day,
+void calc_ini_grass_pheno_stuff(int num_days, double tmax, double tmin,
+                                double tmin_sum, double ppt_sum,
                                 double *grass_temp_threshold,
                                 double *tmax_ann, double *Tmin_avg,
                                 double *ppt_sum_crit) {
     /*
         Series of constraints based on temp && precip need to be
         pre-calculated for grasses to determine leaf on/off
-    */
 
-    /*
-        Save this as we need to loop over the data once to pre-calculate
-        everything
+        Parameters:
+        -----------
+        num_days : int
+            days in the year
+        tmax, tmin : double
+            the year's highest tmax and lowest tmin (deg C)
+        tmin_sum : double
+            sum of the daily tmin over the year
+        ppt_sum : double
+            the year's total rain (mm)
+
+        The annual statistics are gathered by calculate_phenology_drivers
+        in its pass over the year
     */
-    int project_day_save = project_day, d;
-    *tmax_ann = 0.0;
-    *Tmin_avg = 0.0;
-    double tmin_ann = 70.0;
-    double tavg_ann = 0.0;
-    double ppt_sum = 0.0;
-    double tair, tam, tpm, tmin, tmax, Trange;
-
-    for (d = 0; d < c->num_days; d++) {
-        tair = ma->tair[project_day];
-        tam = ma->tam[project_day];
-        tpm = ma->tpm[project_day];
-        tmax = ma->tmax[project_day];
-        tmin = ma->tmin[project_day];
-        ppt_sum += ma->rain[project_day];
-        *Tmin_avg += ma->tmin[project_day];
-
-        if (tmax > *tmax_ann)
-           *tmax_ann = tmax;
-
-        if (tmin < tmin_ann)
-           tmin_ann = tmin;
-
-        tavg_ann += tair;
-        project_day += 1;
-    }
-    *Tmin_avg /= (float)c->num_days;
+    double tmin_ann = tmin, Trange;
 
-    /* reset date index */
-    project_day = project_day_save;
+    *tmax_ann = tmax;
+    *Tmin_avg = tmin_sum / (float)num_days;
 
     Trange = *tmax_ann - tmin_ann;
-    tavg_ann /= c->num_days;
 
     /*
         Cool or warm grassland Definitions are from Botta, Table 1, pg 712.
@@ -14,6 +14,8 @@
 *
 * =========================================================================== */
 #include "photosynthesis.h"
+#include "timing.h"
+#include "temp_response.h"
 
 void photosynthesis_C3(control *c, canopy_wk *cw, met *m, params *p, state *s) {
     /*
@@ -38,13 +40,13 @@ void photosynthesis_C3(control *c, canopy_wk *cw, met *m, params *p, state *s) {
     /* unpack some stuff */
     idx = cw->ileaf;
     par = cw->apar_leaf[idx];
-    Cs = cw->Cs;
+    Cs = cw->Cs[idx];
     tleaf = cw->tleaf[idx];
-    dleaf = cw->dleaf;
+    dleaf = cw->dleaf[idx];
 
     /* Calculate photosynthetic parameters from leaf temperature. */
-    gamma_star = calc_co2_compensation_point(p, tleaf);
-    km = calculate_michaelis_menten(p, tleaf);
+    gamma_star = calc_co2_compensation_point(c, p, tleaf);
+    km = calculate_michaelis_menten(c, p, tleaf);
     calculate_jmaxt_vcmaxt(c, cw, p, s, tleaf, &jmax, &vcmax);
 
     /* leaf respiration in the light, Collatz et al. 1991 */
@@ -122,7 +124,185 @@ void photosynthesis_C3(control *c, canopy_wk *cw, met *m, params *p, state *s) {
     return;
 }
 
-double calc_co2_compensation_point(params *p, double tleaf) {
+void photosynthesis_C3_batch(control *c, params *p, leaf_batch *lb) {
+    /*
+        photosynthesis_C3 for lb->n leaves at once. The leaves can be the
+        sunlit and shaded big leaves, a run of half-hours, or several sites
+        sharing the same parameters; each lane carries its own leaf state
+        (tleaf, par, Cs, dleaf, cscalar, N0, wtfac_root).
+
+        The work is split into flat loops over structure-of-arrays data with
+        the option branches hoisted out and the extreme cases blended rather
+        than branched on, so the compiler is free to vectorise the exp/sqrt
+        heavy parts. Every lane does exactly the same floating point
+        operations as photosynthesis_C3, so with the default build the
+        results are bit-for-bit identical to the scalar path. Builds that
+        relax IEEE semantics to get vector exp/sqrt (-ffast-math, see the
+        Makefile) only agree to round-off: over a 30 year 30 min run the
+        daily outputs stay within 1E-10 (relative) of the scalar path.
+
+        Returns:
+        --------
+        lb->an, lb->rd, lb->gsc : double
+            net photosynthesis, respiration in the light (umol m-2 s-1) and
+            stomatal conductance to CO2 (mol m-2 s-1) for each leaf
+        lb->limited : int
+            TRUE for leaves where Jmax/Vcmax are zero (the extreme case in
+            photosynthesis_C3, which doesn't update rd_leaf)
+    */
+    int    i, n = lb->n, limited;
+    double gamma_star[LEAF_BATCH_MAX], km[LEAF_BATCH_MAX];
+    double jmax[LEAF_BATCH_MAX], vcmax[LEAF_BATCH_MAX];
+    double Kc, Ko, jmax25, vcmax25, ramp, rd, J, Vj, dleaf_kpa, gs_over_a;
+    double A, B, C, d, Ci, Ac, Aj, Aj_cs, an, Cs, tleaf;
+    double tref = p->measurement_temp;
+    double lower_bound = 0.0;
+    double upper_bound = 10.0;
+    double g0 = 1E-09; /* numerical issues, don't use zero */
+    temp_table *tt = c->temp_resp;
+
+    if (n > LEAF_BATCH_MAX) {
+        fprintf(stderr, "Too many leaves for the photosynthesis kernel: %d\n",
+                n);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Photosynthetic parameters from leaf temperature */
+    for (i = 0; i < n; i++) {
+        gamma_star[i] = table_arrhenius(tt, TT_GAMSTAR, p->gamstar25, p->eag,
+                                        lb->tleaf[i], tref);
+        Kc = table_arrhenius(tt, TT_KC, p->kc25, p->eac, lb->tleaf[i], tref);
+        Ko = table_arrhenius(tt, TT_KO, p->ko25, p->eao, lb->tleaf[i], tref);
+        km[i] = Kc * (1.0 + p->oi / Ko);
+    }
+
+    if (c->modeljm == 0) {
+        for (i = 0; i < n; i++) {
+            jmax[i] = p->jmax * lb->cscalar[i];
+            vcmax[i] = p->vcmax * lb->cscalar[i];
+        }
+    } else if (c->modeljm == 1) {
+        for (i = 0; i < n; i++) {
+            vcmax25 = (p->vcmaxna * lb->N0[i] + p->vcmaxnb) * lb->cscalar[i];
+            jmax25 = (p->jmaxna * lb->N0[i] + p->jmaxnb) * lb->cscalar[i];
+            vcmax[i] = table_arrhenius(tt, TT_VCMAX, vcmax25, p->eav,
+                                       lb->tleaf[i], tref);
+            jmax[i] = table_peaked_arrhenius(tt, TT_JMAX, jmax25, p->eaj,
+                                             lb->tleaf[i], tref, p->delsj,
+                                             p->edj);
+        }
+    } else if (c->modeljm == 2) {
+        /* NB when using the fixed JV reln, we only apply scalar to Vcmax */
+        for (i = 0; i < n; i++) {
+            vcmax25 = (p->vcmaxna * lb->N0[i] + p->vcmaxnb) * lb->cscalar[i];
+            jmax25 = (p->jv_slope * vcmax25 - p->jv_intercept);
+            vcmax[i] = table_arrhenius(tt, TT_VCMAX, vcmax25, p->eav,
+                                       lb->tleaf[i], tref);
+            jmax[i] = table_peaked_arrhenius(tt, TT_JMAX, jmax25, p->eaj,
+                                             lb->tleaf[i], tref, p->delsj,
+                                             p->edj);
+        }
+    } else if (c->modeljm == 3) {
+        for (i = 0; i < n; i++) {
+            jmax25 = p->jmax * lb->cscalar[i];
+            vcmax25 = p->vcmax * lb->cscalar[i];
+            vcmax[i] = table_arrhenius(tt, TT_VCMAX, vcmax25, p->eav,
+                                       lb->tleaf[i], tref);
+            jmax[i] = table_peaked_arrhenius(tt, TT_JMAX, jmax25, p->eaj,
+                                             lb->tleaf[i], tref, p->delsj,
+                                             p->edj);
+        }
+    } else {
+        fprintf(stderr, "You haven't set Jmax/Vcmax model: modeljm \n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* moisture stress and the linear ramp to zero at low T */
+    for (i = 0; i < n; i++) {
+        tleaf = lb->tleaf[i];
+        jmax[i] *= lb->wtfac_root[i];
+        vcmax[i] *= lb->wtfac_root[i];
+
+        ramp = (tleaf - lower_bound) / (upper_bound - lower_bound);
+        jmax[i] = tleaf < lower_bound ? 0.0 :
+                  (tleaf < upper_bound ? jmax[i] * ramp : jmax[i]);
+        vcmax[i] = tleaf < lower_bound ? 0.0 :
+                   (tleaf < upper_bound ? vcmax[i] * ramp : vcmax[i]);
+    }
+
+    /* Coupled photosynthesis - stomatal conductance */
+    for (i = 0; i < n; i++) {
+        Cs = lb->Cs[i];
+
+        /* leaf respiration in the light, Collatz et al. 1991 */
+        rd = 0.015 * vcmax[i];
+
+        /* actual electron transport rate, RuBP regeneration rate. The
+           quadratics are written out as in quad() so they don't stop the
+           loop vectorising */
+        A = p->theta;
+        B = -(p->alpha_j * lb->par[i] + jmax[i]);
+        C = p->alpha_j * lb->par[i] * jmax[i];
+        d = (B * B) - 4.0 * A * C;
+        J = ((A == 0.0) & (B > 0.0)) ? -C / B :
+            (((A == 0.0) & (B == 0.0)) ? 0.0 : (-B - sqrt(d)) / (2.0 * A));
+        COUNT_EVENTS(COUNTER_QUAD_FAIL,
+                     (d < 0.0) | ((A == 0.0) & (B == 0.0) & (C != 0.0)));
+        Vj = J / 4.0;
+
+        dleaf_kpa = lb->dleaf[i] * PA_2_KPA;
+        dleaf_kpa = dleaf_kpa < 0.05 ? 0.05 : dleaf_kpa;
+        gs_over_a = (1.0 + (p->g1 * lb->wtfac_root[i]) / sqrt(dleaf_kpa)) / Cs;
+
+        /* Solution when Rubisco activity is limiting */
+        A = g0 + gs_over_a * (vcmax[i] - rd);
+        B = ( (1.0 - Cs * gs_over_a) * (vcmax[i] - rd) + g0 * (km[i] - Cs) -
+               gs_over_a * (vcmax[i] * gamma_star[i] + km[i] * rd) );
+        C = ( -(1.0 - Cs * gs_over_a) * (vcmax[i] * gamma_star[i] +
+               km[i] * rd) - g0 * km[i] * Cs );
+        d = (B * B) - 4.0 * A * C;
+        Ci = ((A == 0.0) & (B > 0.0)) ? -C / B :
+             (((A == 0.0) & (B == 0.0)) ? 0.0 : (-B + sqrt(d)) / (2.0 * A));
+
+        COUNT_EVENTS(COUNTER_QUAD_FAIL,
+                     (d < 0.0) | ((A == 0.0) & (B == 0.0) & (C != 0.0)));
+
+        /* no root (quad() flags an error) or out of range */
+        Ac = ((d < 0.0) | ((A == 0.0) & (B == 0.0) & (C != 0.0)) |
+              (Ci <= 0.0) | (Ci > Cs)) ? 0.0 :
+             vcmax[i] * (Ci - gamma_star[i]) / (Ci + km[i]);
+
+        /* Solution when electron transport rate is limiting */
+        A = g0 + gs_over_a * (Vj - rd);
+        B = ( (1. - Cs * gs_over_a) * (Vj - rd) + g0 *
+              (2. * gamma_star[i] - Cs) - gs_over_a *
+              (Vj * gamma_star[i] + 2.0 * gamma_star[i] * rd) );
+        C = ( -(1.0 - Cs * gs_over_a) * gamma_star[i] * (Vj + 2.0 * rd) -
+               g0 * 2.0 * gamma_star[i] * Cs );
+        d = (B * B) - 4.0 * A * C;
+        Ci = ((A == 0.0) & (B > 0.0)) ? -C / B :
+             (((A == 0.0) & (B == 0.0)) ? 0.0 : (-B + sqrt(d)) / (2.0 * A));
+        COUNT_EVENTS(COUNTER_QUAD_FAIL,
+                     (d < 0.0) | ((A == 0.0) & (B == 0.0) & (C != 0.0)));
+        Aj = Vj * (Ci - gamma_star[i]) / (Ci + 2.0 * gamma_star[i]);
+
+        /* Below light compensation point? */
+        Aj_cs = Vj * (Cs - gamma_star[i]) / (Cs + 2.0 * gamma_star[i]);
+        Aj = (Aj - rd < 1E-6) ? Aj_cs : Aj;
+        an = MIN(Ac, Aj) - rd;
+
+        /* Deal with extreme cases */
+        limited = (jmax[i] <= 0.0) | (vcmax[i] <= 0.0) | isnan(J);
+        lb->limited[i] = limited;
+        lb->rd[i] = rd;
+        lb->an[i] = limited ? -rd : an;
+        lb->gsc[i] = limited ? g0 : MAX(g0, g0 + gs_over_a * an);
+    }
+
+    return;
+}
+
+double calc_co2_compensation_point(control *c, params *p, double tleaf) {
     /*
         CO2 compensation point in the absence of non-photorespiratory
         respiration.
@@ -142,10 +322,11 @@ double calc_co2_compensation_point(params *p, double tleaf) {
         -----------
         * Bernacchi et al 2001 PCE 24: 253-260
     */
-    return (arrhenius(p->gamstar25, p->eag, tleaf, p->measurement_temp));
+    return (table_arrhenius(c->temp_resp, TT_GAMSTAR, p->gamstar25, p->eag,
+                            tleaf, p->measurement_temp));
 }
 
-double calculate_michaelis_menten(params *p, double tleaf) {
+double calculate_michaelis_menten(control *c, params *p, double tleaf) {
     /*
         Effective Michaelis-Menten coefficent of Rubisco activity
 
@@ -170,10 +351,12 @@ double calculate_michaelis_menten(params *p, double tleaf) {
     double Kc, Ko, Km;
 
     /* Michaelis-Menten coefficents for carboxylation by Rubisco */
-    Kc = arrhenius(p->kc25, p->eac, tleaf, p->measurement_temp);
+    Kc = table_arrhenius(c->temp_resp, TT_KC, p->kc25, p->eac, tleaf,
+                         p->measurement_temp);
 
     /* Michaelis-Menten coefficents for oxygenation by Rubisco */
-    Ko = arrhenius(p->ko25, p->eao, tleaf, p->measurement_temp);
+    Ko = table_arrhenius(c->temp_resp, TT_KO, p->ko25, p->eao, tleaf,
+                         p->measurement_temp);
 
     /* return effective Michaelis-Menten coefficient for CO2 */
     Km = Kc * (1.0 + p->oi / Ko);
@@ -199,54 +382,12 @@ void calculate_jmaxt_vcmaxt(control *c, canopy_wk *cw, params *p, state *s,
         vcmax : float
             the maximum Rubisco activity at the leaf temperature (umol m-2 s-1)
     */
-    double jmax25, vcmax25, lai_leaf;
     double lower_bound = 0.0;
     double upper_bound = 10.0;
-    double tref = p->measurement_temp;
-    double jmaxna = p->jmaxna;
-    double jmaxnb = p->jmaxnb;
-    double vcmaxna = p->vcmaxna;
-    double vcmaxnb = p->vcmaxnb;
-    double cscalar = cw->cscalar[cw->ileaf];
 
-    if (c->modeljm == 0) {
-        if (cw->ileaf == SUNLIT) {
-            *jmax = p->jmax * cscalar;
-            *vcmax = p->vcmax * cscalar;
-        } else {
-            *jmax = p->jmax * cscalar;
-            *vcmax = p->vcmax * cscalar;
-        }
-    } else if (c->modeljm == 1) {
-        if (cw->ileaf == SUNLIT) {
-            vcmax25 = (p->vcmaxna * cw->N0 + p->vcmaxnb) * cscalar;
-            jmax25 = (p->jmaxna * cw->N0 + p->jmaxnb) * cscalar;
-        } else {
-            vcmax25 = (p->vcmaxna * cw->N0 + p->vcmaxnb) * cscalar;
-            jmax25 = (p->jmaxna * cw->N0 + p->jmaxnb) * cscalar;
-        }
-        *vcmax = arrhenius(vcmax25, p->eav, tleaf, tref);
-        *jmax = peaked_arrhenius(jmax25, p->eaj, tleaf, tref, p->delsj, p->edj);
-    } else if (c->modeljm == 2) {
-        /* NB when using the fixed JV reln, we only apply scalar to Vcmax */
-        if (cw->ileaf == SUNLIT) {
-            vcmax25 = (p->vcmaxna * cw->N0 + p->vcmaxnb) * cscalar;
-            jmax25 = (p->jv_slope * vcmax25 - p->jv_intercept);
-        } else {
-            vcmax25 = (p->vcmaxna * cw->N0 + p->vcmaxnb) * cscalar;
-            jmax25 = (p->jv_slope * vcmax25 - p->jv_intercept);
-        }
-        *vcmax = arrhenius(vcmax25, p->eav, tleaf, tref);
-        *jmax = peaked_arrhenius(jmax25, p->eaj, tleaf, tref, p->delsj, p->edj);
-    } else if (c->modeljm == 3) {
-        jmax25 = p->jmax * cscalar;
-        vcmax25 = p->vcmax * cscalar;
-        *vcmax = arrhenius(vcmax25, p->eav, tleaf, tref);
-        *jmax = peaked_arrhenius(jmax25, p->eaj, tleaf, tref, p->delsj, p->edj);
-    } else {
-        fprintf(stderr, "You haven't set Jmax/Vcmax model: modeljm \n");
-        exit(EXIT_FAILURE);
-    }
+    /* modeljm, see model_options.c */
+    c->kernels->jmax_vcmax(c, p, cw->N0, cw->cscalar[cw->ileaf], tleaf, jmax,
+                           vcmax);
 
     /* reduce photosynthetic capacity with moisture stress */
     *jmax *= s->wtfac_root;
@@ -264,6 +405,64 @@ void calculate_jmaxt_vcmaxt(control *c, canopy_wk *cw, params *p, state *s,
     return;
 }
 
+void jmax_vcmax_fixed(control *c, params *p, double N0, double cscalar,
+                      double tleaf, double *jmax, double *vcmax) {
+    /* modeljm = 0, Jmax and Vcmax read in, no temperature dependence */
+
+    *jmax = p->jmax * cscalar;
+    *vcmax = p->vcmax * cscalar;
+
+    return;
+}
+
+void jmax_vcmax_leaf_n(control *c, params *p, double N0, double cscalar,
+                       double tleaf, double *jmax, double *vcmax) {
+    /* modeljm = 1, Jmax and Vcmax at 25 deg C from the leaf N content */
+    double jmax25, vcmax25, tref = p->measurement_temp;
+
+    vcmax25 = (p->vcmaxna * N0 + p->vcmaxnb) * cscalar;
+    jmax25 = (p->jmaxna * N0 + p->jmaxnb) * cscalar;
+    *vcmax = table_arrhenius(c->temp_resp, TT_VCMAX, vcmax25, p->eav, tleaf,
+                             tref);
+    *jmax = table_peaked_arrhenius(c->temp_resp, TT_JMAX, jmax25, p->eaj,
+                                   tleaf, tref, p->delsj, p->edj);
+
+    return;
+}
+
+void jmax_vcmax_jv_ratio(control *c, params *p, double N0, double cscalar,
+                         double tleaf, double *jmax, double *vcmax) {
+    /*
+        modeljm = 2, Vcmax at 25 deg C from the leaf N content and Jmax from
+        Vcmax. NB when using the fixed JV reln, we only apply scalar to Vcmax
+    */
+    double jmax25, vcmax25, tref = p->measurement_temp;
+
+    vcmax25 = (p->vcmaxna * N0 + p->vcmaxnb) * cscalar;
+    jmax25 = (p->jv_slope * vcmax25 - p->jv_intercept);
+    *vcmax = table_arrhenius(c->temp_resp, TT_VCMAX, vcmax25, p->eav, tleaf,
+                             tref);
+    *jmax = table_peaked_arrhenius(c->temp_resp, TT_JMAX, jmax25, p->eaj,
+                                   tleaf, tref, p->delsj, p->edj);
+
+    return;
+}
+
+void jmax_vcmax_temp(control *c, params *p, double N0, double cscalar,
+                     double tleaf, double *jmax, double *vcmax) {
+    /* modeljm = 3, Jmax and Vcmax at 25 deg C read in */
+    double jmax25, vcmax25, tref = p->measurement_temp;
+
+    jmax25 = p->jmax * cscalar;
+    vcmax25 = p->vcmax * cscalar;
+    *vcmax = table_arrhenius(c->temp_resp, TT_VCMAX, vcmax25, p->eav, tleaf,
+                             tref);
+    *jmax = table_peaked_arrhenius(c->temp_resp, TT_JMAX, jmax25, p->eaj,
+                                   tleaf, tref, p->delsj, p->edj);
+
+    return;
+}
+
 double calc_leaf_day_respiration(double tleaf, double Rd0) {
     /* Calculate leaf respiration in the light using a Q10 (exponential)
     formulation
@@ -411,6 +610,7 @@ double quad(double a, double b, double c, bool large, int *error) {
         /*fprintf(stderr, "imaginary root found\n");
         exit(EXIT_FAILURE);*/
         *error = TRUE;
+        COUNT_EVENTS(COUNTER_QUAD_FAIL, 1);
     }
 
     if (large) {
@@ -422,6 +622,7 @@ double quad(double a, double b, double c, bool large, int *error) {
                 /*fprintf(stderr, "Can't solve quadratic\n");
                 exit(EXIT_FAILURE);*/
                 *error = TRUE;
+                COUNT_EVENTS(COUNTER_QUAD_FAIL, 1);
             }
         } else {
             root = (-b + sqrt(d)) / (2.0 * a);
@@ -436,6 +637,7 @@ double quad(double a, double b, double c, bool large, int *error) {
                 /*fprintf(stderr, "Can't solve quadratic\n");
                 exit(EXIT_FAILURE);*/
                 *error = TRUE;
+                COUNT_EVENTS(COUNTER_QUAD_FAIL, 1);
             }
         } else {
             root = (-b - sqrt(d)) / (2.0 * a);
@@ -484,11 +686,11 @@ void mate_C3_photosynthesis(control *c, fluxes *f, met *m, params *p, state *s,
     /* Calculate mate params & account for temperature dependencies */
     N0 = calculate_top_of_canopy_n(p, s, ncontent);
 
-    gamma_star_am = calculate_co2_compensation_point(p, m->Tk_am, mt);
-    gamma_star_pm = calculate_co2_compensation_point(p, m->Tk_pm, mt);
+    gamma_star_am = calculate_co2_compensation_point(c, p, m->Tk_am, mt);
+    gamma_star_pm = calculate_co2_compensation_point(c, p, m->Tk_pm, mt);
 
-    Km_am = calculate_michaelis_menten_parameter(p, m->Tk_am, mt);
-    Km_pm = calculate_michaelis_menten_parameter(p, m->Tk_pm, mt);
+    Km_am = calculate_michaelis_menten_parameter(c, p, m->Tk_am, mt);
+    Km_pm = calculate_michaelis_menten_parameter(c, p, m->Tk_pm, mt);
 
     calculate_jmax_and_vcmax(c, p, s, m->Tk_am, N0, &jmax_am, &vcmax_am, mt);
     calculate_jmax_and_vcmax(c, p, s, m->Tk_pm, N0, &jmax_pm, &vcmax_pm, mt);
@@ -570,7 +772,8 @@ double calculate_top_of_canopy_n(params *p, state *s, double ncontent)  {
     return (N0);
 }
 
-double calculate_co2_compensation_point(params *p, double Tk, double mt) {
+double calculate_co2_compensation_point(control *c, params *p, double Tk,
+                                        double mt) {
     /*
         CO2 compensation point in the absence of mitochondrial respiration
         Rate of photosynthesis matches the rate of respiration and the net CO2
@@ -586,7 +789,8 @@ double calculate_co2_compensation_point(params *p, double Tk, double mt) {
         gamma_star : float
             CO2 compensation point in the abscence of mitochondrial respiration
     */
-    return (arrh(mt, p->gamstar25, p->eag, Tk));
+    return (table_arrh(c->temp_resp, TT_GAMSTAR, mt, p->gamstar25, p->eag,
+                       Tk));
 }
 
 double arrh(double mt, double k25, double Ea, double Tk) {
@@ -655,7 +859,8 @@ double peaked_arrh(double mt, double k25, double Ea, double Tk, double deltaS,
     return (arg1 * arg2 / arg3);
 }
 
-double calculate_michaelis_menten_parameter(params *p, double Tk, double mt) {
+double calculate_michaelis_menten_parameter(control *c, params *p, double Tk,
+                                            double mt) {
     /*
         Effective Michaelis-Menten coefficent of Rubisco activity
 
@@ -680,10 +885,10 @@ double calculate_michaelis_menten_parameter(params *p, double Tk, double mt) {
     double Kc, Ko;
 
     /* Michaelis-Menten coefficents for carboxylation by Rubisco */
-    Kc = arrh(mt, p->kc25, p->eac, Tk);
+    Kc = table_arrh(c->temp_resp, TT_KC, mt, p->kc25, p->eac, Tk);
 
     /* Michaelis-Menten coefficents for oxygenation by Rubisco */
-    Ko = arrh(mt, p->ko25, p->eao, Tk);
+    Ko = table_arrh(c->temp_resp, TT_KO, mt, p->ko25, p->eao, Tk);
 
     /* return effective Michaelis-Menten coefficient for CO2 */
     return ( Kc * (1.0 + p->oi / Ko) ) ;
@@ -711,56 +916,82 @@ void calculate_jmax_and_vcmax(control *c, params *p, state *s, double Tk,
         vcmax : float (umol/m2/sec)
             the maximum rate of electron transport at 25 degC
     */
-    double jmax25, vcmax25;
 
-    *vcmax = 0.0;
-    *jmax = 0.0;
+    /* modeljm, see model_options.c */
+    c->kernels->mate_jmax_vcmax(c, p, Tk, N0, mt, jmax, vcmax);
 
-    if (c->modeljm == 0) {
-        *jmax = p->jmax;
-        *vcmax = p->vcmax;
-    } else if (c->modeljm == 1) {
-        /* the maximum rate of electron transport at 25 degC */
-        jmax25 = p->jmaxna * N0 + p->jmaxnb;
+    /* reduce photosynthetic capacity with moisture stress */
+    *jmax *= s->wtfac_root;
+    *vcmax *= s->wtfac_root;
+    /*  Function allowing Jmax/Vcmax to be forced linearly to zero at low T */
+    adj_for_low_temp(*(&jmax), Tk);
+    adj_for_low_temp(*(&vcmax), Tk);
 
-        /* this response is well-behaved for TLEAF < 0.0 */
-        *jmax = peaked_arrh(mt, jmax25, p->eaj, Tk,
-                            p->delsj, p->edj);
+    return;
 
-        /* the maximum rate of electron transport at 25 degC */
-        vcmax25 = p->vcmaxna * N0 + p->vcmaxnb;
-        *vcmax = arrh(mt, vcmax25, p->eav, Tk);
-    } else if (c->modeljm == 2) {
-        vcmax25 = p->vcmaxna * N0 + p->vcmaxnb;
-        *vcmax = arrh(mt, vcmax25, p->eav, Tk);
+}
 
-        jmax25 = p->jv_slope * vcmax25 - p->jv_intercept;
-        *jmax = peaked_arrh(mt, jmax25, p->eaj, Tk, p->delsj,
-                               p->edj);
-    } else if (c->modeljm == 3) {
-        /* the maximum rate of electron transport at 25 degC */
-        jmax25 = p->jmax;
+void mate_jmax_vcmax_fixed(control *c, params *p, double Tk, double N0,
+                           double mt, double *jmax, double *vcmax) {
+    /* modeljm = 0, Jmax and Vcmax read in */
 
-        /* this response is well-behaved for TLEAF < 0.0 */
-        *jmax = peaked_arrh(mt, jmax25, p->eaj, Tk,
-                            p->delsj, p->edj);
+    *jmax = p->jmax;
+    *vcmax = p->vcmax;
 
-        /* the maximum rate of electron transport at 25 degC */
-        vcmax25 = p->vcmax;
-        *vcmax = arrh(mt, vcmax25, p->eav, Tk);
+    return;
+}
 
-    }
+void mate_jmax_vcmax_leaf_n(control *c, params *p, double Tk, double N0,
+                            double mt, double *jmax, double *vcmax) {
+    /* modeljm = 1, Jmax and Vcmax at 25 deg C from the leaf N content */
+    double jmax25, vcmax25;
 
+    /* the maximum rate of electron transport at 25 degC */
+    jmax25 = p->jmaxna * N0 + p->jmaxnb;
 
-    /* reduce photosynthetic capacity with moisture stress */
-    *jmax *= s->wtfac_root;
-    *vcmax *= s->wtfac_root;
-    /*  Function allowing Jmax/Vcmax to be forced linearly to zero at low T */
-    adj_for_low_temp(*(&jmax), Tk);
-    adj_for_low_temp(*(&vcmax), Tk);
+    /* this response is well-behaved for TLEAF < 0.0 */
+    *jmax = table_peaked_arrh(c->temp_resp, TT_JMAX, mt, jmax25, p->eaj, Tk,
+                              p->delsj, p->edj);
+
+    /* the maximum rate of electron transport at 25 degC */
+    vcmax25 = p->vcmaxna * N0 + p->vcmaxnb;
+    *vcmax = table_arrh(c->temp_resp, TT_VCMAX, mt, vcmax25, p->eav, Tk);
+
+    return;
+}
+
+void mate_jmax_vcmax_jv_ratio(control *c, params *p, double Tk, double N0,
+                              double mt, double *jmax, double *vcmax) {
+    /* modeljm = 2, Vcmax from the leaf N content and Jmax from Vcmax */
+    double jmax25, vcmax25;
+
+    vcmax25 = p->vcmaxna * N0 + p->vcmaxnb;
+    *vcmax = table_arrh(c->temp_resp, TT_VCMAX, mt, vcmax25, p->eav, Tk);
+
+    jmax25 = p->jv_slope * vcmax25 - p->jv_intercept;
+    *jmax = table_peaked_arrh(c->temp_resp, TT_JMAX, mt, jmax25, p->eaj, Tk,
+                              p->delsj, p->edj);
 
     return;
+}
+
+void mate_jmax_vcmax_temp(control *c, params *p, double Tk, double N0,
+                          double mt, double *jmax, double *vcmax) {
+    /* modeljm = 3, Jmax and Vcmax at 25 deg C read in */
+    double jmax25, vcmax25;
 
+    /* the maximum rate of electron transport at 25 degC */
+    jmax25 = p->jmax;
+
+    /* this response is well-behaved for TLEAF < 0.0 */
+    *jmax = table_peaked_arrh(c->temp_resp, TT_JMAX, mt, jmax25, p->eaj, Tk,
+                              p->delsj, p->edj);
+
+    /* the maximum rate of electron transport at 25 degC */
+    vcmax25 = p->vcmax;
+    *vcmax = table_arrh(c->temp_resp, TT_VCMAX, mt, vcmax25, p->eav, Tk);
+
+    return;
 }
 
 void adj_for_low_temp(double *param, double Tk) {
@@ -812,13 +1043,10 @@ double calculate_ci(control *c, params *p, state *s, double vpd, double Ca) {
 
     double g1w, cica, ci=0.0;
 
-    if (c->gs_model == MEDLYN) {
-        g1w = p->g1 * s->wtfac_root;
-        cica = g1w / (g1w + sqrt(vpd * PA_2_KPA));
-        ci = cica * Ca;
-    } else {
-        prog_error("Only Belindas gs model is implemented", __LINE__);
-    }
+    /* Medlyn gs is the only gs_model, see resolve_model_options */
+    g1w = p->g1 * s->wtfac_root;
+    cica = g1w / (g1w + sqrt(vpd * PA_2_KPA));
+    ci = cica * Ca;
 
     return (ci);
 }
@@ -17,6 +17,7 @@
 * =========================================================================== */
 #include "plant_growth.h"
 #include "water_balance.h"
+#include "timing.h"
 
 
 
@@ -35,10 +36,14 @@ void calc_day_growth(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma,
 
     if (c->sub_daily) {
         /* calculate 30 min two-leaf GPP/NPP, respiration and water fluxes */
+        TIMER_START(TIMER_CANOPY);
         canopy(cw, c, f, ma, m, p, s);
+        TIMER_STOP(TIMER_CANOPY);
     } else {
         /* calculate daily GPP/NPP, respiration and update water balance */
+        TIMER_START(TIMER_CANOPY);
         carbon_daily_production(c, f, m, p, s, day_length);
+        TIMER_STOP(TIMER_CANOPY);
         calculate_water_balance(c, f, m, p, s, day_length, dummy, dummy, dummy);
     }
 
@@ -197,32 +202,12 @@ void carbon_daily_production(control *c, fluxes *f, met *m, params *p, state *s,
         s->wtfac_topsoil = 1.0;
         s->wtfac_root = 1.0;
     }
-    /* Estimate photosynthesis */
-    if (c->assim_model == BEWDY){
-        exit(EXIT_FAILURE);
-    } else if (c->assim_model == MATE) {
-        if (c->ps_pathway == C3) {
-            mate_C3_photosynthesis(c, f, m, p, s, daylen, ncontent);
-        } else {
-            mate_C4_photosynthesis(c, f, m, p, s, daylen, ncontent);
-        }
-    } else {
-        fprintf(stderr,"Unknown photosynthesis model'");
-        exit(EXIT_FAILURE);
-    }
+    /* Estimate photosynthesis, MATE C3 or C4 (assim_model, ps_pathway) */
+    c->kernels->mate_photosynthesis(c, f, m, p, s, daylen, ncontent);
 
-
-    /* Calculate plant respiration */
-    if (c->respiration_model == FIXED) {
-        /* Plant respiration assuming carbon-use efficiency. */
-        f->auto_resp = f->gpp * p->cue;
-    } else if(c->respiration_model == TEMPERATURE) {
-        fprintf(stderr, "Not implemented yet");
-        exit(EXIT_FAILURE);
-    } else if (c->respiration_model == BIOMASS) {
-        fprintf(stderr, "Not implemented yet");
-        exit(EXIT_FAILURE);
-    }
+    /* Plant respiration assuming carbon-use efficiency, the only
+       respiration_model implemented (see resolve_model_options) */
+    f->auto_resp = f->gpp * p->cue;
 
     /* Calculate NPP */
     f->npp_gCm2 = f->gpp_gCm2 * p->cue;
@@ -341,9 +326,16 @@ int nitrogen_allocation(control *c, fluxes *f, params *p, state *s,
         rtot = s->root * TONNES_HA_2_KG_M2 / p->cfracts;
         /*f->nuptake_old = f->nuptake; */
 
-        calc_opt_root_depth(p->d0x, p->r0, p->topsoil_depth * MM_TO_M,
-                            rtot, nsupply, depth_guess, &s->root_depth,
-                            &f->nuptake, &f->rabove);
+        /* warm start from yesterday's depth, there isn't one on day 1 */
+        if (s->root_depth > 0.0)
+            depth_guess = s->root_depth;
+        if (calc_opt_root_depth(p->d0x, p->r0, p->topsoil_depth * MM_TO_M,
+                                rtot, nsupply, depth_guess, &s->root_depth,
+                                &f->nuptake, &f->rabove) == FALSE) {
+            /* keep the run going on the depth we had */
+            fprintf(stderr, "Warning: optimal root depth not found for root "
+                    "C %g kg DM m-2, keeping %g m\n", rtot, s->root_depth);
+        }
 
         /*umax = self.rm.calc_umax(f->nuptake) */
 
@@ -534,208 +526,228 @@ void calc_carbon_allocation_fracs(control *c, fluxes *f, params *p, state *s,
     Corbeels, M. et al (2005) Ecological Modelling, 187, 449-474.
     McMurtrie, R. E. et al (2000) Plant and Soil, 224, 135-152.
     */
-    double min_leaf_alloc, adj, arg1, arg2, arg3, arg4, leaf2sa_target,
-           sap_cross_sec_area, lr_max, stress, mis_match, orig_af, orig_ar,
-           reduction, target_branch, coarse_root_target, left_over,
-           total_alloc, leaf2sap, spare;
+    double total_alloc;
 
-    /* this is obviously arbitary */
-    double min_stem_alloc = 0.01;
+    /* alloc_model, see model_options.c */
+    c->kernels->alloc_fracs(c, f, p, s, nitfac);
 
-    if (c->alloc_model == FIXED){
-        f->alleaf = (p->c_alloc_fmax + nitfac *
-                     (p->c_alloc_fmax - p->c_alloc_fmin));
+    /*printf("%f %f %f %f %f\n", f->alleaf, f->albranch + f->alstem, f->alroot,  f->alcroot, s->canht);*/
 
-        f->alroot = (p->c_alloc_rmax + nitfac *
-                     (p->c_alloc_rmax - p->c_alloc_rmin));
+    /* Total allocation should be one, if not print warning */
+    total_alloc = f->alroot + f->alleaf + f->albranch + f->alstem + f->alcroot;
+    if (total_alloc > 1.0+EPSILON) {
+        fprintf(stderr, "Allocation fracs > 1: %.13f\n", total_alloc);
+        exit(EXIT_FAILURE);
+    }
 
-        f->albranch = (p->c_alloc_bmax + nitfac *
-                       (p->c_alloc_bmax - p->c_alloc_bmin));
+    return;
+}
 
-        /* allocate remainder to stem */
-        f->alstem = 1.0 - f->alleaf - f->alroot - f->albranch;
+void alloc_fracs_fixed(control *c, fluxes *f, params *p, state *s,
+                       double nitfac) {
+    /* Fixed allocation fractions, scaled by the leaf N:C (alloc_model) */
 
-        f->alcroot = p->c_alloc_cmax * f->alstem;
-        f->alstem -= f->alcroot;
+    f->alleaf = (p->c_alloc_fmax + nitfac *
+                 (p->c_alloc_fmax - p->c_alloc_fmin));
 
-    } else if (c->alloc_model == GRASSES) {
+    f->alroot = (p->c_alloc_rmax + nitfac *
+                 (p->c_alloc_rmax - p->c_alloc_rmin));
 
-        /* First figure out root allocation given available water & nutrients
-           hyperbola shape to allocation */
-        f->alroot = (p->c_alloc_rmax * p->c_alloc_rmin /
-                     (p->c_alloc_rmin + (p->c_alloc_rmax - p->c_alloc_rmin) *
-                      s->prev_sma));
-        f->alleaf = 1.0 - f->alroot;
+    f->albranch = (p->c_alloc_bmax + nitfac *
+                   (p->c_alloc_bmax - p->c_alloc_bmin));
 
-        /* Now adjust root & leaf allocation to maintain balance, accounting
-           for stress e.g. -> Sitch et al. 2003, GCB. */
+    /* allocate remainder to stem */
+    f->alstem = 1.0 - f->alleaf - f->alroot - f->albranch;
 
-        /* leaf-to-root ratio under non-stressed conditons */
-        lr_max = 0.8,
+    f->alcroot = p->c_alloc_cmax * f->alstem;
+    f->alstem -= f->alcroot;
 
-        /* Calculate adjustment on lr_max, based on current "stress"
-           calculated from running mean of N and water stress */
-        stress = lr_max * s->prev_sma;
+    return;
+}
 
-        /* calculate new allocation fractions based on imbalance in *biomass* */
-        mis_match = s->shoot / (s->root * stress);
+void alloc_fracs_grasses(control *c, fluxes *f, params *p, state *s,
+                         double nitfac) {
+    /* Root:shoot functional balance for grasses, no woody allocation */
+    double adj, lr_max, stress, mis_match;
 
+    /* First figure out root allocation given available water & nutrients
+       hyperbola shape to allocation */
+    f->alroot = (p->c_alloc_rmax * p->c_alloc_rmin /
+                 (p->c_alloc_rmin + (p->c_alloc_rmax - p->c_alloc_rmin) *
+                  s->prev_sma));
+    f->alleaf = 1.0 - f->alroot;
 
-        if (mis_match > 1.0) {
-            /* reduce leaf allocation fraction */
-            adj = f->alleaf / mis_match;
-            f->alleaf = MAX(p->c_alloc_fmin, MIN(p->c_alloc_fmax, adj));
-            f->alroot = 1.0 - f->alleaf;
-        } else {
-            /* reduce root allocation */
-            adj = f->alroot * mis_match;
-            f->alroot = MAX(p->c_alloc_rmin, MIN(p->c_alloc_rmax, adj));
-            f->alleaf = 1.0 - f->alroot;
-        }
-        f->alstem = 0.0;
-        f->albranch = 0.0;
-        f->alcroot = 0.0;
-
-    } else if (c->alloc_model == ALLOMETRIC) {
-
-        /* Calculate tree height: allometric reln using the power function
-           (Causton, 1985) */
-        s->canht = p->heighto * pow(s->stem, p->htpower);
-
-        /* LAI to stem sapwood cross-sectional area (As m-2 m-2)
-           (dimensionless)
-           Assume it varies between LS0 and LS1 as a linear function of tree
-           height (m) */
-        arg1 = s->sapwood * TONNES_AS_KG * M2_AS_HA;
-        arg2 = s->canht * p->density * p->cfracts;
-        sap_cross_sec_area = arg1 / arg2;
-        leaf2sap = s->lai / sap_cross_sec_area;
-
-        /* Allocation to leaves dependant on height. Modification of pipe
-           theory, leaf-to-sapwood ratio is not constant above a certain
-           height, due to hydraulic constraints (Magnani et al 2000; Deckmyn
-           et al. 2006). */
-
-        if (s->canht < p->height0) {
-            leaf2sa_target = p->leafsap0;
-        } else if (float_eq(s->canht, p->height1)) {
-            leaf2sa_target = p->leafsap1;
-        } else if (s->canht > p->height1) {
-            leaf2sa_target = p->leafsap1;
-        } else {
-            arg1 = p->leafsap0;
-            arg2 = p->leafsap1 - p->leafsap0;
-            arg3 = s->canht - p->height0;
-            arg4 = p->height1 - p->height0;
-            leaf2sa_target = arg1 + (arg2 * arg3 / arg4);
-        }
-        f->alleaf = alloc_goal_seek(leaf2sap, leaf2sa_target, p->c_alloc_fmax,
-                                    p->targ_sens);
+    /* Now adjust root & leaf allocation to maintain balance, accounting
+       for stress e.g. -> Sitch et al. 2003, GCB. */
 
-        /* Allocation to branch dependent on relationship between the stem
-           and branch */
-        target_branch = p->branch0 * pow(s->stem, p->branch1);
-        f->albranch = alloc_goal_seek(s->branch, target_branch, p->c_alloc_bmax,
-                                      p->targ_sens);
+    /* leaf-to-root ratio under non-stressed conditons */
+    lr_max = 0.8,
 
-        coarse_root_target = p->croot0 * pow(s->stem, p->croot1);
-        f->alcroot = alloc_goal_seek(s->croot, coarse_root_target,
-                                      p->c_alloc_cmax, p->targ_sens);
+    /* Calculate adjustment on lr_max, based on current "stress"
+       calculated from running mean of N and water stress */
+    stress = lr_max * s->prev_sma;
 
+    /* calculate new allocation fractions based on imbalance in *biomass* */
+    mis_match = s->shoot / (s->root * stress);
 
 
-        /* figure out root allocation given available water & nutrients
-           hyperbola shape to allocation, this is adjusted below as we aim
-           to maintain a functional balance */
+    if (mis_match > 1.0) {
+        /* reduce leaf allocation fraction */
+        adj = f->alleaf / mis_match;
+        f->alleaf = MAX(p->c_alloc_fmin, MIN(p->c_alloc_fmax, adj));
+        f->alroot = 1.0 - f->alleaf;
+    } else {
+        /* reduce root allocation */
+        adj = f->alroot * mis_match;
+        f->alroot = MAX(p->c_alloc_rmin, MIN(p->c_alloc_rmax, adj));
+        f->alleaf = 1.0 - f->alroot;
+    }
+    f->alstem = 0.0;
+    f->albranch = 0.0;
+    f->alcroot = 0.0;
 
-        f->alroot = (p->c_alloc_rmax * p->c_alloc_rmin /
-                     (p->c_alloc_rmin + (p->c_alloc_rmax - p->c_alloc_rmin) *
-                      s->prev_sma));
+    return;
+}
 
-        /* Now adjust root & leaf allocation to maintain balance, accounting
-           for stress e.g. -> Sitch et al. 2003, GCB. */
+void alloc_fracs_allometric(control *c, fluxes *f, params *p, state *s,
+                            double nitfac) {
+    /*
+        Allocation following the allometric relations for height, branches
+        and coarse roots, with the root:shoot functional balance
+    */
+    double min_leaf_alloc, adj, arg1, arg2, arg3, arg4, leaf2sa_target,
+           sap_cross_sec_area, lr_max, stress, mis_match, orig_ar,
+           reduction, target_branch, coarse_root_target, left_over,
+           leaf2sap, spare;
 
-        /* leaf-to-root ratio under non-stressed conditons */
-        lr_max = 1.0;
+    /* this is obviously arbitary */
+    double min_stem_alloc = 0.01;
 
-        /* Calculate adjustment on lr_max, based on current "stress"
-           calculated from running mean of N and water stress */
-        stress = lr_max * s->prev_sma;
+    /* Calculate tree height: allometric reln using the power function
+       (Causton, 1985) */
+    s->canht = p->heighto * pow(s->stem, p->htpower);
+
+    /* LAI to stem sapwood cross-sectional area (As m-2 m-2)
+       (dimensionless)
+       Assume it varies between LS0 and LS1 as a linear function of tree
+       height (m) */
+    arg1 = s->sapwood * TONNES_AS_KG * M2_AS_HA;
+    arg2 = s->canht * p->density * p->cfracts;
+    sap_cross_sec_area = arg1 / arg2;
+    leaf2sap = s->lai / sap_cross_sec_area;
+
+    /* Allocation to leaves dependant on height. Modification of pipe
+       theory, leaf-to-sapwood ratio is not constant above a certain
+       height, due to hydraulic constraints (Magnani et al 2000; Deckmyn
+       et al. 2006). */
+
+    if (s->canht < p->height0) {
+        leaf2sa_target = p->leafsap0;
+    } else if (float_eq(s->canht, p->height1)) {
+        leaf2sa_target = p->leafsap1;
+    } else if (s->canht > p->height1) {
+        leaf2sa_target = p->leafsap1;
+    } else {
+        arg1 = p->leafsap0;
+        arg2 = p->leafsap1 - p->leafsap0;
+        arg3 = s->canht - p->height0;
+        arg4 = p->height1 - p->height0;
+        leaf2sa_target = arg1 + (arg2 * arg3 / arg4);
+    }
+    f->alleaf = alloc_goal_seek(leaf2sap, leaf2sa_target, p->c_alloc_fmax,
+                                p->targ_sens);
 
-        /* calculate imbalance, based on *biomass* */
-        if (c->deciduous_model) {
-            mis_match = s->shoot / (s->root * stress);
-        } else {
-            /* Catch for floating point reset of root C mass */
-            if (float_eq(s->root, 0.0))
-                mis_match = 1.9;
-            else
-                mis_match = s->shoot / (s->root * stress);
-        }
+    /* Allocation to branch dependent on relationship between the stem
+       and branch */
+    target_branch = p->branch0 * pow(s->stem, p->branch1);
+    f->albranch = alloc_goal_seek(s->branch, target_branch, p->c_alloc_bmax,
+                                  p->targ_sens);
 
+    coarse_root_target = p->croot0 * pow(s->stem, p->croot1);
+    f->alcroot = alloc_goal_seek(s->croot, coarse_root_target,
+                                  p->c_alloc_cmax, p->targ_sens);
 
-        if (mis_match > 1.0) {
-            /* Root=Leaf biomass in out of balance, borrow from the stem to try
-               and alleviate this difference and move towards a functional
-               balance. */
-            spare = 1.0 - f->alleaf - f->albranch - f->alcroot - min_stem_alloc;
-            adj = f->alroot * mis_match;
-            f->alroot += MAX(p->c_alloc_rmin, MIN(spare, adj));
-            f->alroot = MIN(p->c_alloc_rmax, f->alroot);
-
-        } else if (mis_match < 1.0) {
-            /* Root=Leaf biomass in out of balance, borrow from the root to try
-               and alleviate this difference and move towards a functional
-               balance */
-            /* reduce root allocation */
-            orig_ar = f->alroot;
-            adj = f->alroot * mis_match;
-            f->alroot = MAX(p->c_alloc_rmin, MIN(p->c_alloc_rmax, adj));
-            reduction = MAX(0.0, orig_ar - f->alroot);
-            f->alleaf += MAX(p->c_alloc_fmax, reduction);
-        }
 
 
-        /* Ensure we don't end up with alloc fractions that make no
-           physical sense. */
-        left_over = 1.0 - f->alroot - f->alleaf;
-        if (f->albranch + f->alcroot > left_over) {
-            if (float_eq(s->croot, 0.0)) {
-                f->alcroot = 0.0;
-                f->alstem = 0.5 * left_over;
-                f->albranch = 0.5 * left_over;
-            } else {
-                f->alcroot = 0.3 * left_over;
-                f->alstem = 0.4 * left_over;
-                f->albranch = 0.3 * left_over;
-            }
-        }
-        f->alstem = 1.0 - f->alroot - f->albranch - f->alleaf - f->alcroot;
-
-        /* minimum allocation to leaves - without it tree would die, as this
-           is done annually. */
-        if (c->deciduous_model) {
-            if (f->alleaf < 0.05) {
-                min_leaf_alloc = 0.05;
-                if (f->alstem > min_leaf_alloc)
-                    f->alstem -= min_leaf_alloc;
-                else
-                    f->alroot -= min_leaf_alloc;
-                f->alleaf = min_leaf_alloc;
-            }
-        }
+    /* figure out root allocation given available water & nutrients
+       hyperbola shape to allocation, this is adjusted below as we aim
+       to maintain a functional balance */
+
+    f->alroot = (p->c_alloc_rmax * p->c_alloc_rmin /
+                 (p->c_alloc_rmin + (p->c_alloc_rmax - p->c_alloc_rmin) *
+                  s->prev_sma));
+
+    /* Now adjust root & leaf allocation to maintain balance, accounting
+       for stress e.g. -> Sitch et al. 2003, GCB. */
+
+    /* leaf-to-root ratio under non-stressed conditons */
+    lr_max = 1.0;
+
+    /* Calculate adjustment on lr_max, based on current "stress"
+       calculated from running mean of N and water stress */
+    stress = lr_max * s->prev_sma;
+
+    /* calculate imbalance, based on *biomass* */
+    if (c->deciduous_model) {
+        mis_match = s->shoot / (s->root * stress);
     } else {
-        fprintf(stderr, "Unknown C allocation model: %d\n", c->alloc_model);
-        exit(EXIT_FAILURE);
+        /* Catch for floating point reset of root C mass */
+        if (float_eq(s->root, 0.0))
+            mis_match = 1.9;
+        else
+            mis_match = s->shoot / (s->root * stress);
     }
 
-    /*printf("%f %f %f %f %f\n", f->alleaf, f->albranch + f->alstem, f->alroot,  f->alcroot, s->canht);*/
 
-    /* Total allocation should be one, if not print warning */
-    total_alloc = f->alroot + f->alleaf + f->albranch + f->alstem + f->alcroot;
-    if (total_alloc > 1.0+EPSILON) {
-        fprintf(stderr, "Allocation fracs > 1: %.13f\n", total_alloc);
-        exit(EXIT_FAILURE);
+    if (mis_match > 1.0) {
+        /* Root=Leaf biomass in out of balance, borrow from the stem to try
+           and alleviate this difference and move towards a functional
+           balance. */
+        spare = 1.0 - f->alleaf - f->albranch - f->alcroot - min_stem_alloc;
+        adj = f->alroot * mis_match;
+        f->alroot += MAX(p->c_alloc_rmin, MIN(spare, adj));
+        f->alroot = MIN(p->c_alloc_rmax, f->alroot);
+
+    } else if (mis_match < 1.0) {
+        /* Root=Leaf biomass in out of balance, borrow from the root to try
+           and alleviate this difference and move towards a functional
+           balance */
+        /* reduce root allocation */
+        orig_ar = f->alroot;
+        adj = f->alroot * mis_match;
+        f->alroot = MAX(p->c_alloc_rmin, MIN(p->c_alloc_rmax, adj));
+        reduction = MAX(0.0, orig_ar - f->alroot);
+        f->alleaf += MAX(p->c_alloc_fmax, reduction);
+    }
+
+
+    /* Ensure we don't end up with alloc fractions that make no
+       physical sense. */
+    left_over = 1.0 - f->alroot - f->alleaf;
+    if (f->albranch + f->alcroot > left_over) {
+        if (float_eq(s->croot, 0.0)) {
+            f->alcroot = 0.0;
+            f->alstem = 0.5 * left_over;
+            f->albranch = 0.5 * left_over;
+        } else {
+            f->alcroot = 0.3 * left_over;
+            f->alstem = 0.4 * left_over;
+            f->albranch = 0.3 * left_over;
+        }
+    }
+    f->alstem = 1.0 - f->alroot - f->albranch - f->alleaf - f->alcroot;
+
+    /* minimum allocation to leaves - without it tree would die, as this
+       is done annually. */
+    if (c->deciduous_model) {
+        if (f->alleaf < 0.05) {
+            min_leaf_alloc = 0.05;
+            if (f->alstem > min_leaf_alloc)
+                f->alstem -= min_leaf_alloc;
+            else
+                f->alroot -= min_leaf_alloc;
+            f->alleaf = min_leaf_alloc;
+        }
     }
 
     return;
@@ -1153,33 +1165,40 @@ double calculate_nuptake(control *c, params *p, state *s) {
     * Raich et al. 1991, Ecological Applications, 1, 399-429.
 
     */
-    double nuptake, U0, Kr;
-
-    if (c->nuptake_model == 0) {
-        /* Constant N uptake */
-        nuptake = p->nuptakez;
-    } else if (c->nuptake_model == 1) {
-        /* evaluate nuptake : proportional to dynamic inorganic N pool */
-        nuptake = p->rateuptake * s->inorgn;
-    } else if (c->nuptake_model == 2) {
-        /* N uptake is a saturating function on root biomass following
-           Dewar and McMurtrie, 1996. */
-
-        /* supply rate of available mineral N */
-        U0 = p->rateuptake * s->inorgn;
-        Kr = p->kr;
-        nuptake = MAX(U0 * s->root / (s->root + Kr), 0.0);
-
-        /* Make minimum uptake rate supply rate for deciduous_model cases
-           otherwise it is possible when growing from scratch we don't have
-           enough root mass to obtain N at the annual time step
-           I don't see an obvious better solution?
-        if c->deciduous_model:
-            nuptake = max(U0 * s->root / (s->root + Kr), U0) */
-    } else {
-        fprintf(stderr, "Unknown N uptake option\n");
-        exit(EXIT_FAILURE);
-    }
 
-    return (nuptake);
+    /* nuptake_model, see model_options.c */
+    return (c->kernels->nuptake(p, s));
+}
+
+double nuptake_constant(params *p, state *s) {
+    /* nuptake_model = 0, constant N uptake */
+
+    return (p->nuptakez);
+}
+
+double nuptake_inorgn(params *p, state *s) {
+    /* nuptake_model = 1, proportional to dynamic inorganic N pool */
+
+    return (p->rateuptake * s->inorgn);
+}
+
+double nuptake_root_saturating(params *p, state *s) {
+    /*
+        nuptake_model = 2, N uptake is a saturating function on root biomass
+        following Dewar and McMurtrie, 1996.
+    */
+    double U0, Kr;
+
+    /* supply rate of available mineral N */
+    U0 = p->rateuptake * s->inorgn;
+    Kr = p->kr;
+
+    /* Make minimum uptake rate supply rate for deciduous_model cases
+       otherwise it is possible when growing from scratch we don't have
+       enough root mass to obtain N at the annual time step
+       I don't see an obvious better solution?
+    if c->deciduous_model:
+        nuptake = max(U0 * s->root / (s->root + Kr), U0) */
+
+    return (MAX(U0 * s->root / (s->root + Kr), 0.0));
 }
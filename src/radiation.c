@@ -42,8 +42,8 @@ void spitters(canopy_wk *cw, int doy, double sw_rad) {
     */
     double So, tau, R, K, diffuse_frac, cos_zen_sq;
 
-    /* sine of the elev of the sun above the horizon is the same as cos_zen */
-    So = calc_extra_terrestrial_rad(doy, cw->cos_zenith);
+    /* extra-terrestrial radiation, from get_solar_geometry */
+    So = cw->So;
 
     /* atmospheric transmisivity */
     tau = estimate_clearness(sw_rad, So);
@@ -164,6 +164,64 @@ void calculate_absorbed_radiation(canopy_wk *cw, params *p, state *s,
     return;
 }
 
+void get_solar_geometry(canopy_wk *cw, params *p, double doy, int hod) {
+    /*
+        Sun position (cos_zenith, elevation) and extra-terrestrial radiation
+        for the current half-hour. These only depend on the site, doy and
+        hod, so they are looked up in the table built by build_solar_table
+        when there is one and worked out from scratch otherwise.
+    */
+    int d = (int)doy - 1;
+
+    if (cw->solar != NULL && d >= 0 && d < SOLAR_TABLE_NDAYS &&
+        hod >= 0 && hod < SOLAR_TABLE_NHRS) {
+        cw->cos_zenith = cw->solar->cos_zenith[d][hod];
+        cw->elevation = cw->solar->elevation[d][hod];
+        cw->So = cw->solar->So[d][hod];
+    } else {
+        calculate_solar_geometry(cw, p, doy, hod);
+        cw->So = calc_extra_terrestrial_rad((int)doy, cw->cos_zenith);
+    }
+
+    return;
+}
+
+void build_solar_table(canopy_wk *cw, params *p) {
+    /*
+        Fill in the sun position for every half-hour of the year at this
+        site. Once built (at sim_init) the table is kept with the canopy
+        work structure for the rest of the run, including every spin-up
+        cycle, and only rebuilt if the site moves.
+    */
+    int d, hod;
+
+    if (cw->solar != NULL && cw->solar->latitude == p->latitude &&
+        cw->solar->longitude == p->longitude)
+        return;
+
+    if (cw->solar == NULL) {
+        cw->solar = (solar_table *)malloc(sizeof(solar_table));
+        if (cw->solar == NULL) {
+            fprintf(stderr, "Error allocating space for solar table\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    cw->solar->latitude = p->latitude;
+    cw->solar->longitude = p->longitude;
+
+    for (d = 0; d < SOLAR_TABLE_NDAYS; d++) {
+        for (hod = 0; hod < SOLAR_TABLE_NHRS; hod++) {
+            calculate_solar_geometry(cw, p, (double)(d + 1), hod);
+            cw->solar->cos_zenith[d][hod] = cw->cos_zenith;
+            cw->solar->elevation[d][hod] = cw->elevation;
+            cw->solar->So[d][hod] = calc_extra_terrestrial_rad(d + 1,
+                                                          cw->cos_zenith);
+        }
+    }
+
+    return;
+}
+
 void calculate_solar_geometry(canopy_wk *cw, params *p, double doy,
                               double hod) {
 
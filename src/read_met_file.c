@@ -1,300 +1,405 @@
 #include "read_met_file.h"
+#include "met_stream.h"
+#include "forcing.h"
+
+void read_met_data(char **argv, control *c, met_arrays *ma) {
+    /*
+        Load the met forcing named by met_fname, either a binary columnar
+        file (see met_binary.c) or the daily/30 min CSV.
+    */
+    ma->map_base = NULL;
+    ma->map_len = 0;
+    ma->cache_entry = NULL;
+    ma->row0 = 0;
+    ma->stream = NULL;
+
+    if (c->met_stream && c->sub_daily == FALSE) {
+        fprintf(stderr, "%s: met_stream is only for sub_daily forcing\n",
+                *argv);
+		exit(EXIT_FAILURE);
+    }
+
+    if (is_binary_met_file(c->met_fname)) {
+        read_binary_met_data(argv, c, ma);
+        if (c->met_stream)
+            open_met_stream(argv, c, ma);
+    } else if (c->met_stream)
+        open_met_stream(argv, c, ma);
+    else if (c->sub_daily)
+        read_subdaily_met_data(argv, c, ma);
+    else
+        read_daily_met_data(argv, c, ma);
+
+    /* the terms that follow from tair/press, shared wherever ma is */
+    derive_met_columns(c, ma);
+
+    return;
+}
 
 void read_daily_met_data(char **argv, control *c, met_arrays *ma)
 {
-    FILE  *fp;
-    char   line[STRING_LENGTH];
-    int    file_len = 0;
-    int    i = 0;
-    int    nvars = 20;
-    int    skipped_lines = 0;
-    double current_yr;
-
-    if ((fp = fopen(c->met_fname, "r")) == NULL) {
-		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
-                c->met_fname);
-		exit(EXIT_FAILURE);
-	 }
-
-    /* work out how big the file is */
-    file_len = 0;
-    while (fgets(line, STRING_LENGTH, fp) != NULL) {
-        /* ignore comment line */
-        if (*line == '#')
-            continue;
-        file_len++;
-    }
-    rewind(fp);
-    c->total_num_days = file_len;
-
-    /* allocate memory for meteorological arrays */
-    if ((ma->year = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for year array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->prjday = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for prjday array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tair = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tair array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->rain = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for rain array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tsoil = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tsoil array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tam = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tam array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tpm = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tpm array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tmin = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tmin array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tmax = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tmax array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->tday = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tday array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->vpd_am = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for vpd_am array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->vpd_pm = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for vpd_pm array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->co2 = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for co2 array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->ndep = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for ndep array\n");
-		exit(EXIT_FAILURE);
-    }
-
-    if ((ma->wind = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for wind array\n");
+    /*
+        Daily met forcing, 20 comma separated columns per line. See
+        get_met_columns for the order.
+    */
+    met_column cols[MET_BIN_MAX_VARS];
+    met_real **fields[MET_BIN_MAX_VARS];
+    int        i, nvars;
+
+    nvars = get_met_columns(c, ma, cols);
+    for (i = 0; i < nvars; i++) {
+        fields[i] = cols[i].col;
+    }
+    read_met_csv(argv, c, ma, fields, nvars);
+    c->total_num_days = ma->nrows;
+
+    /* never read from the daily file, but kept for consistency */
+    if ((ma->par = (met_real *)calloc(ma->nrows, sizeof(met_real))) == NULL) {
+        fprintf(stderr,"Error allocating space for par array\n");
 		exit(EXIT_FAILURE);
     }
 
-    if ((ma->press = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for press array\n");
-		exit(EXIT_FAILURE);
-    }
+    return;
+}
 
-    if ((ma->wind_am = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for wind_am array\n");
-		exit(EXIT_FAILURE);
+void read_subdaily_met_data(char **argv, control *c, met_arrays *ma)
+{
+    /*
+        30 min met forcing, 12 comma separated columns per line: year, doy,
+        hod, then the variables in get_met_columns order. The hod column is
+        implied by the row and is skipped.
+    */
+    met_column cols[MET_BIN_MAX_VARS];
+    met_real **fields[MET_BIN_MAX_VARS];
+    int        i, j, ncols;
+
+    ncols = get_met_columns(c, ma, cols);
+    for (i = 0, j = 0; i < ncols; i++) {
+        fields[j++] = cols[i].col;
+        if (i == 1) {
+            /* hod */
+            fields[j++] = NULL;
+        }
     }
+    read_met_csv(argv, c, ma, fields, j);
 
-    if ((ma->wind_pm = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for wind_pm array\n");
-		exit(EXIT_FAILURE);
-    }
+    /* output is daily, so correct for n_timesteps */
+    c->total_num_days = ma->nrows / 48;
 
-    if ((ma->par = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for par array\n");
-		exit(EXIT_FAILURE);
-    }
+    return;
+}
 
-    if ((ma->par_am = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for par_am array\n");
+void read_met_csv(char **argv, control *c, met_arrays *ma, met_real ***fields,
+                  int nvars) {
+    /*
+        Single pass CSV reader. The file is pulled in in large blocks and each
+        line is split with scan_double, rather than counting the lines first
+        and then re-reading everything with sscanf. The columns are grown
+        geometrically as we go.
+
+        Parameters:
+        -----------
+        fields : double
+            where to store each of the nvars columns of a line, NULL entries
+            are parsed but discarded
+    */
+    block_reader br;
+    char   *line;
+    int     j, line_number = 0;
+    long    nrows = 0, nalloc = 0;
+    double  current_yr = -9999.9, values[MET_BIN_MAX_VARS];
+
+    if ((br.fp = fopen(c->met_fname, "r")) == NULL) {
+		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
+                c->met_fname);
 		exit(EXIT_FAILURE);
-    }
+	 }
+    init_block_reader(&br);
 
-    if ((ma->par_pm = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for par_pm array\n");
-		exit(EXIT_FAILURE);
+    for (j = 0; j < nvars; j++) {
+        if (fields[j] != NULL)
+            *(fields[j]) = NULL;
     }
 
-
-    i = 0;
     c->num_years = 0;
-    skipped_lines = 0;
-    while (fgets(line, STRING_LENGTH, fp) != NULL) {
+    while ((line = read_next_line(&br)) != NULL) {
+        line_number++;
+
         /* ignore comment line */
-        if (*line == '#') {
-            skipped_lines++;
+        if (*line == '#')
             continue;
+
+        if (nrows == nalloc) {
+            nalloc = (nalloc == 0) ? 8192 : nalloc * 2;
+            for (j = 0; j < nvars; j++) {
+                if (fields[j] == NULL)
+                    continue;
+                *(fields[j]) = (met_real *)realloc(*(fields[j]),
+                                                 nalloc * sizeof(met_real));
+                if (*(fields[j]) == NULL) {
+                    fprintf(stderr,"Error allocating space for met arrays\n");
+            		exit(EXIT_FAILURE);
+                }
+            }
         }
 
-        if (sscanf(line, "%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf", \
-                          &(ma->year[i]), &(ma->prjday[i]), \
-                          &(ma->tair[i]), &(ma->rain[i]), &(ma->tsoil[i]), \
-                          &(ma->tam[i]), &(ma->tpm[i]), &(ma->tmin[i]), \
-                          &(ma->tmax[i]), &(ma->tday[i]), &(ma->vpd_am[i]), \
-                          &(ma->vpd_pm[i]), &(ma->co2[i]), &(ma->ndep[i]), \
-                          &(ma->wind[i]), &(ma->press[i]), &(ma->wind_am[i]), \
-                          &(ma->wind_pm[i]), &(ma->par_am[i]), \
-                          &(ma->par_pm[i])) != nvars) {
-            fprintf(stderr, "%s: badly formatted input in met file on line %d %d\n", \
-                    *argv, (int)i+1+skipped_lines, nvars);
+        if (parse_met_line(line, values, nvars) == FALSE) {
+            fprintf(stderr, "%s: badly formatted input in met file on line %d\n",
+                    *argv, line_number);
             exit(EXIT_FAILURE);
         }
+        for (j = 0; j < nvars; j++) {
+            if (fields[j] != NULL)
+                (*(fields[j]))[nrows] = values[j];
+        }
 
         /* Build an array of the unique years as we loop over the input file */
-        if (current_yr != ma->year[i]) {
+        if (current_yr != ma->year[nrows]) {
             c->num_years++;
-            current_yr = ma->year[i];
+            current_yr = ma->year[nrows];
         }
-        i++;
+        nrows++;
     }
-    fclose(fp);
+    fclose(br.fp);
+    free(br.buf);
+
+    ma->nrows = nrows;
+
     return;
 }
 
-void read_subdaily_met_data(char **argv, control *c, met_arrays *ma)
-{
-    FILE  *fp;
-    char   line[STRING_LENGTH];
-    int    i = 0;
-    int    nvars = 12;
-    int    skipped_lines = 0;
-    double current_yr, temp_HOD;
-    long   file_len;
-    double hod_dummy;
-
-    if ((fp = fopen(c->met_fname, "r")) == NULL) {
-		fprintf(stderr, "Error: couldn't open Met file %s for read\n",
-                c->met_fname);
-		exit(EXIT_FAILURE);
-	 }
-
-    /* work out how big the file is */
-    file_len = 0;
-    while (fgets(line, STRING_LENGTH, fp) != NULL) {
-        /* ignore comment line */
-        if (*line == '#')
-            continue;
-        file_len++;
+int parse_met_line(char *line, double *values, int nvars) {
+    /*
+        Split one line of the CSV forcing into its nvars comma separated
+        values. Returns FALSE if the line is short or badly formatted.
+    */
+    char *ptr = line;
+    int   j;
+
+    for (j = 0; j < nvars; j++) {
+        if (j > 0) {
+            if (*ptr != ',')
+                return (FALSE);
+            ptr++;
+        }
+        if (scan_double(&ptr, &values[j]) == FALSE)
+            return (FALSE);
     }
-    rewind(fp);
-    /* output is daily, so correct for n_timesteps */
-    c->total_num_days = file_len / 48;
 
-    /* allocate memory for meteorological arrays */
-    if ((ma->year = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for year array\n");
-		exit(EXIT_FAILURE);
-    }
+    return (TRUE);
+}
 
-    if ((ma->doy = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for doy array\n");
-		exit(EXIT_FAILURE);
-    }
+void init_block_reader(block_reader *br) {
+    /* (the caller opens br->fp) */
 
-    if ((ma->rain = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for rain array\n");
+    br->size = 1 << 20;
+    if ((br->buf = (char *)malloc(br->size + 1)) == NULL) {
+        fprintf(stderr,"Error allocating space for met file buffer\n");
 		exit(EXIT_FAILURE);
     }
+    br->start = 0;
+    br->end = 0;
+    br->eof = FALSE;
 
-    if ((ma->par = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for par array\n");
-		exit(EXIT_FAILURE);
-    }
+    return;
+}
 
-    if ((ma->tair = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tair array\n");
-		exit(EXIT_FAILURE);
-    }
+char *read_next_line(block_reader *br) {
+    /*
+        Return the next line of the file (newline stripped, NUL terminated),
+        refilling the buffer a block at a time. The line is only valid until
+        the next call. Returns NULL at the end of the file.
+    */
+    char   *line, *nl;
+    size_t  nread, len;
+
+    while (TRUE) {
+        len = br->end - br->start;
+        nl = memchr(br->buf + br->start, '\n', len);
+        if (nl != NULL) {
+            line = br->buf + br->start;
+            *nl = '\0';
+            br->start = (nl - br->buf) + 1;
+            return (line);
+        }
 
-    if ((ma->tsoil = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for tsoil array\n");
-		exit(EXIT_FAILURE);
-    }
+        if (br->eof) {
+            if (len == 0)
+                return (NULL);
+            /* last line without a trailing newline */
+            line = br->buf + br->start;
+            line[len] = '\0';
+            br->start = br->end;
+            return (line);
+        }
 
-    if ((ma->vpd = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for vpd array\n");
-		exit(EXIT_FAILURE);
+        /* shift the partial line to the front and read some more */
+        memmove(br->buf, br->buf + br->start, len);
+        br->start = 0;
+        br->end = len;
+        if (br->end == br->size) {
+            br->size *= 2;
+            if ((br->buf = (char *)realloc(br->buf, br->size + 1)) == NULL) {
+                fprintf(stderr,"Error allocating space for met file buffer\n");
+        		exit(EXIT_FAILURE);
+            }
+        }
+        nread = fread(br->buf + br->end, 1, br->size - br->end, br->fp);
+        br->end += nread;
+        if (nread == 0)
+            br->eof = TRUE;
     }
+}
 
-    if ((ma->co2 = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for co2 array\n");
-		exit(EXIT_FAILURE);
+int scan_double(char **str, double *value) {
+    /*
+        Parse a double from *str and move *str past it, leading whitespace
+        is skipped (as scanf's %lf would).
+
+        Plain decimal numbers with at most 15 significant digits and a small
+        exponent are exact as (integer mantissa) * or / (power of ten), as
+        both are exactly representable and IEEE arithmetic rounds the single
+        operation correctly. Anything else (more digits, nan/inf, hex...) is
+        handed to strtod, so the result is always identical to sscanf's.
+
+        Reference:
+        ----------
+        * Clinger, W. D. (1990) How to read floating point numbers
+          accurately. PLDI '90, 92-101.
+    */
+    const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                             1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+                             1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    char  *p = *str, *start, *end;
+    int    negative = FALSE, ndigits = 0, nsig = 0, exp10 = 0, esign, eval;
+    unsigned long long mantissa = 0;
+
+    while (isspace((unsigned char)*p))
+        p++;
+    start = p;
+
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        p++;
+    }
+
+    while (*p >= '0' && *p <= '9') {
+        if (mantissa > 0 || *p != '0') {
+            mantissa = mantissa * 10 + (*p - '0');
+            nsig++;
+        }
+        ndigits++;
+        p++;
+        if (nsig > 15)
+            goto slow;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (mantissa > 0 || *p != '0') {
+                mantissa = mantissa * 10 + (*p - '0');
+                nsig++;
+            }
+            exp10--;
+            ndigits++;
+            p++;
+            if (nsig > 15)
+                goto slow;
+        }
     }
+    if (ndigits == 0)
+        goto slow;
 
-    if ((ma->ndep = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for ndep array\n");
-		exit(EXIT_FAILURE);
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        esign = 1;
+        if (*p == '-' || *p == '+') {
+            esign = (*p == '-') ? -1 : 1;
+            p++;
+        }
+        if (*p < '0' || *p > '9')
+            goto slow;
+        eval = 0;
+        while (*p >= '0' && *p <= '9') {
+            eval = eval * 10 + (*p - '0');
+            p++;
+            if (eval > 1000)
+                goto slow;
+        }
+        exp10 += esign * eval;
     }
 
-    if ((ma->wind = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for wind array\n");
-		exit(EXIT_FAILURE);
-    }
+    /* hex float, "1.5.2" etc. */
+    if (*p == 'x' || *p == 'X' || *p == '.' || *p == 'p' || *p == 'P')
+        goto slow;
 
-    if ((ma->press = (double *)calloc(file_len, sizeof(double))) == NULL) {
-        fprintf(stderr,"Error allocating space for press array\n");
-		exit(EXIT_FAILURE);
-    }
+    if (exp10 < -22 || exp10 > 22)
+        goto slow;
 
-    current_yr = ma->year[0];
+    if (exp10 < 0)
+        *value = (double)mantissa / pow10[-exp10];
+    else
+        *value = (double)mantissa * pow10[exp10];
+    if (negative)
+        *value = -*value;
+    *str = p;
 
-    i = 0;
-    c->num_years = 0;
-    skipped_lines = 0;
+    return (TRUE);
 
-    while (fgets(line, STRING_LENGTH, fp) != NULL) {
-        /* ignore comment line */
-        if (*line == '#') {
-            skipped_lines++;
-            continue;
-        }
+slow:
+    *value = strtod(start, &end);
+    if (end == start)
+        return (FALSE);
+    *str = end;
 
-        if (sscanf(line, "%lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf,\
-                          %lf,%lf,%lf", \
-                          &(ma->year[i]), &(ma->doy[i]), &temp_HOD, \
-                          &(ma->rain[i]), &(ma->par[i]), &(ma->tair[i]), \
-                          &(ma->tsoil[i]), &(ma->vpd[i]), &(ma->co2[i]), \
-                          &(ma->ndep[i]), &(ma->wind[i]), \
-                          &(ma->press[i])) != nvars) {
-            fprintf(stderr, "%s: badly formatted input in met file on line %d %d\n", \
-                    *argv, (int)i+1+skipped_lines, nvars);
-            exit(EXIT_FAILURE);
-        }
+    return (TRUE);
+}
 
-        /* Build an array of the unique years as we loop over the input file */
-        if (current_yr != ma->year[i]) {
-            c->num_years++;
-            current_yr = ma->year[i];
-        }
-        i++;
+void free_met_data(control *c, met_arrays *ma) {
+    /* Release the met arrays allocated by the read_*_met_data functions */
+
+    free_met_derived(ma);
+
+    if (ma->stream != NULL) {
+        /* CSV columns point into the stream's window */
+        close_met_stream(ma);
+        if (ma->map_base == NULL)
+            return;
+    }
+
+    if (ma->map_base != NULL) {
+        /* columns point into the mmap'ed binary file */
+        munmap(ma->map_base, ma->map_len);
+        ma->map_base = NULL;
+        return;
+    }
+
+    free(ma->year);
+    free(ma->tair);
+    free(ma->rain);
+    free(ma->tsoil);
+    free(ma->co2);
+    free(ma->ndep);
+    free(ma->wind);
+    free(ma->press);
+    free(ma->par);
+    if (c->sub_daily) {
+        free(ma->vpd);
+        free(ma->doy);
+    } else {
+        free(ma->prjday);
+        free(ma->tam);
+        free(ma->tpm);
+        free(ma->tmin);
+        free(ma->tmax);
+        free(ma->tday);
+        free(ma->vpd_am);
+        free(ma->vpd_pm);
+        free(ma->wind_am);
+        free(ma->wind_pm);
+        free(ma->par_am);
+        free(ma->par_pm);
     }
 
-    fclose(fp);
     return;
 }
@@ -0,0 +1,742 @@
+/* ============================================================================
+* Regional driver: run the cells of a grid, each a G'DAY simulation with its
+* own parameter overrides and forcing, across MPI ranks and, within each
+* rank, a pool of worker threads.
+*
+* The cell list is a plain text file with one cell per line, e.g.
+*
+*   # id      cfg / mode / cost / overrides
+*   *         params/region.cfg files.out_fname=out/%c.gdc
+*   c001      files.met_fname=tiles/t01.bin params.latitude=35.9
+*   c002      files.met_fname=tiles/t01.bin params.latitude=36.1 cost=2
+*   c003      params/other.cfg spinup files.met_fname=tiles/t02.bin
+*
+* The first word is the cell id; then, in any order, a .cfg file, the mode
+* (run or spinup), cost=X, and section.name=value overrides, which are
+* applied on top of the .cfg (and any -set) for that cell alone. The line
+* with id '*' gives the defaults for every cell: its overrides come first,
+* so a cell's own win. '%c' in an override is replaced by the cell id,
+* which is the easy way to give every cell its own output file. Blank lines
+* and lines starting with '#' are ignored.
+*
+* A forcing tile is simply a met file that several cells name; each rank
+* loads it once and its threads share it (see met_cache.c).
+*
+* Load balancing: cells are handed out dearest first (cost, default 1, e.g.
+* years x timesteps per day), a few at a time as a rank's queue runs low, so
+* a rank that lands slow cells simply takes fewer of them. Rank 0 hands out
+* the cells, from its main thread, while its workers run cells like any
+* other rank's. At the end rank 0 writes <cell list>.index.csv, which cell
+* ran where, for how long, and the output file it wrote; read_region in
+* scripts/read_gday_columnar.py pulls a variable for every cell from that.
+*
+* Built with make mpi (gday_mpi, -DGDAY_MPI); the ordinary build still
+* takes -r and runs all the cells as a single rank.
+*
+* NOTES:
+*   Errors inside a cell still exit the process, as they would for a single
+*   run, which takes the whole MPI job down with it.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "region.h"
+#include "timing.h"
+
+#ifdef GDAY_MPI
+#include <mpi.h>
+
+#define TAG_REQUEST 1                   /* rank -> 0, cells wanted */
+#define TAG_CELLS 2                     /* 0 -> rank, count then indices */
+#define TAG_RESULTS 3                   /* rank -> 0, what ran where */
+
+static void serve_cell_requests(region_queue *, int *, int *);
+static void request_cells(region_queue *);
+static void gather_region_results(region_queue *, int, int *);
+#endif
+
+static void feed_own_queue(region_queue *, int *);
+
+void run_region(char **argv, char *fname, int num_threads) {
+    /*
+        Read the cell list and run every cell, spread over the MPI ranks
+        (if built with them) and num_threads workers on each
+
+        Parameters:
+        -----------
+        fname : char
+            the cell list
+        num_threads : int
+            worker threads per rank, <= 0 means one per core
+    */
+    int          i, rank = 0, size = 1, next_cell = 0, num_done_ranks = 0;
+    int         *cell_rank = NULL;
+    char         index_fname[STRING_LENGTH];
+    pthread_t   *threads = NULL;
+    region_cell *cells = NULL;
+    region_queue q;
+#ifdef GDAY_MPI
+    int          provided;
+
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED) {
+        fprintf(stderr, "Error: MPI without thread support\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+
+    /* every rank reads the list, so only indices need sending */
+    read_region_cells(fname, NULL, &cells, &q.num_cells);
+
+    if (num_threads <= 0)
+        num_threads = get_num_cores();
+
+    if ((q.order = (int *)calloc(q.num_cells, sizeof(int))) == NULL ||
+        (q.queue = (int *)calloc(q.num_cells, sizeof(int))) == NULL ||
+        (q.seconds = (double *)calloc(q.num_cells, sizeof(double))) == NULL ||
+        (cell_rank = (int *)calloc(q.num_cells, sizeof(int))) == NULL ||
+        (threads = (pthread_t *)calloc(num_threads,
+                                       sizeof(pthread_t))) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+    sort_region_cells(cells, q.num_cells, q.order);
+    for (i = 0; i < q.num_cells; i++) {
+        q.seconds[i] = -1.0;
+        cell_rank[i] = -1;
+    }
+
+    /* cells that share a forcing tile share one copy of it */
+    enable_met_cache();
+
+    q.argv = argv;
+    q.cells = cells;
+    q.head = 0;
+    q.tail = 0;
+    q.exhausted = FALSE;
+    q.num_threads = num_threads;
+    q.rank = rank;
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.more, NULL);
+    pthread_cond_init(&q.low, NULL);
+
+    if (rank == 0)
+        fprintf(stderr, "Region: %d cells on %d ranks x %d threads\n",
+                q.num_cells, size, num_threads);
+
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, region_worker, &q) != 0) {
+            fprintf(stderr, "Error creating region worker thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* the main thread keeps the queue topped up, and on rank 0 answers
+       the other ranks, it never runs a cell itself */
+    if (rank == 0) {
+        while (TRUE) {
+#ifdef GDAY_MPI
+            serve_cell_requests(&q, &next_cell, &num_done_ranks);
+#endif
+            feed_own_queue(&q, &next_cell);
+            if (q.exhausted && num_done_ranks == size - 1)
+                break;
+
+            pthread_mutex_lock(&q.lock);
+            if (size == 1) {
+                while (q.tail - q.head >= q.num_threads)
+                    pthread_cond_wait(&q.low, &q.lock);
+            } else if (q.tail - q.head >= q.num_threads || q.exhausted) {
+                /* can't sleep through a request from another rank */
+                pthread_mutex_unlock(&q.lock);
+                usleep(1000);
+                pthread_mutex_lock(&q.lock);
+            }
+            pthread_mutex_unlock(&q.lock);
+        }
+    }
+#ifdef GDAY_MPI
+    else {
+        request_cells(&q);
+    }
+#endif
+
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (i = 0; i < q.num_cells; i++) {
+        if (q.seconds[i] >= 0.0)
+            cell_rank[i] = rank;
+    }
+
+#ifdef GDAY_MPI
+    gather_region_results(&q, size, cell_rank);
+#endif
+    if (rank == 0) {
+        snprintf(index_fname, sizeof(index_fname), "%s.index.csv", fname);
+        write_region_index(index_fname, cells, q.num_cells, q.seconds,
+                           cell_rank);
+        fprintf(stderr, "Region: finished, index in %s\n", index_fname);
+    }
+
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.more);
+    pthread_cond_destroy(&q.low);
+    flush_met_cache();
+    free_region_cells(cells, q.num_cells);
+    free(q.order);
+    free(q.queue);
+    free(q.seconds);
+    free(cell_rank);
+    free(threads);
+
+#ifdef GDAY_MPI
+    MPI_Finalize();
+#endif
+
+    return;
+}
+
+static void feed_own_queue(region_queue *q, int *next_cell) {
+    /*
+        Rank 0 tops its own queue up from the list like any other rank
+        would, a thread's worth of cells waiting at a time
+    */
+    int n;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->tail - q->head < q->num_threads) {
+        n = MIN(q->num_threads, q->num_cells - *next_cell);
+        if (n > 0) {
+            memcpy(q->queue + q->tail, q->order + *next_cell, n * sizeof(int));
+            q->tail += n;
+            *next_cell += n;
+            pthread_cond_broadcast(&q->more);
+        }
+    }
+    if (*next_cell == q->num_cells && q->exhausted == FALSE) {
+        q->exhausted = TRUE;
+        pthread_cond_broadcast(&q->more);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return;
+}
+
+#ifdef GDAY_MPI
+static void serve_cell_requests(region_queue *q, int *next_cell,
+                                int *num_done_ranks) {
+    /*
+        Answer every request waiting from the other ranks with the next
+        dearest cells, or none once they are all gone
+    */
+    MPI_Status status;
+    int        flag, want, n, *reply;
+
+    if ((reply = (int *)calloc(q->num_cells + 1, sizeof(int))) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while (TRUE) {
+        MPI_Iprobe(MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &flag,
+                   &status);
+        if (flag == FALSE)
+            break;
+        MPI_Recv(&want, 1, MPI_INT, status.MPI_SOURCE, TAG_REQUEST,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        n = MAX(0, MIN(want, q->num_cells - *next_cell));
+        reply[0] = n;
+        memcpy(reply + 1, q->order + *next_cell, n * sizeof(int));
+        *next_cell += n;
+        MPI_Send(reply, n + 1, MPI_INT, status.MPI_SOURCE, TAG_CELLS,
+                 MPI_COMM_WORLD);
+        if (n == 0)
+            (*num_done_ranks)++;
+    }
+    free(reply);
+
+    return;
+}
+
+static void request_cells(region_queue *q) {
+    /*
+        Ranks other than 0 ask for a thread's worth of cells whenever their
+        queue runs low, until rank 0 has none left
+    */
+    int *reply, n;
+
+    if ((reply = (int *)calloc(q->num_threads + 1, sizeof(int))) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+
+    do {
+        pthread_mutex_lock(&q->lock);
+        while (q->tail - q->head >= q->num_threads)
+            pthread_cond_wait(&q->low, &q->lock);
+        pthread_mutex_unlock(&q->lock);
+
+        MPI_Send(&q->num_threads, 1, MPI_INT, 0, TAG_REQUEST, MPI_COMM_WORLD);
+        MPI_Recv(reply, q->num_threads + 1, MPI_INT, 0, TAG_CELLS,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        n = reply[0];
+
+        pthread_mutex_lock(&q->lock);
+        memcpy(q->queue + q->tail, reply + 1, n * sizeof(int));
+        q->tail += n;
+        if (n == 0)
+            q->exhausted = TRUE;
+        pthread_cond_broadcast(&q->more);
+        pthread_mutex_unlock(&q->lock);
+    } while (n > 0);
+    free(reply);
+
+    return;
+}
+
+static void gather_region_results(region_queue *q, int size, int *cell_rank) {
+    /*
+        Rank 0 collects which cells each rank ran, their wall time and
+        output file, as lines of "index seconds out_fname"
+    */
+    char  *buf = NULL, *line, *end;
+    int    i, r, len, cap = 0, pos = 0, idx, used;
+    double seconds;
+
+    if (q->rank != 0) {
+        for (i = 0; i < q->num_cells; i++) {
+            if (cell_rank[i] != q->rank)
+                continue;
+            len = (int)strlen(q->cells[i].out_fname) + 64;
+            if (pos + len > cap) {
+                cap = MAX(2 * cap, pos + len);
+                if ((buf = (char *)realloc(buf, cap)) == NULL) {
+                    fprintf(stderr,"Error allocating space for region "
+                            "results\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            pos += snprintf(buf + pos, cap - pos, "%d %.17g %s\n", i,
+                            q->seconds[i], q->cells[i].out_fname);
+        }
+        MPI_Send(&pos, 1, MPI_INT, 0, TAG_RESULTS, MPI_COMM_WORLD);
+        MPI_Send(buf, pos, MPI_CHAR, 0, TAG_RESULTS, MPI_COMM_WORLD);
+        free(buf);
+        return;
+    }
+
+    for (r = 1; r < size; r++) {
+        MPI_Recv(&len, 1, MPI_INT, r, TAG_RESULTS, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+        if ((buf = (char *)malloc(len + 1)) == NULL) {
+            fprintf(stderr,"Error allocating space for region results\n");
+            exit(EXIT_FAILURE);
+        }
+        MPI_Recv(buf, len, MPI_CHAR, r, TAG_RESULTS, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+        buf[len] = '\0';
+
+        for (line = buf; *line != '\0'; line = end + 1) {
+            if ((end = strchr(line, '\n')) == NULL)
+                break;
+            *end = '\0';
+            if (sscanf(line, "%d %lf %n", &idx, &seconds, &used) < 2 ||
+                idx < 0 || idx >= q->num_cells) {
+                fprintf(stderr, "Error: bad region results from rank %d\n",
+                        r);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            q->seconds[idx] = seconds;
+            cell_rank[idx] = r;
+            free(q->cells[idx].out_fname);
+            if ((q->cells[idx].out_fname = strdup(line + used)) == NULL) {
+                fprintf(stderr,"Error allocating space for region results\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        free(buf);
+    }
+
+    return;
+}
+#endif /* GDAY_MPI */
+
+void *region_worker(void *arg) {
+    /*
+        Run cells off this rank's queue until it is empty and no more are
+        coming, asking the main thread for more as it runs low
+    */
+    region_queue *q = (region_queue *)arg;
+    region_cell  *cell;
+    int           idx;
+    int64_t       start;
+
+    while (TRUE) {
+        pthread_mutex_lock(&q->lock);
+        while (q->head == q->tail && q->exhausted == FALSE) {
+            pthread_cond_signal(&q->low);
+            pthread_cond_wait(&q->more, &q->lock);
+        }
+        if (q->head == q->tail) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        idx = q->queue[q->head++];
+        if (q->tail - q->head < q->num_threads)
+            pthread_cond_signal(&q->low);
+        pthread_mutex_unlock(&q->lock);
+
+        cell = &(q->cells[idx]);
+        start = timing_clock();
+        simulate_cell(q->argv, cell);
+        /* each cell is only ever run by one thread */
+        q->seconds[idx] = (double)(timing_clock() - start) * 1E-09;
+
+        fprintf(stderr, "Region: rank %d finished cell %s (%.1f s)\n",
+                q->rank, cell->id, q->seconds[idx]);
+    }
+
+    return (NULL);
+}
+
+void simulate_cell(char **argv, region_cell *cell) {
+    /*
+        As simulate_site, with the cell's overrides on top of its .cfg
+    */
+    sim_context *sc;
+
+    sc = new_sim_context_with(argv, cell->cfg_fname, cell->spin_up,
+                              cell->overrides, cell->num_overrides);
+    strncpy0(sc->c->run_label, cell->id, sizeof(sc->c->run_label));
+
+    free(cell->out_fname);
+    if ((cell->out_fname = strdup(sc->c->out_fname)) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (sc->c->spin_up)
+        spin_up_pools(sc->cw, sc->c, sc->f, sc->ma, sc->m, sc->p, sc->s);
+    else
+        run_sim(sc->cw, sc->c, sc->f, sc->ma, sc->m, sc->p, sc->s);
+
+    free_sim_context(sc);
+
+    return;
+}
+
+static char *expand_cell_id(const char *template, const char *id) {
+    /* copy of template with every %c replaced by the cell id */
+    const char *t;
+    char       *out, *o;
+    size_t      len = strlen(template) + 1;
+
+    for (t = strstr(template, "%c"); t != NULL; t = strstr(t + 2, "%c"))
+        len += strlen(id);
+
+    if ((out = (char *)malloc(len)) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+    for (t = template, o = out; *t != '\0'; t++) {
+        if (t[0] == '%' && t[1] == 'c') {
+            strcpy(o, id);
+            o += strlen(id);
+            t++;
+        } else {
+            *o++ = *t;
+        }
+    }
+    *o = '\0';
+
+    return (out);
+}
+
+static void parse_cell_line(char *fname, int line_number, char *line,
+                            region_cell *cell, char **words) {
+    /*
+        Split a line of the cell list into the cell's pieces, overrides are
+        left unexpanded in words (cell->num_overrides of them)
+    */
+    char *word, *saveptr, *end;
+
+    cell->id = NULL;
+    cell->cfg_fname = NULL;
+    cell->spin_up = -1;
+    cell->cost = -1.0;
+    cell->num_overrides = 0;
+
+    for (word = strtok_r(line, " \t", &saveptr); word != NULL;
+         word = strtok_r(NULL, " \t", &saveptr)) {
+        if (cell->id == NULL) {
+            cell->id = word;
+        } else if (strcasecmp(word, "spinup") == 0 ||
+                   strcasecmp(word, "spin_up") == 0) {
+            cell->spin_up = TRUE;
+        } else if (strcasecmp(word, "run") == 0) {
+            cell->spin_up = FALSE;
+        } else if (strncasecmp(word, "cost=", 5) == 0) {
+            cell->cost = strtod(word + 5, &end);
+            if (end == word + 5 || *end != '\0' || cell->cost < 0.0) {
+                fprintf(stderr, "%s: bad cost on line %d\n", fname,
+                        line_number);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strchr(word, '=') != NULL) {
+            if (cell->num_overrides == MAX_CELL_OVERRIDES) {
+                fprintf(stderr, "%s: more than %d overrides on line %d\n",
+                        fname, MAX_CELL_OVERRIDES, line_number);
+                exit(EXIT_FAILURE);
+            }
+            words[cell->num_overrides++] = word;
+        } else if (cell->cfg_fname == NULL) {
+            cell->cfg_fname = word;
+        } else {
+            fprintf(stderr, "%s: badly formatted cell list on line %d\n",
+                    fname, line_number);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return;
+}
+
+static int next_cell_line(FILE *fp, char *fname, char *line, int size,
+                          int *line_number, char **start) {
+    /* next line of the cell list that isn't blank or a comment */
+    while (fgets(line, size, fp) != NULL) {
+        (*line_number)++;
+        if (strchr(line, '\n') == NULL && !feof(fp)) {
+            fprintf(stderr, "%s: line %d of the cell list is too long\n",
+                    fname, *line_number);
+            exit(EXIT_FAILURE);
+        }
+        *start = lskip(rstrip(line));
+        if (**start != '\0' && **start != '#')
+            return (TRUE);
+    }
+
+    return (FALSE);
+}
+
+static int is_defaults_line(char *start) {
+    return (start[0] == '*' && (start[1] == '\0' || isspace(start[1])));
+}
+
+void read_region_cells(char *fname, char *default_cfg, region_cell **cells,
+                       int *num_cells) {
+    /*
+        Parse the cell list, see the top of the file for the format. The
+        defaults line can come anywhere, so the list is read twice, for it
+        and then for the cells.
+
+        Parameters:
+        -----------
+        default_cfg : char
+            .cfg of cells that name none (and no defaults line does), NULL
+            if they must
+
+        Returns:
+        --------
+        cells : region_cell
+            array of cells to run, in the order of the list
+        num_cells : int
+            number of cells in the list
+    */
+    FILE        *fp;
+    char         line[4 * STRING_LENGTH], def_line[4 * STRING_LENGTH];
+    char        *start, *words[MAX_CELL_OVERRIDES];
+    char        *def_words[MAX_CELL_OVERRIDES];
+    int          line_number = 0, nalloc = 16, i, num_defaults = 0;
+    int          have_defaults = FALSE;
+    region_cell *cell, defaults;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "Error: couldn't open cell list %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    defaults.cfg_fname = default_cfg;
+    defaults.spin_up = FALSE;
+    defaults.cost = 1.0;
+    while (next_cell_line(fp, fname, line, sizeof(line), &line_number,
+                          &start)) {
+        if (is_defaults_line(start) == FALSE)
+            continue;
+        if (have_defaults) {
+            fprintf(stderr, "%s: second defaults line on line %d\n",
+                    fname, line_number);
+            exit(EXIT_FAILURE);
+        }
+        strcpy(def_line, start);
+        parse_cell_line(fname, line_number, def_line, &defaults, def_words);
+        if (defaults.cfg_fname == NULL)
+            defaults.cfg_fname = default_cfg;
+        if (defaults.spin_up == -1)
+            defaults.spin_up = FALSE;
+        if (defaults.cost < 0.0)
+            defaults.cost = 1.0;
+        num_defaults = defaults.num_overrides;
+        have_defaults = TRUE;
+    }
+
+    if ((*cells = (region_cell *)calloc(nalloc, sizeof(region_cell))) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rewind(fp);
+    line_number = 0;
+    *num_cells = 0;
+    while (next_cell_line(fp, fname, line, sizeof(line), &line_number,
+                          &start)) {
+        if (is_defaults_line(start))
+            continue;
+
+        if (*num_cells == nalloc) {
+            nalloc *= 2;
+            *cells = (region_cell *)realloc(*cells,
+                                            nalloc * sizeof(region_cell));
+            if (*cells == NULL) {
+                fprintf(stderr,"Error allocating space for region cells\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        cell = &((*cells)[*num_cells]);
+        parse_cell_line(fname, line_number, start, cell, words);
+
+        if (cell->cfg_fname == NULL)
+            cell->cfg_fname = defaults.cfg_fname;
+        if (cell->cfg_fname == NULL) {
+            fprintf(stderr, "%s: no .cfg file for cell %s on line %d\n",
+                    fname, cell->id, line_number);
+            exit(EXIT_FAILURE);
+        }
+        if (cell->spin_up == -1)
+            cell->spin_up = defaults.spin_up;
+        if (cell->cost < 0.0)
+            cell->cost = defaults.cost;
+        if (num_defaults + cell->num_overrides > MAX_CELL_OVERRIDES) {
+            fprintf(stderr, "%s: more than %d overrides for cell %s\n",
+                    fname, MAX_CELL_OVERRIDES, cell->id);
+            exit(EXIT_FAILURE);
+        }
+
+        /* the defaults first, so the cell's own win */
+        cell->overrides = (char **)calloc(MAX(1, num_defaults +
+                                              cell->num_overrides),
+                                          sizeof(char *));
+        if (cell->overrides == NULL) {
+            fprintf(stderr,"Error allocating space for region cells\n");
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < num_defaults; i++)
+            cell->overrides[i] = expand_cell_id(def_words[i], cell->id);
+        for (i = 0; i < cell->num_overrides; i++)
+            cell->overrides[num_defaults + i] = expand_cell_id(words[i],
+                                                               cell->id);
+        cell->num_overrides += num_defaults;
+
+        /* stop pointing into the line */
+        cell->id = strdup(cell->id);
+        cell->cfg_fname = strdup(cell->cfg_fname);
+        cell->out_fname = strdup("");
+        if (cell->id == NULL || cell->cfg_fname == NULL ||
+            cell->out_fname == NULL) {
+            fprintf(stderr,"Error allocating space for region cells\n");
+            exit(EXIT_FAILURE);
+        }
+        (*num_cells)++;
+    }
+    fclose(fp);
+
+    if (*num_cells == 0) {
+        fprintf(stderr, "Error: no cells found in cell list %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+void free_region_cells(region_cell *cells, int num_cells) {
+    int i, j;
+
+    for (i = 0; i < num_cells; i++) {
+        for (j = 0; j < cells[i].num_overrides; j++)
+            free(cells[i].overrides[j]);
+        free(cells[i].overrides);
+        free(cells[i].id);
+        free(cells[i].cfg_fname);
+        free(cells[i].out_fname);
+    }
+    free(cells);
+
+    return;
+}
+
+typedef struct {
+    double cost;
+    int    idx;
+} cell_cost;
+
+static int dearest_first(const void *a, const void *b) {
+    /* by cost, largest first, then in the order of the list */
+    const cell_cost *x = (const cell_cost *)a, *y = (const cell_cost *)b;
+
+    if (x->cost != y->cost)
+        return (x->cost < y->cost ? 1 : -1);
+
+    return (x->idx - y->idx);
+}
+
+void sort_region_cells(region_cell *cells, int num_cells, int *order) {
+    /* order the cells are handed out in, dearest first */
+    cell_cost *costs;
+    int        i;
+
+    if ((costs = (cell_cost *)calloc(num_cells, sizeof(cell_cost))) == NULL) {
+        fprintf(stderr,"Error allocating space for region cells\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < num_cells; i++) {
+        costs[i].cost = cells[i].cost;
+        costs[i].idx = i;
+    }
+    qsort(costs, num_cells, sizeof(cell_cost), dearest_first);
+    for (i = 0; i < num_cells; i++)
+        order[i] = costs[i].idx;
+    free(costs);
+
+    return;
+}
+
+void write_region_index(char *fname, region_cell *cells, int num_cells,
+                        double *seconds, int *cell_rank) {
+    /*
+        Which rank ran each cell, for how long, and the file it wrote, in
+        the order of the cell list
+    */
+    FILE *fp;
+    int   i;
+
+    if ((fp = fopen(fname, "w")) == NULL) {
+        fprintf(stderr, "Error: couldn't open region index %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(fp, "id,rank,seconds,out_fname\n");
+    for (i = 0; i < num_cells; i++) {
+        fprintf(fp, "%s,%d,%.3f,%s\n", cells[i].id, cell_rank[i], seconds[i],
+                cells[i].out_fname);
+    }
+    fclose(fp);
+
+    return;
+}
@@ -0,0 +1,635 @@
+/* ============================================================================
+* Simulation context: a re-entrant wrapper around a single G'DAY run.
+*
+* A context owns the model structures plus the bits of working storage the
+* run needs between days (stress running mean, day lengths, disturbance
+* years, year/day cursors). Nothing here touches global state, so any number
+* of contexts can be stepped on different threads and each gives the same
+* answer it would running on its own. The random stream used for
+* disturbance events is per context and seeded from the "seed" option.
+*
+* NOTES:
+*   Errors are still reported via exit(), as in the rest of the model.
+*
+* AUTHOR:
+*   Martin De Kauwe
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "sim_context.h"
+#include "checkpoint.h"
+#include "radiation.h"
+#include "forcing.h"
+#include "output_writer.h"
+#include "output_aggregate.h"
+#include "columnar.h"
+#include "met_stream.h"
+#include "output_buffer.h"
+#include "timing.h"
+#include "model_options.h"
+#include "temp_response.h"
+#include "soil_matrix.h"
+#include "telemetry.h"
+
+sim_context *new_sim_context(char **argv, char *cfg_fname, int spin_up) {
+    /*
+        Allocate the model structures, read the .cfg file and met forcing.
+
+        Parameters:
+        -----------
+        argv : char
+            program name, used when reporting errors in the met file
+        cfg_fname : char
+            .INI style parameter file
+        spin_up : int
+            spin the model up (TRUE) rather than just run it
+
+        Returns:
+        --------
+        sc : sim_context
+            context ready for sim_init/spin_up_pools
+    */
+
+    return (new_sim_context_with(argv, cfg_fname, spin_up, NULL, 0));
+}
+
+sim_context *new_sim_context_with(char **argv, char *cfg_fname, int spin_up,
+                                  char **overrides, int num_overrides) {
+    /*
+        As new_sim_context, with section.name=value overrides of this run
+        only, applied after any -set (a region cell's, see region.c). The
+        strings are the caller's and must outlive the context.
+    */
+    int error = 0;
+    sim_context *sc;
+
+    sc = (sim_context *)calloc(1, sizeof(sim_context));
+    if (sc == NULL) {
+        fprintf(stderr, "sim context: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    /*
+    ** Setup structures, initialise stuff, e.g. zero fluxes. control, params
+    ** and state are zeroed so that they hash reproducibly (spinup_library.c),
+    ** fluxes and met so that fields a run never sets are 0 rather than garbage
+    */
+    sc->cw = (canopy_wk *)calloc(1, sizeof(canopy_wk));
+    if (sc->cw == NULL) {
+        fprintf(stderr, "canopy wk structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->c = (control *)calloc(1, sizeof(control));
+    if (sc->c == NULL) {
+        fprintf(stderr, "control structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->f = (fluxes *)calloc(1, sizeof(fluxes));
+    if (sc->f == NULL) {
+    	fprintf(stderr, "fluxes structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->ma = (met_arrays *)calloc(1, sizeof(met_arrays));
+    if (sc->ma == NULL) {
+    	fprintf(stderr, "met arrays structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->m = (met *)calloc(1, sizeof(met));
+    if (sc->m == NULL) {
+    	fprintf(stderr, "met structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->p = (params *)calloc(1, sizeof(params));
+    if (sc->p == NULL) {
+    	fprintf(stderr, "params structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    sc->s = (state *)calloc(1, sizeof(state));
+    if (sc->s == NULL) {
+    	fprintf(stderr, "state structure: Not allocated enough memory!\n");
+    	exit(EXIT_FAILURE);
+    }
+
+    initialise_control(sc->c);
+    initialise_params(sc->p);
+    initialise_fluxes(sc->f);
+    initialise_state(sc->s);
+
+    strcpy(sc->c->cfg_fname, cfg_fname);
+    sc->c->spin_up = spin_up;
+    sc->c->run_overrides = overrides;
+    sc->c->num_run_overrides = num_overrides;
+
+    /*
+    ** Read .ini parameter file and meterological data
+    */
+    error = parse_ini_file(sc->c, sc->p, sc->s);
+    if (error != 0) {
+        prog_error("Error reading .INI file on line", __LINE__);
+    }
+    strcpy(sc->c->git_code_ver, build_git_sha);
+    seed_random(&(sc->c->rng_state), (unsigned long long)sc->c->seed);
+
+    /* a streamed forcing is never shared, each run holds its own window */
+    TIMER_START(TIMER_READ_MET);
+    if (met_cache_enabled() && sc->c->met_stream == FALSE)
+        acquire_met_data(argv, sc->c, sc->ma);
+    else
+        read_met_data(argv, sc->c, sc->ma);
+    TIMER_STOP(TIMER_READ_MET);
+    sc->ma->forcing = NULL;
+
+    return (sc);
+}
+
+void free_sim_context(sim_context *sc) {
+    /* close the run's files and release everything new_sim_context made */
+
+    if (sc->writer != NULL) {
+        stop_output_writer(sc->writer);
+        sc->writer = NULL;
+    }
+    if (sc->columns != NULL) {
+        close_column_file(sc->columns);
+        sc->columns = NULL;
+    }
+    if (sc->accum != NULL) {
+        free_output_accum(sc->accum);
+        sc->accum = NULL;
+    }
+    if (sc->buffer != NULL) {
+        free_output_buffer(sc->buffer);
+        sc->buffer = NULL;
+    }
+
+    if (sc->c->ofp != NULL)
+        fclose(sc->c->ofp);
+    if (sc->c->ifp != NULL)
+        fclose(sc->c->ifp);
+    if (sc->c->ofp_hdr != NULL)
+        fclose(sc->c->ofp_hdr);
+
+    close_telemetry(sc->c);
+    free_forcing(sc->ma);
+    if (sc->ma->cache_entry != NULL)
+        release_met_data(sc->c, sc->ma);
+    else
+        free_met_data(sc->c, sc->ma);
+    free(sc->cw->solar);
+    free(sc->cw);
+    free_model_options(sc->c);
+    free_temp_table(sc->c);
+    free_soil_transfer(sc->c);
+    free(sc->c);
+    free(sc->f);
+    free(sc->ma);
+    free(sc->m);
+    free(sc->p);
+    free(sc->s);
+    free(sc);
+
+    return;
+}
+
+void attach_sim_context(sim_context *sc, canopy_wk *cw, control *c,
+                        fluxes *f, met_arrays *ma, met *m, params *p,
+                        state *s) {
+    /* Point a (caller owned) context at an existing set of structures */
+
+    sc->cw = cw;
+    sc->c = c;
+    sc->f = f;
+    sc->ma = ma;
+    sc->m = m;
+    sc->p = p;
+    sc->s = s;
+    memset(&(sc->hw), 0, sizeof(sma_obj));
+    sc->writer = NULL;
+    sc->accum = NULL;
+    sc->columns = NULL;
+    sc->buffer = NULL;
+    sc->day_length = NULL;
+    sc->disturbance_yrs = NULL;
+    sc->num_disturbance_yrs = 0;
+    sc->nyr = 0;
+    sc->doy = 0;
+    sc->year = 0.0;
+
+    return;
+}
+
+void sim_init(sim_context *sc) {
+    /*
+        Everything that has to happen once before the first day: output
+        files, running mean, rate constant units, soil water parameters...
+    */
+    control *c = sc->c;
+    fluxes  *f = sc->f;
+    params  *p = sc->p;
+    state   *s = sc->s;
+    int      window_size;
+    double   nitfac;
+
+    /* pick the model variants once, rather than on every step */
+    resolve_model_options(c);
+    build_temp_table(c, p);
+    build_soil_transfer(c, p);
+
+    /* potentially allocating 1 extra spot, but will be fine as we always
+       index by num_days */
+    if ((sc->day_length = (double *)calloc(366, sizeof(double))) == NULL) {
+        fprintf(stderr,"Error allocating space for day_length\n");
+		exit(EXIT_FAILURE);
+    }
+
+    if (c->deciduous_model) {
+
+        /* Are we reading in last years average growing season? */
+        if (float_eq(s->avg_alleaf, 0.0) &&
+            float_eq(s->avg_alstem, 0.0) &&
+            float_eq(s->avg_albranch, 0.0) &&
+            float_eq(s->avg_alleaf, 0.0) &&
+            float_eq(s->avg_alroot, 0.0) &&
+            float_eq(s->avg_alcroot, 0.0)) {
+            nitfac = 0.0;
+            calc_carbon_allocation_fracs(c, f, p, s, nitfac);
+        } else {
+            f->alleaf = s->avg_alleaf;
+            f->alstem = s->avg_alstem;
+            f->albranch = s->avg_albranch;
+            f->alroot = s->avg_alroot;
+            f->alcroot = s->avg_alcroot;
+        }
+        allocate_stored_c_and_n(f, p, s);
+    }
+
+    /* Setup output file */
+    if (c->output_period == OUTPUT_PERIOD_DAILY)
+        c->num_output_records = c->total_num_days;
+    else
+        c->num_output_records = count_output_records(c, sc->ma);
+
+    if (c->print_options == DAILY && c->spin_up == FALSE && c->output_memory) {
+        /* handed back to the host program, the last run's are dropped */
+        if (sc->buffer != NULL)
+            free_output_buffer(sc->buffer);
+        sc->buffer = new_output_buffer(c->num_output_vars,
+                                       c->num_output_records);
+    } else if (c->print_options == DAILY && c->spin_up == FALSE &&
+        c->restart && c->restart_mode == RESTART_RESUME) {
+        /* carry on with the daily outputs written before the checkpoint */
+        resume_output_files(c);
+    } else if (c->print_options == DAILY && c->spin_up == FALSE) {
+        /* Daily outputs */
+        open_daily_output_files(c);
+    } else if (c->print_options == END && c->spin_up == FALSE) {
+        /* Final state + param file */
+        open_output_file(c, c->out_param_fname, &(c->ofp));
+    }
+    if (c->print_options == DAILY && c->spin_up == FALSE && c->output_columnar &&
+        sc->buffer == NULL)
+        sc->columns = start_column_file(c, c->ofp);
+    if (c->print_options == DAILY && c->spin_up == FALSE && c->async_output &&
+        sc->buffer == NULL)
+        sc->writer = start_output_writer(c, c->ofp, sc->columns);
+    if (c->print_options == DAILY && c->spin_up == FALSE &&
+        c->output_period != OUTPUT_PERIOD_DAILY)
+        sc->accum = new_output_accum(c);
+
+    /*
+        Window size = root lifespan in days...
+        For deciduous species window size is set as the length of the
+        growing season in the main part of the code
+    */
+    window_size = (int)(1.0 / p->rdecay * NDAYS_IN_YR);
+    sma_init(&(sc->hw), window_size);
+    if (s->prev_sma > -900) {
+        sma_fill(&(sc->hw), s->prev_sma, window_size);
+    }
+    /* Set up SMA
+    **  - If we don't have any information about the N & water limitation, i.e.
+    **    as would be the case with spin-up, assume that there is no limitation
+    **    to begin with.
+    */
+    if (s->prev_sma < -900)
+        s->prev_sma = 1.0;
+
+    /*
+        params are defined in per year, needs to be per day. Important this is
+        done here as rate constants elsewhere in the code are assumed to be in
+        units of days not years
+    */
+    correct_rate_constants(p, FALSE);
+    day_end_calculations(c, p, s, -99, TRUE);
+
+    initialise_soil_moisture_parameters(c, p);
+    s->pawater_root = p->wcapac_root;
+    s->pawater_topsoil = p->wcapac_topsoil;
+
+    if (c->fixed_lai) {
+        s->lai = p->fix_lai;
+    } else {
+        s->lai = MAX(0.01, (p->sla * M2_AS_HA / KG_AS_TONNES /
+                            p->cfracts * s->shoot));
+    }
+
+    sc->num_disturbance_yrs = 0;
+    if (c->disturbance) {
+        if ((sc->disturbance_yrs = (int *)calloc(1, sizeof(int))) == NULL) {
+            fprintf(stderr,"Error allocating space for disturbance_yrs\n");
+    		exit(EXIT_FAILURE);
+        }
+        figure_out_years_with_disturbances(c, sc->ma, p, &(sc->disturbance_yrs),
+                                           &(sc->num_disturbance_yrs));
+    }
+
+    /* day length, phenology drivers and sun positions repeat every year
+       (and every spin-up cycle) */
+    preprocess_forcing(c, sc->ma, p);
+    if (c->sub_daily)
+        build_solar_table(sc->cw, p);
+
+    c->day_idx = 0;
+    c->hour_idx = 0;
+    sc->nyr = 0;
+    sc->doy = 0;
+
+    /* only the first sim_init of a run (or spin-up) opens it */
+    open_telemetry(c);
+
+    if (c->checkpoint_interval > 0 &&
+        strcmp(c->checkpoint_fname, "*NOT SET*") == 0) {
+        fprintf(stderr, "Error: checkpoint_interval set without a "
+                "checkpoint_fname\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* only the first pass of a spin-up starts from the checkpoint */
+    if (c->restart) {
+        restore_checkpoint(sc, c->restart_fname);
+        c->restart = FALSE;
+    }
+
+    return;
+}
+
+int sim_step(sim_context *sc) {
+    /*
+        Advance the simulation by one day.
+
+        Returns:
+        --------
+        more : int
+            TRUE while there are days left to run, FALSE once the final day
+            of the met forcing has been simulated
+    */
+    control *c = sc->c;
+
+    if (sc->nyr >= c->num_years)
+        return (FALSE);
+
+    if (sc->doy == 0)
+        start_sim_year(sc);
+
+    TIMER_START(TIMER_DAY);
+    simulate_day(sc);
+    TIMER_STOP(TIMER_DAY);
+    sc->doy++;
+    if (c->telemetry != NULL)
+        telemetry_day(c, sc->cw);
+
+    if (sc->doy == c->num_days) {
+        end_sim_year(sc);
+        if (c->telemetry != NULL)
+            telemetry_year(sc);
+        sc->doy = 0;
+        sc->nyr++;
+
+        if (c->checkpoint_interval > 0 && c->spin_up == FALSE &&
+            sc->nyr % c->checkpoint_interval == 0 && sc->nyr < c->num_years)
+            write_checkpoint(sc, c->checkpoint_fname, TRUE);
+    }
+
+    return (sc->nyr < c->num_years);
+}
+
+void sim_finish(sim_context *sc) {
+    /* Undo the unit changes and write the final state if required */
+    control *c = sc->c;
+    double   rec[MAX_OUTPUT_VARS];
+
+    /* ========================= **
+    **   E N D   O F   Y E A R   **
+    ** ========================= */
+    correct_rate_constants(sc->p, TRUE);
+
+    /* a run that stops part way through an output period */
+    if (sc->accum != NULL && flush_output_accum(sc->accum, rec))
+        write_sim_outputs(sc, rec);
+
+    if (sc->writer != NULL) {
+        stop_output_writer(sc->writer);
+        sc->writer = NULL;
+    }
+    if (sc->columns != NULL) {
+        close_column_file(sc->columns);
+        sc->columns = NULL;
+    }
+    if (sc->accum != NULL) {
+        free_output_accum(sc->accum);
+        sc->accum = NULL;
+    }
+
+    if (c->print_options == END && c->spin_up == FALSE) {
+        write_final_state(c, sc->p, sc->s);
+    }
+
+    sma_free(&(sc->hw));
+    free(sc->day_length);
+    sc->day_length = NULL;
+    if (c->disturbance) {
+        free(sc->disturbance_yrs);
+        sc->disturbance_yrs = NULL;
+    }
+
+    return;
+}
+
+void start_sim_year(sim_context *sc) {
+    /* ====================== **
+    **   Y E A R    L O O P   **
+    ** ====================== */
+    control *c = sc->c;
+    params  *p = sc->p;
+    state   *s = sc->s;
+
+    if (c->sub_daily) {
+        if (sc->ma->stream != NULL)
+            advance_met_stream(sc->ma, c->hour_idx);
+        sc->year = sc->ma->year[c->hour_idx - sc->ma->row0];
+    } else {
+        sc->year = sc->ma->year[c->day_idx];
+    }
+    if (is_leap_year(sc->year))
+        c->num_days = 366;
+    else
+        c->num_days = 365;
+
+    get_daylength(sc->ma, p, c->num_days, sc->day_length);
+
+    if (c->deciduous_model) {
+        TIMER_START(TIMER_PHENOLOGY);
+        phenology(c, sc->f, sc->ma, p, s, sc->day_length,
+                  get_met_year(sc->ma, sc->nyr));
+        TIMER_STOP(TIMER_PHENOLOGY);
+
+        /* Change window size to length of growing season */
+        sma_reset(&(sc->hw), p->growing_seas_len);
+        if (s->prev_sma > -900) {
+            sma_fill(&(sc->hw), s->prev_sma, p->growing_seas_len);
+        }
+
+        zero_stuff(c, s);
+    }
+
+    return;
+}
+
+void simulate_day(sim_context *sc) {
+    /* =================== **
+    **   D A Y   L O O P   **
+    ** =================== */
+    control *c = sc->c;
+    fluxes  *f = sc->f;
+    met     *m = sc->m;
+    params  *p = sc->p;
+    state   *s = sc->s;
+    int      doy = sc->doy, dummy = 0;
+    int      fire_found = FALSE;
+    double   fdecay, rdecay, current_limitation;
+    double   rec[MAX_OUTPUT_VARS];
+
+    if (! c->sub_daily) {
+        unpack_met_data(c, sc->ma, m, dummy);
+    }
+    calculate_litterfall(c, f, p, s, doy, &fdecay, &rdecay);
+
+    if (c->disturbance && p->disturbance_doy == doy+1) {
+        /* Fire Disturbance? */
+        fire_found = FALSE;
+        fire_found = check_for_fire(c, f, p, s, sc->year, sc->disturbance_yrs,
+                                    sc->num_disturbance_yrs);
+
+        if (fire_found) {
+            fire(c, f, p, s);
+            sma_reset(&(sc->hw), p->growing_seas_len);
+        }
+    } else if (c->hurricane &&
+        p->hurricane_yr == sc->year &&
+        p->hurricane_doy == doy) {
+        /* Hurricane? */
+        hurricane(f, p, s);
+    }
+    TIMER_START(TIMER_DAY_GROWTH);
+    calc_day_growth(sc->cw, c, f, sc->ma, m, p, s, sc->day_length[doy],
+                    doy, fdecay, rdecay);
+    TIMER_STOP(TIMER_DAY_GROWTH);
+
+    TIMER_START(TIMER_CSOIL);
+    calculate_csoil_flows(c, f, p, s, m->tsoil, doy);
+    TIMER_STOP(TIMER_CSOIL);
+    TIMER_START(TIMER_NSOIL);
+    calculate_nsoil_flows(c, f, p, s, m->ndep, doy);
+    TIMER_STOP(TIMER_NSOIL);
+
+    /* update stress SMA */
+    if (c->deciduous_model && s->leaf_out_days[doy] > 0.0) {
+         /*Allocation is annually for deciduous "tree" model, but we
+           need to keep a check on stresses during the growing season
+           and the LAI figure out limitations during leaf growth period.
+           This also applies for deciduous grasses, need to do the
+           growth stress calc for grasses here too. */
+        current_limitation = calculate_growth_stress_limitation(p, s);
+        s->prev_sma = sma_add(&(sc->hw), current_limitation);
+    } else if (c->deciduous_model == FALSE) {
+        current_limitation = calculate_growth_stress_limitation(p, s);
+        s->prev_sma = sma_add(&(sc->hw), current_limitation);
+    }
+
+    /*
+        if grazing took place need to reset "stress" running mean
+        calculation for grasses
+    */
+    if (c->grazing == 2 && p->disturbance_doy == doy+1) {
+        sma_reset(&(sc->hw), p->growing_seas_len);
+    }
+
+    /* Turn off all N calculations */
+    if (c->ncycle == FALSE)
+        reset_all_n_pools_and_fluxes(f, s);
+
+    /* calculate C:N ratios and increment annual flux sum */
+    day_end_calculations(c, p, s, c->num_days, FALSE);
+
+    if (c->print_options == DAILY && c->spin_up == FALSE) {
+        TIMER_START(TIMER_OUTPUTS);
+        if (sc->accum != NULL) {
+            if (aggregate_daily_outputs(sc->accum, c, f, s, sc->year, doy+1,
+                                        rec))
+                write_sim_outputs(sc, rec);
+        } else if (sc->buffer != NULL) {
+            pack_daily_outputs(c, f, s, sc->year, doy+1, rec);
+            append_output_buffer(sc->buffer, rec);
+        } else if (sc->writer != NULL) {
+            queue_daily_outputs(sc->writer, c, f, s, sc->year, doy+1);
+        } else if (sc->columns != NULL) {
+            pack_daily_outputs(c, f, s, sc->year, doy+1, rec);
+            append_column_record(sc->columns, rec);
+        } else if (c->output_ascii) {
+            write_daily_outputs_ascii(c, f, s, sc->year, doy+1);
+        } else {
+            write_daily_outputs_binary(c, f, s, sc->year, doy+1);
+        }
+        TIMER_STOP(TIMER_OUTPUTS);
+    }
+    c->day_idx++;
+    /* ======================= **
+    **   E N D   O F   D A Y   **
+    ** ======================= */
+
+    return;
+}
+
+void end_sim_year(sim_context *sc) {
+    /* Allocate stored C&N for the following year */
+
+    if (sc->c->deciduous_model) {
+        calculate_average_alloc_fractions(sc->f, sc->s, sc->p->growing_seas_len);
+        allocate_stored_c_and_n(sc->f, sc->p, sc->s);
+    }
+
+    return;
+}
+
+void write_sim_outputs(sim_context *sc, const double *rec) {
+    /* Write a finished (aggregated) output record, via the writer if any */
+
+    if (sc->buffer != NULL)
+        append_output_buffer(sc->buffer, rec);
+    else if (sc->writer != NULL)
+        queue_output_record(sc->writer, rec);
+    else if (sc->columns != NULL)
+        append_column_record(sc->columns, rec);
+    else
+        write_output_record(sc->c, rec, sc->c->num_output_vars);
+
+    return;
+}
@@ -1,65 +1,100 @@
 /*
 Computes the simple moving average of a series of numbers.
-Taken from:
+Originally taken from:
     http://rosettacode.org/wiki/Averages/Simple_moving_average
+
+now a fixed capacity ring buffer, so the running mean of the growth stress
+doesn't allocate anything once the simulation is set up. The daily update
+(sma_add) is inline in the header.
 */
 
 
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
 
 #include "simple_moving_average.h"
 
-sma_result sma(enum Action action, ...)
-{
-     va_list vl;
-     sma_result r;
-     sma_obj *o;
-     double v;
-
-     va_start(vl, action);
-     switch(action) {
-     case SMA_NEW: // args: int period
-         r.handle = malloc(sizeof(sma_obj));
-         r.handle->sma = 0.0;
-         r.handle->period = va_arg(vl, int);
-         r.handle->values = malloc(r.handle->period * sizeof(double));
-         r.handle->lv = 0;
-         r.handle->sum = 0.0;
-         break;
-     case SMA_FREE: // args: sma_obj *handle
-         r.handle = va_arg(vl, sma_obj *);
-         free(r.handle->values);
-         free(r.handle);
-         r.handle = NULL;
-         break;
-     case SMA_VALUES: // args: sma_obj *handle
-         o = va_arg(vl, sma_obj *);
-         r.values = o->values;
-         break;
-     case SMA_MEAN: // args: sma_obj *handle
-         o = va_arg(vl, sma_obj *);
-         r.sma = o->sma;
-         break;
-     case SMA_ADD: // args: sma_obj *handle, double value
-         o = va_arg(vl, sma_obj *);
-         v = va_arg(vl, double);
-         if ( o->lv < o->period ) {
-             o->values[o->lv++] = v;
-             o->sum += v;
-             o->sma = o->sum / o->lv;
-         } else {
-             o->sum -= o->values[ o->lv % o->period];
-             o->sum += v;
-             o->sma = o->sum / o->period;
-             o->values[ o->lv % o->period ] = v; o->lv++;
-         }
-         r.sma = o->sma;
-         break;
-     }
-     va_end(vl);
-
-     return r;
+void sma_init(sma_obj *o, int capacity) {
+    /* Allocate room for windows of up to capacity values */
+    o->capacity = capacity < SMA_MIN_CAPACITY ? SMA_MIN_CAPACITY : capacity;
+    if ((o->values = (double *)malloc(o->capacity * sizeof(double))) == NULL) {
+        fprintf(stderr, "Error allocating space for running mean\n");
+        exit(EXIT_FAILURE);
+    }
+    sma_reset(o, capacity);
+
+    return;
+}
+
+void sma_free(sma_obj *o) {
+    free(o->values);
+    o->values = NULL;
+    o->capacity = 0;
+    o->period = 0;
+
+    return;
+}
+
+void sma_reset(sma_obj *o, int period) {
+    /*
+        Empty the window and set its length, only reallocating if it is
+        longer than anything seen so far
+    */
+    if (period < 1)
+        period = 1;
+
+    if (period > o->capacity) {
+        o->values = (double *)realloc(o->values, period * sizeof(double));
+        if (o->values == NULL) {
+            fprintf(stderr, "Error allocating space for running mean\n");
+            exit(EXIT_FAILURE);
+        }
+        o->capacity = period;
+    }
+    o->period = period;
+    o->sma = 0.0;
+    o->sum = 0.0;
+    o->lv = 0;
+    o->pos = 0;
+
+    return;
+}
+
+void sma_fill(sma_obj *o, double v, int n) {
+    /* Same as n calls to sma_add(o, v) */
+    int i;
+
+    if (o->lv != 0 || n > o->period) {
+        for (i = 0; i < n; i++) {
+            sma_add(o, v);
+        }
+        return;
+    }
+
+    /* filling an empty window, keep the additions in the same order */
+    for (i = 0; i < n; i++) {
+        o->values[i] = v;
+        o->sum += v;
+    }
+    if (n > 0) {
+        o->lv = n;
+        o->pos = (n == o->period) ? 0 : n;
+        o->sma = o->sum / n;
+    }
+
+    return;
+}
+
+void sma_restore(sma_obj *o, int period, int lv, double mean, double sum) {
+    /*
+        Put back a window saved in a checkpoint, the caller has reset it to
+        period and copied the values in
+    */
+    o->lv = lv;
+    o->pos = lv % period;
+    o->sma = mean;
+    o->sum = sum;
+
+    return;
 }
@@ -0,0 +1,201 @@
+/* ============================================================================
+* Soil pool transfer matrix.
+*
+* The CENTURY flows of soils.c between the 4 litter and 3 SOM pools are
+* first order in the donor pool with fixed partitioning, so a day's
+* decomposition is
+*
+*   out = k o C                  (C decomposed in each pool)
+*   C  += u + A out - out        (u the litter inputs)
+*
+* with A[i][j] the fraction of pool j's decomposed C that enters pool i,
+* the rest being respired. The pools are held as vectors in the state
+* (s->soil_cpool, s->soil_npool) in the p->decayrate order, and A and its N
+* counterpart depend only on ligshoot, ligroot and finesoil, so they're
+* built once at sim_init.
+*
+* The same matrix gives the steady state directly: with mean inputs u and
+* decay rates k, the mean outflows solve (I - A) out = u, and C = out / k,
+* which is what the accelerated spin-up jumps the pools to.
+*
+* References:
+* ----------
+* * Xia, J. Y., Luo, Y. Q., Wang, Y.-P., Weng, E. S., and Hararuk, O. (2012)
+*   A semi-analytical solution to accelerate spin-up of a coupled carbon
+*   and nitrogen land model to steady state, Geosci. Model Dev., 5,
+*   1259-1271.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "soil_matrix.h"
+
+
+void build_soil_transfer(control *c, params *p) {
+    /*
+        Transfer fractions between the soil pools. Rebuilt at every
+        sim_init, so it always matches params.
+    */
+    soil_transfer *tr = c->soil_tr;
+    /* Fraction of C lost due to microbial respiration */
+    double frac_microb_resp = 0.85 - (0.68 * p->finesoil);
+    double total;
+    int    i, j;
+
+    if (tr == NULL) {
+        if ((tr = (soil_transfer *)calloc(1, sizeof(soil_transfer))) == NULL) {
+            fprintf(stderr, "Error allocating space for soil transfer matrix\n");
+            exit(EXIT_FAILURE);
+        }
+        c->soil_tr = tr;
+    }
+    memset(tr, 0, sizeof(soil_transfer));
+
+    /* surface structural -> slow (lignin), the rest -> active */
+    tr->cfrac[SP_SLOW][SP_STRUCTSURF] = p->ligshoot * 0.7;
+    tr->cfrac[SP_ACTIVE][SP_STRUCTSURF] = (1.0 - p->ligshoot) * 0.55;
+    tr->resp[SP_STRUCTSURF] = p->ligshoot * 0.3 + (1.0 - p->ligshoot) * 0.45;
+
+    /* soil structural -> slow (lignin), the rest -> active */
+    tr->cfrac[SP_SLOW][SP_STRUCTSOIL] = p->ligroot * 0.7;
+    tr->cfrac[SP_ACTIVE][SP_STRUCTSOIL] = (1.0 - p->ligroot) * 0.45;
+    tr->resp[SP_STRUCTSOIL] = p->ligroot * 0.3 + (1.0 - p->ligroot) * 0.55;
+
+    /* metabolic -> active */
+    tr->cfrac[SP_ACTIVE][SP_METABSURF] = 0.45;
+    tr->resp[SP_METABSURF] = 0.55;
+    tr->cfrac[SP_ACTIVE][SP_METABSOIL] = 0.45;
+    tr->resp[SP_METABSOIL] = 0.55;
+
+    /* active -> slow & passive. (Parton 1993)
+       1.0 - frac_microb_resp - 0.003 - 0.032 * Claysoil to slow */
+    tr->cfrac[SP_SLOW][SP_ACTIVE] = 1.0 - frac_microb_resp - 0.004;
+    tr->cfrac[SP_PASSIVE][SP_ACTIVE] = 0.004;
+    tr->resp[SP_ACTIVE] = frac_microb_resp;
+
+    /* slow -> active & passive */
+    tr->cfrac[SP_ACTIVE][SP_SLOW] = 0.42;
+    tr->cfrac[SP_PASSIVE][SP_SLOW] = 0.03;
+    tr->resp[SP_SLOW] = 0.55;
+
+    /* passive -> active */
+    tr->cfrac[SP_ACTIVE][SP_PASSIVE] = 0.45;
+    tr->resp[SP_PASSIVE] = 0.55;
+
+    /* N leaves with the C at the source N:C, none of it is respired, i.e.
+       the C fractions renormalised over the receiving pools */
+    for (j = 0; j < NSOIL_POOLS; j++) {
+        total = 0.0;
+        for (i = 0; i < NSOIL_POOLS; i++)
+            total += tr->cfrac[i][j];
+        for (i = 0; i < NSOIL_POOLS; i++)
+            tr->nfrac[i][j] = total > 0.0 ? tr->cfrac[i][j] / total : 0.0;
+    }
+
+    return;
+}
+
+void free_soil_transfer(control *c) {
+
+    free(c->soil_tr);
+    c->soil_tr = NULL;
+
+    return;
+}
+
+void soil_transfer_flows(double a[NSOIL_POOLS][NSOIL_POOLS], double *out,
+                         double *in) {
+    /* flows into each pool, in = a out, given what left each pool */
+    int i, j;
+
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        in[i] = 0.0;
+        for (j = 0; j < NSOIL_POOLS; j++)
+            in[i] += a[i][j] * out[j];
+    }
+
+    return;
+}
+
+int soil_steady_state(soil_transfer *tr, double *u, double *k, int *held,
+                      double *pool) {
+    /*
+        Steady state of the soil C pools under constant litter inputs and
+        decay rates, by Gaussian elimination of (I - A) out = u.
+
+        Parameters:
+        -----------
+        u : double[NSOIL_POOLS]
+            mean litter (and any other external) C input to each pool
+        k : double[NSOIL_POOLS]
+            mean decay rate of each pool
+        held : int[NSOIL_POOLS]
+            TRUE for a pool to leave as it is (e.g. passiveconst), its
+            outflow k * pool is then simply an input to the others
+        pool : double[NSOIL_POOLS]
+            in: the current pools, out: the steady state
+
+        Returns:
+        --------
+        ok : int
+            FALSE, and pool untouched, if a pool that isn't held has no
+            decay, i.e. no steady state
+    */
+    double m[NSOIL_POOLS][NSOIL_POOLS + 1], factor, tmp;
+    int    i, j, r, piv;
+
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        if (held[i] == FALSE && !(k[i] > 0.0))
+            return (FALSE);
+        for (j = 0; j < NSOIL_POOLS; j++) {
+            m[i][j] = (i == j ? 1.0 : 0.0) - tr->cfrac[i][j];
+        }
+        m[i][NSOIL_POOLS] = u[i];
+        if (held[i]) {
+            /* out_i = k_i pool_i */
+            for (j = 0; j < NSOIL_POOLS; j++)
+                m[i][j] = (i == j ? 1.0 : 0.0);
+            m[i][NSOIL_POOLS] = k[i] * pool[i];
+        }
+    }
+
+    /* I - A is diagonally dominant by columns, as every column of A sums
+       to less than one, but pivot anyway */
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        piv = i;
+        for (r = i + 1; r < NSOIL_POOLS; r++) {
+            if (fabs(m[r][i]) > fabs(m[piv][i]))
+                piv = r;
+        }
+        if (m[piv][i] == 0.0)
+            return (FALSE);
+        if (piv != i) {
+            for (j = 0; j <= NSOIL_POOLS; j++) {
+                tmp = m[i][j];
+                m[i][j] = m[piv][j];
+                m[piv][j] = tmp;
+            }
+        }
+        for (r = i + 1; r < NSOIL_POOLS; r++) {
+            factor = m[r][i] / m[i][i];
+            for (j = i; j <= NSOIL_POOLS; j++)
+                m[r][j] -= factor * m[i][j];
+        }
+    }
+    for (i = NSOIL_POOLS - 1; i >= 0; i--) {
+        for (j = i + 1; j < NSOIL_POOLS; j++)
+            m[i][NSOIL_POOLS] -= m[i][j] * m[j][NSOIL_POOLS];
+        m[i][NSOIL_POOLS] /= m[i][i];
+    }
+
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        if (held[i] == FALSE)
+            pool[i] = MAX(0.0, m[i][NSOIL_POOLS]) / k[i];
+    }
+
+    return (TRUE);
+}
@@ -18,12 +18,12 @@
 *
 * =========================================================================== */
 #include "soils.h"
+#include "temp_response.h"
+#include "soil_matrix.h"
 
 void calculate_csoil_flows(control *c, fluxes *f, params *p, state *s,
                            double tsoil, int doy) {
     double lnleaf, lnroot, nc_leaf_litter;
-    /* Fraction of C lost due to microbial respiration */
-    double frac_microb_resp = 0.85 - (0.68 * p->finesoil);
 
     /* need to store grazing flag. Allows us to switch on the annual
        grazing event, but turn it off for every other day of the year.  */
@@ -32,7 +32,7 @@ void calculate_csoil_flows(control *c, fluxes *f, params *p, state *s,
         c->grazing = TRUE;
     }
 
-    soil_temp_factor(f, tsoil);
+    soil_temp_factor(c, f, tsoil);
 
     /* calculate model decay rates */
     calculate_decay_rates(f, p, s);
@@ -49,11 +49,7 @@ void calculate_csoil_flows(control *c, fluxes *f, params *p, state *s,
     /* input from faeces */
     flux_from_grazers(c, f, p);
     partition_plant_litter(f, p);
-    cfluxes_from_structural_pool(f, p, s);
-    cfluxes_from_metabolic_pool(f, p, s);
-    cfluxes_from_active_pool(f, p, s, frac_microb_resp);
-    cfluxes_from_slow_pool(f, p, s);
-    cfluxes_from_passive_pool(f, p, s);
+    cfluxes_from_soil_pools(c, f, p, s);
     calculate_soil_respiration(c, f, p, s);
 
     /* update the C pools */
@@ -175,7 +171,34 @@ void calculate_decay_rates(fluxes *f, params *p, state *s) {
     return;
 }
 
-void soil_temp_factor(fluxes *f, double tsoil) {
+void soil_temp_factor(control *c, fluxes *f, double tsoil) {
+    /*
+    Soil-temperature activity factor (A9), from the temperature response
+    table when there is one (temp_tables)
+
+    Parameters:
+    -----------
+    tsoil : double
+        soil temperature (deg C)
+
+    Returns:
+    --------
+    tfac : float
+        soil temperature factor [degC]
+
+    */
+
+    double fit;
+
+    if (tsoil > 0.0 && temp_lookup(c->temp_resp, TT_SOIL, tsoil, &fit))
+        f->tfac_soil_decomp = MAX(0.0, fit);
+    else
+        f->tfac_soil_decomp = soil_temp_response(tsoil);
+
+    return;
+}
+
+double soil_temp_response(double tsoil) {
     /*
     Soil-temperature activity factor (A9). Fit to Parton's fig 2a
 
@@ -190,19 +213,26 @@ void soil_temp_factor(fluxes *f, double tsoil) {
         soil temperature factor [degC]
 
     */
+    double tfac;
 
     if (tsoil > 0.0) {
-        f->tfac_soil_decomp = (0.0326 + 0.00351 * pow(tsoil, 1.652) -
-                                pow((tsoil / 41.748), 7.19));
-        if (f->tfac_soil_decomp < 0.0)
-        f->tfac_soil_decomp = 0.0;
+        tfac = soil_temp_fit(tsoil);
+        if (tfac < 0.0)
+            tfac = 0.0;
     } else {
         /* negative number cannot be raised to a fractional power
            number would need to be complex */
-        f->tfac_soil_decomp = 0.0;
+        tfac = 0.0;
     }
 
-    return;
+    return (tfac);
+}
+
+double soil_temp_fit(double tsoil) {
+    /* Parton's fit for tsoil > 0, before it is clipped at zero */
+
+    return (0.0326 + 0.00351 * pow(tsoil, 1.652) -
+            pow((tsoil / 41.748), 7.19));
 }
 
 void flux_from_grazers(control *c, fluxes *f, params *p) {
@@ -345,105 +375,61 @@ void partition_plant_litter(fluxes *f, params *p) {
     /* ...to the metabolic pool */
     f->soil_metab_litter = f->deadroots * p->fmroot;
 
-    return;
-}
-
-void cfluxes_from_structural_pool(fluxes *f, params *p, state *s) {
-
-    /* C fluxes from structural pools */
-
-    double structout_surf = s->structsurf * p->decayrate[0];
-    double structout_soil = s->structsoil * p->decayrate[2];
-
-    /* C flux surface structural pool -> slow pool */
-    f->surf_struct_to_slow = structout_surf * p->ligshoot * 0.7;
-
-    /* C flux surface structural pool -> active pool */
-    f->surf_struct_to_active = structout_surf * (1.0 - p->ligshoot) * 0.55;
-
-    /* C flux soil structural pool -> slow pool */
-    f->soil_struct_to_slow = structout_soil * p->ligroot * 0.7;
-
-    /* soil structural pool -> active pool */
-    f->soil_struct_to_active = structout_soil * (1.0 - p->ligroot) * 0.45;
-
-
-    /* Respiration fluxes */
-
-    /* CO2 lost during transfer of structural C to the slow pool */
-    f->co2_to_air[0] = (structout_surf *
-                        (p->ligshoot * 0.3 + (1.0 - p->ligshoot) * 0.45));
-
-    /* CO2 lost during transfer structural C  to the active pool */
-    f->co2_to_air[1] = (structout_soil *
-                        (p->ligroot * 0.3 + (1.0 - p->ligroot) * 0.55));
-
-    return;
-}
-
-void cfluxes_from_metabolic_pool(fluxes *f, params *p, state *s) {
-    /* C fluxes from metabolic pools */
-
-    /* C flux surface metabolic pool -> active pool */
-    f->surf_metab_to_active = s->metabsurf * p->decayrate[1] * 0.45;
-
-    /* C flux soil metabolic pool  -> active pool */
-    f->soil_metab_to_active = s->metabsoil * p->decayrate[3] * 0.45;
-
-    /* Respiration fluxes */
-    f->co2_to_air[2] = s->metabsurf * p->decayrate[1] * 0.55;
-    f->co2_to_air[3] = s->metabsoil * p->decayrate[3] * 0.55;
-
-    return;
-}
-
-void cfluxes_from_active_pool(fluxes *f, params *p, state *s,
-                              double frac_microb_resp) {
-    /* C fluxes from active pools */
-
-    double activeout = s->activesoil * p->decayrate[4];
-
-    /* C flux active pool -> slow pool */
-    f->active_to_slow = activeout * (1.0 - frac_microb_resp - 0.004);
-
-    /* (Parton 1993)
-    f->active_to_slow = (activeout * (1.0 - frac_microb_resp - 0.003 -
-                         0.032 * Claysoil));
-    */
-
-    /* C flux active pool -> passive pool */
-    f->active_to_passive = activeout * 0.004;
-
-    /* Respiration fluxes */
-    f->co2_to_air[4] = activeout * frac_microb_resp;
+    f->soil_litter_c[SP_STRUCTSURF] = f->surf_struct_litter;
+    f->soil_litter_c[SP_METABSURF] = f->surf_metab_litter;
+    f->soil_litter_c[SP_STRUCTSOIL] = f->soil_struct_litter;
+    f->soil_litter_c[SP_METABSOIL] = f->soil_metab_litter;
+    f->soil_litter_c[SP_ACTIVE] = 0.0;
+    f->soil_litter_c[SP_SLOW] = 0.0;
+    f->soil_litter_c[SP_PASSIVE] = 0.0;
 
     return;
 }
 
-void cfluxes_from_slow_pool(fluxes *f, params *p, state *s) {
-    /* C fluxes from slow pools */
+void cfluxes_from_soil_pools(control *c, fluxes *f, params *p, state *s) {
+    /* C decomposed in each soil pool and where it goes, i.e. the soil
+       pools times the transfer matrix (soil_matrix.c) */
+    soil_transfer *tr = c->soil_tr;
+    double        *out = f->soil_c_out;
+    int            i;
 
-    double slowout = s->slowsoil * p->decayrate[5];
-
-    /* C flux slow pool -> active pool */
-    f->slow_to_active = slowout * 0.42;
-
-    /* slow pool -> passive pool */
-    f->slow_to_passive = slowout * 0.03;
-
-    /* Respiration fluxes */
-    f->co2_to_air[5] = slowout * 0.55;
-
-    return;
-}
-
-void cfluxes_from_passive_pool(fluxes *f, params *p, state *s) {
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        out[i] = s->soil_cpool[i] * p->decayrate[i];
+    }
+    soil_transfer_flows(tr->cfrac, out, f->soil_c_in);
+
+    /* the individual flows, for the output */
+    f->surf_struct_to_slow = tr->cfrac[SP_SLOW][SP_STRUCTSURF] *
+                             out[SP_STRUCTSURF];
+    f->surf_struct_to_active = tr->cfrac[SP_ACTIVE][SP_STRUCTSURF] *
+                               out[SP_STRUCTSURF];
+    f->soil_struct_to_slow = tr->cfrac[SP_SLOW][SP_STRUCTSOIL] *
+                             out[SP_STRUCTSOIL];
+    f->soil_struct_to_active = tr->cfrac[SP_ACTIVE][SP_STRUCTSOIL] *
+                               out[SP_STRUCTSOIL];
+    f->surf_metab_to_active = tr->cfrac[SP_ACTIVE][SP_METABSURF] *
+                              out[SP_METABSURF];
+    f->soil_metab_to_active = tr->cfrac[SP_ACTIVE][SP_METABSOIL] *
+                              out[SP_METABSOIL];
+    f->active_to_slow = tr->cfrac[SP_SLOW][SP_ACTIVE] * out[SP_ACTIVE];
+    f->active_to_passive = tr->cfrac[SP_PASSIVE][SP_ACTIVE] * out[SP_ACTIVE];
+    f->slow_to_active = tr->cfrac[SP_ACTIVE][SP_SLOW] * out[SP_SLOW];
+    f->slow_to_passive = tr->cfrac[SP_PASSIVE][SP_SLOW] * out[SP_SLOW];
+    f->passive_to_active = tr->cfrac[SP_ACTIVE][SP_PASSIVE] * out[SP_PASSIVE];
 
-    /* C flux passive pool -> active pool */
-    f->passive_to_active = s->passivesoil * p->decayrate[6] * 0.45;
+    /* store the C SOM fluxes for Nitrogen calculations */
+    f->c_into_active = f->soil_c_in[SP_ACTIVE];
+    f->c_into_slow = f->soil_c_in[SP_SLOW];
+    f->c_into_passive = f->soil_c_in[SP_PASSIVE];
 
     /* Respiration fluxes */
-    f->co2_to_air[6] = s->passivesoil * p->decayrate[6] * 0.55;
+    f->co2_to_air[0] = tr->resp[SP_STRUCTSURF] * out[SP_STRUCTSURF];
+    f->co2_to_air[1] = tr->resp[SP_STRUCTSOIL] * out[SP_STRUCTSOIL];
+    f->co2_to_air[2] = tr->resp[SP_METABSURF] * out[SP_METABSURF];
+    f->co2_to_air[3] = tr->resp[SP_METABSOIL] * out[SP_METABSOIL];
+    f->co2_to_air[4] = tr->resp[SP_ACTIVE] * out[SP_ACTIVE];
+    f->co2_to_air[5] = tr->resp[SP_SLOW] * out[SP_SLOW];
+    f->co2_to_air[6] = tr->resp[SP_PASSIVE] * out[SP_PASSIVE];
 
     return;
 }
@@ -461,8 +447,7 @@ void calculate_soil_respiration(control *c, fluxes *f, params *p, state *s) {
        assuming a fixed passive pool */
     if (c->passiveconst == TRUE) {
         f->hetero_resp = (f->hetero_resp + f->active_to_passive +
-                          f->slow_to_passive - s->passivesoil *
-                          p->decayrate[6]);
+                          f->slow_to_passive - f->soil_c_out[SP_PASSIVE]);
     }
 
     return;
@@ -470,42 +455,14 @@ void calculate_soil_respiration(control *c, fluxes *f, params *p, state *s) {
 
 void calculate_cpools(fluxes *f, state *s) {
     /* Calculate new soil carbon pools. */
+    int i;
 
-    /* Update pools */
-    s->structsurf += (f->surf_struct_litter -
-                     (f->surf_struct_to_slow + f->surf_struct_to_active +
-                      f->co2_to_air[0]));
-
-    s->structsoil += (f->soil_struct_litter -
-                     (f->soil_struct_to_slow + f->soil_struct_to_active +
-                      f->co2_to_air[1]));
-
-    s->metabsurf += (f->surf_metab_litter -
-                     (f->surf_metab_to_active + f->co2_to_air[2]));
-
-    s->metabsoil += (f->soil_metab_litter -
-                     (f->soil_metab_to_active + f->co2_to_air[3]));
-
-    /* store the C SOM fluxes for Nitrogen calculations */
-    f->c_into_active = (f->surf_struct_to_active + f->soil_struct_to_active +
-                        f->surf_metab_to_active + f->soil_metab_to_active +
-                        f->slow_to_active + f->passive_to_active);
-
-    f->c_into_slow = (f->surf_struct_to_slow + f->soil_struct_to_slow +
-                      f->active_to_slow);
-
-    f->c_into_passive = f->active_to_passive + f->slow_to_passive;
-
-    s->activesoil += (f->c_into_active -
-                      (f->active_to_slow + f->active_to_passive +
-                       f->co2_to_air[4]));
-
-    s->slowsoil += (f->c_into_slow -
-                    (f->slow_to_active + f->slow_to_passive +
-                     f->co2_to_air[5]));
-
-    s->passivesoil += (f->c_into_passive -
-                        (f->passive_to_active + f->co2_to_air[6]));
+    /* Update pools, litter in, decomposed C from the other pools in and
+       all of this pool's decomposed C out */
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        s->soil_cpool[i] += (f->soil_litter_c[i] + f->soil_c_in[i] -
+                             f->soil_c_out[i]);
+    }
 
     /*
       When nothing is being added to the metabolic pools, there is the
@@ -553,8 +510,6 @@ void calculate_nsoil_flows(control *c, fluxes *f, params *p, state *s,
         c->grazing = TRUE;
     }
 
-    /* Fraction of C lost due to microbial respiration */
-    double frac_microb_resp = 0.85 - (0.68 * p->finesoil);
     double nsurf, nsoil, active_nc_slope, slow_nc_slope, passive_nc_slope;
 
     grazer_inputs(c, f, p);
@@ -563,11 +518,7 @@ void calculate_nsoil_flows(control *c, fluxes *f, params *p, state *s,
 
     /* SOM nitrogen effluxes.  These are assumed to have the source n:c
        ratio prior to the increase of N:C due to co2 evolution. */
-    nfluxes_from_structural_pools(f, p, s);
-    nfluxes_from_metabolic_pool(f, p, s);
-    nfluxes_from_active_pool(f, p, s, frac_microb_resp);
-    nfluxes_from_slow_pool(f, p, s);
-    nfluxes_from_passive_pool(f, p, s);
+    nfluxes_from_soil_pools(c, f, p, s);
 
     /* gross N mineralisation */
     calculate_n_mineralisation(f);
@@ -771,81 +722,32 @@ void partition_plant_litter_n(control *c, fluxes *f, params *p, double nsurf,
     return;
 }
 
-void nfluxes_from_structural_pools(fluxes *f, params *p, state *s) {
-    /* from structural pool */
-    double sigwt;
-    double structout_surf = s->structsurfn * p->decayrate[0];
-    double structout_soil = s->structsoiln * p->decayrate[2];
-
-    sigwt = structout_surf / (p->ligshoot * 0.7 + (1.0 - p->ligshoot) * 0.55);
+void nfluxes_from_soil_pools(control *c, fluxes *f, params *p, state *s) {
+    /* N leaving each soil pool with the decomposed C, split between the
+       receiving pools by the N transfer matrix (soil_matrix.c) */
+    soil_transfer *tr = c->soil_tr;
+    double        *out = f->soil_n_out;
+    int            i;
 
-    /* N flux from surface structural pool -> slow pool */
-    f->n_surf_struct_to_slow = sigwt * p->ligshoot * 0.7;
-
-    /* N flux surface structural pool -> active pool */
-    f->n_surf_struct_to_active = sigwt * (1.0 - p->ligshoot) * 0.55;
-
-    sigwt = structout_soil / (p->ligroot * 0.7 + (1. - p->ligroot) * 0.45);
-
-
-    /* N flux from soil structural pool -> slow pool */
-    f->n_soil_struct_to_slow = sigwt * p->ligroot * 0.7;
-
-    /* N flux from soil structural pool -> active pool */
-    f->n_soil_struct_to_active = sigwt * (1.0 - p->ligroot) * 0.45;
-
-    return;
-}
-
-void nfluxes_from_metabolic_pool(fluxes *f, params *p, state *s) {
-
-    /* N flux surface metabolic pool -> active pool */
-    f->n_surf_metab_to_active = s->metabsurfn * p->decayrate[1];
-
-    /* N flux soil metabolic pool  -> active pool */
-    f->n_soil_metab_to_active = s->metabsoiln * p->decayrate[3];
-
-    return;
-}
-
-
-void nfluxes_from_active_pool(fluxes *f, params *p, state *s,
-                              double frac_microb_resp) {
-
-    double activeout, sigwt;
-    /* N fluxes from active pool */
-    activeout = s->activesoiln * p->decayrate[4];
-    sigwt = activeout / (1.0 - frac_microb_resp);
-
-    /* N flux active pool -> slow pool */
-    f->n_active_to_slow = sigwt * (1.0 - frac_microb_resp - 0.004);
-
-    /* N flux active pool -> passive pool */
-    f->n_active_to_passive = sigwt * 0.004;
-
-    return;
-}
-
-void nfluxes_from_slow_pool(fluxes *f, params *p, state *s) {
-    /* N fluxes from slow pools */
-
-    double slowout = s->slowsoiln * p->decayrate[5];
-    double sigwt = slowout / 0.45;
-
-    /* C flux slow pool -> active pool */
-    f->n_slow_to_active = sigwt * 0.42;
-
-    /* slow pool -> passive pool */
-    f->n_slow_to_passive = sigwt * 0.03;
-
-    return;
-}
-
-void nfluxes_from_passive_pool(fluxes *f, params *p, state *s) {
-    /* N fluxes from passive pool */
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        out[i] = s->soil_npool[i] * p->decayrate[i];
+    }
 
-    /* C flux passive pool -> active pool */
-    f->n_passive_to_active = s->passivesoiln * p->decayrate[6];
+    f->n_surf_struct_to_slow = tr->nfrac[SP_SLOW][SP_STRUCTSURF] *
+                               out[SP_STRUCTSURF];
+    f->n_surf_struct_to_active = tr->nfrac[SP_ACTIVE][SP_STRUCTSURF] *
+                                 out[SP_STRUCTSURF];
+    f->n_soil_struct_to_slow = tr->nfrac[SP_SLOW][SP_STRUCTSOIL] *
+                               out[SP_STRUCTSOIL];
+    f->n_soil_struct_to_active = tr->nfrac[SP_ACTIVE][SP_STRUCTSOIL] *
+                                 out[SP_STRUCTSOIL];
+    f->n_surf_metab_to_active = out[SP_METABSURF];
+    f->n_soil_metab_to_active = out[SP_METABSOIL];
+    f->n_active_to_slow = tr->nfrac[SP_SLOW][SP_ACTIVE] * out[SP_ACTIVE];
+    f->n_active_to_passive = tr->nfrac[SP_PASSIVE][SP_ACTIVE] * out[SP_ACTIVE];
+    f->n_slow_to_active = tr->nfrac[SP_ACTIVE][SP_SLOW] * out[SP_SLOW];
+    f->n_slow_to_passive = tr->nfrac[SP_PASSIVE][SP_SLOW] * out[SP_SLOW];
+    f->n_passive_to_active = out[SP_PASSIVE];
 
     return;
 }
@@ -990,7 +892,7 @@ void calculate_npools(control *c, fluxes *f, params *p, state *s,
     */
     double n_into_active, n_out_of_active, n_into_slow, n_out_of_slow,
            n_into_passive, n_out_of_passive, arg, active_nc, fixn, slow_nc,
-           pass_nc;
+           pass_nc, n_in[NSOIL_POOLS];
 
     /*
         net N release implied by separation of litter into structural
@@ -1002,12 +904,8 @@ void calculate_npools(control *c, fluxes *f, params *p, state *s,
        each call to nc_limit and stored in f->nlittrelease */
     f->nlittrelease = 0.0;
 
-    s->structsurfn += (f->n_surf_struct_litter -
-                        (f->n_surf_struct_to_slow +
-                         f->n_surf_struct_to_active));
-
-    s->structsoiln += (f->n_soil_struct_litter -
-                       (f->n_soil_struct_to_slow + f->n_soil_struct_to_active));
+    s->structsurfn += f->n_surf_struct_litter - f->soil_n_out[SP_STRUCTSURF];
+    s->structsoiln += f->n_soil_struct_litter - f->soil_n_out[SP_STRUCTSOIL];
 
     if (c->strfloat == FALSE) {
         s->structsurfn += nc_limit(f, s->structsurf, s->structsurfn,
@@ -1016,9 +914,9 @@ void calculate_npools(control *c, fluxes *f, params *p, state *s,
                                    1.0/p->structcn, 1.0/p->structcn);
     }
 
-    s->metabsurfn += f->n_surf_metab_litter - f->n_surf_metab_to_active;
+    s->metabsurfn += f->n_surf_metab_litter - f->soil_n_out[SP_METABSURF];
     s->metabsurfn += nc_limit(f, s->metabsurf, s->metabsurfn,1.0/25.0, 1.0/10.0);
-    s->metabsoiln += (f->n_soil_metab_litter - f->n_soil_metab_to_active);
+    s->metabsoiln += f->n_soil_metab_litter - f->soil_n_out[SP_METABSOIL];
     s->metabsoiln += nc_limit(f, s->metabsoil, s->metabsoiln, 1.0/25.0,
                               1.0/10.0);
 
@@ -1029,18 +927,13 @@ void calculate_npools(control *c, fluxes *f, params *p, state *s,
     precision_control_soil_n(f, s);
 
     /* Update SOM pools */
-    n_into_active = (f->n_surf_struct_to_active + f->n_soil_struct_to_active +
-                     f->n_surf_metab_to_active + f->n_soil_metab_to_active +
-                     f->n_slow_to_active + f->n_passive_to_active);
-
-    n_out_of_active = f->n_active_to_slow + f->n_active_to_passive;
-
-    n_into_slow = (f->n_surf_struct_to_slow + f->n_soil_struct_to_slow +
-                   f->n_active_to_slow);
-
-    n_out_of_slow = f->n_slow_to_active + f->n_slow_to_passive;
-    n_into_passive = f->n_active_to_passive + f->n_slow_to_passive;
-    n_out_of_passive = f->n_passive_to_active;
+    soil_transfer_flows(c->soil_tr->nfrac, f->soil_n_out, n_in);
+    n_into_active = n_in[SP_ACTIVE];
+    n_out_of_active = f->soil_n_out[SP_ACTIVE];
+    n_into_slow = n_in[SP_SLOW];
+    n_out_of_slow = f->soil_n_out[SP_SLOW];
+    n_into_passive = n_in[SP_PASSIVE];
+    n_out_of_passive = f->soil_n_out[SP_PASSIVE];
 
     /* N:C of the SOM pools increases linearly btw prescribed min and max
        values as the Nconc of the soil increases. */
@@ -1160,12 +1053,14 @@ void precision_control_soil_n(fluxes *f, state *s) {
     if (s->metabsurfn < tolerance) {
         excess = s->metabsurfn;
         f->n_surf_metab_to_active = excess;
+        f->soil_n_out[SP_METABSURF] = excess;
         s->metabsurfn = 0.0;
     }
 
     if (s->metabsoiln < tolerance) {
         excess = s->metabsoiln;
         f->n_soil_metab_to_active = excess;
+        f->soil_n_out[SP_METABSOIL] = excess;
         s->metabsoiln = 0.0;
     }
 
@@ -0,0 +1,323 @@
+/* ============================================================================
+* Spin up the model plant & soil pools to equilibrium.
+*
+* The met forcing is cycled until plant and soil C stop changing. What used
+* to be a fixed scheme (test only every 20 cycles, i.e. every 1000 years of
+* 50 yr forcing) is now set by three [control] options,
+*
+*   spinup_check_interval - cycles between convergence tests (default 20)
+*   spinup_extrapolate    - project the change over the test window from
+*                           the trend between tests rather than waiting to
+*                           simulate it (default false)
+*   spinup_accelerate     - jump the SOM pools to the steady state of the
+*                           soil transfer matrix (default false)
+*
+* The defaults reproduce the original spin-up exactly.
+*
+* NOTES:
+*   Each cycle is a full run_sim, i.e. soil water, LAI and the stress
+*   running mean are reset at the start of each pass through the forcing,
+*   as they always have been.
+*
+* References:
+* ----------
+* * Murty, D and McMurtrie, R. E. (2000) Ecological Modelling, 134,
+*   185-205, specifically page 196.
+* * Xia, J. Y., Luo, Y. Q., Wang, Y.-P., Weng, E. S., and Hararuk, O. (2012)
+*   A semi-analytical solution to accelerate spin-up of a coupled carbon
+*   and nitrogen land model to steady state, Geosci. Model Dev., 5,
+*   1259-1271.
+*
+* AUTHOR:
+*   Martin De Kauwe
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "spinup.h"
+#include "checkpoint.h"
+#include "spinup_library.h"
+#include "telemetry.h"
+
+void spin_up_pools(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma, met *m,
+                   params *p, state *s){
+    /* Spin up model plant & soil pools to equilibrium.
+
+    - Examine sequences of 50 years and check if C pools are changing
+      by more than 0.005 units per 1000 yrs. Note this check is done in
+      units of: kg m-2.
+    */
+    double tol = 5E-03;
+    double prev_plantc = 99999.9;
+    double prev_soilc = 99999.9;
+    double dplantc, dsoilc, prev_dplantc = 0.0, prev_dsoilc = 0.0;
+    double plantc_drift, soilc_drift, cycle_plantc, cycle_soilc;
+    double jump = 0.0;
+    int i, cntrl_flag, ncycles = 0, nblocks, accelerating, converged;
+    int njumps = 0;
+    int interval = MAX(1, c->spinup_check_interval);
+    int use_library = (strcmp(c->spinup_library, "*NOT SET*") != 0);
+    char library_fname[STRING_LENGTH];
+    uint64_t key = 0;
+    spinup_fluxes acc;
+    sim_context sc;
+    /* check for convergences in units of kg/m2 */
+    double conv = TONNES_HA_2_KG_M2;
+
+    /* Final state + param file, a host driving libgday may just want the
+       spun up state left in memory */
+    if (strcmp(c->out_param_fname, "*NOT SET*") != 0)
+        open_output_file(c, c->out_param_fname, &(c->ofp));
+
+    /* Has this exact spin-up been done before? */
+    if (use_library) {
+        key = spinup_state_key(c, p, s);
+        if (load_spinup_state(c, p, s, f, key)) {
+            if (strcmp(c->checkpoint_fname, "*NOT SET*") != 0) {
+                attach_sim_context(&sc, cw, c, f, ma, m, p, s);
+                write_checkpoint(&sc, c->checkpoint_fname, FALSE);
+            }
+            if (c->ofp != NULL)
+                write_final_state(c, p, s);
+            return;
+        }
+    }
+
+    /* If we are prescribing disturbance, first allow the forest to establish */
+    if (c->disturbance) {
+        cntrl_flag = c->disturbance;
+        c->disturbance = FALSE;
+        /*  200 years (50 yrs x 4 cycles) */
+        for (i = 0; i < 4; i++) {
+            run_sim(cw, c, f, ma, m, p, s); /* run GDAY */
+        }
+        c->disturbance = cntrl_flag;
+    }
+
+    fprintf(stderr, "Spinning up the model...\n");
+    accelerating = c->spinup_accelerate;
+    while (TRUE) {
+        prev_plantc = s->plantc;
+        prev_soilc = s->soilc;
+
+        for (i = 0; i < interval; i++) {
+            cycle_plantc = s->plantc;
+            cycle_soilc = s->soilc;
+            if (c->telemetry != NULL)
+                c->telemetry->cycle = ncycles + i + 1;
+            run_spinup_cycle(cw, c, f, ma, m, p, s, &acc); /* run GDAY */
+            telemetry_spinup_cycle(c, s, ncycles + i + 1,
+                                   s->plantc - cycle_plantc,
+                                   s->soilc - cycle_soilc);
+        }
+        ncycles += interval;
+
+        fprintf(stderr,
+          "Spinup: Plant C - %f, Soil C - %f, Plant N - %f, Soil N - %f\n",
+           s->plantc, s->soilc, s->plantn, s->soiln);
+
+        /* Have we reached a steady state? */
+        dplantc = s->plantc - prev_plantc;
+        dsoilc = s->soilc - prev_soilc;
+        plantc_drift = project_spinup_drift(dplantc, prev_dplantc, interval,
+                                            c->spinup_extrapolate);
+        soilc_drift = project_spinup_drift(dsoilc, prev_dsoilc, interval,
+                                           c->spinup_extrapolate);
+        converged = (fabs(plantc_drift * conv) < tol &&
+                     fabs(soilc_drift * conv) < tol);
+        telemetry_spinup_test(c, ncycles, plantc_drift * conv,
+                              soilc_drift * conv, tol, converged);
+        if (converged)
+            break;
+
+        prev_dplantc = dplantc;
+        prev_dsoilc = dsoilc;
+        if (accelerating && njumps > 0 && dsoilc * jump < 0.0) {
+            /* the model pulled the soil back against the last jump, so that
+               overshot, and jumping again would only repeat it */
+            accelerating = FALSE;
+        }
+        if (accelerating) {
+            accelerating = accelerate_soil_pools(c, s, &acc, &jump);
+            njumps++;
+            /* stop once there is little left to gain */
+            if (fabs(jump * conv) < tol || njumps >= SPINUP_MAX_JUMPS)
+                accelerating = FALSE;
+            /* the next test starts after the jump, and the jump says
+               nothing about the trend */
+            prev_dplantc = 0.0;
+            prev_dsoilc = 0.0;
+        }
+    }
+
+    if (interval != SPINUP_WINDOW || c->spinup_extrapolate ||
+        c->spinup_accelerate) {
+        /* testing every 1000 years, we'd have got this far at the earliest
+           at the next block boundary and then needed to confirm it */
+        nblocks = (ncycles + SPINUP_WINDOW - 1) / SPINUP_WINDOW;
+        if (nblocks * SPINUP_WINDOW == ncycles)
+            nblocks++;
+        fprintf(stderr, "Spinup: converged after %d years (%d cycles), "
+                "at least %d years fewer than 1000 yr blocks\n",
+                ncycles * c->num_years, ncycles,
+                (nblocks * SPINUP_WINDOW - ncycles) * c->num_years);
+    } else {
+        /* the benchmark counts the simulated days from this */
+        fprintf(stderr, "Spinup: converged after %d years (%d cycles)\n",
+                ncycles * c->num_years, ncycles);
+    }
+    if (strcmp(c->checkpoint_fname, "*NOT SET*") != 0) {
+        /* full precision copy of the spun up state */
+        attach_sim_context(&sc, cw, c, f, ma, m, p, s);
+        write_checkpoint(&sc, c->checkpoint_fname, FALSE);
+    }
+    if (use_library) {
+        /* the directory may well exist already */
+        mkdir(c->spinup_library, 0755);
+        spinup_library_fname(c, key, library_fname);
+        attach_sim_context(&sc, cw, c, f, ma, m, p, s);
+        write_checkpoint(&sc, library_fname, FALSE);
+        fprintf(stderr, "Spinup: saved spun up state to %s\n", library_fname);
+    }
+    if (c->ofp != NULL)
+        write_final_state(c, p, s);
+
+    return;
+}
+
+void run_spinup_cycle(canopy_wk *cw, control *c, fluxes *f, met_arrays *ma,
+                      met *m, params *p, state *s, spinup_fluxes *acc) {
+    /*
+        One pass through the met forcing, as run_sim, also summing the soil
+        pool inputs, decomposition and sizes for accelerate_soil_pools
+    */
+    sim_context sc;
+    int         i, more;
+
+    memset(acc, 0, sizeof(spinup_fluxes));
+
+    attach_sim_context(&sc, cw, c, f, ma, m, p, s);
+
+    sim_init(&sc);
+    do {
+        more = sim_step(&sc);
+
+        for (i = 0; i < NSOIL_POOLS; i++) {
+            acc->litter_in[i] += f->soil_litter_c[i];
+            acc->decomposed[i] += f->soil_c_out[i];
+            acc->pool[i] += s->soil_cpool[i];
+        }
+        if (c->exudation)
+            acc->litter_in[SP_ACTIVE] += f->root_exc * f->rexc_cue;
+        acc->ndays++;
+    } while (more);
+    sim_finish(&sc);
+
+    return;
+}
+
+double project_spinup_drift(double delta, double prev_delta, int interval,
+                            int extrapolate) {
+    /*
+        Change in a pool we expect over the SPINUP_WINDOW cycles the
+        convergence test is defined for, given the change over the last
+        interval cycles.
+
+        Parameters:
+        -----------
+        delta : double
+            change over the last interval cycles
+        prev_delta : double
+            change over the interval before that, 0.0 if unknown
+        interval : int
+            cycles between tests
+        extrapolate : int
+            assume the pool is relaxing geometrically towards its steady
+            state, rather than drifting at its current rate
+
+        Returns:
+        --------
+        drift : double
+            projected change over SPINUP_WINDOW cycles
+    */
+    double ntests = (double)SPINUP_WINDOW / (double)interval;
+    double ratio;
+
+    if (extrapolate && prev_delta != 0.0) {
+        ratio = delta / prev_delta;
+        if (ratio > 0.0 && ratio < 1.0) {
+            /* sum of the geometric series over the next ntests tests */
+            return (delta * ratio * (1.0 - pow(ratio, ntests)) / (1.0 - ratio));
+        }
+    }
+
+    return (delta * ntests);
+}
+
+int accelerate_soil_pools(control *c, state *s, spinup_fluxes *acc,
+                          double *jump) {
+    /*
+        Semi-analytic spin-up of the SOM pools. With the mean litter inputs
+        and decay rates of the last cycle the steady state of all the soil
+        pools follows from the transfer matrix in one solve (see
+        soil_matrix.c), including the C that cycles active -> slow ->
+        active and on through the passive pool. The decay rate of each pool
+        is taken as its decomposition over the cycle over its mean size,
+        so the seasonal covariance of pool and rate is kept.
+
+        The steady state is of the pools' mean over a cycle, so the active,
+        slow and passive pools (and their N, at the current N:C) are scaled
+        by the ratio of that to their mean over the last cycle, which keeps
+        them at the same point in their seasonal cycle. The litter pools
+        equilibrate within a cycle anyway, and are left as they are.
+
+        Returns:
+        --------
+        jumped : int
+            FALSE if there is no steady state to jump to
+        jump : double
+            change in soil C (t/ha) the jump made
+    */
+    double u[NSOIL_POOLS], k[NSOIL_POOLS], eq[NSOIL_POOLS], ratio;
+    double prev_soilc = s->soilc;
+    int    held[NSOIL_POOLS], i;
+
+    *jump = 0.0;
+    if (acc->ndays == 0 || c->soil_tr == NULL)
+        return (FALSE);
+
+    for (i = 0; i < NSOIL_POOLS; i++) {
+        u[i] = acc->litter_in[i] / acc->ndays;
+        k[i] = acc->pool[i] > 0.0 ? acc->decomposed[i] / acc->pool[i] : 0.0;
+        eq[i] = acc->pool[i] / acc->ndays;
+        /* an empty pool says nothing about its decay rate */
+        held[i] = !(k[i] > 0.0);
+    }
+    /* passive pool is held fixed with passiveconst */
+    if (c->passiveconst)
+        held[SP_PASSIVE] = TRUE;
+
+    if (! soil_steady_state(c->soil_tr, u, k, held, eq))
+        return (FALSE);
+
+    for (i = SP_ACTIVE; i <= SP_PASSIVE; i++) {
+        if (held[i] || acc->pool[i] <= 0.0)
+            continue;
+        ratio = eq[i] / (acc->pool[i] / acc->ndays);
+        s->soil_cpool[i] *= ratio;
+        s->soil_npool[i] *= ratio;
+    }
+
+    /* keep the totals consistent with the pools, see day_end_calculations */
+    s->soiln = s->inorgn + s->activesoiln + s->slowsoiln + s->passivesoiln;
+    s->soilc = s->activesoil + s->slowsoil + s->passivesoil;
+    s->totaln = s->plantn + s->littern + s->soiln;
+    s->totalc = s->soilc + s->litterc + s->plantc;
+    *jump = s->soilc - prev_soilc;
+
+    fprintf(stderr, "Spinup: accelerated active C to %f, slow C to %f, "
+            "passive C to %f\n", s->activesoil, s->slowsoil, s->passivesoil);
+
+    return (TRUE);
+}
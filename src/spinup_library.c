@@ -0,0 +1,192 @@
+/* ============================================================================
+* Library of spun up states.
+*
+* Lots of experiments share a spin-up: same site, same equilibrium met
+* and the same parameters. With
+*
+*   [files]
+*   spinup_library = spinup_states
+*
+* every spin-up is saved as a checkpoint (see checkpoint.c) named after a
+* hash of everything that decides where it ends up, and a later spin-up
+* with the same hash just reads the state back instead of re-running.
+*
+* The key covers the contents (not the name) of the met file, the params
+* and initial state as read from the .cfg, the model options in control
+* and the git revision of the build, as a checkpoint is only valid for the
+* build that wrote it.
+*
+* NOTES:
+*   The options are a list of what the model uses (model_controls below),
+*   so a new control field that only changes the I/O needs nothing here.
+*   One that changes the model itself has to be added to the list.
+*
+*   Entries are written via a temporary file and rename, so simulations
+*   in a batch can share a library; at worst two of them both spin up the
+*   same site.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "spinup_library.h"
+#include "checkpoint.h"
+#include "param_table.h"
+
+/* a control field that changes what the model does, and so the key */
+typedef struct {
+    const char *name;
+    size_t      offset;
+    size_t      size;
+} key_field;
+
+#define MODEL_CONTROL(n) { #n, offsetof(control, n), sizeof(((control *)0)->n) }
+
+static const key_field model_controls[] = {
+    MODEL_CONTROL(adjust_rtslow),
+    MODEL_CONTROL(alloc_model),
+    MODEL_CONTROL(assim_model),
+    MODEL_CONTROL(calc_sw_params),
+    MODEL_CONTROL(deciduous_model),
+    MODEL_CONTROL(disturbance),
+    MODEL_CONTROL(exudation),
+    MODEL_CONTROL(fixed_stem_nc),
+    MODEL_CONTROL(fixed_lai),
+    MODEL_CONTROL(fixleafnc),
+    MODEL_CONTROL(grazing),
+    MODEL_CONTROL(gs_model),
+    MODEL_CONTROL(hurricane),
+    MODEL_CONTROL(leaf_kernel),
+    MODEL_CONTROL(model_optroot),
+    MODEL_CONTROL(modeljm),
+    MODEL_CONTROL(ncycle),
+    MODEL_CONTROL(nuptake_model),
+    MODEL_CONTROL(passiveconst),
+    MODEL_CONTROL(ps_pathway),
+    MODEL_CONTROL(respiration_model),
+    MODEL_CONTROL(sub_daily),
+    MODEL_CONTROL(seed),
+    MODEL_CONTROL(spinup_accelerate),
+    MODEL_CONTROL(spinup_check_interval),
+    MODEL_CONTROL(spinup_extrapolate),
+    MODEL_CONTROL(strfloat),
+    MODEL_CONTROL(sw_stress_model),
+    MODEL_CONTROL(temp_tables),
+    MODEL_CONTROL(temp_table_res),
+    MODEL_CONTROL(use_eff_nc),
+    MODEL_CONTROL(water_stress),
+};
+
+#define NUM_MODEL_CONTROLS ((int)(sizeof(model_controls) / sizeof(model_controls[0])))
+
+uint64_t spinup_state_key(control *c, params *p, state *s) {
+    /*
+        Hash of the inputs a spin-up's final state depends on, taken before
+        the spin-up starts: the [params] and [state] keys of param_table,
+        the model options listed in model_controls and the met file.
+        Everything else in control (file names, output format, threads...)
+        is left out without having to be listed.
+    */
+    uint64_t           key = FNV_OFFSET_BASIS;
+    int                i, met_precision = sizeof(met_real);
+    double             value;
+    const param_field *f;
+    const char        *str;
+
+    key = hash_bytes(key, build_git_sha, strlen(build_git_sha));
+    key = hash_bytes(key, &met_precision, sizeof(met_precision));
+
+    for (i = 0; i < NUM_MODEL_CONTROLS; i++) {
+        key = hash_bytes(key, model_controls[i].name,
+                         strlen(model_controls[i].name) + 1);
+        key = hash_bytes(key, (char *)c + model_controls[i].offset,
+                         model_controls[i].size);
+    }
+
+    for (i = 0; i < num_param_fields(); i++) {
+        f = &(param_table[i]);
+        if (f->base == PARAM_CONTROL)
+            continue;
+        key = hash_bytes(key, f->name, strlen(f->name) + 1);
+        if (get_param_value(f, c, p, s, &value)) {
+            key = hash_bytes(key, &value, sizeof(value));
+        } else {
+            str = (f->base == PARAM_PARAMS ? (char *)p : (char *)s) +
+                  f->offset;
+            key = hash_bytes(key, str, strlen(str) + 1);
+        }
+    }
+
+    key = hash_file(key, c->met_fname);
+
+    return (key);
+}
+
+void spinup_library_fname(control *c, uint64_t key, char *fname) {
+    /* Where the library keeps the state for key */
+
+    if (snprintf(fname, STRING_LENGTH, "%s/%016llx.ckp", c->spinup_library,
+                 (unsigned long long)key) >= STRING_LENGTH) {
+        fprintf(stderr, "Error: spinup_library path %s is too long\n",
+                c->spinup_library);
+        exit(EXIT_FAILURE);
+    }
+
+    return;
+}
+
+int load_spinup_state(control *c, params *p, state *s, fluxes *f,
+                      uint64_t key) {
+    /*
+        Fill s, p & f from the library if it holds a spin-up for key.
+
+        Returns:
+        --------
+        found : int
+            TRUE if the state came from the library
+    */
+    char fname[STRING_LENGTH];
+
+    spinup_library_fname(c, key, fname);
+    if (access(fname, R_OK) != 0)
+        return (FALSE);
+
+    read_checkpoint_structs(fname, s, p, f);
+    fprintf(stderr, "Spinup: using spun up state %s\n", fname);
+
+    return (TRUE);
+}
+
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t len) {
+    /* 64 bit FNV-1a */
+    const unsigned char *ptr = (const unsigned char *)data;
+    size_t               i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= ptr[i];
+        hash *= FNV_PRIME;
+    }
+
+    return (hash);
+}
+
+uint64_t hash_file(uint64_t hash, char *fname) {
+    /* Fold the contents of fname into hash */
+    FILE          *fp;
+    unsigned char  buf[65536];
+    size_t         nread;
+
+    if ((fp = fopen(fname, "rb")) == NULL) {
+		fprintf(stderr, "Error: couldn't open Met file %s for read\n", fname);
+		exit(EXIT_FAILURE);
+    }
+    while ((nread = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        hash = hash_bytes(hash, buf, nread);
+    }
+    fclose(fp);
+
+    return (hash);
+}
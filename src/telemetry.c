@@ -0,0 +1,368 @@
+/* ============================================================================
+* Run telemetry, a JSON lines stream a scheduler can follow.
+*
+* With telemetry_fname set in [files], a run appends one JSON object per
+* line to that file (or sends it down a unix domain socket if the name is
+* unix:path) as it goes:
+*
+*   start        - the run, its .cfg and forcing, when it starts
+*   progress     - at most every telemetry_interval seconds, at a year end:
+*                  the year, simulated years per second, leaf solver
+*                  iterations and memory use
+*   spinup_cycle - after every cycle of a spin-up, the change in plant and
+*                  soil C over it
+*   spinup_test  - each convergence test, with the projected drifts
+*   finish       - when the run is done
+*
+* Every record carries the time, the run's label (the region cell or
+* scenario id, else the .cfg) and the pid, so one file or socket can take
+* all the runs of a batch, region or branch. A record is written with a
+* single write() on a file opened for appending, so records from threads
+* sharing a file don't interleave.
+*
+* NOTES:
+*   Telemetry is only ever advisory. If the file can't be opened, or a
+*   write fails (the socket's reader has gone), the run says so once on
+*   stderr and carries on without it.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+
+#include "telemetry.h"
+#include "timing.h"
+
+void open_telemetry(control *c) {
+    /* Open the run's stream, if it has one, and say it has started */
+    telemetry_stream  *ts;
+    struct sockaddr_un addr;
+    char              *fname = c->telemetry_fname;
+    char               rec[TELEMETRY_RECORD_LEN];
+    int                n;
+
+    if (c->telemetry != NULL || strcmp(fname, "*NOT SET*") == 0)
+        return;
+
+    if ((ts = (telemetry_stream *)calloc(1, sizeof(telemetry_stream))) == NULL) {
+        fprintf(stderr, "Error allocating space for the telemetry stream\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (strncmp(fname, TELEMETRY_SOCKET_PREFIX,
+                strlen(TELEMETRY_SOCKET_PREFIX)) == 0) {
+        fname += strlen(TELEMETRY_SOCKET_PREFIX);
+        ts->is_socket = TRUE;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy0(addr.sun_path, fname, sizeof(addr.sun_path));
+        ts->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (ts->fd >= 0 &&
+            connect(ts->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(ts->fd);
+            ts->fd = -1;
+        }
+    } else {
+        ts->fd = open(fname, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    }
+    if (ts->fd < 0) {
+        fprintf(stderr, "Warning: couldn't open telemetry %s (%s), running "
+                "without it\n", c->telemetry_fname, strerror(errno));
+        free(ts);
+        return;
+    }
+
+    if (strcmp(c->run_label, "*NOT SET*") != 0)
+        strcpy(ts->label, c->run_label);
+    else
+        strcpy(ts->label, c->cfg_fname);
+    ts->start_ns = timing_clock();
+    ts->last_ns = ts->start_ns;
+    c->telemetry = ts;
+
+    n = telemetry_header(ts, rec, sizeof(rec), "start");
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"cfg\":");
+    n += json_string(rec + n, sizeof(rec) - n, c->cfg_fname);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"met\":");
+    n += json_string(rec + n, sizeof(rec) - n, c->met_fname);
+    n += snprintf(rec + n, sizeof(rec) - n,
+                  ",\"num_years\":%d,\"sub_daily\":%s,\"spin_up\":%s}\n",
+                  c->num_years, c->sub_daily ? "true" : "false",
+                  c->spin_up ? "true" : "false");
+    write_telemetry_record(ts, rec, n);
+
+    return;
+}
+
+void close_telemetry(control *c) {
+    /* Say the run has finished and close its stream */
+    telemetry_stream *ts = c->telemetry;
+    char              rec[TELEMETRY_RECORD_LEN];
+    double            elapsed, rss, peak_rss;
+    int               n;
+
+    if (ts == NULL)
+        return;
+
+    elapsed = (timing_clock() - ts->start_ns) * 1E-9;
+    get_memory_use(&rss, &peak_rss);
+    n = telemetry_header(ts, rec, sizeof(rec), "finish");
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"days\":%ld,\"years\":%ld",
+                  ts->days, ts->years);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"elapsed\":");
+    n += json_number(rec + n, sizeof(rec) - n, elapsed);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"years_per_sec\":");
+    n += json_number(rec + n, sizeof(rec) - n,
+                     elapsed > 0.0 ? ts->years / elapsed : 0.0);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"peak_rss_mb\":");
+    n += json_number(rec + n, sizeof(rec) - n, peak_rss);
+    n += snprintf(rec + n, sizeof(rec) - n, "}\n");
+    write_telemetry_record(ts, rec, n);
+
+    if (ts->fd >= 0)
+        close(ts->fd);
+    free(ts);
+    c->telemetry = NULL;
+
+    return;
+}
+
+void telemetry_day(control *c, canopy_wk *cw) {
+    /* Count the day and its leaf solves */
+    telemetry_stream *ts = c->telemetry;
+
+    ts->days++;
+    if (c->sub_daily) {
+        ts->leaf_solves += cw->leaf_solves;
+        ts->leaf_iter += cw->leaf_iter_sum;
+    }
+
+    return;
+}
+
+void telemetry_year(sim_context *sc) {
+    /*
+        Count the year just finished and, if telemetry_interval seconds
+        have gone by since the last one, send a progress record
+    */
+    control          *c = sc->c;
+    telemetry_stream *ts = c->telemetry;
+    char              rec[TELEMETRY_RECORD_LEN];
+    double            dt, elapsed, rate, mean_rate, rss, peak_rss;
+    int64_t           now;
+    int               n;
+
+    ts->years++;
+    now = timing_clock();
+    dt = (now - ts->last_ns) * 1E-9;
+    if (dt < c->telemetry_interval)
+        return;
+
+    elapsed = (now - ts->start_ns) * 1E-9;
+    rate = dt > 0.0 ? (ts->years - ts->last_years) / dt : 0.0;
+    mean_rate = elapsed > 0.0 ? ts->years / elapsed : 0.0;
+    get_memory_use(&rss, &peak_rss);
+
+    n = telemetry_header(ts, rec, sizeof(rec), "progress");
+    n += snprintf(rec + n, sizeof(rec) - n,
+                  ",\"year\":%d,\"nyr\":%d,\"num_years\":%d,\"cycle\":%d,"
+                  "\"years\":%ld", (int)sc->year, sc->nyr + 1, c->num_years,
+                  ts->cycle, ts->years);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"elapsed\":");
+    n += json_number(rec + n, sizeof(rec) - n, elapsed);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"years_per_sec\":");
+    n += json_number(rec + n, sizeof(rec) - n, rate);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"mean_years_per_sec\":");
+    n += json_number(rec + n, sizeof(rec) - n, mean_rate);
+
+    /* a spin-up's length isn't known until it has converged */
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"eta\":");
+    if (c->spin_up == FALSE && rate > 0.0)
+        n += json_number(rec + n, sizeof(rec) - n,
+                         (c->num_years - sc->nyr - 1) / rate);
+    else
+        n += snprintf(rec + n, sizeof(rec) - n, "null");
+
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"leaf_solves\":%lld,"
+                  "\"leaf_iter_per_solve\":", (long long)ts->leaf_solves);
+    if (ts->leaf_solves > 0)
+        n += json_number(rec + n, sizeof(rec) - n,
+                         (double)ts->leaf_iter / ts->leaf_solves);
+    else
+        n += snprintf(rec + n, sizeof(rec) - n, "null");
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"rss_mb\":");
+    n += json_number(rec + n, sizeof(rec) - n, rss);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"peak_rss_mb\":");
+    n += json_number(rec + n, sizeof(rec) - n, peak_rss);
+    n += snprintf(rec + n, sizeof(rec) - n, "}\n");
+    write_telemetry_record(ts, rec, n);
+
+    ts->last_ns = now;
+    ts->last_years = ts->years;
+    ts->leaf_solves = 0;
+    ts->leaf_iter = 0;
+
+    return;
+}
+
+void telemetry_spinup_cycle(control *c, state *s, int cycle, double dplantc,
+                            double dsoilc) {
+    /* Plant and soil C after a spin-up cycle and their change over it */
+    telemetry_stream *ts = c->telemetry;
+    char              rec[TELEMETRY_RECORD_LEN];
+    int               n;
+
+    if (ts == NULL)
+        return;
+
+    n = telemetry_header(ts, rec, sizeof(rec), "spinup_cycle");
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"cycle\":%d,\"years\":%ld",
+                  cycle, ts->years);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"plantc\":");
+    n += json_number(rec + n, sizeof(rec) - n, s->plantc * TONNES_HA_2_KG_M2);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"soilc\":");
+    n += json_number(rec + n, sizeof(rec) - n, s->soilc * TONNES_HA_2_KG_M2);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"dplantc\":");
+    n += json_number(rec + n, sizeof(rec) - n, dplantc * TONNES_HA_2_KG_M2);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"dsoilc\":");
+    n += json_number(rec + n, sizeof(rec) - n, dsoilc * TONNES_HA_2_KG_M2);
+    n += snprintf(rec + n, sizeof(rec) - n, "}\n");
+    write_telemetry_record(ts, rec, n);
+
+    return;
+}
+
+void telemetry_spinup_test(control *c, int cycle, double plantc_drift,
+                           double soilc_drift, double tol, int converged) {
+    /* A convergence test, drifts as judged by spin_up_pools (kg m-2) */
+    telemetry_stream *ts = c->telemetry;
+    char              rec[TELEMETRY_RECORD_LEN];
+    int               n;
+
+    if (ts == NULL)
+        return;
+
+    n = telemetry_header(ts, rec, sizeof(rec), "spinup_test");
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"cycle\":%d", cycle);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"plantc_drift\":");
+    n += json_number(rec + n, sizeof(rec) - n, plantc_drift);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"soilc_drift\":");
+    n += json_number(rec + n, sizeof(rec) - n, soilc_drift);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"tol\":");
+    n += json_number(rec + n, sizeof(rec) - n, tol);
+    n += snprintf(rec + n, sizeof(rec) - n, ",\"converged\":%s}\n",
+                  converged ? "true" : "false");
+    write_telemetry_record(ts, rec, n);
+
+    return;
+}
+
+void write_telemetry_record(telemetry_stream *ts, char *rec, int n) {
+    /* One write per record, a failure switches the stream off */
+    ssize_t put;
+
+    if (ts->fd < 0)
+        return;
+    if (n >= TELEMETRY_RECORD_LEN) {
+        /* truncated, keep the stream one object per line */
+        n = TELEMETRY_RECORD_LEN - 1;
+        rec[n - 1] = '\n';
+    }
+
+    if (ts->is_socket)
+        put = send(ts->fd, rec, n, MSG_NOSIGNAL);
+    else
+        put = write(ts->fd, rec, n);
+    if (put != n) {
+        fprintf(stderr, "Warning: telemetry for %s stopped (%s)\n", ts->label,
+                put < 0 ? strerror(errno) : "short write");
+        close(ts->fd);
+        ts->fd = -1;
+    }
+
+    return;
+}
+
+int telemetry_header(telemetry_stream *ts, char *rec, int size,
+                     const char *event) {
+    /* The fields every record starts with, the object left open */
+    struct timespec now;
+    int             n;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    n = snprintf(rec, size, "{\"event\":\"%s\",\"time\":%lld.%03ld,"
+                 "\"pid\":%ld,\"run\":", event, (long long)now.tv_sec,
+                 now.tv_nsec / 1000000, (long)getpid());
+    n += json_string(rec + n, size - n, ts->label);
+
+    return (n);
+}
+
+int json_number(char *buf, int size, double x) {
+    /* JSON has no NaN or Inf */
+    if (isnan(x) || isinf(x))
+        return (snprintf(buf, size, "null"));
+
+    return (snprintf(buf, size, "%.10g", x));
+}
+
+int json_string(char *buf, int size, const char *str) {
+    /*
+        str quoted, with quotes, backslashes and control characters escaped,
+        cut short if it would take more than STRING_LENGTH characters
+    */
+    int n = 0;
+
+    size = MIN(size, STRING_LENGTH);
+    if (size < 3)
+        return (0);
+    buf[n++] = '"';
+    for (; *str != '\0' && n < size - 8; str++) {
+        if (*str == '"' || *str == '\\') {
+            buf[n++] = '\\';
+            buf[n++] = *str;
+        } else if ((unsigned char)*str < 0x20) {
+            n += snprintf(buf + n, size - n, "\\u%04x", (unsigned char)*str);
+        } else {
+            buf[n++] = *str;
+        }
+    }
+    buf[n++] = '"';
+    buf[n] = '\0';
+
+    return (n);
+}
+
+void get_memory_use(double *rss, double *peak_rss) {
+    /* Resident and peak resident size of the process (MB) */
+    struct rusage ru;
+    FILE         *fp;
+    long          size, resident;
+
+    *rss = 0.0;
+    if ((fp = fopen("/proc/self/statm", "r")) != NULL) {
+        if (fscanf(fp, "%ld %ld", &size, &resident) == 2)
+            *rss = resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+        fclose(fp);
+    }
+
+    *peak_rss = 0.0;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        /* kB on Linux, bytes on macOS */
+#ifdef __APPLE__
+        *peak_rss = ru.ru_maxrss / (1024.0 * 1024.0);
+#else
+        *peak_rss = ru.ru_maxrss / 1024.0;
+#endif
+    }
+
+    return;
+}
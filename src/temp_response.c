@@ -0,0 +1,138 @@
+/* ============================================================================
+* Temperature response tables.
+*
+* The Arrhenius responses of the Rubisco kinetics, Vcmax and Jmax are worked
+* out several times for every leaf and every half-hour (and twice a day, am
+* and pm, by MATE), each time an exp() of the leaf temperature with
+* parameters that are fixed for the run. With temp_tables = true these are
+* tabulated once, at sim_init, along with the soil temperature factor of
+* the decomposition rates, and interpolated linearly from then on:
+*
+*   [control]
+*   temp_tables = true
+*   temp_table_res = 10     ; points per deg C
+*
+* Linear interpolation over a step h is out by at most h^2 / 8 max|f''|.
+* For an Arrhenius response f''/f is about (Ea / (R Tk^2))^2, largest for
+* the biggest activation energy (eac) at the cold end of the table, so at
+* the default 0.1 deg C step the relative error is below 5E-05, and it goes
+* as 1 / temp_table_res^2. The peaked Jmax response is steeper above its
+* optimum and the soil factor isn't Arrhenius at all, so the worst case of
+* all the columns is also measured at every midpoint when the table is
+* built and kept in max_rel_err (relative for the Arrhenius columns,
+* relative to the largest value for the soil factor). With the default
+* parameters that is 5.1E-05 at temp_table_res = 10, from the soil factor.
+* Temperatures outside TEMP_TABLE_TMIN to TEMP_TABLE_TMAX fall back to the
+* exact functions.
+*
+* The tables change results at that level, so the default is off; the
+* regression test has a tolerance file for them, see tests/regression.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include <float.h>
+#include "temp_response.h"
+
+static void exact_responses(params *p, double T, double *row) {
+    /* every column of the table at temperature T (deg C) */
+    double tref = p->measurement_temp;
+
+    row[TT_GAMSTAR] = arrhenius(1.0, p->eag, T, tref);
+    row[TT_KC] = arrhenius(1.0, p->eac, T, tref);
+    row[TT_KO] = arrhenius(1.0, p->eao, T, tref);
+    row[TT_VCMAX] = arrhenius(1.0, p->eav, T, tref);
+    row[TT_JMAX] = peaked_arrhenius(1.0, p->eaj, T, tref, p->delsj, p->edj);
+    /* the soil factor jumps to zero at 0 deg C and is clipped at zero
+       above ~46 deg C, neither of which interpolates well, so the table
+       holds the smooth fit (from above 0) and soil_temp_factor clips it
+       and only uses it for tsoil > 0 */
+    row[TT_SOIL] = soil_temp_fit(MAX(T, DBL_MIN));
+
+    return;
+}
+
+void build_temp_table(control *c, params *p) {
+    /*
+        Tabulate the temperature responses for this run's parameters. Done
+        at every sim_init, which is cheap next to even a year of the model,
+        so the table always matches params (e.g. after a -set override).
+    */
+    temp_table *t = c->temp_resp;
+    double      exact[TT_NCOLS], Tmid, value, err, scale[TT_NCOLS];
+    int         i, j, n;
+
+    if (c->temp_tables == FALSE) {
+        free_temp_table(c);
+        return;
+    }
+    if (c->temp_table_res < 1) {
+        fprintf(stderr, "temp_table_res must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+    n = (int)(TEMP_TABLE_TMAX - TEMP_TABLE_TMIN) * c->temp_table_res + 1;
+
+    if (t == NULL) {
+        if ((t = (temp_table *)calloc(1, sizeof(temp_table))) == NULL) {
+            fprintf(stderr, "Error allocating space for temp table\n");
+            exit(EXIT_FAILURE);
+        }
+        c->temp_resp = t;
+    }
+    if (t->v == NULL || t->n != n) {
+        free(t->v);
+        if ((t->v = (double *)malloc(n * TT_NCOLS * sizeof(double))) == NULL) {
+            fprintf(stderr, "Error allocating space for temp table\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    t->n = n;
+    t->tmin = TEMP_TABLE_TMIN;
+    t->step = 1.0 / (double)c->temp_table_res;
+    t->inv_step = (double)c->temp_table_res;
+
+    for (j = 0; j < TT_NCOLS; j++) {
+        scale[j] = 0.0;
+    }
+    for (i = 0; i < n; i++) {
+        exact_responses(p, t->tmin + (double)i * t->step,
+                        t->v + i * TT_NCOLS);
+        for (j = 0; j < TT_NCOLS; j++) {
+            scale[j] = MAX(scale[j], t->v[i * TT_NCOLS + j]);
+        }
+    }
+
+    /* the interpolation error is largest between the nodes */
+    t->max_rel_err = 0.0;
+    for (i = 0; i < n - 1; i++) {
+        Tmid = t->tmin + ((double)i + 0.5) * t->step;
+        exact_responses(p, Tmid, exact);
+        for (j = 0; j < TT_NCOLS; j++) {
+            temp_lookup(t, j, Tmid, &value);
+            if (j == TT_SOIL) {
+                /* as used, i.e. clipped at zero */
+                err = fabs(MAX(0.0, value) - MAX(0.0, exact[j]));
+                err /= scale[j] > 0.0 ? scale[j] : 1.0;
+            } else {
+                err = fabs(value - exact[j]) / fabs(exact[j]);
+            }
+            t->max_rel_err = MAX(t->max_rel_err, err);
+        }
+    }
+
+    return;
+}
+
+void free_temp_table(control *c) {
+
+    if (c->temp_resp != NULL)
+        free(c->temp_resp->v);
+    free(c->temp_resp);
+    c->temp_resp = NULL;
+
+    return;
+}
@@ -0,0 +1,126 @@
+/* ============================================================================
+* Hot path timing and solver counters, for a build with -DGDAY_TIMING.
+*
+* TIMER_START/TIMER_STOP around a call add its wall time and one call to
+* the region's totals, COUNT_EVENTS adds to a counter (see timing.h). The
+* totals are shared by every thread of a batch run and updated atomically,
+* so with several threads a region's time is the sum over the threads.
+* A table is printed to stderr when the program finishes and, if
+* GDAY_TIMING_JSON names a file, the same numbers are written there as JSON.
+*
+* Without -DGDAY_TIMING the macros are empty and nothing here is called.
+*
+* AUTHOR:
+*   agent
+*
+* DATE:
+*   14.10.2026
+*
+* =========================================================================== */
+#include "timing.h"
+
+static const char *timer_names[NUM_TIMERS] = {
+    "read_met", "simulate_day", "calc_day_growth", "canopy",
+    "water_balance", "csoil_flows", "nsoil_flows", "phenology", "outputs"
+};
+static const char *counter_names[NUM_COUNTERS] = {
+    "leaf_solves", "leaf_iterations", "newton_calls", "newton_iterations",
+    "quad_failures"
+};
+
+static int64_t timer_ns[NUM_TIMERS];
+static int64_t timer_calls[NUM_TIMERS];
+static int64_t counts[NUM_COUNTERS];
+
+int64_t timing_clock(void) {
+    /* nanoseconds on the monotonic clock */
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+void add_timing(int timer, int64_t ns) {
+
+    __atomic_fetch_add(&timer_ns[timer], ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&timer_calls[timer], 1, __ATOMIC_RELAXED);
+
+    return;
+}
+
+void add_count(int counter, int64_t n) {
+
+    __atomic_fetch_add(&counts[counter], n, __ATOMIC_RELAXED);
+
+    return;
+}
+
+void report_timing(void) {
+    /*
+        Table of the time in each region, mean time per call and share of
+        the time spent in simulate_day, followed by the solver counters
+    */
+    int     i;
+    double  day_ns = (double)MAX(timer_ns[TIMER_DAY], 1);
+    char   *json_fname;
+
+    fprintf(stderr, "\n%-16s %12s %12s %12s %8s\n", "region", "calls",
+            "total (s)", "mean (us)", "% day");
+    for (i = 0; i < NUM_TIMERS; i++) {
+        if (timer_calls[i] == 0)
+            continue;
+        fprintf(stderr, "%-16s %12lld %12.3f %12.3f %8.1f\n", timer_names[i],
+                (long long)timer_calls[i], timer_ns[i] * 1E-9,
+                timer_ns[i] * 1E-3 / timer_calls[i],
+                i == TIMER_READ_MET ? 0.0 : 100.0 * timer_ns[i] / day_ns);
+    }
+
+    fprintf(stderr, "\n%-20s %14s\n", "counter", "count");
+    for (i = 0; i < NUM_COUNTERS; i++) {
+        fprintf(stderr, "%-20s %14lld\n", counter_names[i],
+                (long long)counts[i]);
+    }
+    if (counts[COUNTER_LEAF_SOLVES] > 0)
+        fprintf(stderr, "%-20s %14.2f\n", "leaf_iter_per_solve",
+                (double)counts[COUNTER_LEAF_ITER] / counts[COUNTER_LEAF_SOLVES]);
+    if (counts[COUNTER_NEWTON_CALLS] > 0)
+        fprintf(stderr, "%-20s %14.2f\n", "newton_iter_per_call",
+                (double)counts[COUNTER_NEWTON_ITER] /
+                counts[COUNTER_NEWTON_CALLS]);
+
+    if ((json_fname = getenv("GDAY_TIMING_JSON")) != NULL)
+        write_timing_json(json_fname);
+
+    return;
+}
+
+void write_timing_json(char *fname) {
+    /*
+        {"timers": {"canopy": {"calls": n, "seconds": t}, ...},
+         "counters": {"leaf_iterations": n, ...}}
+    */
+    FILE *fp;
+    int   i;
+
+    if ((fp = fopen(fname, "w")) == NULL) {
+        fprintf(stderr, "Error: couldn't open timing file %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "{\n  \"timers\": {\n");
+    for (i = 0; i < NUM_TIMERS; i++) {
+        fprintf(fp, "    \"%s\": {\"calls\": %lld, \"seconds\": %.9f}%s\n",
+                timer_names[i], (long long)timer_calls[i],
+                timer_ns[i] * 1E-9, i < NUM_TIMERS - 1 ? "," : "");
+    }
+    fprintf(fp, "  },\n  \"counters\": {\n");
+    for (i = 0; i < NUM_COUNTERS; i++) {
+        fprintf(fp, "    \"%s\": %lld%s\n", counter_names[i],
+                (long long)counts[i], i < NUM_COUNTERS - 1 ? "," : "");
+    }
+    fprintf(fp, "  }\n}\n");
+    fclose(fp);
+
+    return;
+}
@@ -131,3 +131,35 @@ char *strncpy0(char* dest, char* src, size_t size)
 double round_to_value(double number, double roundto) {
     return (round(number / roundto) * roundto);
 }
+
+void seed_random(unsigned long long *rng_state, unsigned long long seed) {
+    /*
+        Seed a per-simulation random number stream. The stream lives in
+        the caller's structure (c->rng_state) so that concurrent runs never
+        share generator state and a given seed always reproduces a run.
+    */
+    *rng_state = seed;
+
+    return;
+}
+
+double random_uniform(unsigned long long *rng_state) {
+    /*
+        Uniform random number on [0, 1) from the splitmix64 generator.
+
+        Reference:
+        ----------
+        * Steele, G. et al. (2014) Fast splittable pseudorandom number
+          generators. OOPSLA '14, 453-472.
+    */
+    unsigned long long z;
+
+    *rng_state += 0x9E3779B97F4A7C15ULL;
+    z = *rng_state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    /* top 53 bits -> double */
+    return ((z >> 11) * (1.0 / 9007199254740992.0));
+}
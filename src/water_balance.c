@@ -1,4 +1,5 @@
 #include "water_balance.h"
+#include "timing.h"
 
 
 void calculate_water_balance(control *c, fluxes *f, met *m, params *p,
@@ -37,6 +38,7 @@ void calculate_water_balance(control *c, fluxes *f, met *m, params *p,
            omega_am, gs_mol_m2_hfday_am, ga_mol_m2_hfday_am, gpp_am,
            gpp_pm, trans_pm, omega_pm, gs_mol_m2_hfday_pm, ga_mol_m2_hfday_pm,
            throughfall, canopy_evap;
+    TIMER_START(TIMER_WATER_BALANCE);
 
     SEC_2_DAY = 60.0 * 60.0 * daylen;
     DAY_2_SEC = 1.0 / SEC_2_DAY;
@@ -79,12 +81,14 @@ void calculate_water_balance(control *c, fluxes *f, met *m, params *p,
         gpp_am = f->gpp_am * conv;
         gpp_pm = f->gpp_pm * conv;
 
-        penman_canopy_wrapper(p, s, m->press, m->vpd_am, m->tair_am, m->wind_am,
-                              net_rad_am, m->Ca, gpp_am, &ga_am, &gs_am,
-                              &transpiration_am, &LE_am, &omega_am);
-        penman_canopy_wrapper(p, s, m->press, m->vpd_pm, m->tair_pm, m->wind_pm,
-                              net_rad_pm, m->Ca, gpp_pm, &ga_pm, &gs_pm,
-                              &transpiration_pm, &LE_pm, &omega_pm);
+        penman_canopy_wrapper(p, s, &(m->derived_am), m->press, m->vpd_am,
+                              m->tair_am, m->wind_am, net_rad_am, m->Ca,
+                              gpp_am, &ga_am, &gs_am, &transpiration_am,
+                              &LE_am, &omega_am);
+        penman_canopy_wrapper(p, s, &(m->derived_pm), m->press, m->vpd_pm,
+                              m->tair_pm, m->wind_pm, net_rad_pm, m->Ca,
+                              gpp_pm, &ga_pm, &gs_pm, &transpiration_pm,
+                              &LE_pm, &omega_pm);
 
         /* mol m-2 s-1 to mm/day */
         conv = MOLE_WATER_2_G_WATER * G_TO_KG * SEC_2_DAY;
@@ -113,6 +117,59 @@ void calculate_water_balance(control *c, fluxes *f, met *m, params *p,
         update_daily_water_struct(f, soil_evap, transpiration, et, interception,
                                   throughfall, canopy_evap, runoff);
     }
+    TIMER_STOP(TIMER_WATER_BALANCE);
+
+    return;
+}
+
+void calculate_water_balance_night(control *c, fluxes *f, met *m, params *p,
+                                   state *s) {
+    /*
+        calculate_water_balance for a dark half-hour of the sub-daily model,
+        i.e. with no transpiration, decoupling or canopy net radiation.
+
+        With no rain and a dry canopy there is nothing to intercept and the
+        canopy evaporation is limited to the (empty) store, and with no net
+        radiation at the surface the soil evaporation is zero, so in those
+        cases the two Penman terms aren't evaluated. Otherwise everything is
+        worked out just as calculate_water_balance would, so the answer is
+        the same to the bit.
+    */
+    double soil_evap, et, interception, runoff, transpiration, net_rad,
+           throughfall, canopy_evap;
+    TIMER_START(TIMER_WATER_BALANCE);
+
+    if (m->rain > 0.0 || s->canopy_store != 0.0 || !(m->vpd >= 0.0) ||
+        s->lai < 0.0) {
+        canopy_evap = calc_canopy_evaporation(m, p, s, 0.0);
+        canopy_evap *= MOLE_WATER_2_G_WATER * G_TO_KG * SEC_2_HLFHR;
+        calc_interception(c, m, p, f, s, &throughfall, &interception,
+                          &canopy_evap);
+    } else {
+        /* the potential rate is >= 0, more than the store holds */
+        interception = 0.0;
+        throughfall = m->rain;
+        canopy_evap = s->canopy_store;
+        s->canopy_store = 0.0;
+    }
+
+    net_rad = calc_net_radiation(p, m->sw_rad, m->tair);
+    if (net_rad != 0.0 || !(s->wtfac_topsoil >= 0.0)) {
+        soil_evap = calc_soil_evaporation(m, p, s, net_rad);
+        soil_evap *= MOLE_WATER_2_G_WATER * G_TO_KG * SEC_2_HLFHR;
+    } else {
+        soil_evap = 0.0;
+    }
+
+    transpiration = 0.0;
+    et = transpiration + soil_evap + canopy_evap;
+
+    update_water_storage(c, f, p, s, throughfall, interception, canopy_evap,
+                         &transpiration, &soil_evap, &et, &runoff);
+
+    sum_hourly_water_fluxes(f, soil_evap, transpiration, et, interception,
+                            throughfall, canopy_evap, runoff, 0.0);
+    TIMER_STOP(TIMER_WATER_BALANCE);
 
     return;
 }
@@ -419,9 +476,10 @@ double calc_soil_evaporation(met *m, params *p, state *s, double net_rad) {
     */
     double lambda, gamma, slope, arg1, arg2, soil_evap;
 
-    lambda = calc_latent_heat_of_vapourisation(m->tair);
-    gamma = calc_pyschrometric_constant(m->press, lambda);
-    slope = calc_slope_of_sat_vapour_pressure_curve(m->tair);
+    /* see derive_met_columns */
+    lambda = m->derived.lambda;
+    gamma = m->derived.gamma;
+    slope = m->derived.slope;
 
     /* mol H20 m-2 s-1 */
     soil_evap = ((slope / (slope + gamma)) * net_rad) / lambda;
@@ -468,9 +526,9 @@ double calc_canopy_evaporation(met *m, params *p, state *s, double rnet) {
     double lambda, gamma, slope, arg1, arg2, pot_evap, LE, ga;
 
     ga = canopy_boundary_layer_conduct(p, s->canht, m->wind, m->press, m->tair);
-    lambda = calc_latent_heat_of_vapourisation(m->tair);
-    gamma = calc_pyschrometric_constant(m->press, lambda);
-    slope = calc_slope_of_sat_vapour_pressure_curve(m->tair);
+    lambda = m->derived.lambda;
+    gamma = m->derived.gamma;
+    slope = m->derived.slope;
 
     arg1 = slope * rnet + m->vpd * ga * CP * MASS_AIR;
     arg2 = slope + gamma;
@@ -502,10 +560,11 @@ double calc_net_radiation(params *p, double sw_rad, double tair) {
 }
 
 
-void penman_canopy_wrapper(params *p, state *s, double press, double vpd,
-                           double tair, double wind, double rnet, double ca,
-                           double gpp, double *ga, double *gsv,
-                           double *transpiration, double *LE, double *omega) {
+void penman_canopy_wrapper(params *p, state *s, met_derived *md,
+                           double press, double vpd, double tair, double wind,
+                           double rnet, double ca, double gpp, double *ga,
+                           double *gsv, double *transpiration, double *LE,
+                           double *omega) {
     /*
         Calculates transpiration at the canopy scale (or big leaf) using the
         Penman-Monteith
@@ -516,6 +575,8 @@ void penman_canopy_wrapper(params *p, state *s, double press, double vpd,
             parameters
         state : structure
             state variables
+        md : structure
+            derived met terms at tair and press
         press : float
             atmospheric pressure (Pa)
         vpd : float
@@ -554,9 +615,9 @@ void penman_canopy_wrapper(params *p, state *s, double press, double vpd,
     /* Total leaf conductance to water vapour */
     gv = 1.0 / (1.0 / *gsv + 1.0 / *ga);
 
-    lambda = calc_latent_heat_of_vapourisation(tair);
-    gamma = calc_pyschrometric_constant(press, lambda);
-    slope = calc_slope_of_sat_vapour_pressure_curve(tair);
+    lambda = md->lambda;
+    gamma = md->gamma;
+    slope = md->slope;
 
     penman_monteith(press, vpd, rnet, slope, lambda, gamma, ga, &gv,
                     transpiration, LE);
@@ -595,7 +656,7 @@ void penman_leaf_wrapper(met *m, params *p, state *s, double tleaf, double rnet,
            gbv, gsv, gamma, Tdiff, sensible_heat, ema, Tk;
 
     /* Radiation conductance (mol m-2 s-1) */
-    gradn = calc_radiation_conductance(m->tair);
+    gradn = m->derived.gradn;
 
     /* Boundary layer conductance for heat - single sided, forced
        convection (mol m-2 s-1) */
@@ -618,9 +679,9 @@ void penman_leaf_wrapper(met *m, params *p, state *s, double tleaf, double rnet,
     *gv = (gbv * gsv) / (gbv + gsv);
     *gbc = gbh / GBHGBC;
 
-    lambda = calc_latent_heat_of_vapourisation(m->tair);
-    gamma = calc_pyschrometric_constant(m->press, lambda);
-    slope = calc_slope_of_sat_vapour_pressure_curve(m->tair);
+    lambda = m->derived.lambda;
+    gamma = m->derived.gamma;
+    slope = m->derived.slope;
 
     penman_monteith(m->press, m->vpd, rnet, slope, lambda, gamma, gh, gv,
                     transpiration, LE);
@@ -948,11 +1009,11 @@ void initialise_soil_moisture_parameters(control *c, params *p) {
       available water.
      */
 
-    double *fsoil_top = NULL, *fsoil_root = NULL;
+    double fsoil_top[3], fsoil_root[3];
 
     if (c->calc_sw_params) {
-        fsoil_top = get_soil_fracs(p->topsoil_type);
-        fsoil_root = get_soil_fracs(p->rootsoil_type);
+        get_soil_fracs(p->topsoil_type, fsoil_top);
+        get_soil_fracs(p->rootsoil_type, fsoil_root);
 
         /* top soil */
         calc_soil_params(fsoil_top, &p->theta_fc_topsoil, &p->theta_wp_topsoil,
@@ -991,21 +1052,16 @@ void initialise_soil_moisture_parameters(control *c, params *p) {
 
     exit(1); */
 
-
-
-    free(fsoil_top);
-    free(fsoil_root);
-
     return;
 }
 
 
-double *get_soil_fracs(char *soil_type) {
+void get_soil_fracs(char *soil_type, double *fsoil) {
     /*
      * Based on Table 2 in Cosby et al 1984, page 2.
-     * Fractions of silt, sand and clay (in that order)
+     * Fractions of silt, sand and clay (in that order), written into the
+     * caller's 3 element array.
      */
-    double *fsoil = malloc(3 * sizeof(double));
 
     if (strcmp(soil_type, "sand") == 0) {
         fsoil[0] = 0.05;
@@ -1055,7 +1111,7 @@ double *get_soil_fracs(char *soil_type) {
         prog_error("Could not understand soil type", __LINE__);
     }
 
-    return (fsoil);
+    return;
 }
 
 void get_soil_params(char *soil_type, double *c_theta, double *n_theta) {
@@ -1209,38 +1265,35 @@ void calculate_soil_water_fac(control *c, params *p, state *s) {
         water availability factor for the root zone [0,1]
     */
 
-    double moisture_ratio_topsoil, moisture_ratio_root, psi_swp_topsoil, theta;
-
-    if (c->sw_stress_model == 0) {
-        /* JULES type model, see Egea et al. (2011) */
-        s->wtfac_topsoil = calc_beta(s->pawater_topsoil, p->topsoil_depth,
-                                     p->theta_fc_topsoil, p->theta_wp_topsoil,
-                                     p->qs);
-
-        s->wtfac_root = calc_beta(s->pawater_root, p->rooting_depth,
-                                     p->theta_fc_root, p->theta_wp_root,
-                                     p->qs);
-
-    } else if (c->sw_stress_model == 1) {
-        /* Landsberg and Waring, (1997) */
-        moisture_ratio_topsoil = s->pawater_topsoil / p->wcapac_topsoil;
-        moisture_ratio_root = s->pawater_root / p->wcapac_root;
-
-        s->wtfac_topsoil = calc_sw_modifier(moisture_ratio_topsoil,
-                                            p->ctheta_topsoil,
-                                            p->ntheta_topsoil);
-        s->wtfac_root = calc_sw_modifier(moisture_ratio_root, p->ctheta_root,
-                                         p->ntheta_root);
-
-    } else if (c->sw_stress_model == 2) {
-        /*
-            Zhou et al.(2013) Agricultural & Forest Met. 182–183, 204–214
-            Assuming that overnight 􏰀pre-dawn leaf water potential =
-            pre-dawn soil water potential.
-        */
-        fprintf(stderr, "Zhou model not implemented\n");
-        exit(EXIT_FAILURE);
-        /*
+
+    /* sw_stress_model, see model_options.c */
+    c->kernels->soil_water_fac(p, s);
+
+    return;
+}
+
+void soil_water_fac_jules(params *p, state *s) {
+    /* sw_stress_model = 0, JULES type model, see Egea et al. (2011) */
+
+    s->wtfac_topsoil = calc_beta(s->pawater_topsoil, p->topsoil_depth,
+                                 p->theta_fc_topsoil, p->theta_wp_topsoil,
+                                 p->qs);
+
+    s->wtfac_root = calc_beta(s->pawater_root, p->rooting_depth,
+                                 p->theta_fc_root, p->theta_wp_root,
+                                 p->qs);
+
+    return;
+}
+
+void soil_water_fac_landsberg(params *p, state *s) {
+    /*
+        sw_stress_model = 1, Landsberg and Waring, (1997)
+
+        NB sw_stress_model = 2 would be Zhou et al.(2013) Agricultural &
+        Forest Met. 182-183, 204-214, assuming that overnight pre-dawn leaf
+        water potential = pre-dawn soil water potential. Not implemented:
+
         s->wtfac_topsoil = exp(p->g1_b * s->psi_s_topsoil);
         s->wtfac_root = exp(p->g1_b * s->psi_s_root);
 
@@ -1251,8 +1304,18 @@ void calculate_soil_water_fac(control *c, params *p, state *s) {
         s->wtfac_root_ns = (1.0 + exp(p->vcmax_sf * p->vcmax_psi_f)) / \
                             (1.0 + exp(p->vcmax_sf * \
                                         (p->vcmax_psi_f - s->psi_s_root)));
-        */
-    }
+    */
+    double moisture_ratio_topsoil, moisture_ratio_root;
+
+    moisture_ratio_topsoil = s->pawater_topsoil / p->wcapac_topsoil;
+    moisture_ratio_root = s->pawater_root / p->wcapac_root;
+
+    s->wtfac_topsoil = calc_sw_modifier(moisture_ratio_topsoil,
+                                        p->ctheta_topsoil,
+                                        p->ntheta_topsoil);
+    s->wtfac_root = calc_sw_modifier(moisture_ratio_root, p->ctheta_root,
+                                     p->ntheta_root);
+
     return;
 }
 
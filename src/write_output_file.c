@@ -4,7 +4,9 @@
 *
 *
 * NOTES:
-*   Currently I have only implemented the ascii version
+*   Both writers emit the variables selected in the [outputs] section (see
+*   output_vars.c), the binary one as raw doubles described by the header
+*   file (out_fname_hdr).
 *
 * AUTHOR:
 *   Martin De Kauwe
@@ -14,6 +16,7 @@
 *
 * =========================================================================== */
 #include "write_output_file.h"
+#include "param_table.h"
 
 
 void open_output_file(control *c, char *fname, FILE **fp) {
@@ -23,90 +26,77 @@ void open_output_file(control *c, char *fname, FILE **fp) {
 }
 
 
-void write_output_header(control *c, FILE **fp) {
+void open_daily_output_files(control *c) {
     /*
-        Write daily state and fluxes headers to an output CSV file. Note we
-        are not writing anything useful like units as there is a wrapper
-        script to translate the outputs to a nice CSV file with input met
-        data, units and nice header information.
+        Open the daily output file and write its header. Binary outputs
+        always get a separate header file describing the records, ASCII
+        outputs only when out_fname_hdr is set.
     */
-    int ncols = 86;
-    int nrows = c->num_days;
-
-    /* Git version */
-    fprintf(*fp, "#Git_revision_code:%s\n", c->git_code_ver);
+    open_output_file(c, c->out_fname, &(c->ofp));
 
-    /* time stuff */
-    fprintf(*fp, "year,doy,");
+    /* columnar files describe themselves, see columnar.c */
+    if (c->output_columnar)
+        return;
 
-    /*
-    ** STATE
-    */
+    if (c->output_ascii)
+        write_output_header(c, &(c->ofp));
 
-    /* water*/
-    fprintf(*fp, "wtfac_root,pawater_root,");
-
-    /* plant */
-    fprintf(*fp, "shoot,lai,branch,stem,root,croot,shootn,branchn,stemn,");
-    fprintf(*fp, "rootn,crootn,cstore,nstore,");
+    if (c->output_ascii == FALSE || strcmp(c->out_fname_hdr, "*NOT SET*") != 0) {
+        open_output_file(c, c->out_fname_hdr, &(c->ofp_hdr));
+        write_output_description(c, &(c->ofp_hdr));
+    }
 
-    /* belowground */
-    fprintf(*fp, "soilc,soiln,inorgn,litterc,littercag,littercbg,");
-    fprintf(*fp, "litternag,litternbg,activesoil,slowsoil,");
-    fprintf(*fp, "passivesoil,activesoiln,slowsoiln,passivesoiln,");
+    return;
+}
 
+void write_output_header(control *c, FILE **fp) {
     /*
-    ** FLUXES
+        Write the CSV header: git revision, then the names of the selected
+        output variables (see output_vars.c). Units are not written here so
+        the file still reads straight into pandas etc, they go in the
+        header file (write_output_description).
     */
+    int i;
 
-    /* water */
-    fprintf(*fp, "et,transpiration,soil_evap,canopy_evap,runoff,");
-    fprintf(*fp, "gs_mol_m2_sec,ga_mol_m2_sec,");
-
-    /* litter */
-    fprintf(*fp, "deadleaves,deadbranch,deadstems,deadroots,deadcroots,");
-    fprintf(*fp, "deadleafn,deadbranchn,deadstemn,deadrootn,deadcrootn,");
-
-    /* C fluxes */
-    fprintf(*fp, "nep,gpp,npp,hetero_resp,auto_resp,apar,");
-
-    /* C & N growth */
-    fprintf(*fp, "cpleaf,cpbranch,cpstem,cproot,cpcroot,");
-    fprintf(*fp, "npleaf,npbranch,npstemimm,npstemmob,nproot,npcroot,");
-
-    /* N stuff */
-    fprintf(*fp, "nuptake,ngross,nmineralisation,nloss,");
-
-    /* traceability stuff */
-    fprintf(*fp, "tfac_soil_decomp,c_into_active,c_into_slow,");
-    fprintf(*fp, "c_into_passive,active_to_slow,active_to_passive,");
-    fprintf(*fp, "slow_to_active,slow_to_passive,passive_to_active,");
-    fprintf(*fp, "co2_rel_from_surf_struct_litter,");
-    fprintf(*fp, "co2_rel_from_soil_struct_litter,");
-    fprintf(*fp, "co2_rel_from_surf_metab_litter,");
-    fprintf(*fp, "co2_rel_from_soil_metab_litter,");
-    fprintf(*fp, "co2_rel_from_active_pool,");
-    fprintf(*fp, "co2_rel_from_slow_pool,");
-    fprintf(*fp, "co2_rel_from_passive_pool,");
-
-    /* extra priming stuff */
-    fprintf(*fp, "root_exc,");
-    fprintf(*fp, "root_exn,");
-    fprintf(*fp, "co2_released_exud,");
-    fprintf(*fp, "factive,");
-    fprintf(*fp, "rtslow,");
-    fprintf(*fp, "rexc_cue,");
-
-
+    /* Git version */
+    fprintf(*fp, "#Git_revision_code:%s\n", c->git_code_ver);
 
-    /* Misc */
-    fprintf(*fp, "leafretransn\n");
+    for (i = 0; i < c->num_output_vars; i++) {
+        fprintf(*fp, "%s%s", get_output_var(c->output_vars[i])->name,
+                (i < c->num_output_vars - 1) ? "," : "\n");
+    }
 
+    return;
+}
 
-    if (c->output_ascii == FALSE) {
-        fprintf(*fp, "nrows=%d\n", nrows);
-        fprintf(*fp, "ncols=%d\n", ncols);
+void write_output_description(control *c, FILE **fp) {
+    /*
+        Describe the daily output records: git revision, variable names,
+        units, number of rows (days, or output periods) and columns. For binary outputs each
+        row is ncols native doubles, in the order the names are listed.
+    */
+    const output_var *v;
+    int               i, len;
+
+    write_output_header(c, fp);
+
+    fprintf(*fp, "units=");
+    for (i = 0; i < c->num_output_vars; i++) {
+        v = get_output_var(c->output_vars[i]);
+        len = strlen(v->units);
+
+        /* fluxes summed over an output period are per period, not per day */
+        if (c->output_period != OUTPUT_PERIOD_DAILY &&
+            v->aggregate == OUTPUT_AGG_SUM && len > 4 &&
+            strcmp(v->units + len - 4, " d-1") == 0)
+            len -= 4;
+        fprintf(*fp, "%.*s%s", len, v->units,
+                (i < c->num_output_vars - 1) ? "," : "\n");
     }
+    fprintf(*fp, "nrows=%d\n", c->num_output_records);
+    fprintf(*fp, "ncols=%d\n", c->num_output_vars);
+    fprintf(*fp, "dtype=%s\n", c->output_ascii ? "ascii" : "float64");
+
     return;
 }
 
@@ -118,95 +108,13 @@ void write_daily_outputs_ascii(control *c, fluxes *f, state *s, int year,
         script to translate the outputs to a nice CSV file with input met
         data, units and nice header information.
     */
+    double vals[MAX_OUTPUT_VARS];
+    char   line[MAX_OUTPUT_VARS * OUTPUT_CHARS_PER_VAL];
+    int    nvals;
 
-
-    /* time stuff */
-    fprintf(c->ofp, "%.10f,%.10f,", (double)year, (double)doy);
-
-    /*
-    ** STATE
-
-    */
-
-    /* water*/
-    fprintf(c->ofp, "%.10f,%.10f,", s->wtfac_root,s->pawater_root);
-
-    /* plant */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    s->shoot,s->lai,s->branch,s->stem,s->root,s->croot,
-                    s->shootn,s->branchn,s->stemn);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,",
-                    s->rootn,s->crootn,s->cstore,s->nstore);
-
-    /* belowground */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    s->soilc,s->soiln,s->inorgn,s->litterc,s->littercag,
-                    s->littercbg);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    s->litternag,s->litternbg,s->activesoil,s->slowsoil,
-                    s->passivesoil,s->activesoiln,s->slowsoiln,
-                    s->passivesoiln);
-    /*
-    ** FLUXES
-    */
-
-    /* water */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,",
-                    f->et,f->transpiration,f->soil_evap,f->canopy_evap);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,",
-                    f->runoff,f->gs_mol_m2_sec,f->ga_mol_m2_sec);
-
-    /* litter */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    f->deadleaves,f->deadbranch,f->deadstems,f->deadroots,
-                    f->deadcroots);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    f->deadleafn,f->deadbranchn,f->deadstemn,f->deadrootn,
-                    f->deadcrootn);
-
-    /* C fluxes */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    f->nep,f->gpp,f->npp,f->hetero_resp,f->auto_resp,
-                    f->apar);
-
-    /* C & N growth */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    f->cpleaf,f->cpbranch,f->cpstem,f->cproot,f->cpcroot);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,%.10f,%.10f,",
-                    f->npleaf,f->npbranch,f->npstemimm,f->npstemmob,f->nproot,
-                    f->npcroot);
-
-    /* N stuff */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,%.10f,",
-                    f->nuptake,f->ngross,f->nmineralisation,f->nloss);
-
-
-    /* traceability stuff */
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,",
-                    f->tfac_soil_decomp,f->c_into_active,f->c_into_slow);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,",
-                    f->c_into_passive,f->active_to_slow,f->active_to_passive);
-    fprintf(c->ofp, "%.10f,%.10f,%.10f,",
-                    f->slow_to_active,f->slow_to_passive,f->passive_to_active);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_surf_struct_litter);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_soil_struct_litter);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_surf_metab_litter);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_soil_metab_litter);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_active_pool);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_slow_pool);
-    fprintf(c->ofp, "%.10f,", f->co2_rel_from_passive_pool);
-
-    /* extra priming stuff */
-    fprintf(c->ofp, "%.10f,", f->root_exc);
-    fprintf(c->ofp, "%.10f,", f->root_exn);
-    fprintf(c->ofp, "%.10f,", f->co2_released_exud);
-    fprintf(c->ofp, "%.10f,", f->factive);
-    fprintf(c->ofp, "%.10f,", f->rtslow);
-    fprintf(c->ofp, "%.10f,", f->rexc_cue);
-
-    /* Misc */
-    fprintf(c->ofp, "%.10f\n", f->leafretransn);
-
+    nvals = pack_daily_outputs(c, f, s, year, doy, vals);
+    format_output_record(vals, nvals, line, sizeof(line));
+    fputs(line, c->ofp);
 
     return;
 }
@@ -219,36 +127,80 @@ void write_daily_outputs_binary(control *c, fluxes *f, state *s, int year,
         script to translate the outputs to a nice CSV file with input met
         data, units and nice header information.
     */
-    double temp;
-
-    /* time stuff */
-    temp = (double)year;
-    fwrite(&temp, sizeof(double), 1, c->ofp);
-    temp = (double)doy;
-    fwrite(&temp, sizeof(double), 1, c->ofp);
+    double vals[MAX_OUTPUT_VARS];
+    int    nvals;
 
+    nvals = pack_daily_outputs(c, f, s, year, doy, vals);
+    fwrite(vals, sizeof(double), nvals, c->ofp);
 
-    /* plant */
-    fwrite(&(s->shoot), sizeof(double), 1, c->ofp);
-    fwrite(&(s->lai), sizeof(double), 1, c->ofp);
-    fwrite(&(s->branch), sizeof(double), 1, c->ofp);
-    fwrite(&(s->stem), sizeof(double), 1, c->ofp);
-    fwrite(&(s->root), sizeof(double), 1, c->ofp);
+    return;
+}
 
-    /* water */
-    fwrite(&(s->wtfac_root), sizeof(double), 1, c->ofp);
-    fwrite(&(s->pawater_root), sizeof(double), 1, c->ofp);
-    fwrite(&(f->transpiration), sizeof(double), 1, c->ofp);
-    fwrite(&(f->soil_evap), sizeof(double), 1, c->ofp);
-    fwrite(&(f->canopy_evap), sizeof(double), 1, c->ofp);
-    fwrite(&(f->runoff), sizeof(double), 1, c->ofp);
+void write_output_record(control *c, const double *vals, int nvals) {
+    /* Write one (daily or aggregated) record to the output file */
+    char line[MAX_OUTPUT_VARS * OUTPUT_CHARS_PER_VAL];
 
-    /* C fluxes */
-    fwrite(&(f->npp), sizeof(double), 1, c->ofp);
+    if (c->output_ascii) {
+        format_output_record(vals, nvals, line, sizeof(line));
+        fputs(line, c->ofp);
+    } else {
+        fwrite(vals, sizeof(double), nvals, c->ofp);
+    }
 
     return;
 }
 
+int pack_daily_outputs(control *c, fluxes *f, state *s, int year, int doy,
+                       double *vals) {
+    /*
+        Copy the day's values of the selected output variables, in file
+        order, into vals. These are all the daily writers need, so a day can
+        be handed on to the output writer thread (output_writer.c) as a
+        plain record.
+
+        Returns:
+        --------
+        nvals : int
+            number of values in the record
+    */
+    int i;
+
+    for (i = 0; i < c->num_output_vars; i++) {
+        vals[i] = get_output_value(get_output_var(c->output_vars[i]), f, s,
+                                   year, doy);
+    }
+
+    return (c->num_output_vars);
+}
+
+size_t format_output_record(const double *vals, int nvals, char *buf,
+                            size_t size) {
+    /*
+        One line of the CSV output, nvals * OUTPUT_CHARS_PER_VAL characters
+        is always enough for sensible values
+
+        Returns:
+        --------
+        len : size_t
+            length of the line, including the newline
+    */
+    size_t len = 0;
+    int    i, n;
+
+    for (i = 0; i < nvals; i++) {
+        n = snprintf(buf + len, size - len,
+                     (i < nvals - 1) ? "%.10f," : "%.10f\n", vals[i]);
+        if (n < 0 || (size_t)n >= size - len) {
+            fprintf(stderr, "Error: output value %d (%g) too wide to write\n",
+                    i, vals[i]);
+            exit(EXIT_FAILURE);
+        }
+        len += n;
+    }
+
+    return (len);
+}
+
 
 int write_final_state(control *c, params *p, state *s)
 {
@@ -341,6 +293,8 @@ int ohandler(char *section, char *name, char *value, control *c, params *p,
 
     - also added previous ncd as this potential can be changed internally
     */
+    const param_field *field;
+    const char        *override;
 
     #define MATCH(s, n) strcasecmp(section, s) == 0 && strcasecmp(name, n) == 0
 
@@ -363,135 +317,16 @@ int ohandler(char *section, char *name, char *value, control *c, params *p,
     /*
     ** STATE
     */
-
-    if (MATCH("state", "activesoil")) {
-        fprintf(c->ofp, "activesoil = %.10f\n", s->activesoil);
-        *match = TRUE;
-    } else if (MATCH("state", "activesoiln")) {
-        fprintf(c->ofp, "activesoiln = %.10f\n", s->activesoiln);
-        *match = TRUE;
-    } else if (MATCH("state", "age")) {
-        fprintf(c->ofp, "age = %.10f\n", s->age);
-        *match = TRUE;
-    } else if (MATCH("state", "avg_albranch")) {
-        fprintf(c->ofp, "avg_albranch = %.10f\n", s->avg_albranch);
-        *match = TRUE;
-    } else if (MATCH("state", "avg_alcroot")) {
-        fprintf(c->ofp, "avg_alcroot = %.10f\n", s->avg_alcroot);
-        *match = TRUE;
-    } else if (MATCH("state", "avg_alleaf")) {
-        fprintf(c->ofp, "avg_alleaf = %.10f\n", s->avg_alleaf);
-        *match = TRUE;
-    } else if (MATCH("state", "avg_alroot")) {
-        fprintf(c->ofp, "avg_alroot = %.10f\n", s->avg_alroot);
-        *match = TRUE;
-    } else if (MATCH("state", "avg_alstem")) {
-        fprintf(c->ofp, "avg_alstem = %.10f\n", s->avg_alstem);
-        *match = TRUE;
-    } else if (MATCH("state", "branch")) {
-        fprintf(c->ofp, "branch = %.10f\n", s->branch);
-        *match = TRUE;
-    } else if (MATCH("state", "branchn")) {
-        fprintf(c->ofp, "branchn = %.10f\n", s->branchn);
-        *match = TRUE;
-    } else if (MATCH("state", "canht")) {
-        fprintf(c->ofp, "canht = %.10f\n", s->canht);
-        *match = TRUE;
-    } else if (MATCH("state", "croot")) {
-        fprintf(c->ofp, "croot = %.10f\n", s->croot);
-        *match = TRUE;
-    } else if (MATCH("state", "crootn")) {
-        fprintf(c->ofp, "crootn = %.10f\n", s->crootn);
-        *match = TRUE;
-    } else if (MATCH("state", "cstore")) {
-        fprintf(c->ofp, "cstore = %.10f\n", s->cstore);
-        *match = TRUE;
-    } else if (MATCH("state", "inorgn")) {
-        fprintf(c->ofp, "inorgn = %.10f\n", s->inorgn);
-        *match = TRUE;
-    } else if (MATCH("state", "lai")) {
-        fprintf(c->ofp, "lai = %.10f\n", s->lai);
-        *match = TRUE;
-    } else if (MATCH("state", "metabsoil")) {
-        fprintf(c->ofp, "metabsoil = %.10f\n", s->metabsoil);
-        *match = TRUE;
-    } else if (MATCH("state", "metabsoiln")) {
-        fprintf(c->ofp, "metabsoiln = %.10f\n", s->metabsoiln);
-        *match = TRUE;
-    } else if (MATCH("state", "metabsurf")) {
-        fprintf(c->ofp, "metabsurf = %.10f\n", s->metabsurf);
-        *match = TRUE;
-    } else if (MATCH("state", "metabsurfn")) {
-        fprintf(c->ofp, "metabsurfn = %.10f\n", s->metabsurfn);
-        *match = TRUE;
-    } else if (MATCH("state", "nstore")) {
-        fprintf(c->ofp, "nstore = %.10f\n", s->nstore);
-        *match = TRUE;
-    } else if (MATCH("state", "passivesoil")) {
-        fprintf(c->ofp, "passivesoil = %.10f\n", s->passivesoil);
-        *match = TRUE;
-    } else if (MATCH("state", "passivesoiln")) {
-        fprintf(c->ofp, "passivesoiln = %.10f\n", s->passivesoiln);
-        *match = TRUE;
-    } else if (MATCH("state", "pawater_root")) {
-        fprintf(c->ofp, "pawater_root = %.10f\n", s->pawater_root);
-        *match = TRUE;
-    } else if (MATCH("state", "pawater_topsoil")) {
-        fprintf(c->ofp, "pawater_topsoil = %.10f\n", s->pawater_topsoil);
-        *match = TRUE;
-    } else if (MATCH("state", "prev_sma")) {
-        fprintf(c->ofp, "prev_sma = %.10f\n", s->prev_sma);
-        *match = TRUE;
-    } else if (MATCH("state", "root")) {
-        fprintf(c->ofp, "root = %.10f\n", s->root);
-        *match = TRUE;
-    } else if (MATCH("state", "root_depth")) {
-        fprintf(c->ofp, "root_depth = %.10f\n", s->root_depth);
-        *match = TRUE;
-    } else if (MATCH("state", "rootn")) {
-        fprintf(c->ofp, "rootn = %.10f\n", s->rootn);
-        *match = TRUE;
-    } else if (MATCH("state", "sapwood")) {
-        fprintf(c->ofp, "sapwood = %.10f\n", s->sapwood);
-        *match = TRUE;
-    } else if (MATCH("state", "shoot")) {
-        fprintf(c->ofp, "shoot = %.10f\n", s->shoot);
-        *match = TRUE;
-    } else if (MATCH("state", "shootn")) {
-        fprintf(c->ofp, "shootn = %.10f\n", s->shootn);
-        *match = TRUE;
-    } else if (MATCH("state", "sla")) {
-        fprintf(c->ofp, "sla = %.10f\n", s->sla);
-        *match = TRUE;
-    } else if (MATCH("state", "slowsoil")) {
-        fprintf(c->ofp, "slowsoil = %.10f\n", s->slowsoil);
-        *match = TRUE;
-    } else if (MATCH("state", "slowsoiln")) {
-        fprintf(c->ofp, "slowsoiln = %.10f\n", s->slowsoiln);
-        *match = TRUE;
-    } else if (MATCH("state", "stem")) {
-        fprintf(c->ofp, "stem = %.10f\n", s->stem);
-        *match = TRUE;
-    } else if (MATCH("state", "stemn")) {
-        fprintf(c->ofp, "stemn = %.10f\n", s->stemn);
-        *match = TRUE;
-    } else if (MATCH("state", "stemnimm")) {
-        fprintf(c->ofp, "stemnimm = %.10f\n", s->stemnimm);
-        *match = TRUE;
-    } else if (MATCH("state", "stemnmob")) {
-        fprintf(c->ofp, "stemnmob = %.10f\n", s->stemnmob);
-        *match = TRUE;
-    } else if (MATCH("state", "structsoil")) {
-        fprintf(c->ofp, "structsoil = %.10f\n", s->structsoil);
-        *match = TRUE;
-    } else if (MATCH("state", "structsoiln")) {
-        fprintf(c->ofp, "structsoiln = %.10f\n", s->structsoiln);
-        *match = TRUE;
-    } else if (MATCH("state", "structsurf")) {
-        fprintf(c->ofp, "structsurf = %.10f\n", s->structsurf);
-        *match = TRUE;
-    } else if (MATCH("state", "structsurfn")) {
-        fprintf(c->ofp, "structsurfn = %.10f\n", s->structsurfn);
+    field = find_param_field(section, name);
+    if (field != NULL && field->base == PARAM_STATE) {
+        fprintf(c->ofp, "%s = %.10f\n", field->name,
+                *(double *)((char *)s + field->offset));
+        *match = TRUE;
+    } else if (*match == FALSE &&
+               ((override = find_run_override(c, section, name)) != NULL ||
+                (override = find_param_override(section, name)) != NULL)) {
+        /* write out values changed with -set, so the file reproduces the run */
+        fprintf(c->ofp, "%s = %s\n", name, override);
         *match = TRUE;
     }
 
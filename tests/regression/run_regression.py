@@ -0,0 +1,508 @@
+#!/usr/bin/env python
+
+"""
+Numerical regression test of the C model: run the reference cases and
+compare every output variable with the stored goldens (make test in src)
+
+    $ python run_regression.py                # compare, exit status 1 on fail
+    $ python run_regression.py --only grass   # just one case
+    $ python run_regression.py --update       # store new goldens
+    $ python run_regression.py --set control.temp_tables=true \
+          --tolerances tolerances_temp_tables.txt
+
+The cases are the Duke ambient daily run, a deciduous grass run on the same
+forcing, a 3 year synthetic 30 min run and a full spin-up, on the forcing the
+benchmark makes (the Duke files rearranged into the model's daily layout, and
+a synthetic 30 min file made from them, see run_benchmark.py). The first three
+are compared day by day over all of their output variables; the spin-up is
+compared on the [state] section of the final parameter file it writes. The
+branch case forks the Duke run at 2000 (gday -branch) into a scenario with
+no overrides, whose years after the trunk's must give duke_daily again. The
+libgday case drives the synthetic 30 min run through src/libgday.so with tair
+raised by LIBGDAY_TAIR_SHIFT through gday_set_forcing, and compares it with
+the program run on a met file raised by the same amount.
+
+A value passes when |new - golden| <= atol + rtol * scale, where scale is the
+largest magnitude the variable reaches in the golden run (most fluxes pass
+through zero, where a pointwise relative error means nothing). The atol and
+rtol of each variable are read from tolerances.txt. For every variable that
+fails the report gives the first day it moves outside its tolerance and the
+largest difference, and each case gives the first day any variable does.
+A NaN or Inf never passes, not even against the same in the golden, and
+--update won't store a run that has one. Whether the run is bit for bit
+identical is reported as well, so an
+optimisation that is meant to change nothing can be held to that. Any --set
+KEY=VALUE is added to every case, for checking a model option that is meant
+to change results slightly against the same goldens, with its own
+tolerances.
+"""
+
+import os
+import sys
+import csv
+import gzip
+import math
+import shutil
+import ctypes
+import argparse
+import subprocess
+
+__author__  = "agent"
+__version__ = "1.0 (14.10.2026)"
+__email__   = "agent@local"
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+EXAMPLE_DIR = os.path.join(HERE, "..", "..", "example")
+GOLDEN_DIR = os.path.join(HERE, "golden")
+WORK_DIR = os.path.join(HERE, "work")
+CFG = "params/NCEAS_DUKE_model_youngforest_amb.cfg"
+BRANCH_YEAR = 2000
+SYNTHETIC_YEARS = 3
+LIBGDAY_TAIR_SHIFT = 5.0
+
+# the forcing is made the same way as the benchmark's
+sys.path.insert(0, os.path.join(HERE, "..", "..", "benchmark"))
+from run_benchmark import (MET_DAILY, MET_EQUIL, make_forcing, non_finite,
+                           write_daily_forcing, write_synthetic_forcing)
+
+MET_FILES = {
+    "duke_daily_met.csv": lambda fname: write_daily_forcing(MET_DAILY, fname),
+    "duke_equilibrium_met.csv": lambda fname: write_daily_forcing(MET_EQUIL,
+                                                              fname),
+    "synthetic_30min_met.csv": lambda fname: write_synthetic_forcing(
+        fname, SYNTHETIC_YEARS),
+}
+
+
+def met_fname(name):
+    return os.path.join(WORK_DIR, name)
+
+
+def cases():
+    """ name, -s or not, and the -set overrides of each reference run """
+    daily = "files.met_fname=%s" % met_fname("duke_daily_met.csv")
+
+    return [
+        ("duke_daily", False, [daily, "control.print_options=daily"]),
+        ("grass", False, [daily, "control.alloc_model=grasses",
+                          "control.deciduous_model=true",
+                          "control.print_options=daily"]),
+        ("synthetic_30min", False, [
+            "files.met_fname=%s" % met_fname("synthetic_30min_met.csv"),
+            "control.sub_daily=true", "control.print_options=daily"]),
+        ("spinup", True, [
+            "files.met_fname=%s" % met_fname("duke_equilibrium_met.csv"),
+            "control.print_options=end"]),
+        ("spinup_accelerate", True, [
+            "files.met_fname=%s" % met_fname("duke_equilibrium_met.csv"),
+            "control.print_options=end", "control.spinup_accelerate=true"]),
+        ("branch", False, [daily]),
+        ("libgday", False, [
+            "files.met_fname=%s" % met_fname("synthetic_30min_met.csv"),
+            "control.sub_daily=true", "control.print_options=daily"]),
+    ]
+
+
+# cases checked against another case's golden
+GOLDEN_OF = {"branch": "duke_daily"}
+
+
+def read_tolerances(fname):
+    """ {variable: (atol, rtol)}, with the "default" entry for the rest """
+    tols = {}
+    with open(fname) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            if not line:
+                continue
+            (name, atol, rtol) = line.split()
+            tols[name] = (float(atol), float(rtol))
+    if "default" not in tols:
+        raise ValueError("%s has no default tolerance" % fname)
+
+    return tols
+
+
+def open_text(fname):
+    if fname.endswith(".gz"):
+        return gzip.open(fname, "rt")
+    return open(fname, "r")
+
+
+def read_output(fname):
+    """ variable names and rows of values of a CSV output file.
+
+    The first line holds the git revision, the second the variable names.
+    """
+    with open_text(fname) as f:
+        rows = list(csv.reader(f))
+    names = [name.strip() for name in rows[1]]
+    data = [[float(x) for x in row] for row in rows[2:] if row]
+
+    return names, data
+
+
+def read_state(fname):
+    """ the [state] section of a parameter file as ([names], [[values]]) """
+    names = []
+    values = []
+    section = None
+    with open_text(fname) as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("["):
+                section = line.strip("[]")
+            elif section == "state" and "=" in line:
+                (key, value) = [x.strip() for x in line.split("=", 1)]
+                names.append(key)
+                values.append(float(value))
+
+    return names, [values]
+
+
+def finite(x):
+    return not (math.isnan(x) or math.isinf(x))
+
+
+def same(x, y):
+    """ a NaN or Inf is never the same as anything, a golden that has one
+    has nothing to check against """
+    return x == y and finite(x)
+
+
+def compare(names, golden, new, tols):
+    """
+    Compare the new run with the golden, variable by variable.
+
+    Returns the failures, (first row outside tolerance, name, golden and new
+    values there, largest difference, limit) in the order they diverge, and
+    whether everything matched bit for bit.
+    """
+    identical = True
+    failures = []
+    for (j, name) in enumerate(names):
+        (atol, rtol) = tols.get(name, tols["default"])
+        column = [row[j] for row in golden]
+        scale = max([abs(x) for x in column if finite(x)] + [0.0])
+        limit = atol + rtol * scale
+
+        first = None
+        worst = 0.0
+        for (i, row) in enumerate(new):
+            (x, y) = (golden[i][j], row[j])
+            if same(x, y):
+                continue
+            identical = False
+            diff = abs(x - y)
+            if math.isnan(diff):
+                worst = diff
+            elif not math.isnan(worst):
+                worst = max(worst, diff)
+            if first is None and (math.isnan(diff) or diff > limit):
+                first = i
+        if first is not None:
+            failures.append((first, name, golden[first][j], new[first][j],
+                             worst, limit))
+    failures.sort(key=lambda f: f[0])
+
+    return failures, identical
+
+
+def run_case(gday, name, spin_up, overrides):
+    """ run one case, returns the file holding its results """
+    out = os.path.join(WORK_DIR, name + ".csv")
+    final = os.path.join(WORK_DIR, name + "_final.cfg")
+    cmd = [gday]
+    if spin_up:
+        cmd.append("-s")
+    cmd += ["-p", CFG, "-set", "files.out_fname=%s" % out,
+            "-set", "files.out_param_fname=%s" % final]
+    for kv in overrides:
+        cmd += ["-set", kv]
+
+    log_fname = os.path.join(WORK_DIR, name + ".log")
+    with open(log_fname, "w") as log:
+        status = subprocess.call(cmd, cwd=EXAMPLE_DIR, stdout=log, stderr=log)
+    if status != 0:
+        with open(log_fname) as log:
+            sys.stderr.write("%s: gday failed\n%s" % (name, log.read()))
+        return None
+
+    return final if spin_up else out
+
+
+def run_branch(gday, overrides):
+    """ the Duke run forked at BRANCH_YEAR, returns its trunk and scenario
+    output files """
+    trunk = os.path.join(WORK_DIR, "branch_trunk.csv")
+    scenario = os.path.join(WORK_DIR, "branch_same.csv")
+    scenarios = os.path.join(WORK_DIR, "branch_scenarios.txt")
+    with open(scenarios, "w") as f:
+        f.write("* files.out_fname=%s\n" % os.path.join(WORK_DIR,
+                                                      "branch_%c.csv"))
+        f.write("same\n")
+
+    cmd = [gday, "-p", CFG, "-set", "files.out_fname=%s" % trunk,
+           "-set", "control.print_options=daily"]
+    for kv in overrides:
+        cmd += ["-set", kv]
+    cmd += ["-branch", scenarios, "-at", str(BRANCH_YEAR)]
+
+    log_fname = os.path.join(WORK_DIR, "branch.log")
+    with open(log_fname, "w") as log:
+        status = subprocess.call(cmd, cwd=EXAMPLE_DIR, stdout=log, stderr=log)
+    if status != 0:
+        with open(log_fname) as log:
+            sys.stderr.write("branch: gday failed\n%s" % log.read())
+        return None
+
+    return trunk, scenario
+
+
+def read_branch(fnames):
+    """ the trunk's rows followed by the scenario's """
+    (names, trunk) = read_output(fnames[0])
+    (scenario_names, scenario) = read_output(fnames[1])
+    if scenario_names != names:
+        return scenario_names, scenario
+
+    return names, trunk + scenario
+
+
+def write_cfg(fname, overrides):
+    """ CFG with the section.key=value overrides applied, as -set would """
+    changes = {}
+    for kv in overrides:
+        (key, value) = kv.split("=", 1)
+        (section, name) = key.split(".", 1)
+        changes.setdefault(section, {})[name] = value
+
+    section = None
+    with open(os.path.join(EXAMPLE_DIR, CFG)) as fin:
+        with open(fname, "w") as fout:
+            for line in fin:
+                stripped = line.strip()
+                if stripped.startswith("["):
+                    section = stripped.strip("[]")
+                    fout.write(line)
+                    # new keys go at the top of their section
+                    for (name, value) in changes.get(section, {}).items():
+                        fout.write("%s = %s\n" % (name, value))
+                    continue
+                name = stripped.split("=", 1)[0].strip()
+                if "=" in stripped and name in changes.get(section, {}):
+                    continue
+                fout.write(line)
+
+
+def write_output_csv(fname, names, rows):
+    """ rows in the layout (and precision) of the model's daily output """
+    with open(fname, "w") as f:
+        f.write("#Git_revision_code:libgday\n")
+        f.write("%s\n" % ",".join(names))
+        for row in rows:
+            f.write("%s\n" % ",".join("%.10f" % x for x in row))
+
+
+def run_libgday(gday, lib_fname, overrides):
+    """
+    The synthetic run with tair shifted through gday_set_forcing, and the
+    program on a met file shifted the same way. Returns the program's and
+    the library's output files.
+    """
+    met = met_fname("synthetic_30min_met.csv")
+    shifted = os.path.join(WORK_DIR, "libgday_shifted_met.csv")
+    tair = []
+    with open(met) as fin:
+        with open(shifted, "w") as fout:
+            for line in fin:
+                if line.startswith("#"):
+                    fout.write(line)
+                    continue
+                v = line.rstrip("\n").split(",")
+                v[5] = "%f" % (float(v[5]) + LIBGDAY_TAIR_SHIFT)
+                tair.append(float(v[5]))
+                fout.write("%s\n" % ",".join(v))
+
+    program = os.path.join(WORK_DIR, "libgday_program.csv")
+    cmd = [gday, "-p", CFG, "-set", "files.out_fname=%s" % program]
+    for kv in overrides + ["files.met_fname=%s" % shifted]:
+        cmd += ["-set", kv]
+    log_fname = os.path.join(WORK_DIR, "libgday.log")
+    with open(log_fname, "w") as log:
+        status = subprocess.call(cmd, cwd=EXAMPLE_DIR, stdout=log, stderr=log)
+    if status != 0:
+        with open(log_fname) as log:
+            sys.stderr.write("libgday: gday failed\n%s" % log.read())
+        return None
+
+    if not os.path.exists(lib_fname):
+        sys.stderr.write("libgday: %s not found, run make in src\n" %
+                         lib_fname)
+        return None
+    lib = ctypes.CDLL(lib_fname)
+    lib.gday_open.restype = ctypes.c_void_p
+    lib.gday_open.argtypes = [ctypes.c_char_p]
+    for fn in (lib.gday_close, lib.gday_run, lib.gday_num_outputs,
+               lib.gday_num_records, lib.gday_num_forcing_rows):
+        fn.argtypes = [ctypes.c_void_p]
+    lib.gday_num_records.restype = ctypes.c_long
+    lib.gday_num_forcing_rows.restype = ctypes.c_long
+    lib.gday_set_forcing.argtypes = [ctypes.c_void_p, ctypes.c_char_p,
+                                     ctypes.c_void_p, ctypes.c_long]
+    lib.gday_output_name.restype = ctypes.c_char_p
+    lib.gday_output_name.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.gday_output.restype = ctypes.POINTER(ctypes.c_double)
+    lib.gday_output.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+
+    # the library reads the unshifted file, the host hands it the shift
+    cfg = os.path.join(WORK_DIR, "libgday.cfg")
+    write_cfg(cfg, overrides)
+    cwd = os.getcwd()
+    os.chdir(EXAMPLE_DIR)
+    try:
+        model = lib.gday_open(cfg.encode())
+        if not model:
+            sys.stderr.write("libgday: gday_open failed\n")
+            return None
+        real = (ctypes.c_double if lib.gday_forcing_size() == 8 else
+                ctypes.c_float)
+        values = (real * len(tair))(*tair)
+        if (lib.gday_num_forcing_rows(model) != len(tair) or
+            lib.gday_set_forcing(model, b"tair", values, len(tair)) != 0):
+            sys.stderr.write("libgday: gday_set_forcing failed\n")
+            lib.gday_close(model)
+            return None
+        lib.gday_run(model)
+        names = [lib.gday_output_name(model, i).decode()
+                 for i in range(lib.gday_num_outputs(model))]
+        nrecords = lib.gday_num_records(model)
+        columns = [lib.gday_output(model, name.encode()) for name in names]
+        rows = [[column[i] for column in columns] for i in range(nrecords)]
+        lib.gday_close(model)
+    finally:
+        os.chdir(cwd)
+
+    library = os.path.join(WORK_DIR, "libgday_library.csv")
+    write_output_csv(library, names, rows)
+
+    return program, library
+
+
+def golden_fname(name, spin_up):
+    return os.path.join(GOLDEN_DIR, name + (".cfg.gz" if spin_up else
+                                            ".csv.gz"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--gday", default=os.path.join(HERE, "..", "..",
+                                                       "src", "gday"),
+                        help="model executable")
+    parser.add_argument("--lib", default=os.path.join(HERE, "..", "..",
+                                                      "src", "libgday.so"),
+                        help="model shared library, for the libgday case")
+    parser.add_argument("--tolerances", default=os.path.join(
+                            HERE, "tolerances.txt"),
+                        help="per variable atol and rtol")
+    parser.add_argument("--update", action="store_true",
+                        help="store these results as the new goldens")
+    parser.add_argument("--only", nargs="+", metavar="NAME",
+                        help="run just these cases")
+    parser.add_argument("--set", action="append", default=[],
+                        metavar="KEY=VALUE",
+                        help="extra -set override for every case")
+    parser.add_argument("--all", action="store_true",
+                        help="list every failing variable, not just ten")
+    args = parser.parse_args()
+    if args.update and args.set:
+        sys.stderr.write("the goldens are of the default model, don't "
+                         "--update with --set\n")
+        sys.exit(1)
+
+    gday = os.path.abspath(args.gday)
+    if not os.path.exists(gday):
+        sys.stderr.write("%s not found, run make in src first\n" % gday)
+        sys.exit(1)
+    for d in (WORK_DIR, GOLDEN_DIR):
+        if not os.path.isdir(d):
+            os.makedirs(d)
+    tols = read_tolerances(args.tolerances)
+
+    nfail = 0
+    for (name, spin_up, overrides) in cases():
+        if args.only and name not in args.only:
+            continue
+        for (fname, write) in MET_FILES.items():
+            if fname in " ".join(overrides):
+                make_forcing(met_fname(fname), write)
+
+        if name in ("branch", "libgday") and args.update:
+            continue
+        if name == "branch":
+            result = run_branch(gday, overrides + args.set)
+        elif name == "libgday":
+            result = run_libgday(gday, os.path.abspath(args.lib),
+                                 overrides + args.set)
+        else:
+            result = run_case(gday, name, spin_up, overrides + args.set)
+        if result is None:
+            nfail += 1
+            continue
+
+        if name == "libgday":
+            # checked against the program rather than a stored golden
+            (golden, result) = result
+        else:
+            golden = golden_fname(GOLDEN_OF.get(name, name), spin_up)
+        if args.update:
+            bad = non_finite(result)
+            if bad is not None:
+                print("%-18s FAIL %s isn't finite, golden not updated" %
+                      (name, bad))
+                nfail += 1
+                continue
+            with open(result, "rb") as fin:
+                with gzip.open(golden, "wb") as fout:
+                    shutil.copyfileobj(fin, fout)
+            print("%-18s golden updated" % name)
+            continue
+        if not os.path.exists(golden):
+            print("%-18s FAIL no golden, run with --update" % name)
+            nfail += 1
+            continue
+
+        read = read_state if spin_up else read_output
+        (names, ref) = read(golden)
+        (new_names, new) = (read_branch if name == "branch" else read)(result)
+        if new_names != names or len(new) != len(ref):
+            print("%-18s FAIL %d variables x %d rows, golden has %d x %d" %
+                  (name, len(new_names), len(new), len(names), len(ref)))
+            nfail += 1
+            continue
+
+        if spin_up:
+            label_row = lambda i: "final state"
+        else:
+            label_row = lambda i: "year %d doy %d" % (ref[i][0], ref[i][1])
+        (failures, identical) = compare(names, ref, new, tols)
+        if not failures:
+            print("%-18s ok   %s" % (name, "bit for bit" if identical else
+                                     "within tolerance"))
+            continue
+
+        nfail += 1
+        print("%-18s FAIL %d of %d variables, first diverges at %s" %
+              (name, len(failures), len(names), label_row(failures[0][0])))
+        for f in failures if args.all else failures[:10]:
+            print("    %-20s %-20s golden %-14.8g new %-14.8g "
+                  "max diff %-10.3g (limit %.3g)" %
+                  ((f[1], label_row(f[0])) + f[2:]))
+        if len(failures) > 10 and not args.all:
+            print("    ... %d more, see --all" % (len(failures) - 10))
+
+    sys.exit(1 if nfail > 0 else 0)
+
+
+if __name__ == "__main__":
+    main()